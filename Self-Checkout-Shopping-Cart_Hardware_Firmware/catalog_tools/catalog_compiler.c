@@ -0,0 +1,483 @@
+/*
+ * @file catalog_compiler.c
+ * @brief Host tool building the catalog image stored in the MX25 external flash of the shopping cart from a CSV file.
+ *
+ * Build:	gcc -O2 -I ../shopping_cart_software -o catalog_compiler catalog_compiler.c ../shopping_cart_software/src/cart_codec.c
+ * Usage:	catalog_compiler products.csv catalog.bin
+ *
+ * One product per line: code,price,name
+ * 	code	EAN-8, UPC-A, EAN-13 or GTIN-14 digits
+ * 	price	in the currency unit, with up to 2 decimals (3.49)
+ * 	name	rest of the line, optionally between double quotes, truncated to CATALOG_NAME_MAXSIZE
+ * Empty lines, lines starting with # and a header line are skipped.
+ *
+ * The product id is cart_codec_product_id() of the name, linked from the firmware sources, so a product scanned from
+ * a label carrying its name and from its code ends up on the same line of the cart. The image is written at
+ * CATALOG_FLASH_ADDRESS of the external flash.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "../shopping_cart_software/inc/catalog.h"
+#include "../shopping_cart_software/inc/cart_codec.h"
+
+
+#define CATALOG_BUCKET_SIZE						(4)									/* Average number of codes per bucket */
+#define CATALOG_SEED_ATTEMPTS					(64)
+#define CATALOG_HEADER_SIZE						(64)								/* Header area, the index starts after it */
+#define LINE_MAXSIZE							(512)
+
+
+struct product
+{
+	struct catalog_record record;
+	uint64_t hash;
+	uint32_t bucket;
+	uint32_t line;
+};
+
+
+struct bucket
+{
+	uint32_t first;									/* Index in the products sorted by bucket */
+	uint32_t size;
+	uint32_t id;
+};
+
+
+static struct product *products;
+static uint32_t product_count;
+
+
+/**
+ * @brief This function parses one CSV line into a product.
+ * @return 1 for a product, 0 for a line to skip, -1 on error.
+ */
+static int product_parse(char* line, struct catalog_record* record, uint32_t line_number)
+{
+	char *cursor = line;
+	uint32_t digits = 0;
+	uint32_t units = 0;
+	uint32_t cents = 0;
+	uint32_t decimals = 0;
+
+	line[strcspn(line, "\r\n")] = '\0';
+	while(isspace((unsigned char)*cursor))
+	{
+		cursor++;
+	}
+	if((*cursor == '\0') || (*cursor == '#'))
+	{
+		return 0;
+	}
+
+	/* Code */
+	memset(record, 0, sizeof(struct catalog_record));
+	while(isdigit((unsigned char)*cursor))
+	{
+		record->code = (record->code * 10) + (*cursor++ - '0');
+		digits++;
+	}
+	if(digits == 0)
+	{
+		/* Header line */
+		return (line_number == 1) ? 0 : -1;
+	}
+	if((digits > CATALOG_CODE_MAXDIGITS) || (*cursor++ != ','))
+	{
+		return -1;
+	}
+
+	/* Price */
+	while(isdigit((unsigned char)*cursor))
+	{
+		units = (units * 10) + (*cursor++ - '0');
+		if(units > (UINT32_MAX / 100))
+		{
+			return -1;
+		}
+	}
+	if(*cursor == '.')
+	{
+		cursor++;
+		while(isdigit((unsigned char)*cursor) && (decimals < 2))
+		{
+			cents = (cents * 10) + (*cursor++ - '0');
+			decimals++;
+		}
+		cents *= (decimals == 1) ? 10 : 1;
+	}
+	if(*cursor++ != ',')
+	{
+		return -1;
+	}
+	record->price = (units * 100) + cents;
+
+	/* Name */
+	size_t size = strlen(cursor);
+	if((size >= 2) && (cursor[0] == '"') && (cursor[size - 1] == '"'))
+	{
+		cursor++;
+		size -= 2;
+	}
+	if(size == 0)
+	{
+		return -1;
+	}
+	if(size > CATALOG_NAME_MAXSIZE)
+	{
+		fprintf(stderr, "line %u: name truncated to %d characters\n", line_number, CATALOG_NAME_MAXSIZE);
+		size = CATALOG_NAME_MAXSIZE;
+	}
+	memcpy(record->name, cursor, size);
+	record->name_size = (uint8_t)size;
+	record->product_id = cart_codec_product_id(record->name, record->name_size);
+
+	return 1;
+}
+
+
+/**
+ * @brief This function reads the products of the CSV file.
+ * @return 0 on success, -1 on error.
+ */
+static int products_read(const char* path)
+{
+	char line[LINE_MAXSIZE];
+	uint32_t line_number = 0;
+	uint32_t capacity = 0;
+	FILE *file = fopen(path, "r");
+
+	if(file == NULL)
+	{
+		perror(path);
+		return -1;
+	}
+
+	while(fgets(line, sizeof(line), file) != NULL)
+	{
+		struct catalog_record record;
+		int ret = product_parse(line, &record, ++line_number);
+
+		if(ret < 0)
+		{
+			fprintf(stderr, "%s:%u: malformed line\n", path, line_number);
+			fclose(file);
+			return -1;
+		}
+		if(ret == 0)
+		{
+			continue;
+		}
+
+		if(product_count == capacity)
+		{
+			capacity = capacity ? (capacity * 2) : 1024;
+			products = realloc(products, capacity * sizeof(struct product));
+			if(products == NULL)
+			{
+				fclose(file);
+				return -1;
+			}
+		}
+		products[product_count].record = record;
+		products[product_count].line = line_number;
+		product_count++;
+	}
+
+	fclose(file);
+	return 0;
+}
+
+
+static int product_compare_code(const void* a, const void* b)
+{
+	uint64_t code_a = ((const struct product*)a)->record.code;
+	uint64_t code_b = ((const struct product*)b)->record.code;
+
+	return (code_a > code_b) - (code_a < code_b);
+}
+
+
+static int product_compare_bucket(const void* a, const void* b)
+{
+	uint32_t bucket_a = ((const struct product*)a)->bucket;
+	uint32_t bucket_b = ((const struct product*)b)->bucket;
+
+	return (bucket_a > bucket_b) - (bucket_a < bucket_b);
+}
+
+
+static int bucket_compare_size(const void* a, const void* b)
+{
+	const struct bucket *bucket_a = a;
+	const struct bucket *bucket_b = b;
+
+	/* Biggest first, then by id so that the image does not depend on qsort */
+	if(bucket_a->size != bucket_b->size)
+	{
+		return (bucket_a->size < bucket_b->size) ? 1 : -1;
+	}
+	return (bucket_a->id > bucket_b->id) - (bucket_a->id < bucket_b->id);
+}
+
+
+/**
+ * @brief This function builds the minimal perfect hash: the buckets are placed biggest first, each one with the
+ * first displacement sending all its codes to free slots.
+ * @return 0 on success, -1 if a bucket could not be placed with this seed.
+ */
+static int catalog_build(uint32_t seed, uint32_t bucket_count, uint16_t* index, uint32_t* slot_of)
+{
+	struct bucket *buckets = calloc(bucket_count, sizeof(struct bucket));
+	uint8_t *taken = calloc(product_count, 1);
+	uint32_t slots[64];
+	int ret = 0;
+
+	for(uint32_t i = 0; i < product_count; i++)
+	{
+		products[i].hash = catalog_hash(products[i].record.code, seed);
+		products[i].bucket = catalog_bucket(products[i].hash, bucket_count);
+	}
+	qsort(products, product_count, sizeof(struct product), product_compare_bucket);
+
+	for(uint32_t b = 0; b < bucket_count; b++)
+	{
+		buckets[b].id = b;
+	}
+	for(uint32_t i = 0; i < product_count; i++)
+	{
+		struct bucket *bucket = &buckets[products[i].bucket];
+
+		if(bucket->size == 0)
+		{
+			bucket->first = i;
+		}
+		bucket->size++;
+	}
+	qsort(buckets, bucket_count, sizeof(struct bucket), bucket_compare_size);
+
+	for(uint32_t b = 0; (b < bucket_count) && (buckets[b].size > 0) && (ret == 0); b++)
+	{
+		const struct bucket *bucket = &buckets[b];
+		uint32_t displacement;
+
+		if(bucket->size > (sizeof(slots) / sizeof(slots[0])))
+		{
+			ret = -1;
+			break;
+		}
+
+		for(displacement = 0; displacement <= UINT16_MAX; displacement++)
+		{
+			uint32_t placed = 0;
+
+			for(; placed < bucket->size; placed++)
+			{
+				const struct product *product = &products[bucket->first + placed];
+				uint32_t slot = catalog_slot(product->hash, (uint16_t)displacement, product_count);
+				uint32_t k;
+
+				for(k = 0; (k < placed) && (slots[k] != slot); k++);
+				if(taken[slot] || (k < placed))
+				{
+					break;
+				}
+				slots[placed] = slot;
+			}
+
+			if(placed == bucket->size)
+			{
+				break;
+			}
+		}
+
+		if(displacement > UINT16_MAX)
+		{
+			ret = -1;
+			break;
+		}
+
+		index[bucket->id] = (uint16_t)displacement;
+		for(uint32_t k = 0; k < bucket->size; k++)
+		{
+			taken[slots[k]] = 1;
+			slot_of[bucket->first + k] = slots[k];
+		}
+	}
+
+	free(buckets);
+	free(taken);
+	return ret;
+}
+
+
+static void put32(uint8_t* data, uint32_t value)
+{
+	for(int i = 0; i < 4; i++)
+	{
+		data[i] = (uint8_t)(value >> (8 * i));
+	}
+}
+
+
+static void put64(uint8_t* data, uint64_t value)
+{
+	put32(data, (uint32_t)value);
+	put32(data + 4, (uint32_t)(value >> 32));
+}
+
+
+static uint32_t get32(const uint8_t* data)
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+
+/**
+ * @brief This function looks up every product in the image the way catalog_lookup() does.
+ * @return Number of products not found.
+ */
+static uint32_t catalog_verify(const uint8_t* image, const struct catalog_header* header)
+{
+	uint32_t errors = 0;
+
+	for(uint32_t i = 0; i < product_count; i++)
+	{
+		uint64_t code = products[i].record.code;
+		uint64_t hash = catalog_hash(code, header->seed);
+		const uint8_t *entry = &image[header->index_offset + (catalog_bucket(hash, header->bucket_count) * 2)];
+		uint16_t displacement = entry[0] | (entry[1] << 8);
+		uint32_t slot = catalog_slot(hash, displacement, header->record_count);
+		const uint8_t *record = &image[header->record_offset + (slot * CATALOG_RECORD_SIZE)];
+
+		if((get32(record) != (uint32_t)code) || (get32(record + 4) != (uint32_t)(code >> 32)))
+		{
+			errors++;
+		}
+	}
+
+	return errors;
+}
+
+
+int main(int argc, char** argv)
+{
+	struct catalog_header header;
+	uint32_t seed;
+
+	if(argc != 3)
+	{
+		fprintf(stderr, "usage: %s products.csv catalog.bin\n", argv[0]);
+		return 1;
+	}
+
+	if((products_read(argv[1]) < 0) || (product_count == 0))
+	{
+		fprintf(stderr, "%s: no products\n", argv[1]);
+		return 1;
+	}
+
+	qsort(products, product_count, sizeof(struct product), product_compare_code);
+	for(uint32_t i = 1; i < product_count; i++)
+	{
+		if(products[i].record.code == products[i - 1].record.code)
+		{
+			fprintf(stderr, "%s:%u: duplicate code, first on line %u\n", argv[1], products[i].line, products[i - 1].line);
+			return 1;
+		}
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.magic = CATALOG_MAGIC;
+	header.version = CATALOG_VERSION;
+	header.record_size = CATALOG_RECORD_SIZE;
+	header.record_count = product_count;
+	header.bucket_count = (product_count + CATALOG_BUCKET_SIZE - 1) / CATALOG_BUCKET_SIZE;
+	header.index_offset = CATALOG_HEADER_SIZE;
+	header.record_offset = (header.index_offset + (header.bucket_count * 2) + CATALOG_RECORD_SIZE - 1) & ~(CATALOG_RECORD_SIZE - 1);
+	header.image_size = header.record_offset + (product_count * CATALOG_RECORD_SIZE);
+
+	if((CATALOG_FLASH_ADDRESS + header.image_size) > CATALOG_FLASH_MAXSIZE)
+	{
+		fprintf(stderr, "%u products do not fit in the external flash\n", product_count);
+		return 1;
+	}
+
+	uint16_t *index = calloc(header.bucket_count, sizeof(uint16_t));
+	uint32_t *slot_of = calloc(product_count, sizeof(uint32_t));
+	for(seed = 1; seed <= CATALOG_SEED_ATTEMPTS; seed++)
+	{
+		if(catalog_build(seed, header.bucket_count, index, slot_of) == 0)
+		{
+			break;
+		}
+	}
+	if(seed > CATALOG_SEED_ATTEMPTS)
+	{
+		fprintf(stderr, "no perfect hash found after %d seeds\n", CATALOG_SEED_ATTEMPTS);
+		return 1;
+	}
+	header.seed = seed;
+
+	/* Erased flash reads 0xFF, keep the padding the same so that the image can be compared with a flash dump */
+	uint8_t *image = malloc(header.image_size);
+	memset(image, 0xFF, header.image_size);
+
+	put32(&image[0], header.magic);
+	put32(&image[4], header.version);
+	put32(&image[8], header.record_size);
+	put32(&image[12], header.record_count);
+	put32(&image[16], header.bucket_count);
+	put32(&image[20], header.seed);
+	put32(&image[24], header.index_offset);
+	put32(&image[28], header.record_offset);
+	put32(&image[32], header.image_size);
+	memset(&image[36], 0, CATALOG_HEADER_SIZE - 36);
+	for(uint32_t b = 0; b < header.bucket_count; b++)
+	{
+		image[header.index_offset + (b * 2)] = (uint8_t)index[b];
+		image[header.index_offset + (b * 2) + 1] = (uint8_t)(index[b] >> 8);
+	}
+	for(uint32_t i = 0; i < product_count; i++)
+	{
+		const struct catalog_record *record = &products[i].record;
+		uint8_t *data = &image[header.record_offset + (slot_of[i] * CATALOG_RECORD_SIZE)];
+
+		memset(data, 0, CATALOG_RECORD_SIZE);
+		put64(data, record->code);
+		put32(data + 8, record->product_id);
+		put32(data + 12, record->price);
+		data[16] = record->name_size;
+		memcpy(data + 17, record->name, record->name_size);
+	}
+
+	uint32_t errors = catalog_verify(image, &header);
+	if(errors)
+	{
+		fprintf(stderr, "%u products cannot be found in the image\n", errors);
+		return 1;
+	}
+
+	FILE *file = fopen(argv[2], "wb");
+	if((file == NULL) || (fwrite(image, 1, header.image_size, file) != header.image_size) || fclose(file))
+	{
+		perror(argv[2]);
+		return 1;
+	}
+
+	printf("%u products, %u buckets, seed %u, %u bytes\n", product_count, header.bucket_count, header.seed, header.image_size);
+
+	free(image);
+	free(index);
+	free(slot_of);
+	free(products);
+	return 0;
+}
@@ -24,6 +24,7 @@
 #include "em_gpio.h"
 #include "em_usart.h"
 #include "em_cmu.h"
+#include "inc/timing.h"
 
 /* If the USART for the MX25 driver is not defined, these functions are unavailable */
 #ifdef MX25_USART
@@ -138,11 +139,7 @@ void MX25_deinit( void )
  */
 void Wait_Flash_WarmUp()
 {
-    volatile int time_cnt = FlashFullAccessTime;
-    while( time_cnt > 0 )
-    {
-        time_cnt--;
-    }
+    timing_wait_us( tPUW / 1000 );
 }
 
 /*
@@ -0,0 +1,51 @@
+/*
+ * @file adv_policy.h
+ * @brief Header file for adv_policy.c.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INC_ADV_POLICY_H_
+#define INC_ADV_POLICY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/* Advertising started by an NFC tap, see connection_param.h. The scan response carries the name and the token of
+ * the NFC handover record. The application arms a soft timer with the ticks returned by adv_policy_start() and
+ * adv_policy_step() */
+struct adv_policy
+{
+	bool advertising;
+	uint16_t interval;							/* Advertising interval in use, in units of 0.625 ms */
+
+	/* RTCC counter value of the tap, until the connection or the end of the advertising */
+	uint32_t tap_timestamp;
+	bool tap_pending;
+
+	/* Statistics */
+	uint32_t start_count;
+	uint32_t step_count;
+	uint32_t connect_count;						/* Connections opened after a tap */
+	uint32_t timeout_count;						/* Taps without a connection */
+	uint32_t connect_ms_last;					/* Tap to connection time */
+	uint32_t connect_ms_max;
+	uint32_t connect_ms_total;
+};
+
+
+struct adv_policy adv_policy;					/* Only one instance since there is only one advertising set */
+
+
+/* Function Declarations */
+uint32_t adv_policy_start(uint32_t tap_timestamp);
+uint32_t adv_policy_step(void);
+void adv_policy_stop(void);
+void adv_policy_connected(void);
+
+
+#endif /* INC_ADV_POLICY_H_ */
@@ -11,10 +11,19 @@
 #ifndef INC_BARCODE_H_
 #define INC_BARCODE_H_
 
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/leuart.h"
 
 #define BARCODE_PREAMBLE		(126)		/* Ascii equivalent of ~ */
 #define BARCODE_POSTAMBLE		(96)		/* Ascii equivalent of ` */
+#define BARCODE_CODE_MARKER		(35)		/* Ascii equivalent of #, a frame only carrying a product code : ~#4006381333931` */
+#define BARCODE_CODE_MAXDIGITS	(14)		/* GTIN-14, also holds EAN-13, UPC-A and EAN-8 */
 #define ASCII_DIGIT_START		(48)		/* Ascii Value for interger 0 */
+#define BARCODE_HEADER_SIZE		(1 + 3 + 3)	/* Preamble, payload size and cost */
+#define BARCODE_FIELD_DIGITS	(3)			/* Number of ascii digits in the payload size and cost fields */
+#define BARCODE_PAYLOAD_MAXSIZE	(LEUART_BUFFER_MAXSIZE - BARCODE_HEADER_SIZE - 1)	/* The payload size field allows 999 but the
+																					   whole frame has to fit in leuart_circbuff */
 
 
 
@@ -41,14 +50,76 @@ struct barcode_packet									/* Example Packet data to send enclosed in the bar
 };
 
 
-struct barcode_packet barcode_packet;							/*Only one instance of barcode packet since the data
- 	 	 	 	 	 	 	 	 	 	 	 	 	 	 	 	 	 is sent sequentially over bluetooth*/
+/* States of the barcode frame parser, one per field of the packet */
+enum barcode_parser_state
+{
+	BARCODE_STATE_PREAMBLE,
+	BARCODE_STATE_PAYLOAD_SIZE,
+	BARCODE_STATE_COST,
+	BARCODE_STATE_PAYLOAD,
+	BARCODE_STATE_POSTAMBLE,
+	BARCODE_STATE_CODE
+};
+
+
+/* Descriptor of a complete barcode frame still stored in leuart_circbuff. Nothing is copied out of the buffer,
+ * the descriptor is valid until it is given back with barcode_frame_release() */
+struct barcode_frame
+{
+	/* Decoded payload size and cost fields */
+	uint16_t payload_size;
+	uint16_t cost;
+
+	/* The payload inside leuart_circbuff. span[1] is only used when the payload wraps around the end of the buffer */
+	const char *span[2];
+	uint16_t span_size[2];
+
+	/* Number of buffer bytes occupied by the frame, from the preamble to the postamble */
+	uint32_t frame_size;
+
+	/* Product code of a code frame, the name and price are then looked up in the catalog. 0 digits for a named frame */
+	uint64_t code;
+	uint8_t code_digits;
+};
+
+
+/* Resumable parser state. It consumes whatever bytes are available in leuart_circbuff and
+ * keeps the partial frame state across calls */
+struct barcode_parser
+{
+	enum barcode_parser_state state;
+
+	/* Offset from the read position of leuart_circbuff of the next byte to parse */
+	uint32_t offset;
+
+	/* Numeric field being decoded and the number of its digits received so far */
+	uint16_t field;
+	uint8_t digits;
+
+	uint16_t payload_size;
+	uint16_t cost;
+	uint64_t code;
+
+	/* Last leuart_circbuff.overrun_count seen, a change means the unread data the parser was working on has been discarded */
+	uint32_t overrun_count;
+
+	/* Statistics */
+	uint32_t frame_count;
+	uint32_t garbage_count;						/* Bytes dropped between frames */
+	uint32_t truncated_count;					/* Frames dropped because they were incomplete or malformed */
+};
+
+
+struct barcode_parser barcode_parser;							/* Only one instance since there is only one barcode scanner */
 
 
 /* Function Declarations */
 void barcode_test_blocking(void);
 void barcode_test_blocking_scanning(void);
-int barcode_packet_create(struct barcode_packet* barcode_packet, int * payload_size);
+void barcode_parser_init(struct barcode_parser* parser);
+bool barcode_parser_run(struct barcode_parser* parser, struct barcode_frame* frame);
+void barcode_frame_release(struct barcode_parser* parser, const struct barcode_frame* frame);
+int barcode_packet_create(struct barcode_packet* barcode_packet, const struct barcode_frame* frame);
 char* itoa(int num, char* str, int base);
 void swap(char *x, char *y);
 #endif /* INC_BARCODE_H_ */
@@ -0,0 +1,67 @@
+/*
+ * @file ble_packer.h
+ * @brief Header file for ble_packer.c.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INC_BLE_PACKER_H_
+#define INC_BLE_PACKER_H_
+
+#include <stdint.h>
+#include "inc/scan_queue.h"
+
+
+/* Notification format on the Item Stream characteristic:
+ *
+ * Byte 0		Sequence number, incremented by one for every notification of the connection.
+ * Byte 1		CART_CODEC_VERSION in the upper nibble, BLE_PACKER_FLAG_CONTINUED and BLE_PACKER_FLAG_MORE in the lower nibble.
+ * Byte 2..		Stream of cart records, see cart_codec.h.
+ *
+ * As many records as fit are packed into one notification. A record that does not fit is cut and continues
+ * in the next notification. The client appends the bodies in sequence order and decodes the stream,
+ * a gap in the sequence numbers means the partial record has to be dropped */
+#define BLE_PACKER_HEADER_SIZE					(2)
+#define BLE_PACKER_FLAG_CONTINUED				(0x01)						/* The body starts in the middle of a record */
+#define BLE_PACKER_FLAG_MORE					(0x02)						/* The last record continues in the next notification */
+#define BLE_PACKER_VERSION_SHIFT				(4)
+
+#define BLE_ATT_HEADER_SIZE						(3)							/* ATT opcode and attribute handle of a notification */
+#define BLE_ATT_MTU_DEFAULT						(23)						/* ATT MTU before the MTU exchange */
+#define BLE_ATT_MTU_MAX							(247)						/* Largest MTU requested, fills one 251 byte LL packet */
+#define BLE_PACKER_NOTIFICATION_MAXSIZE			(BLE_ATT_MTU_MAX - BLE_ATT_HEADER_SIZE)
+
+
+struct ble_packer
+{
+	/* Negotiated ATT MTU of the connection */
+	uint16_t mtu;
+
+	/* Sequence number of the next notification */
+	uint8_t sequence;
+
+	/* Bytes of the record at the front of scan_queue already packed */
+	uint16_t record_offset;
+
+	/* Statistics */
+	uint32_t notification_count;
+	uint32_t item_count;
+	uint32_t fragment_count;				/* Notifications ending in the middle of a record */
+	uint32_t items_max;						/* Maximum number of complete records in one notification */
+};
+
+
+struct ble_packer ble_packer;				/* Only one instance since there is only one client connection */
+
+
+/* Function Declarations */
+void ble_packer_init(struct ble_packer* packer);
+void ble_packer_set_mtu(struct ble_packer* packer, uint16_t mtu);
+uint16_t ble_packer_fill(struct ble_packer* packer, uint8_t* notification);
+uint16_t ble_packer_wrap(struct ble_packer* packer, uint8_t* notification, const uint8_t* record, uint16_t size);
+
+
+#endif /* INC_BLE_PACKER_H_ */
@@ -0,0 +1,79 @@
+/*
+ * @file ble_tx.h
+ * @brief Header file for ble_tx.c.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INC_BLE_TX_H_
+#define INC_BLE_TX_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/ble_packer.h"
+
+
+#define BLE_TX_QUEUE_SIZE						(4)									/* Must be a power of two */
+#define BLE_TX_QUEUE_MASK						(BLE_TX_QUEUE_SIZE - 1)
+
+
+/* Compile time check, the queue indexes are masked with BLE_TX_QUEUE_MASK */
+typedef char ble_tx_queue_size_check[((BLE_TX_QUEUE_SIZE & BLE_TX_QUEUE_MASK) == 0) ? 1 : -1];
+
+
+/* A notification waiting to be accepted by the bluetooth stack */
+struct ble_tx_entry
+{
+	uint16_t size;
+	uint8_t data[BLE_PACKER_NOTIFICATION_MAXSIZE];
+};
+
+
+/* Ring of built notifications. They are handed to the stack in order, and only removed once the stack accepted them.
+ * A notification the stack refuses for lack of buffers stays at the head for as long as it takes, the full ring holds
+ * back the packer and scan_queue in turn, which stalls the parser through scan_queue.stalled */
+struct ble_tx
+{
+	struct ble_tx_entry entry[BLE_TX_QUEUE_SIZE];
+
+	/* Free running indexes, masked with BLE_TX_QUEUE_MASK on access */
+	uint32_t head;
+	uint32_t tail;
+
+	/* Destination of the notifications */
+	uint8_t connection;
+	uint16_t characteristic;
+
+	/* Number of times the stack refused the notification at the head */
+	uint32_t attempts;
+
+	/* The last refusal was bg_err_wrong_state, the client has the item stream disabled and nothing is retried
+	 * until it enables it again */
+	bool client_disabled;
+
+	/* Statistics */
+	uint32_t sent_count;
+	uint32_t sent_bytes;
+	uint32_t retry_count;						/* Submissions refused by the stack and retried later */
+	uint32_t drop_count;						/* Notifications the stack rejected with a hard error, or flushed on disconnect */
+	uint32_t high_water;
+	uint32_t attempts_max;						/* Most refusals of one notification before the stack took it */
+};
+
+
+struct ble_tx ble_tx;							/* Only one instance since there is only one client connection */
+
+
+/* Function Declarations */
+void ble_tx_init(uint8_t connection, uint16_t characteristic);
+void ble_tx_flush(void);
+uint32_t ble_tx_count(void);
+uint8_t* ble_tx_reserve(void);
+void ble_tx_commit(uint16_t size);
+bool ble_tx_submit(void);
+
+
+#endif /* INC_BLE_TX_H_ */
@@ -0,0 +1,119 @@
+/*
+ * @file cart_codec.h
+ * @brief Header file for cart_codec.c.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INC_CART_CODEC_H_
+#define INC_CART_CODEC_H_
+
+#include <stdint.h>
+
+
+/* Binary record format sent on the Item Stream characteristic and read from the Cart Summary and Catalog Sync
+ * characteristics. Every record is a TLV:
+ *
+ * Type			1 byte, CART_TLV_ITEM, CART_TLV_BILL, CART_TLV_SESSION or CART_TLV_CATALOG.
+ * Length		Varint, number of bytes of the value.
+ * Value		Item:	flags (1 byte), product id (varint, only with CART_ITEM_FLAG_ID), price in minor units (varint),
+ * 						quantity (varint, only with CART_ITEM_FLAG_QUANTITY, 1 without it),
+ * 						sequence number (varint, only with CART_ITEM_FLAG_SEQUENCE),
+ * 						product name (remaining bytes, only with CART_ITEM_FLAG_NAME).
+ * 				Bill:	total in minor units (varint), number of items (varint).
+ * 				Session: session id (varint), sequence number of the last item of the session (varint).
+ * 				Catalog: number of products (varint), seed of the catalog image (varint), both 0 without a catalog.
+ *
+ * The product id is the 32 bit FNV-1a hash of the product name (cart_codec_product_id()). An item sent with its name
+ * leaves the id out and the decoder derives it from the name, the id is only sent when the name is not, or when the
+ * name was truncated. The name is only sent when the product enters the cart, the client keeps it with the id.
+ *
+ * Varints are little endian base 128, 7 bits per byte with the top bit set on all bytes but the last.
+ * A decoder skips the types it does not know using the length. New item fields are announced by new flag bits.
+ * The format version is carried in the notification header */
+#define CART_CODEC_VERSION						(2)
+
+#define CART_TLV_ITEM							(0x01)
+#define CART_TLV_BILL							(0x02)
+#define CART_TLV_SESSION						(0x03)
+#define CART_TLV_CATALOG						(0x04)
+
+#define CART_ITEM_FLAG_NAME						(0x01)							/* The product name follows the fixed fields */
+#define CART_ITEM_FLAG_REMOVED					(0x02)							/* The item was taken out of the cart */
+#define CART_ITEM_FLAG_SEQUENCE					(0x04)							/* The sequence number follows the quantity */
+#define CART_ITEM_FLAG_ID						(0x08)							/* The product id follows the flags, set and cleared by the codec only */
+#define CART_ITEM_FLAG_QUANTITY					(0x10)							/* The quantity follows the price, set and cleared by the codec only */
+#define CART_ITEM_FLAG_CODEC					(CART_ITEM_FLAG_ID | CART_ITEM_FLAG_QUANTITY)
+
+#define CART_PRICE_SCALE						(100)							/* Minor units (cents) per unit of the scanned cost */
+#define CART_VARINT_MAXSIZE						(5)								/* Bytes needed for a 32 bit varint */
+#define CART_LENGTH_MAXSIZE						(2)								/* Record values are at most 16383 bytes */
+#define CART_ITEM_HEADER_MAXSIZE				(1 + CART_LENGTH_MAXSIZE + (3 * CART_VARINT_MAXSIZE) + 1 + CART_VARINT_MAXSIZE)
+#define CART_BILL_MAXSIZE						(1 + CART_LENGTH_MAXSIZE + (2 * CART_VARINT_MAXSIZE))
+#define CART_SESSION_MAXSIZE					(1 + CART_LENGTH_MAXSIZE + (2 * CART_VARINT_MAXSIZE))
+#define CART_CATALOG_MAXSIZE					(1 + CART_LENGTH_MAXSIZE + (2 * CART_VARINT_MAXSIZE))
+
+
+/* A cart item. The name is not copied, it points to the payload of the scan */
+struct cart_item
+{
+	uint32_t product_id;
+	uint32_t price;
+	uint32_t quantity;
+	uint8_t flags;
+	uint32_t sequence;
+	const char *name;
+	uint16_t name_size;
+};
+
+
+/* The bill sent when the client asks for it */
+struct cart_bill
+{
+	uint32_t total;
+	uint32_t item_count;
+};
+
+
+/* The cart session announced when the client resumes */
+struct cart_session_info
+{
+	uint32_t id;
+	uint32_t sequence;
+};
+
+
+/* The product catalog of the cart, the phone checks its copy of the catalog against it */
+struct cart_catalog_info
+{
+	uint32_t record_count;
+	uint32_t seed;
+};
+
+
+/* A decoded record */
+struct cart_record
+{
+	uint8_t type;
+	struct cart_item item;
+	struct cart_bill bill;
+	struct cart_session_info session;
+	struct cart_catalog_info catalog;
+};
+
+
+/* Function Declarations */
+uint8_t cart_codec_varint_put(uint8_t* dest, uint32_t value);
+uint8_t cart_codec_varint_get(const uint8_t* src, uint16_t size, uint32_t* value);
+uint32_t cart_codec_product_id(const char* name, uint16_t size);
+uint8_t cart_codec_item_header(uint8_t* dest, const struct cart_item* item);
+uint8_t cart_codec_bill_encode(uint8_t* dest, const struct cart_bill* bill);
+uint8_t cart_codec_session_encode(uint8_t* dest, const struct cart_session_info* session);
+uint8_t cart_codec_catalog_encode(uint8_t* dest, const struct cart_catalog_info* catalog);
+int32_t cart_codec_decode(const uint8_t* src, uint16_t size, struct cart_record* record);
+
+
+#endif /* INC_CART_CODEC_H_ */
@@ -0,0 +1,95 @@
+/*
+ * @file cart_journal.h
+ * @brief Header file for cart_journal.c.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INC_CART_JOURNAL_H_
+#define INC_CART_JOURNAL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/cart_codec.h"
+#include "inc/cart_session.h"
+
+
+#define CART_JOURNAL_ADDRESS					(0x000F0000)						/* Last 64KB of the MX25 flash, right after CATALOG_FLASH_MAXSIZE */
+#define CART_JOURNAL_SECTOR_SIZE				(0x1000)							/* Sector_Offset, the erase unit */
+#define CART_JOURNAL_SECTOR_COUNT				(16)
+#define CART_JOURNAL_PAGE_SIZE					(0x100)								/* Page_Offset, the program unit */
+#define CART_JOURNAL_MAGIC						(0x4C4E4A43)						/* "CJNL" in little endian */
+#define CART_JOURNAL_HEADER_SIZE				(12)								/* Magic, generation and its complement at the start of each sector */
+#define CART_JOURNAL_CRC_SIZE					(2)
+#define CART_JOURNAL_RECORD_MAXSIZE				(CART_ITEM_HEADER_MAXSIZE + CART_SESSION_NAME_MAXSIZE + CART_JOURNAL_CRC_SIZE)
+#define CART_JOURNAL_FLUSH_TICKS				(32768 / 4)							/* Changes made within 250ms are programmed together */
+#define CART_JOURNAL_ERASE_POLL_TICKS			(32768 / 50)						/* A sector erase takes 40ms to 240ms */
+#define CART_JOURNAL_SECTOR_NONE				(0xFF)
+
+
+/* Compile time check, a record never crosses a page */
+typedef char cart_journal_record_size_check[(CART_JOURNAL_RECORD_MAXSIZE <= (CART_JOURNAL_PAGE_SIZE - CART_JOURNAL_HEADER_SIZE)) ? 1 : -1];
+
+
+/* State of the sector after the one being written. It is erased in the background so that the journal can move on
+ * without waiting, unless it still holds the start of the current session */
+enum cart_journal_next
+{
+	CART_JOURNAL_NEXT_DIRTY,
+	CART_JOURNAL_NEXT_ERASING,
+	CART_JOURNAL_NEXT_ERASED
+};
+
+
+/* Append only log of the changes of the cart in a ring of sectors, replayed at boot so that a reset or a brown out
+ * in the middle of shopping does not lose the cart. Each record is a cart_codec record followed by its CRC-16.
+ * Records are gathered in a RAM copy of the current page and programmed together. Erased flash reads 0xFF, which
+ * is not a record type: the rest of a page is skipped on 0xFF or on a bad CRC, and a page starting with 0xFF
+ * ends the sector. An erase cut by a reset leaves random bytes at 0xFF, the complement of the generation keeps such
+ * a sector from passing for the newest one */
+struct cart_journal
+{
+	bool ready;
+	bool replaying;
+	bool full;
+
+	/* Write position: sector of the ring, generation written in its header, page being filled */
+	uint8_t sector;
+	uint32_t generation;
+	uint16_t page_start;
+
+	/* RAM copy of the page, bytes from flushed up to fill are not programmed yet */
+	uint8_t page[CART_JOURNAL_PAGE_SIZE];
+	uint16_t fill;
+	uint16_t flushed;
+
+	/* Sector holding the start of the current session, it must not be erased */
+	uint8_t session_sector;
+	enum cart_journal_next next;
+
+	/* Statistics */
+	uint32_t append_count;
+	uint32_t program_count;
+	uint32_t erase_count;
+	uint32_t drop_count;
+	uint32_t corrupt_count;
+	uint32_t replay_count;
+	uint32_t replay_ticks;
+};
+
+
+struct cart_journal cart_journal;				/* Only one instance since there is only one cart */
+
+
+/* Function Declarations */
+int cart_journal_init(void);
+void cart_journal_session(const struct cart_session_info* session);
+void cart_journal_item(const struct cart_item* item);
+void cart_journal_service(void);
+uint32_t cart_journal_service_ticks(void);
+
+
+#endif /* INC_CART_JOURNAL_H_ */
@@ -0,0 +1,66 @@
+/*
+ * @file cart_ledger.h
+ * @brief Header file for cart_ledger.c.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INC_CART_LEDGER_H_
+#define INC_CART_LEDGER_H_
+
+#include <stdint.h>
+
+
+#define CART_LEDGER_LINES_MAX					(512)								/* Maximum number of different products in the cart */
+#define CART_LEDGER_INDEX_SIZE					(1024)								/* Must be a power of two, at least twice CART_LEDGER_LINES_MAX */
+#define CART_LEDGER_INDEX_MASK					(CART_LEDGER_INDEX_SIZE - 1)
+#define CART_LEDGER_INDEX_EMPTY					(0xFFFF)
+#define CART_LEDGER_QUANTITY_MAX				(UINT16_MAX)						/* Units of one product, a change of more is refused */
+
+
+/* Compile time check, the index is probed with CART_LEDGER_INDEX_MASK and stays at most half full */
+typedef char cart_ledger_index_size_check[(((CART_LEDGER_INDEX_SIZE & CART_LEDGER_INDEX_MASK) == 0) &&
+										   (CART_LEDGER_INDEX_SIZE >= (2 * CART_LEDGER_LINES_MAX))) ? 1 : -1];
+
+
+/* One product of the cart. Amounts are in minor units (cents) */
+struct cart_ledger_line
+{
+	uint32_t product_id;
+	uint32_t price;
+	uint16_t quantity;
+};
+
+
+/* The content of the cart. The lines are kept packed at the start of the array and found through an open
+ * addressing index on the product id, so every operation and the total are O(1) whatever the size of the cart.
+ * About 8 KB of RAM: 512 lines of 12 B and an index of 2 KB */
+struct cart_ledger
+{
+	struct cart_ledger_line line[CART_LEDGER_LINES_MAX];
+	uint16_t line_count;
+
+	/* Position in line[] of each product, linear probing on the product id */
+	uint16_t index[CART_LEDGER_INDEX_SIZE];
+
+	/* Maintained on every operation */
+	uint32_t total;
+	uint32_t item_count;
+};
+
+
+struct cart_ledger cart_ledger;					/* Only one instance since there is only one cart */
+
+
+/* Function Declarations */
+void cart_ledger_init(void);
+const struct cart_ledger_line* cart_ledger_find(uint32_t product_id);
+int cart_ledger_add(uint32_t product_id, uint32_t price, uint16_t quantity);
+int cart_ledger_remove(uint32_t product_id, uint16_t quantity);
+int cart_ledger_void(uint32_t product_id);
+
+
+#endif /* INC_CART_LEDGER_H_ */
@@ -0,0 +1,89 @@
+/*
+ * @file cart_session.h
+ * @brief Header file for cart_session.c.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INC_CART_SESSION_H_
+#define INC_CART_SESSION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/cart_codec.h"
+#include "inc/cart_ledger.h"
+
+
+#define CART_SESSION_LOG_SIZE					(128)								/* Must be a power of two */
+#define CART_SESSION_LOG_MASK					(CART_SESSION_LOG_SIZE - 1)
+#define CART_SESSION_NAME_MAXSIZE				(48)								/* Longer names are resent truncated, the product id still identifies the item */
+
+#define CART_SESSION_CMD_RESUME					('R')								/* Client command: 'R' followed by the last sequence number received, 32 bit little endian */
+#define CART_SESSION_CMD_RESUME_SIZE			(1 + 4)
+#define CART_SESSION_CMD_REMOVE					('X')								/* Client command: 'X' followed by the product id, 32 bit little endian, takes out one unit */
+#define CART_SESSION_CMD_VOID					('V')								/* Client command: 'V' followed by the product id, 32 bit little endian, takes out the whole line */
+#define CART_SESSION_CMD_PRODUCT_SIZE			(1 + 4)
+
+
+/* Compile time check, the log is indexed with CART_SESSION_LOG_MASK */
+typedef char cart_session_log_size_check[((CART_SESSION_LOG_SIZE & CART_SESSION_LOG_MASK) == 0) ? 1 : -1];
+
+
+/* One change of the cart, kept so that it can be sent again after a reconnection. The log takes about 7.5 KB of
+ * RAM, 128 changes of 60 B, next to the 8 KB of cart_ledger */
+struct cart_session_delta
+{
+	uint32_t product_id;
+	uint32_t price;
+	uint16_t quantity;							/* cart_session_append() refuses changes above CART_LEDGER_QUANTITY_MAX */
+	uint8_t flags;
+	uint8_t name_size;
+	char name[CART_SESSION_NAME_MAXSIZE];
+};
+
+
+/* The cart survives disconnections. Every change gets the next sequence number, starting from 1.
+ * When the client reconnects it sends the last sequence number it received and only the changes
+ * after it are sent again. The client applies the changes by sequence number and ignores the ones it already has.
+ * The content and the totals of the cart are kept by cart_ledger */
+struct cart_session
+{
+	/* Delta of sequence number n is stored at index n & CART_SESSION_LOG_MASK */
+	struct cart_session_delta delta[CART_SESSION_LOG_SIZE];
+
+	/* Changes when the cart is emptied, a client with another session id has to resume from 0 */
+	uint32_t id;
+
+	/* Sequence number of the last change */
+	uint32_t sequence;
+
+	/* Next sequence number to send again, resending while it is not above sequence */
+	uint32_t resend_next;
+
+	/* Statistics */
+	uint32_t resume_count;
+	uint32_t resent_count;
+	uint32_t lost_count;						/* Changes requested by the client but already overwritten in the log */
+};
+
+
+struct cart_session cart_session;				/* Only one instance since there is only one cart */
+
+
+/* Function Declarations */
+void cart_session_init(void);
+void cart_session_restore(uint32_t id);
+int cart_session_append(struct cart_item* item);
+int cart_session_remove(uint32_t product_id, bool whole_line, struct cart_item* item);
+void cart_session_defer(uint32_t sequence);
+void cart_session_resume(uint32_t acked);
+bool cart_session_resend_peek(struct cart_item* item);
+void cart_session_resend_done(void);
+bool cart_session_resend_pending(void);
+void cart_session_info_get(struct cart_session_info* info);
+
+
+#endif /* INC_CART_SESSION_H_ */
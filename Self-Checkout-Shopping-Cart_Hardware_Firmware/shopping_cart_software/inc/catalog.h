@@ -0,0 +1,170 @@
+/*
+ * @file catalog.h
+ * @brief Header file for catalog.c. It also describes the catalog image, shared with the catalog compiler
+ * in catalog_tools, so the image layout and the hash functions must only be changed together with CATALOG_VERSION.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INC_CATALOG_H_
+#define INC_CATALOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+#define CATALOG_FLASH_ADDRESS					(0x00000000)						/* Start of the catalog image in the MX25 flash */
+#define CATALOG_FLASH_MAXSIZE					(0x000F0000)						/* The last 64KB of the flash hold the cart journal */
+#define CATALOG_MAGIC							(0x4C544143)						/* "CATL" in little endian */
+#define CATALOG_VERSION							(1)
+#define CATALOG_RECORD_SIZE						(64)
+#define CATALOG_NAME_MAXSIZE					(CATALOG_RECORD_SIZE - 8 - 4 - 4 - 1)
+#define CATALOG_CODE_MAXDIGITS					(14)								/* GTIN-14, also holds EAN-13, UPC-A and EAN-8 */
+#define CATALOG_INDEX_CACHE_SIZE				(512)								/* Catalogs with up to this many buckets keep the index in RAM */
+#ifndef CATALOG_CACHE_BYTES
+#define CATALOG_CACHE_BYTES						(1024)								/* RAM given to the cache of the last products looked up, can be set by the build */
+#endif
+#define CATALOG_CACHE_SIZE						(CATALOG_CACHE_BYTES / (CATALOG_RECORD_SIZE + 8 + 1))	/* Record, code and referenced bit */
+
+
+/* Catalog image, all fields little endian:
+ *
+ * header			struct catalog_header at CATALOG_FLASH_ADDRESS
+ * index			bucket_count displacements of 16 bit at index_offset
+ * records			record_count struct catalog_record at record_offset
+ *
+ * The index is a minimal perfect hash of the product codes (hash and displace). The code is hashed once,
+ * the hash selects a bucket and the displacement of the bucket selects the record, so a lookup reads one
+ * displacement and one record. A code that is not in the catalog still lands on a record and is detected
+ * by comparing the code stored in the record */
+struct catalog_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t record_size;
+	uint32_t record_count;
+	uint32_t bucket_count;
+	uint32_t seed;
+	uint32_t index_offset;							/* From the start of the image */
+	uint32_t record_offset;							/* From the start of the image */
+	uint32_t image_size;
+};
+
+
+/* One product, fixed size so that the record of a slot is found without reading the others */
+struct catalog_record
+{
+	uint64_t code;
+	uint32_t product_id;
+	uint32_t price;									/* In minor units, see CART_PRICE_SCALE */
+	uint8_t name_size;
+	char name[CATALOG_NAME_MAXSIZE];
+};
+
+
+/* Compile time checks, the image layout is shared with the catalog compiler */
+typedef char catalog_record_size_check[(sizeof(struct catalog_record) == CATALOG_RECORD_SIZE) ? 1 : -1];
+typedef char catalog_header_size_check[(sizeof(struct catalog_header) == (9 * 4)) ? 1 : -1];
+
+/* Compile time check, the cache holds at least one product */
+typedef char catalog_cache_size_check[(CATALOG_CACHE_SIZE > 0) ? 1 : -1];
+
+
+/* Products looked up recently, popular products are scanned again and again in a store. The replacement
+ * is CLOCK: a hit sets the referenced bit, the hand skips and clears referenced entries and replaces the first
+ * entry that was not used since the last pass */
+struct catalog_cache
+{
+	/* The codes are kept apart from the records so that a lookup only scans them */
+	uint64_t code[CATALOG_CACHE_SIZE];
+	struct catalog_record record[CATALOG_CACHE_SIZE];
+	bool referenced[CATALOG_CACHE_SIZE];
+	uint16_t count;
+	uint16_t hand;
+
+	/* Statistics */
+	uint32_t hit_count;
+	uint32_t miss_count;
+};
+
+
+struct catalog
+{
+	struct catalog_header header;
+	bool ready;
+
+	/* Copy of the index when it is small enough, a lookup then reads only the record */
+	uint16_t index_cache[CATALOG_INDEX_CACHE_SIZE];
+	bool index_cached;
+
+	struct catalog_cache cache;
+
+	/* Statistics */
+	uint32_t lookup_count;
+	uint32_t miss_count;
+	uint32_t read_count;
+	uint32_t lookup_ticks_max;						/* Longest lookup in RTCC ticks */
+};
+
+
+struct catalog catalog;							/* Only one instance since there is only one external flash */
+
+
+/**
+ * @brief This function mixes a product code with the seed of the catalog (splitmix64 finalizer).
+ * @param uint64_t code The product code
+ * @param uint32_t seed The seed of the catalog
+ * @return The 64 bit hash, the bucket and the slot are taken from it.
+ */
+static inline uint64_t catalog_hash(uint64_t code, uint32_t seed)
+{
+	uint64_t hash = code ^ (((uint64_t)seed << 32) | seed);
+
+	hash ^= hash >> 30;
+	hash *= 0xBF58476D1CE4E5B9ull;
+	hash ^= hash >> 27;
+	hash *= 0x94D049BB133111EBull;
+	hash ^= hash >> 31;
+
+	return hash;
+}
+
+
+/**
+ * @brief This function returns the bucket of a hash.
+ * @param uint64_t hash The hash of the code
+ * @param uint32_t bucket_count Number of buckets of the catalog
+ * @return The bucket.
+ */
+static inline uint32_t catalog_bucket(uint64_t hash, uint32_t bucket_count)
+{
+	return (uint32_t)(hash >> 32) % bucket_count;
+}
+
+
+/**
+ * @brief This function returns the record slot of a hash for a displacement. The high byte of the displacement
+ * moves the codes of the bucket by different steps and the low byte by the same offset.
+ * @param uint64_t hash The hash of the code
+ * @param uint16_t displacement The displacement of the bucket of the code
+ * @param uint32_t record_count Number of records of the catalog
+ * @return The slot.
+ */
+static inline uint32_t catalog_slot(uint64_t hash, uint16_t displacement, uint32_t record_count)
+{
+	uint32_t first = (uint32_t)hash % record_count;
+	uint32_t step = (uint32_t)(hash >> 12) % record_count;
+
+	return (uint32_t)(((uint64_t)first + ((uint64_t)(displacement >> 8) * step) + (displacement & 0xFF)) % record_count);
+}
+
+
+/* Function Declarations */
+int catalog_init(void);
+int catalog_lookup(uint64_t code, struct catalog_record* record);
+
+
+#endif /* INC_CATALOG_H_ */
@@ -0,0 +1,64 @@
+/*
+ * @file conn_policy.h
+ * @brief Header file for conn_policy.c.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INC_CONN_POLICY_H_
+#define INC_CONN_POLICY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/* Connection parameter sets, see connection_param.h */
+enum conn_policy_mode
+{
+	CONN_POLICY_ACTIVE,
+	CONN_POLICY_IDLE
+};
+
+
+struct conn_policy
+{
+	uint8_t connection;
+
+	/* Mode wanted by the application and mode of the request waiting for the gecko_evt_le_connection_parameters_id feedback */
+	enum conn_policy_mode mode;
+	enum conn_policy_mode requested_mode;
+	bool request_pending;
+	uint32_t request_timestamp;					/* RTCC counter value when the pending request was sent */
+	uint8_t retries;							/* Requests of the mode sent again after a timeout */
+
+	/* Parameters in use, as reported by the stack */
+	uint16_t interval;
+	uint16_t latency;
+	uint16_t timeout;
+
+	/* Statistics */
+	uint32_t active_count;						/* Switches to the active parameters */
+	uint32_t idle_count;						/* Switches to the idle parameters */
+	uint32_t update_count;						/* Parameter updates reported by the stack */
+	uint32_t timeout_count;						/* Requests the central rejected or ignored */
+	uint32_t give_up_count;						/* Modes given up after CON_REQUEST_RETRIES timeouts */
+};
+
+
+struct conn_policy conn_policy;					/* Only one instance since there is only one client connection */
+
+
+/* Function Declarations */
+void conn_policy_init(uint8_t connection);
+void conn_policy_activity(void);
+void conn_policy_quiet(void);
+void conn_policy_parameters(uint16_t interval, uint16_t latency, uint16_t timeout);
+uint32_t conn_policy_request_ticks(void);
+void conn_policy_request_timeout(void);
+uint32_t conn_policy_interval_ticks(void);
+
+
+#endif /* INC_CONN_POLICY_H_ */
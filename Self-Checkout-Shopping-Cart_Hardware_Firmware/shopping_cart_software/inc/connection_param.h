@@ -12,18 +12,41 @@
 #define INC_CONNECTION_PARAM_H_
 
 
-/* Macros for Connection Setup */
+/* Macros for Connection Setup, advertising intervals in units of 0.625 ms */
 #define ADV_HANDLE					(0)
-#define ADV_INTERVAL_MIN			(400)
-#define ADV_INTERVAL_MAX			(400)
+#define ADV_INTERVAL_MIN			(1600)					/* Low power interval the backoff ends at, 1 s */
+#define ADV_INTERVAL_MAX			(1600)
 #define ADV_TIMING_DURATION			(0)
 #define ADV_MAXEVENTS				(0)
 
-
-#define CON_INTERVAL_MIN			(60)
-#define CON_INTERVAL_MAX			(60)
-#define CON_LATENCY					(3)
-#define CON_TIMEOUT					(400)
+/* Advertising after an NFC tap. The phone that just tapped is scanning, a burst at the shortest connectable interval
+ * lets it connect within a few advertising events. The interval then doubles every step up to ADV_INTERVAL_MAX */
+#define ADV_BURST_INTERVAL			(32)					/* 20 ms */
+#define ADV_BURST_MS				(2000)
+#define ADV_BACKOFF_STEP_MS			(2000)
+
+
+/* Connection parameters, interval in units of 1.25 ms and timeout in units of 10 ms. Both sets stay within the limits
+ * iOS accepts: the minimum interval is a multiple of 15 ms and at least 15 ms, the maximum at least 15 ms above it,
+ * interval max x (latency + 1) is at most 2 s, the timeout is at most 6 s and strictly greater than 3 times
+ * interval max x (latency + 1) */
+
+/* While the shopper is scanning, 15 to 30 ms */
+#define CON_ACTIVE_INTERVAL_MIN		(12)
+#define CON_ACTIVE_INTERVAL_MAX		(24)
+#define CON_ACTIVE_LATENCY			(0)
+#define CON_ACTIVE_TIMEOUT			(400)
+
+/* While the cart is idle, 360 to 400 ms with 3 skipped events, 1.6 s between listens and 4.8 s x 3 below the 6 s
+ * timeout. A 2 s product would need a timeout above the 6 s limit */
+#define CON_IDLE_INTERVAL_MIN		(288)
+#define CON_IDLE_INTERVAL_MAX		(320)
+#define CON_IDLE_LATENCY			(3)
+#define CON_IDLE_TIMEOUT			(600)
+
+#define CON_QUIET_PERIOD_S			(10)					/* Seconds without scans before switching to the idle parameters */
+#define CON_REQUEST_TIMEOUT_S		(10)					/* Seconds without feedback before a request is taken as rejected */
+#define CON_REQUEST_RETRIES			(2)						/* Requests sent again for a mode before giving up on it */
 
 #define SECURITY_CONFIGURE_FLAG		(0x00)
 
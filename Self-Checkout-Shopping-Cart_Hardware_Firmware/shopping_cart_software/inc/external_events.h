@@ -15,6 +15,10 @@
 /* Event Bits assigned to different Signal Events */
 #define EVENT_LEUART						(0x01)
 #define EVENT_NFC_GPIO						(0x02)
+#define EVENT_SCAN_READY					(0x04)
+#define EVENT_FLASH							(0x08)
+#define EVENT_I2C							(0x10)
+#define EVENT_NFC							(0x20)
 
 
 /* Global Variable for Event Status */
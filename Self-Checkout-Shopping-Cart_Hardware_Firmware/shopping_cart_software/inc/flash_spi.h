@@ -0,0 +1,87 @@
+/*
+ * @file flash_spi.h
+ * @brief Header file for flash_spi.c.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INC_FLASH_SPI_H_
+#define INC_FLASH_SPI_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+#define FLASH_SPI_BAUDRATE						(8000000)							/* READ (03h) is specified up to 33MHz in ultra low power mode,
+																					   the deep power down timings of mx25flash_spi.c assume 8Mbps */
+#define FLASH_SPI_RX_LDMA_CHANNEL				(1)									/* LDMA channel 0 is used for LEUART0 RX */
+#define FLASH_SPI_TX_LDMA_CHANNEL				(2)
+#define FLASH_SPI_LDMA_MAXSIZE					(2048)								/* Largest transfer of one LDMA descriptor */
+#define FLASH_SPI_TIMEOUT_US					(1000)								/* Margin of a blocking read over its transfer time */
+#define FLASH_SPI_ERASE_POLL_MS					(2)									/* A sector erase takes 40ms to 240ms */
+#define FLASH_SPI_ERASE_TIMEOUT_MS				(400)								/* tSE is 240ms at most */
+#define FLASH_SPI_SUSPEND_TIMEOUT_US			(100)								/* tESL is 20us at most */
+
+
+/* Called from the bluetooth event loop once an asynchronous read is over, status is 0 on success and -1 on error */
+typedef void (*flash_spi_callback)(int status, void* context);
+
+
+/* Bulk reads of the MX25 flash. The command and the address are sent byte by byte, then the data is clocked
+ * in by two LDMA channels, one writing dummy bytes to the USART and one storing the received bytes.
+ * Only one read at a time */
+struct flash_spi
+{
+	volatile bool busy;
+	volatile int status;
+
+	/* Rest of the current read, moved forward on every LDMA transfer */
+	uint8_t *data;
+	uint32_t remaining;
+	uint32_t transfer_size;
+
+	/* Caller of an asynchronous read, NULL for a blocking read */
+	flash_spi_callback callback;
+	void *context;
+	volatile bool complete;
+
+	/* A sector erase runs in the background, reads suspend it and resume it when they are over */
+	bool erasing;
+	volatile bool suspended;
+
+	/* Deep power down, entered once the flash is idle */
+	bool asleep;
+	bool sleep_requested;
+
+	/* Statistics */
+	uint32_t read_count;
+	uint32_t byte_count;
+	uint32_t error_count;
+	uint32_t program_count;
+	uint32_t erase_count;
+	uint32_t suspend_count;
+};
+
+
+struct flash_spi flash_spi;						/* Only one instance since there is only one external flash */
+
+
+/* Function Declarations */
+void flash_spi_init(void);
+void flash_spi_wake(void);
+void flash_spi_sleep(void);
+int flash_spi_read(uint32_t address, void* data, uint32_t size);
+int flash_spi_read_async(uint32_t address, void* data, uint32_t size, flash_spi_callback callback, void* context);
+bool flash_spi_busy(void);
+void flash_spi_complete(void);
+void flash_spi_ldma_irq(uint32_t flags);
+int flash_spi_program(uint32_t address, const void* data, uint32_t size);
+int flash_spi_erase_start(uint32_t address);
+bool flash_spi_erase_busy(void);
+int flash_spi_erase_wait(void);
+
+
+#endif /* INC_FLASH_SPI_H_ */
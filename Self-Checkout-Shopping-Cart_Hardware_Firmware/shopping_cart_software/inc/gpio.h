@@ -16,7 +16,7 @@
 /* Macros */
 #define GPIO_NFC_PORT							(gpioPortC)
 #define GPIO_NFC_PIN							(9)								/* Pin number 10 */
-#define GPIO_RISING_EDGE						(false)
+#define GPIO_RISING_EDGE						(true)							/* FD is released at the end of a tap */
 #define GPIO_FALLING_EDGE						(true)
 #define GPIO_INTERRUPT_ENABLE					(true)
 #define GPIO_NFC_INTERRUPT_FLAG					(0x01 << GPIO_NFC_PIN)			/*FD Pin interrupt*/
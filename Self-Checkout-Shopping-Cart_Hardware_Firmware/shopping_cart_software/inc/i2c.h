@@ -13,11 +13,31 @@
 #define INC_I2C_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 
 
 #define NXP_NTAG_R (0x05) 										//NXP NTAG NFC Read Command
 #define NXP_NTAG_W (0x04) 										//NXP NTAG NFC Write Command
+#define NXP_NTAG_BLOCK_SIZE				(16)					/* The NTAG memory is read and written by blocks of 16 bytes */
+#define NXP_NTAG_SESSION_MEMA			(0xFE)					/* Memory address byte selecting the session registers */
+#define NXP_NTAG_SRAM_BLOCK				(0xF8)					/* 64 bytes of SRAM, 4 blocks, lost without VCC */
+#define NXP_NTAG_SRAM_BLOCKS			(4)
+
+/* Session registers, reloaded from the configuration registers at power on */
+#define NXP_NTAG_REG_NC					(0x00)
+#define NXP_NTAG_REG_LAST_NDEF_BLOCK	(0x01)					/* Block holding the end of the NDEF message */
+#define NXP_NTAG_REG_SRAM_MIRROR_BLOCK	(0x02)					/* Block of the user memory the SRAM shows up at on the NFC side */
+#define NXP_NTAG_REG_NS					(0x06)
+#define NXP_NTAG_NC_SRAM_MIRROR			(0x02)
+#define NXP_NTAG_NC_FD_ON_MASK			(0x0C)
+#define NXP_NTAG_NC_FD_ON_FIELD			(0x00)					/* FD pulled low when the field comes on */
+#define NXP_NTAG_NC_FD_OFF_MASK			(0x30)
+#define NXP_NTAG_NC_FD_OFF_NDEF_READ	(0x20)					/* FD released when the field goes off or LAST_NDEF_BLOCK is read */
+#define NXP_NTAG_NS_RF_FIELD_PRESENT	(0x01)
+#define NXP_NTAG_NS_SRAM_I2C_READY		(0x10)					/* The NFC side wrote the SRAM, pass-through mode only */
+#define NXP_NTAG_NS_I2C_LOCKED			(0x40)					/* Set by an I2C access to the SRAM, the NFC side waits until it is cleared */
+#define NXP_NTAG_NS_NDEF_DATA_READ		(0x80)					/* LAST_NDEF_BLOCK was read, cleared by reading NS_REG */
 
 
 /* SCL and SDA pins for I2C*/
@@ -27,21 +47,97 @@
 #define SDA_PIN							(11)
 
 
-/*Global Variables*/
-volatile uint8_t interrupt_flag_ack;
-uint8_t read[16];
-uint8_t write[16];
+#define I2C_TX_MAXSIZE					(1 + NXP_NTAG_BLOCK_SIZE)	/* Memory address byte and one block */
+#define I2C_ADDRESS_RETRIES				(64)					/* The NTAG does not acknowledge its address for up to 4.5ms
+																   while it programs its EEPROM, a retry takes about 110us */
+
+
+/* Result of a transfer */
+enum i2c_status
+{
+	I2C_STATUS_DONE,
+	I2C_STATUS_BUSY,
+	I2C_STATUS_NACK,										/* Address not acknowledged after all the retries, or data not acknowledged */
+	I2C_STATUS_ARBLOST,
+	I2C_STATUS_BUSERR,
+	I2C_STATUS_TIMEOUT										/* SCL held low for 1024 prescaled clock cycles */
+};
+
+
+/* Step of the transfer run by I2C0_IRQHandler() */
+enum i2c_state
+{
+	I2C_STATE_IDLE,
+	I2C_STATE_WRITE_ADDRESS,
+	I2C_STATE_WRITE_DATA,
+	I2C_STATE_WRITE_STOP,
+	I2C_STATE_READ_ADDRESS,
+	I2C_STATE_READ_DATA,
+	I2C_STATE_READ_STOP,
+	I2C_STATE_RETRY_STOP,									/* Address not acknowledged, the phase starts again after the STOP */
+	I2C_STATE_FAIL_STOP										/* The transfer ends with an error after the STOP */
+};
+
+
+struct i2c_transfer;
+
+
+/* Called from the bluetooth event loop once a transfer is over */
+typedef void (*i2c_callback)(struct i2c_transfer* transfer);
+
+
+/* Transfer descriptor, owned by the caller until the callback. The bytes of tx are written after the write address,
+ * then if rx_size is not 0 the bytes of rx are read after a STOP and the read address. The NTAG needs the STOP,
+ * it does not take a repeated START */
+struct i2c_transfer
+{
+	uint8_t address;										/* 8 bit write address of the slave */
+	uint8_t tx[I2C_TX_MAXSIZE];
+	uint8_t tx_size;
+	uint8_t *rx;
+	uint8_t rx_size;
+
+	i2c_callback callback;
+	void *context;
+	volatile enum i2c_status status;
+	struct i2c_transfer *next;								/* Queued behind the running transfer */
+};
+
+
+/* Interrupt driven I2C0 master, one transfer at a time. Completion is handed to the bluetooth event loop through
+ * EVENT_I2C and i2c_complete(). Transfers queued while the bus is taken start in order once it is free */
+struct i2c_engine
+{
+	struct i2c_transfer *transfer;
+	struct i2c_transfer *queue_head;
+	struct i2c_transfer *queue_tail;
+	volatile enum i2c_state state;
+	volatile bool complete;
+	uint8_t index;
+	uint8_t retries;
+
+	/* Statistics */
+	uint32_t transfer_count;
+	uint32_t queue_count;									/* Transfers that had to wait for the bus */
+	uint32_t retry_count;
+	uint32_t error_count;
+};
+
+
+struct i2c_engine i2c_engine;							/* Only one instance since there is only one I2C0 */
 
 
 /*Function Declarations*/
 void i2c_init(void);
-void i2c_write_poll(uint8_t add,uint8_t *data);
 void i2c_disable(void);
-uint8_t* i2c_read_poll(uint8_t register_address);
-uint8_t i2c_read_session_poll(uint8_t session_register);
-void i2c_test_blocking(void);
-uint8_t* nxp_ntag_nfc_read(uint8_t *arr, uint8_t row);
-void nxp_ntag_nfc_write(uint8_t *arr, uint8_t row);
+int i2c_transfer_start(struct i2c_transfer* transfer);
+int i2c_transfer_queue(struct i2c_transfer* transfer);
+bool i2c_busy(void);
+void i2c_complete(void);
+void i2c_ntag_block_write(struct i2c_transfer* transfer, uint8_t block, const uint8_t* data);
+void i2c_ntag_block_read(struct i2c_transfer* transfer, uint8_t block, uint8_t* data);
+void i2c_ntag_register_read(struct i2c_transfer* transfer, uint8_t reg, uint8_t* data);
+void i2c_ntag_register_write(struct i2c_transfer* transfer, uint8_t reg, uint8_t mask, uint8_t value);
 
 
 #endif /* INC_I2C_H_ */
@@ -0,0 +1,92 @@
+/*
+ * @file kv_store.h
+ * @brief Header file for kv_store.c.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INC_KV_STORE_H_
+#define INC_KV_STORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_device.h"
+
+
+#define KV_STORE_PAGE_COUNT					(8)									/* Must match __kvstoreSize in efr32bg13p632f512gm48.ld */
+#define KV_STORE_MAGIC						(0x3153564B)						/* "KVS1" in little endian */
+#define KV_STORE_HEADER_WORDS				(4)									/* Magic, erase count, generation and its complement */
+#define KV_STORE_VALUE_MAXSIZE				(16)
+#define KV_STORE_RECORD_MAXSIZE				(4 + KV_STORE_VALUE_MAXSIZE)		/* Header word and value padded to a word */
+#define KV_STORE_RECORD_OPEN				(0x80)								/* Bit of the size, cleared once the value is written */
+#define KV_STORE_FLUSH_TICKS				(32768 * 10)						/* Settings changed within 10s are written together */
+#define KV_STORE_BLANK						(0xFFFFFFFF)
+
+
+/* Keys of the store. The values of a key keep their meaning across firmware updates, new keys go at the end */
+enum kv_key
+{
+	KV_KEY_CART_ID,								/* Last cart session id given out, uint32_t */
+	KV_KEY_BOOT_COUNT,							/* Lifetime number of boots, uint32_t */
+	KV_KEY_SCAN_COUNT,							/* Lifetime number of items added by a scan, uint32_t */
+	KV_KEY_COUNT
+};
+
+
+/* Compile time check, all the values fit in a page next to its header */
+typedef char kv_store_page_check[((KV_KEY_COUNT * KV_STORE_RECORD_MAXSIZE) <= (FLASH_PAGE_SIZE - (KV_STORE_HEADER_WORDS * 4))) ? 1 : -1];
+
+
+/* Small key/value store in a ring of internal flash pages reserved by the linker script, right below the
+ * NVM section of the bluetooth stack. Only one page is in use at a time. Records are appended to it, and when
+ * it is full the current values are copied to the next page of the ring and the old page is erased, so that
+ * every page is erased in turn. Every value is kept in RAM, a read never touches the flash.
+ *
+ * Each record is a header word {key, size, CRC-16 of key, size and value} followed by the value padded to a word.
+ * A flush writes its records open, then writes each header a second time to clear KV_STORE_RECORD_OPEN, so that
+ * a record cut by a reset is never read back even when its CRC happens to match. A page is valid once its magic
+ * is written, after its records. An erase cut by a reset leaves random bits set, the complement of the generation
+ * keeps such a page from passing for the newest one. The erase count in the header is written right after the
+ * erase, in 16 bits next to its complement, far above the 10000 erases the flash is rated for */
+struct kv_store
+{
+	bool ready;
+
+	/* Page in use, its generation and the offset of the first blank word */
+	uint8_t page;
+	uint32_t generation;
+	uint16_t offset;
+
+	/* Current values and the keys changed since the last write */
+	uint8_t value[KV_KEY_COUNT][KV_STORE_VALUE_MAXSIZE];
+	uint8_t size[KV_KEY_COUNT];
+	uint32_t dirty;
+
+	/* The tail of the page could not be read back, the next write moves to a new page */
+	bool compact_pending;
+
+	/* Statistics */
+	uint32_t erase_count[KV_STORE_PAGE_COUNT];
+	uint32_t write_count;
+	uint32_t compact_count;
+	uint32_t corrupt_count;
+};
+
+
+struct kv_store kv_store;						/* Only one instance since there is only one store */
+
+
+/* Function Declarations */
+int kv_store_init(void);
+int kv_store_get(enum kv_key key, void* data, uint8_t size);
+int kv_store_set(enum kv_key key, const void* data, uint8_t size);
+uint32_t kv_store_get_u32(enum kv_key key, uint32_t value);
+int kv_store_set_u32(enum kv_key key, uint32_t value);
+int kv_store_flush(void);
+bool kv_store_dirty(void);
+
+
+#endif /* INC_KV_STORE_H_ */
@@ -20,33 +20,58 @@
 #define LEUART_RX_PIN							(11)								/* RX (Pin Number 9) */
 
 
-#define LEUART_BUFFER_MAXSIZE					(512)
-#define LEUART_BUFFER_INTERRUPT_SIZE			(10)
+#define LEUART_BUFFER_MAXSIZE					(512)								/* Must be a power of two */
+#define LEUART_BUFFER_MASK						(LEUART_BUFFER_MAXSIZE - 1)
 #define LEUART_INTERRUPT_TIMER					(1)
 
 
+/* Receive path selection. With LEUART_RX_LDMA the LDMA fills the two halves of leuart_circbuff.buffer
+ * in hardware and the CPU only wakes up on a half/full transfer or at the end of a barcode frame.
+ * Comment this line, or define LEUART_RX_INTERRUPT, to use the per byte RXDATAV interrupt path instead */
+#ifndef LEUART_RX_INTERRUPT
+#define LEUART_RX_LDMA							(1)
+#endif
+#define LEUART_RX_LDMA_CHANNEL					(0)										/* LDMA channel used for LEUART0 RX */
+#define LEUART_RX_LDMA_HALF_SIZE				(LEUART_BUFFER_MAXSIZE / 2)				/* Ping-pong buffer size, one descriptor per half */
+#define LEUART_RX_LDMA_DRAIN_POLLS				(32)									/* Polls of RXDATAV for the postamble after the signal frame */
+
+
+/* Compile time check, the ring indexes are masked with LEUART_BUFFER_MASK instead of being wrapped with a branch */
+typedef char leuart_buffer_size_check[((LEUART_BUFFER_MAXSIZE & LEUART_BUFFER_MASK) == 0) ? 1 : -1];
+
+
 /* Variable Declaration */
+/* Single producer (LEUART0 interrupt or LDMA) / single consumer (bluetooth event loop) ring buffer.
+ * head and tail are free running counters, each one written by only one side, so neither side
+ * needs to disable interrupts. The number of stored bytes is always head - tail. */
 struct leuart_circbuff
 {
 	/* A circular buffer of size 512 bytes to store the contents of the data received from the UART register*/
 	char buffer[LEUART_BUFFER_MAXSIZE];
 
-	/*The write index for the circular buffer*/
-	uint32_t write_index;
+	/* Total number of bytes written into the buffer. Only written by the producer */
+	volatile uint32_t head;
 
-	/*The read index for the circular buffer*/
-	uint32_t read_index;
+	/* Total number of bytes read from the buffer. Only written by the consumer */
+	volatile uint32_t tail;
 
-	/*The current number of elements is stored here*/
-	volatile uint32_t buffer_count;
+	/* Number of complete barcode frames (postamble signal frames) received. Only written by the producer */
+	volatile uint32_t frame_count;
 
-	/* The buffer count value in order to trigger the gecko_evt_system_external_signal_id event
-	   The event would be triggered when buffer_interrupt_count == BUFFER_INTERRUPT_SIZE */
-	volatile uint32_t buffer_interrupt_count;
+	/* Number of times the bluetooth event loop was woken up to read the buffer. Only written by the consumer.
+	   frame_count / wakeup_count gives the frames handled per wakeup */
+	uint32_t wakeup_count;
 
-	/*This variable is set true after every BUFFER_INTERRUPT_SIZE bytes are received.
-	  If this flag is true the control would be transferred to gecko_evt_system_external_signal_id event */
-	volatile bool buffer_interrupt_flag;
+	/* Number of received bytes lost because the buffer was not drained in time */
+	volatile uint32_t overrun_count;
+
+	/* Set by the producer when the LDMA channel stopped on a transfer error. The consumer discards the
+	   buffer and restarts the channel, head and tail are only reset while the channel is stopped */
+	volatile bool resync;
+	uint32_t resync_count;
+
+	/* Number of signal frames handled before the LDMA had moved the postamble. Only written by the producer */
+	volatile uint32_t drain_timeout_count;
 };
 
 
@@ -59,34 +84,14 @@ void leuart_init(void);
 void leuart_buffer_push(void);
 char leuart_buffer_pop(void);
 bool leuart_buffer_empty_status(void);
+uint32_t leuart_buffer_count(void);
+uint32_t leuart_buffer_peek(uint32_t offset, const char **data);
+void leuart_buffer_consume(uint32_t count);
 void leuart_disable(void);
 void leuart_loopback_test_blocking(void);
 void leuart_loopback_test_non_blocking(void);
 
 
-/**
- * @brief This function increments the read or write index of the circular buffer based on the
- * maximum size of the circular buffer.
- * @note This function might lead to overwriting of the previous data on index rollover.
- * Developer must make sure to read the old data as soon as possible.
- * @param The read or write index value of the circular buffer
- * @return void
- */
-static inline uint32_t leuart_circbuff_index_increment(uint32_t index)
-{
-	if(index == LEUART_BUFFER_MAXSIZE - 1)
-	{
-		index = 0;
-	}
-	else
-	{
-		index++;
-	}
-
-	return index;
-}
-
-
 
 /**
  * @brief Function to send data using LEUART peripheral.
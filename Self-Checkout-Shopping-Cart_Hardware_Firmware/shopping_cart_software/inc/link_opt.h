@@ -0,0 +1,58 @@
+/*
+ * @file link_opt.h
+ * @brief Header file for link_opt.c.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INC_LINK_OPT_H_
+#define INC_LINK_OPT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/* Throughput benchmark. Once the client enables notifications a synthetic basket of LINK_BENCHMARK_ITEMS
+ * scans is streamed through the scan queue, the packer and the transmit queue, and the throughput is printed.
+ * Uncomment this line to build the benchmark firmware */
+//#define LINK_BENCHMARK							(1)
+#define LINK_BENCHMARK_ITEMS					(200)
+
+
+/* Link configuration negotiated with the client */
+struct link_opt
+{
+	uint8_t connection;
+
+	/* PHY in use, le_gap_phy_1m or le_gap_phy_2m */
+	uint8_t phy;
+
+	/* Link layer payload size after the data length update, 27 bytes without DLE */
+	uint16_t txsize;
+
+	/* ATT MTU */
+	uint16_t mtu;
+
+	/* Set when the 2M PHY request was refused by the stack or the client */
+	bool fallback;
+};
+
+
+struct link_opt link_opt;						/* Only one instance since there is only one client connection */
+
+
+/* Function Declarations */
+void link_opt_init(uint8_t connection);
+void link_opt_phy(uint8_t phy);
+void link_opt_txsize(uint16_t txsize);
+void link_opt_mtu(uint16_t mtu);
+#ifdef LINK_BENCHMARK
+void link_benchmark_start(void);
+void link_benchmark_run(void);
+#endif
+
+
+#endif /* INC_LINK_OPT_H_ */
@@ -0,0 +1,88 @@
+/*
+ * @file ndef.h
+ * @brief Header file for ndef.c.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INC_NDEF_H_
+#define INC_NDEF_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/i2c.h"
+
+
+#define NDEF_TAG_FIRST_BLOCK				(0x01)								/* Block 0 holds the I2C address, serial number and CC of the NTAG */
+#define NDEF_BLE_OOB_BLOCKS					(4)
+#define NDEF_BLE_OOB_SIZE					(NDEF_BLE_OOB_BLOCKS * NXP_NTAG_BLOCK_SIZE)
+#define NDEF_BLE_ADDRESS_SIZE				(6)
+#define NDEF_TOKEN_NONCE_SIZE				(4)
+#define NDEF_TOKEN_SIZE						(4 + NDEF_TOKEN_NONCE_SIZE)		/* Cart session id and a nonce drawn on every tap */
+#define NDEF_SCAN_RESPONSE_MAXSIZE			(31)
+
+
+typedef char ndef_sram_size_check[(NDEF_BLE_OOB_BLOCKS <= NXP_NTAG_SRAM_BLOCKS) ? 1 : -1];
+
+
+/* Step of the tag update run on EVENT_I2C */
+enum ndef_tag_step
+{
+	NDEF_TAG_IDLE,
+	NDEF_TAG_EEPROM_READ,												/* Reading back a block of the EEPROM record */
+	NDEF_TAG_EEPROM_WRITE,
+	NDEF_TAG_SRAM_WRITE,												/* Writing a block of the session record */
+	NDEF_TAG_MIRROR_BLOCK,
+	NDEF_TAG_LAST_BLOCK,
+	NDEF_TAG_MIRROR_ON,
+	NDEF_TAG_UNLOCK														/* Handing the SRAM over to the NFC side */
+};
+
+
+/* Bluetooth LE out of band pairing record read by the phone when the cart is tapped. The records are templates in
+ * flash, only the address and the token are filled in.
+ * The EEPROM holds a record with the address and the name, read when the cart is not powered. It is read back block
+ * by block at boot and a block is only written when it differs.
+ * While the cart is powered, the SRAM is mirrored over the same blocks and holds a record with the address and a
+ * session token. Writing it takes no EEPROM programming, so it is written again with a fresh token on every field
+ * detect, and once the cart session changes */
+struct ndef_tag
+{
+	uint8_t image[NDEF_BLE_OOB_SIZE];									/* Content the EEPROM should have */
+	uint8_t session[NDEF_BLE_OOB_SIZE];									/* Content of the SRAM */
+	uint8_t block[NXP_NTAG_BLOCK_SIZE];									/* Block read back from the tag */
+	uint8_t address[NDEF_BLE_ADDRESS_SIZE];
+	uint8_t token[NDEF_TOKEN_SIZE];
+	uint8_t index;
+	enum ndef_tag_step step;
+	bool ready;															/* The address is known */
+	bool mirror;														/* The SRAM is mirrored over the EEPROM record, FD is set up */
+	bool publish_pending;
+	uint32_t publish_start;
+	struct i2c_transfer transfer;
+
+	/* Statistics */
+	uint32_t write_count;
+	uint32_t skip_count;
+	uint32_t publish_count;
+	uint32_t publish_ticks_max;											/* From the request to the SRAM handed over to the NFC side */
+	uint32_t error_count;
+};
+
+
+struct ndef_tag ndef_tag;						/* Only one instance since there is only one NFC tag */
+
+
+/* Function Declarations */
+void ndef_ble_oob_build(uint8_t *image, const uint8_t *address);
+void ndef_ble_oob_session_build(uint8_t *image, const uint8_t *address, const uint8_t *token);
+int ndef_tag_update(const uint8_t *address);
+void ndef_tag_publish(uint32_t session_id, const uint8_t *nonce);
+bool ndef_tag_configured(uint8_t nc);
+uint8_t ndef_scan_response_build(uint8_t *data);
+
+
+#endif /* INC_NDEF_H_ */
@@ -0,0 +1,84 @@
+/*
+ * @file nfc_event.h
+ * @brief Header file for nfc_event.c.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INC_NFC_EVENT_H_
+#define INC_NFC_EVENT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/i2c.h"
+
+
+#define NFC_EVENT_QUEUE_SIZE					(8)									/* Must be a power of two */
+#define NFC_EVENT_QUEUE_MASK					(NFC_EVENT_QUEUE_SIZE - 1)
+
+
+/* Compile time check, the queue indexes are masked with NFC_EVENT_QUEUE_MASK */
+typedef char nfc_event_queue_size_check[((NFC_EVENT_QUEUE_SIZE & NFC_EVENT_QUEUE_MASK) == 0) ? 1 : -1];
+
+
+/* What the phone did, worked out from the session registers. Writes of the phone are not reported: in SRAM mirror
+ * mode NS_REG does not tell them and FD has no edge for them */
+enum nfc_event_type
+{
+	NFC_EVENT_FIELD_ON,
+	NFC_EVENT_FIELD_OFF,
+	NFC_EVENT_READ_DONE,														/* The phone read the end of the handover record */
+	NFC_EVENT_TYPE_COUNT
+};
+
+
+struct nfc_event
+{
+	enum nfc_event_type type;
+	uint32_t timestamp;															/* RTCC counter value of the FD edge, the falling one for a field on */
+};
+
+
+/* Every FD edge is followed by an asynchronous read of NS_REG and NC_REG through the I2C engine. The events
+ * are queued for the application, which is woken up through EVENT_NFC. Edges coming in while the registers are
+ * being read are folded into one more read */
+struct nfc_event_service
+{
+	struct nfc_event event[NFC_EVENT_QUEUE_SIZE];
+
+	/* Free running indexes, masked with NFC_EVENT_QUEUE_MASK on access */
+	uint32_t head;
+	uint32_t tail;
+
+	struct i2c_transfer transfer;
+	uint8_t ns;
+	uint8_t nc;
+	bool reading;
+	bool again;
+	bool field;																	/* Last known state of the field */
+	bool field_edge;															/* FD was pulled low since the last read */
+	uint32_t edge_timestamp;													/* Last edge */
+	uint32_t field_timestamp;													/* Last falling edge, the field coming on */
+
+	/* Statistics */
+	uint32_t edge_count;
+	uint32_t event_count[NFC_EVENT_TYPE_COUNT];
+	uint32_t dropped_count;
+	uint32_t error_count;
+	uint32_t config_lost_count;													/* Times the NTAG came back with its power on defaults */
+};
+
+
+struct nfc_event_service nfc_event_service;			/* Only one instance since there is only one NFC tag */
+
+
+/* Function Declarations */
+void nfc_event_init(void);
+void nfc_event_edge(void);
+bool nfc_event_get(struct nfc_event* event);
+
+
+#endif /* INC_NFC_EVENT_H_ */
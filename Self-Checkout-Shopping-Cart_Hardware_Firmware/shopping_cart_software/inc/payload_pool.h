@@ -0,0 +1,51 @@
+/*
+ * @file payload_pool.h
+ * @brief Header file for payload_pool.c.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INC_PAYLOAD_POOL_H_
+#define INC_PAYLOAD_POOL_H_
+
+#include <stdint.h>
+#include "inc/barcode.h"
+
+
+/* Block sizes and number of blocks of each size class. Every block size must be a multiple of 4 bytes.
+ * The last class holds the biggest payload a barcode frame can carry plus the NULL character */
+#define PAYLOAD_POOL_SMALL_SIZE					(32)
+#define PAYLOAD_POOL_SMALL_COUNT				(8)
+#define PAYLOAD_POOL_MEDIUM_SIZE				(64)
+#define PAYLOAD_POOL_MEDIUM_COUNT				(4)
+#define PAYLOAD_POOL_LARGE_SIZE					(128)
+#define PAYLOAD_POOL_LARGE_COUNT				(2)
+#define PAYLOAD_POOL_MAX_SIZE					((BARCODE_PAYLOAD_MAXSIZE + 1 + 3) & ~3)
+#define PAYLOAD_POOL_MAX_COUNT					(1)
+#define PAYLOAD_POOL_CLASS_COUNT				(4)
+
+
+/* Usage statistics of the payload pool */
+struct payload_pool_stats
+{
+	/* Number of successful and failed allocations */
+	uint32_t alloc_count;
+	uint32_t failure_count;
+
+	/* Number of blocks of each size class currently in use and the maximum ever used at the same time */
+	uint16_t in_use[PAYLOAD_POOL_CLASS_COUNT];
+	uint16_t high_water[PAYLOAD_POOL_CLASS_COUNT];
+};
+
+
+/* Function Declarations */
+void payload_pool_init(void);
+char* payload_pool_alloc(uint16_t size);
+void payload_pool_free(void* block);
+const struct payload_pool_stats* payload_pool_stats_get(void);
+
+
+#endif /* INC_PAYLOAD_POOL_H_ */
@@ -0,0 +1,83 @@
+/*
+ * @file scan_queue.h
+ * @brief Header file for scan_queue.c.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INC_SCAN_QUEUE_H_
+#define INC_SCAN_QUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/barcode.h"
+#include "inc/cart_codec.h"
+
+
+#define SCAN_QUEUE_SIZE							(8)									/* Must be a power of two */
+#define SCAN_QUEUE_MASK							(SCAN_QUEUE_SIZE - 1)
+
+
+/* Compile time check, the queue indexes are masked with SCAN_QUEUE_MASK */
+typedef char scan_queue_size_check[((SCAN_QUEUE_SIZE & SCAN_QUEUE_MASK) == 0) ? 1 : -1];
+
+
+/* A parsed scan waiting to be sent over bluetooth */
+struct scan_record
+{
+	struct barcode_packet packet;
+
+	/* Decoded payload size and cost of the packet */
+	uint16_t payload_size;
+	uint16_t cost;
+
+	/* RTCC counter value when the frame was parsed, used to measure the scan to notification latency */
+	uint32_t timestamp;
+
+	/* Encoded item record up to the product name, the name is sent straight from the payload */
+	uint8_t header[CART_ITEM_HEADER_MAXSIZE];
+	uint8_t header_size;
+};
+
+
+/* Bounded queue between the barcode parser and the bluetooth sender. Both stages run in the bluetooth
+ * event loop, the parser stops consuming leuart_circbuff while the queue is full */
+struct scan_queue
+{
+	struct scan_record record[SCAN_QUEUE_SIZE];
+
+	/* Free running indexes, masked with SCAN_QUEUE_MASK on access */
+	uint32_t head;
+	uint32_t tail;
+
+	/* Set when a frame was held back in leuart_circbuff because the queue was full */
+	bool stalled;
+
+	/* Statistics */
+	uint32_t enqueued_count;
+	uint32_t sent_count;
+	uint32_t dropped_count;						/* Frames lost because no payload block was available or flushed on disconnect */
+	uint32_t stall_count;						/* Times the parser was held back because the queue was full */
+	uint32_t high_water;						/* Maximum number of records queued at the same time */
+	uint32_t latency_max;						/* Maximum scan to notification latency in RTCC ticks */
+};
+
+
+struct scan_queue scan_queue;					/* Only one instance since there is only one barcode scanner */
+
+
+/* Function Declarations */
+void scan_queue_init(void);
+void scan_queue_flush(void);
+uint32_t scan_queue_count(void);
+bool scan_queue_full(void);
+bool scan_queue_push(const struct barcode_frame* frame);
+bool scan_queue_push_item(const struct cart_item* item);
+struct scan_record* scan_queue_front(void);
+void scan_queue_pop(void);
+
+
+#endif /* INC_SCAN_QUEUE_H_ */
@@ -0,0 +1,52 @@
+/*
+ * @file timing.h
+ * @brief Header file for timing.c.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INC_TIMING_H_
+#define INC_TIMING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+#define TIMING_TICKS_PER_S					(32768)								/* RTCC on the LFXO without prescaler, set up in init_mcu.c */
+#define TIMING_SPIN_MAX_US					(61)								/* Up to 2 RTCC ticks the wait counts CPU cycles */
+#define TIMING_SLEEP_MIN_TICKS				(33)								/* Waits of 1ms or more sleep, waking up the CPU costs about 10us */
+
+
+/* Waits and timeouts measured with the RTCC, which keeps counting in EM2. Long waits sleep until the CRYOTIMER,
+ * also on the LFXO, wakes the CPU up. The CRYOTIMER only has periods of 2^n ticks, a wait sleeps for the largest
+ * period left before its deadline until less than TIMING_SLEEP_MIN_TICKS are left, then spins on the RTCC.
+ * EM2 is only entered if no driver blocks it, the SLEEP driver picks the energy mode */
+struct timing
+{
+	bool ready;
+	uint32_t cycles_per_us;
+	volatile bool wakeup;
+
+	/* Statistics, in RTCC ticks */
+	uint32_t sleep_ticks;
+	uint32_t spin_ticks;
+	uint32_t wait_count;
+};
+
+
+struct timing timing;							/* Only one instance since there is only one RTCC */
+
+
+/* Function Declarations */
+void timing_init(void);
+void timing_wait_us(uint32_t us);
+void timing_wait_ms(uint32_t ms);
+uint32_t timing_deadline_us(uint32_t us);
+bool timing_expired(uint32_t deadline);
+void timing_wait_until(uint32_t deadline);
+
+
+#endif /* INC_TIMING_H_ */
@@ -60,16 +60,39 @@
 #include "inc/barcode.h"
 #include "inc/i2c.h"
 #include "inc/gpio.h"
+#include "inc/payload_pool.h"
+#include "inc/scan_queue.h"
+#include "inc/ble_packer.h"
+#include "inc/ble_tx.h"
+#include "inc/conn_policy.h"
+#include "inc/link_opt.h"
+#include "inc/cart_session.h"
+#include "inc/catalog.h"
+#include "inc/flash_spi.h"
+#include "inc/cart_journal.h"
+#include "inc/kv_store.h"
+#include "inc/timing.h"
+#include "inc/ndef.h"
+#include "inc/nfc_event.h"
+#include "inc/adv_policy.h"
 
 
 /* Global Variables */
 #define TIMER_CLK_FREQ 							((uint32)32768)				/* Timer Clock Frequency */
 #define TIMER_S_TO_TICKS(s)						(TIMER_CLK_FREQ * s)		/* Convert seconds to timer ticks */
 #define SOFT_TIMER_LEUART_INTERRUPT				(55)
-#define SOFT_TIMER_NFC_INTERRUPT				(56)
+#define SOFT_TIMER_NFC_ADVERTISING				(56)
+#define SOFT_TIMER_BLE_TX_RETRY					(57)
+#define SOFT_TIMER_CONN_QUIET					(58)
+#define SOFT_TIMER_JOURNAL						(59)
+#define SOFT_TIMER_KV_STORE						(60)
+#define SOFT_TIMER_ADV_STEP						(61)
+#define SOFT_TIMER_CONN_REQUEST					(62)
+#define NFC_ADVERTISING_S						(15)						/* Advertising after a tap, until the phone reads the record */
+#define NFC_CONNECT_S							(5)							/* Advertising left once the phone read the record */
+#define CONTROL_SESSION							(0x01)						/* Session record answering a resume command */
+#define CONTROL_BILL							(0x02)						/* Bill record answering a bill command */
 #define CART_DEBUG_PRINTS						(1)							/* Comment this line to remove debug prints */*/
-#define EXTRA_PAYLOAD_SIZE						(1 + 1 + 3 + 1 + 1)				/* 1 byte for "," , 1 byte for "$", 3 bytes for cost, 1 byte for "\n" , 1 byte to accomodate NULL character*/
-#define MAX_BLUETOOTH_SIZE_SEND					(50)						/* This is the maximum bluetooth data size that can be sent in one go */
 
 
 #ifdef CART_DEBUG_PRINTS
@@ -126,12 +149,12 @@ static gecko_configuration_t config = {
 /* Global Variables */
 static uint8_t boot_to_dfu = 0;					// Flag for indicating DFU Reset must be performed
 static uint8_t connection_handle;
-int payload_size = 0;							/* Payload_size to be sent to the android application */
-int total_cost = 0;								/* Total cost of the shopping list is stored here */
-
-
-uint8_t write_nfc_row[16] = {0x03, 0x18, 0xD1, 0x01, 0x14, 0x54, 0x02, 0x65, 0x6E, 0x30, 0x30, 0x3A, 0x30, 0x42, 0x3A, 0x35};
-uint8_t write_nfc_row_1[16] = {0x37, 0x3A, 0x45, 0x46, 0x3A, 0x32, 0x39, 0x3A, 0x42, 0x31, 0xFE, 0x4F, 0x00, 0x00, 0x00, 0x00};
+static uint8_t control_pending = 0;				/* CONTROL_ records asked for by the client and not queued yet */
+static bool journal_timer_armed = false;		/* SOFT_TIMER_JOURNAL is running */
+static bool kv_store_timer_armed = false;		/* SOFT_TIMER_KV_STORE is running */
+static bool conn_request_timer_armed = false;	/* SOFT_TIMER_CONN_REQUEST is running */
+static bool connected = false;
+static uint32_t nfc_field_timestamp;			/* RTCC counter value of the last tap */
 
 
 
@@ -140,7 +163,16 @@ uint8_t write_nfc_row_1[16] = {0x37, 0x3A, 0x45, 0x46, 0x3A, 0x32, 0x39, 0x3A, 0
 static void handle_gecko_event(uint32_t evt_id, struct gecko_cmd_packet *evt);
 static void bt_connection_init(void);
 static void bt_server_print_address(void);
-static void write_ble_address_to_nfc(void);
+static void external_event_set(uint32_t event);
+static bool control_send(void);
+static void ble_tx_resume(void);
+static void journal_schedule(void);
+static void kv_store_schedule(void);
+static void conn_request_schedule(void);
+static void nfc_publish(void);
+static void nfc_event_handle(const struct nfc_event* event);
+static void cart_command_handle(const uint8_t* data, uint8_t size);
+static void cart_read_handle(uint8_t connection, uint16_t characteristic, uint16_t offset);
 
 
 
@@ -168,13 +200,33 @@ int main(void)
   printf("Self Checkout Shopping Cart.\n");
   printf("Team Name: Ashwathama.\n");
 
+  /* Waits and timeouts of the drivers, long waits sleep from here on */
+  timing_init();
+
   //Initializing Structures Circular Buffer and Barcode Packet to value 0
   memset(&leuart_circbuff, 0, sizeof(struct leuart_circbuff));
-  memset(&barcode_packet, 0, sizeof(struct barcode_packet));
+  memset(&barcode_parser, 0, sizeof(struct barcode_parser));
+  payload_pool_init();
+  scan_queue_init();
+
+  /* Settings and lifetime statistics from the internal flash, the cart id is needed by the cart session */
+  kv_store_init();
+  kv_store_set_u32(KV_KEY_BOOT_COUNT, kv_store_get_u32(KV_KEY_BOOT_COUNT, 0) + 1);
+
+  /* Without a catalog in the external flash only the barcodes carrying the name and cost are accepted */
+  flash_spi_init();
+  catalog_init();
+
+  /* The cart survives a reset, the journal replays it. A new session is only started without one */
+  if(cart_journal_init() < 0)
+  {
+	  cart_session_init();
+  }
 
   /* Initializing GPIO Interrupts for NFC, LEUART and I2C*/
   gpio_init();
   i2c_init();
+  nfc_event_init();
 
   //Starting Software Timer for leuart interrupts.
   //gecko_cmd_hardware_set_soft_timer(TIMER_S_TO_TICKS(1), SOFT_TIMER_LEUART_INTERRUPT, 0);
@@ -206,15 +258,39 @@ static void handle_gecko_event(uint32_t evt_id, struct gecko_cmd_packet *evt)
 		/*Set up Bluetooth connection parameters and start advertising */
 		bt_connection_init();
 
+		/* The NFC tag hands the address over to the phone, only the blocks that changed are written */
+		if(ndef_tag_update(gecko_cmd_system_get_bt_address()->address.addr) < 0)
+		{
+			printf("ERROR: I2C busy, address not written in NFC Module\n");
+		}
+		nfc_publish();
+
+		/* The journal erases its next sector in the background */
+		journal_schedule();
+		kv_store_schedule();
+
 		break;
 
 
 	/* This event is generated when a connected client has either
 	 * 1) changed a Characteristic Client Configuration, meaning that they have enabled
 	 * or disabled Notifications or Indications, or
-	 * 2) sent a confirmation upon a successful reception of the indication. */
+	 * 2) sent a confirmation upon a successful reception of the indication. The item stream only notifies,
+	 * confirmations are only sent for the service changed indication. */
 	case gecko_evt_gatt_server_characteristic_status_id:
 		printf("Event: gecko_evt_gatt_server_characteristic_status_id\n");
+
+		/* The client enabled the item stream, scans made before are waiting in the queues */
+		if ((evt->data.evt_gatt_server_characteristic_status.characteristic == gattdb_item_stream) &&
+			(evt->data.evt_gatt_server_characteristic_status.status_flags == gatt_server_client_config) &&
+			evt->data.evt_gatt_server_characteristic_status.client_config_flags)
+		{
+#ifdef LINK_BENCHMARK
+			link_benchmark_start();
+			external_event_set(EVENT_SCAN_READY);
+#endif
+			ble_tx_resume();
+		}
 		break;
 
 
@@ -224,14 +300,25 @@ static void handle_gecko_event(uint32_t evt_id, struct gecko_cmd_packet *evt)
 		char client_address_string[6];
 
 		/* Disabling NFC software timer on successful connection */
-		gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_NFC_INTERRUPT, 0);
+		gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_NFC_ADVERTISING, 0);
+		gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_ADV_STEP, 0);
+		adv_policy_connected();
+		connected = true;
 
 		/* Enabling leuart only after successful connection */
 		leuart_init();
-
-		/*Configure Connection Parameters*/
-		gecko_cmd_le_connection_set_parameters(evt->data.evt_le_connection_opened.connection,
-													CON_INTERVAL_MIN,CON_INTERVAL_MAX,CON_LATENCY,CON_TIMEOUT);
+		barcode_parser_init(&barcode_parser);
+		ble_packer_init(&ble_packer);
+		ble_tx_init(evt->data.evt_le_connection_opened.connection, gattdb_item_stream);
+		control_pending = 0;
+
+		/*Configure Connection Parameters, the fast ones first since the shopper starts scanning*/
+		conn_policy_init(evt->data.evt_le_connection_opened.connection);
+		conn_request_schedule();
+
+		/* Request the 2M PHY, the data length is extended by the stack */
+		link_opt_init(evt->data.evt_le_connection_opened.connection);
+		gecko_cmd_hardware_set_soft_timer(TIMER_S_TO_TICKS(CON_QUIET_PERIOD_S), SOFT_TIMER_CONN_QUIET, 1);
 		connection_handle = evt->data.evt_le_connection_opened.connection;
 
 		bd_addr client_address = evt->data.evt_le_connection_opened.address;
@@ -241,6 +328,31 @@ static void handle_gecko_event(uint32_t evt_id, struct gecko_cmd_packet *evt)
 		break;
 
 
+	case gecko_evt_le_connection_parameters_id:
+		printf("Event: gecko_evt_le_connection_parameters_id\n");
+		conn_policy_parameters(evt->data.evt_le_connection_parameters.interval, evt->data.evt_le_connection_parameters.latency,
+							   evt->data.evt_le_connection_parameters.timeout);
+		conn_request_schedule();
+		link_opt_txsize(evt->data.evt_le_connection_parameters.txsize);
+		break;
+
+
+	case gecko_evt_le_connection_phy_status_id:
+		printf("Event: gecko_evt_le_connection_phy_status_id\n");
+		link_opt_phy(evt->data.evt_le_connection_phy_status.phy);
+		break;
+
+
+	case gecko_evt_gatt_mtu_exchanged_id:
+		printf("Event: gecko_evt_gatt_mtu_exchanged_id\n");
+		printf("ATT MTU: %d\n", evt->data.evt_gatt_mtu_exchanged.mtu);
+
+		/* Size the notifications to the negotiated MTU */
+		ble_packer_set_mtu(&ble_packer, evt->data.evt_gatt_mtu_exchanged.mtu);
+		link_opt_mtu(evt->data.evt_gatt_mtu_exchanged.mtu);
+		break;
+
+
 	case gecko_evt_sm_bonded_id:
 		printf("Event: gecko_evt_sm_bonded_id\n");
 		break;
@@ -255,8 +367,8 @@ static void handle_gecko_event(uint32_t evt_id, struct gecko_cmd_packet *evt)
 		/* Check if need to boot to dfu mode */
 		printf("Event: gecko_evt_le_connection_closed_id\n");
 		printf("Disconnected\n");
-		total_cost = 0;
 		gecko_cmd_system_set_tx_power(0);
+		connected = false;
 
 		if (boot_to_dfu) {
 			/* Enter to DFU OTA mode */
@@ -267,11 +379,17 @@ static void handle_gecko_event(uint32_t evt_id, struct gecko_cmd_packet *evt)
 			/* Stop timer in case client disconnected before indications were turned off */
 			gecko_cmd_hardware_set_soft_timer(0, 0, 0);
 
-			/* Start NFC GPIO interrupt to reconnect using NFC */
-			GPIO_IntConfig(GPIO_NFC_PORT, GPIO_NFC_PIN, GPIO_RISING_EDGE, GPIO_FALLING_EDGE, GPIO_INTERRUPT_ENABLE);
-
 			/* Disable leuart peripheral over here */
 			leuart_disable();
+
+			/* Scans not sent yet belong to the closed connection */
+			scan_queue_flush();
+			scan_queue.stalled = false;
+			ble_tx_flush();
+			gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_BLE_TX_RETRY, 0);
+			gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_CONN_QUIET, 0);
+			gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_CONN_REQUEST, 0);
+			conn_request_timer_armed = false;
 		}
 		break;
 
@@ -298,55 +416,67 @@ static void handle_gecko_event(uint32_t evt_id, struct gecko_cmd_packet *evt)
 			printf("SOFT_TIMER_LEUART_INTERRUPT\n");
 			if(!leuart_buffer_empty_status())
 			{
-				CORE_AtomicDisableIrq();
-				external_event |= EVENT_LEUART;
-				gecko_external_signal(external_event);
-				CORE_AtomicEnableIrq();
+				external_event_set(EVENT_LEUART);
 			}
 
 			break;
 
-		case SOFT_TIMER_NFC_INTERRUPT:
+		case SOFT_TIMER_BLE_TX_RETRY:
 
-			printf("SOFT_TIMER_NFC_INTERRUPT\n");
-			/* Stop advertising and enable interrupts */
-			gecko_cmd_le_gap_stop_advertising(0);
-			GPIO_IntConfig(GPIO_NFC_PORT, GPIO_NFC_PIN, GPIO_RISING_EDGE, GPIO_FALLING_EDGE, GPIO_INTERRUPT_ENABLE);
+			ble_tx_resume();
+			break;
 
+		case SOFT_TIMER_CONN_QUIET:
 
-		}
-		break;
+			/* Stay on the active parameters while scans are still waiting to be sent */
+			if(scan_queue_count() || ble_tx_count())
+			{
+				gecko_cmd_hardware_set_soft_timer(TIMER_S_TO_TICKS(CON_QUIET_PERIOD_S), SOFT_TIMER_CONN_QUIET, 1);
+			}
+			else
+			{
+				conn_policy_quiet();
+				conn_request_schedule();
+			}
+			break;
 
+		case SOFT_TIMER_CONN_REQUEST:
 
-	case gecko_evt_gatt_server_attribute_value_id:
-		printf("Event: gecko_evt_gatt_server_attribute_value_id\n");
+			/* The central rejected or ignored the parameter request, or the timer was armed for an earlier one */
+			conn_request_timer_armed = false;
+			conn_policy_request_timeout();
+			conn_request_schedule();
+			break;
 
-		char cost_string[4];
-		char *ptr = &cost_string[0];
-		ptr = itoa(total_cost, cost_string, 10);
-		printf("Total cost decimal: %d\n", total_cost);
-		printf("Total Cost String: %s\n",cost_string);
-		printf("Received response: %c \n", evt->data.evt_gatt_server_attribute_value.value.data[0]);
-		if (evt->data.evt_gatt_server_attribute_value.value.len && (evt->data.evt_gatt_server_attribute_value.value.data[0] == 'B'))
-		{
-			printf("Sending Bill\n");
-			printf("Send Result: %x\n",gecko_cmd_gatt_server_send_characteristic_notification(
-					(uint8)connection_handle, (uint8)gattdb_product_name, (uint8)4, (const uint8*)ptr)->result);
-		}
-		else if (evt->data.evt_gatt_server_attribute_value.value.len && (evt->data.evt_gatt_server_attribute_value.value.data[0] == 'P'))
-		{
-			printf("Total Cost set to 0\n");
-			total_cost = 0;
-			gecko_cmd_le_connection_close(connection_handle);		//Closing the connection since payment is completed
-		}
+		case SOFT_TIMER_JOURNAL:
 
+			journal_timer_armed = false;
+			cart_journal_service();
+			journal_schedule();
+			break;
 
+		case SOFT_TIMER_KV_STORE:
 
-		break;
+			kv_store_timer_armed = false;
+			kv_store_flush();
+			kv_store_schedule();
+			break;
+
+		case SOFT_TIMER_NFC_ADVERTISING:
+
+			printf("SOFT_TIMER_NFC_ADVERTISING\n");
+			/* Nobody connected after the tap, stop advertising until the next one */
+			gecko_cmd_hardware_set_soft_timer(0, SOFT_TIMER_ADV_STEP, 0);
+			adv_policy_stop();
+			break;
 
+		case SOFT_TIMER_ADV_STEP:
 
-	case gecko_evt_gatt_procedure_completed_id:
-		printf("GATT Procedure completed\n");
+			/* Back off from the burst, 0 ticks leave the timer stopped once at the low power interval */
+			gecko_cmd_hardware_set_soft_timer(adv_policy_step(), SOFT_TIMER_ADV_STEP, 1);
+			break;
+
+		}
 		break;
 
 
@@ -362,65 +492,115 @@ static void handle_gecko_event(uint32_t evt_id, struct gecko_cmd_packet *evt)
 
 			printf("External Signal Event for LEUART received.\n");
 
-			//Initial data - Not necessary to initialize
-			uint32_t temp_read_index = leuart_circbuff.read_index;
+			leuart_circbuff.wakeup_count++;
+			printf("Frames per wakeup: %lu/%lu\n", (unsigned long)leuart_circbuff.frame_count, (unsigned long)leuart_circbuff.wakeup_count);
 
-			/* Read data from leuart_circbuff till it is empty */
-			while(!leuart_buffer_empty_status())
+			/* Parse the complete frames available in leuart_circbuff while the scan queue has room. A partial frame,
+			 * or frames held back by a full queue, stay in the buffer until the next event */
+			struct barcode_frame frame;
+			uint32_t frame_count = barcode_parser.frame_count;
+			while(!scan_queue_full() && barcode_parser_run(&barcode_parser, &frame))
 			{
-
-				//TODO: Add a Software Timer for UART Receiving external event trigger.
-				if(leuart_circbuff.buffer[leuart_circbuff.read_index] == BARCODE_PREAMBLE)
+				/* Queue the frame and give the buffer space back */
+				if(scan_queue_push(&frame))
 				{
-					temp_read_index = leuart_circbuff.read_index + 7;							/* 7 as per the packet structure */
-
-					/* Start making packet here */
-					total_cost += barcode_packet_create(&barcode_packet, &payload_size);
-
+					kv_store_set_u32(KV_KEY_SCAN_COUNT, kv_store_get_u32(KV_KEY_SCAN_COUNT, 0) + 1);
 				}
-				else if(leuart_circbuff.buffer[leuart_circbuff.read_index] == BARCODE_POSTAMBLE)
-				{
-					/* Temporary packet to send data. Maxmum size BLE can transfer at a time is 20 bytes */
-					char packet_send[MAX_BLUETOOTH_SIZE_SEND];
-					int total_payload_size = payload_size + EXTRA_PAYLOAD_SIZE;
+				barcode_frame_release(&barcode_parser, &frame);
+			}
+			journal_schedule();
+			kv_store_schedule();
 
-					memset(packet_send, 0, sizeof(packet_send));
+			/* Scans are arriving, use the fast connection parameters and restart the quiet period */
+			if(barcode_parser.frame_count != frame_count)
+			{
+				conn_policy_activity();
+				conn_request_schedule();
+				gecko_cmd_hardware_set_soft_timer(TIMER_S_TO_TICKS(CON_QUIET_PERIOD_S), SOFT_TIMER_CONN_QUIET, 1);
+			}
+
+			/* More data is waiting behind a full queue, the sender resumes the parser once it made room */
+			if(scan_queue_full() && (leuart_buffer_count() > barcode_parser.offset))
+			{
+				scan_queue.stalled = true;
+				scan_queue.stall_count++;
+			}
 
-					/* Pop the postamble and the \r character*/
-					barcode_packet.postamble = leuart_buffer_pop();
-					leuart_buffer_pop();														/* To remove the redundant \r received from the barcode*/
+			if(scan_queue_count() || cart_session_resend_pending())
+			{
+				external_event_set(EVENT_SCAN_READY);
+			}
 
-					/* Copy the received buffer data into the packet structure and append a null character to the string at the end */
-					memcpy(&barcode_packet.payload[0], &leuart_circbuff.buffer[temp_read_index], payload_size);
-					barcode_packet.payload[payload_size] = '\0';								/* Adding a NULL character at the end of string*/
+			printf("Parser: %lu frames, %lu garbage bytes, %lu truncated frames\n", (unsigned long)barcode_parser.frame_count,
+					(unsigned long)barcode_parser.garbage_count, (unsigned long)barcode_parser.truncated_count);
+
+			const struct payload_pool_stats *pool_stats = payload_pool_stats_get();
+			printf("Payload pool: %lu allocations, %lu failures, high water %u/%u/%u/%u\n", (unsigned long)pool_stats->alloc_count,
+					(unsigned long)pool_stats->failure_count, pool_stats->high_water[0], pool_stats->high_water[1],
+					pool_stats->high_water[2], pool_stats->high_water[3]);
+
+			printf("Catalog: %lu lookups, %lu cache hits, %lu not found, %lu flash reads, longest %lu ticks\n",
+					(unsigned long)catalog.lookup_count, (unsigned long)catalog.cache.hit_count, (unsigned long)catalog.miss_count,
+					(unsigned long)catalog.read_count, (unsigned long)catalog.lookup_ticks_max);
+			printf("Journal: %lu records, %lu page programs, %lu erases, %lu dropped\n", (unsigned long)cart_journal.append_count,
+					(unsigned long)cart_journal.program_count, (unsigned long)cart_journal.erase_count, (unsigned long)cart_journal.drop_count);
+			printf("Timing: %lu waits, %lu ticks asleep, %lu ticks spinning\n", (unsigned long)timing.wait_count,
+					(unsigned long)timing.sleep_ticks, (unsigned long)timing.spin_ticks);
+			printf("NFC tag: %lu tokens published, longest %lu ticks, %lu errors\n", (unsigned long)ndef_tag.publish_count,
+					(unsigned long)ndef_tag.publish_ticks_max, (unsigned long)ndef_tag.error_count);
+			printf("NFC events: %lu edges, %lu taps, %lu reads, %lu dropped, %lu errors\n",
+					(unsigned long)nfc_event_service.edge_count, (unsigned long)nfc_event_service.event_count[NFC_EVENT_FIELD_ON],
+					(unsigned long)nfc_event_service.event_count[NFC_EVENT_READ_DONE], (unsigned long)nfc_event_service.dropped_count,
+					(unsigned long)nfc_event_service.error_count);
+			printf("Advertising: %lu taps, %lu connections, %lu timeouts, tap to connect last %lu ms, longest %lu ms\n",
+					(unsigned long)adv_policy.start_count, (unsigned long)adv_policy.connect_count, (unsigned long)adv_policy.timeout_count,
+					(unsigned long)adv_policy.connect_ms_last, (unsigned long)adv_policy.connect_ms_max);
+		}
 
+		if (evt->data.evt_system_external_signal.extsignals & EVENT_SCAN_READY)
+		{
 
-					//TODO: Now Start Sending data over bluetooth here.
-					snprintf(packet_send, total_payload_size, "%s,$%s\n", barcode_packet.payload, &barcode_packet.cost[0]);
-					printf("Packet to be sent over Bluetooth: %s \n", packet_send);
+			CORE_AtomicDisableIrq();
+			external_event &= ~EVENT_SCAN_READY;
+			CORE_AtomicEnableIrq();
 
-					do
-					{
-						if (total_payload_size <= MAX_BLUETOOTH_SIZE_SEND)
-						{
-							printf("Send Result: %x\n",gecko_cmd_gatt_server_send_characteristic_notification(
-									connection_handle, gattdb_product_name, total_payload_size, (const uint8 *)&packet_send[0])->result);
-						}
-						total_payload_size -= MAX_BLUETOOTH_SIZE_SEND;
-					}
-					while( total_payload_size > 0 /*&& (total_payload_size / MAX_BLUETOOTH_SIZE_SEND)*/);
+			printf("External Signal Event for scan queue received.\n");
 
+#ifdef LINK_BENCHMARK
+			link_benchmark_run();
+#endif
 
-					/* Free the barcode_packet data structure after sending data */
-					free(barcode_packet.payload);
+			/* Changes missed by a reconnected client, once the session record is queued */
+			struct cart_item item;
+			while(!(control_pending & CONTROL_SESSION) && cart_session_resend_peek(&item) && scan_queue_push_item(&item))
+			{
+				cart_session_resend_done();
+			}
 
-					/* Initializing the barcode_packet data structure to zero */
-					memset(&barcode_packet, 0, sizeof(struct barcode_packet));
-				}
-				else
-				{
-					leuart_buffer_pop();														/* To pop remaining data*/
-				}
+			/* Pack the queued scans, oldest first, into the free entries of the transmit queue and hand them to the stack */
+			uint8_t *notification;
+			uint16_t notification_size;
+			while(((notification = ble_tx_reserve()) != NULL) && ((notification_size = ble_packer_fill(&ble_packer, notification)) > 0))
+			{
+				ble_tx_commit(notification_size);
+			}
+			ble_tx_resume();
+
+			printf("Scan queue: %lu queued, %lu sent, %lu dropped, %lu stalls, high water %lu, max latency %lu ticks\n",
+					(unsigned long)scan_queue.enqueued_count, (unsigned long)scan_queue.sent_count, (unsigned long)scan_queue.dropped_count,
+					(unsigned long)scan_queue.stall_count, (unsigned long)scan_queue.high_water, (unsigned long)scan_queue.latency_max);
+			printf("Packer: %lu items in %lu notifications, %lu fragments, max %lu items per notification\n",
+					(unsigned long)ble_packer.item_count, (unsigned long)ble_packer.notification_count,
+					(unsigned long)ble_packer.fragment_count, (unsigned long)ble_packer.items_max);
+			printf("Transmit queue: %lu sent, %lu retries, %lu dropped, high water %lu, most retries %lu\n", (unsigned long)ble_tx.sent_count,
+					(unsigned long)ble_tx.retry_count, (unsigned long)ble_tx.drop_count, (unsigned long)ble_tx.high_water,
+					(unsigned long)ble_tx.attempts_max);
+
+			/* The parser was held back by a full queue, resume it now that there is room */
+			if(scan_queue.stalled && !scan_queue_full())
+			{
+				scan_queue.stalled = false;
+				external_event_set(EVENT_LEUART);
 			}
 		}
 
@@ -433,24 +613,72 @@ static void handle_gecko_event(uint32_t evt_id, struct gecko_cmd_packet *evt)
 
 			printf("External Signal Event for NFC FD pin interrupt received.\n");
 
-			gecko_cmd_le_gap_start_advertising(0, le_gap_general_discoverable, le_gap_connectable_scannable);
+			/* The session registers tell what the phone did */
+			nfc_event_edge();
+		}
+
+		if (evt->data.evt_system_external_signal.extsignals & EVENT_NFC)
+		{
+
+			CORE_AtomicDisableIrq();
+			external_event &= ~EVENT_NFC;
+			CORE_AtomicEnableIrq();
+
+			struct nfc_event nfc_event;
+			while(nfc_event_get(&nfc_event))
+			{
+				nfc_event_handle(&nfc_event);
+			}
+		}
+
+		if (evt->data.evt_system_external_signal.extsignals & EVENT_FLASH)
+		{
 
-			gecko_cmd_hardware_set_soft_timer(TIMER_S_TO_TICKS(15), SOFT_TIMER_NFC_INTERRUPT, 1);
+			CORE_AtomicDisableIrq();
+			external_event &= ~EVENT_FLASH;
+			CORE_AtomicEnableIrq();
+
+			/* An asynchronous read of the external flash is over */
+			flash_spi_complete();
+		}
+
+		if (evt->data.evt_system_external_signal.extsignals & EVENT_I2C)
+		{
+
+			CORE_AtomicDisableIrq();
+			external_event &= ~EVENT_I2C;
+			CORE_AtomicEnableIrq();
 
+			/* An I2C transfer is over */
+			i2c_complete();
 		}
 
 		break;
 
 
 
+	/* The cart summary and the catalog are built on every read, they are never stored in the GATT database */
+	case gecko_evt_gatt_server_user_read_request_id:
+		printf("Event: gecko_evt_gatt_server_user_read_request_id\n");
+		cart_read_handle(evt->data.evt_gatt_server_user_read_request.connection,
+						 evt->data.evt_gatt_server_user_read_request.characteristic,
+						 evt->data.evt_gatt_server_user_read_request.offset);
+		break;
+
+
 	/* Events related to OTA upgrading
 			   ----------------------------------------------------------------------------- */
 
 	/* Checks if the user-type OTA Control Characteristic was written.
-	 * If written, boots the device into Device Firmware Upgrade (DFU) mode. */
+	 * If written, boots the device into Device Firmware Upgrade (DFU) mode.
+	 * The command characteristic is write without response, the stack expects no response for it. */
 	case gecko_evt_gatt_server_user_write_request_id:
 		printf("Write request receieved from the mobile app\n");
-		if (evt->data.evt_gatt_server_user_write_request.characteristic == gattdb_ota_control) {
+		if (evt->data.evt_gatt_server_user_write_request.characteristic == gattdb_cart_command) {
+			cart_command_handle(evt->data.evt_gatt_server_user_write_request.value.data,
+								evt->data.evt_gatt_server_user_write_request.value.len);
+		}
+		else if (evt->data.evt_gatt_server_user_write_request.characteristic == gattdb_ota_control) {
 			/* Set flag to enter to OTA mode */
 			boot_to_dfu = 1;
 			/* Send response to Write Request */
@@ -504,6 +732,9 @@ static void bt_connection_init(void)
 	//Setting Transmit Power
 	gecko_cmd_system_set_tx_power(0);
 
+	//Allowing the client to negotiate a bigger ATT MTU so that several scans fit in one notification
+	gecko_cmd_gatt_set_max_mtu(BLE_ATT_MTU_MAX);
+
 	// Delete all previous bondings
 	gecko_cmd_sm_delete_bondings();
 
@@ -519,52 +750,328 @@ static void bt_connection_init(void)
 }
 
 
-static void write_ble_address_to_nfc(void)
+/**
+ * @brief This function raises an external signal event for the bluetooth event loop.
+ * @param uint32_t event The event bit to raise
+ * @return void
+ */
+static void external_event_set(uint32_t event)
+{
+	CORE_AtomicDisableIrq();
+	external_event |= event;
+	gecko_external_signal(external_event);
+	CORE_AtomicEnableIrq();
+}
+
+
+/**
+ * @brief This function arms SOFT_TIMER_JOURNAL when the journal has records to program or an erase to follow.
+ * The timer is not pushed back by later changes, so that the records of a burst of scans are programmed together.
+ * @param void
+ * @return void
+ */
+static void journal_schedule(void)
+{
+	uint32_t ticks = cart_journal_service_ticks();
+
+	if(ticks && !journal_timer_armed)
+	{
+		gecko_cmd_hardware_set_soft_timer(ticks, SOFT_TIMER_JOURNAL, 1);
+		journal_timer_armed = true;
+	}
+}
+
+
+/**
+ * @brief This function arms SOFT_TIMER_KV_STORE when some values are not written to the internal flash yet.
+ * Like the journal timer it is not pushed back, a value changed on every scan is written every KV_STORE_FLUSH_TICKS.
+ * @param void
+ * @return void
+ */
+static void kv_store_schedule(void)
+{
+	if(kv_store_dirty() && !kv_store_timer_armed)
+	{
+		gecko_cmd_hardware_set_soft_timer(KV_STORE_FLUSH_TICKS, SOFT_TIMER_KV_STORE, 1);
+		kv_store_timer_armed = true;
+	}
+}
+
+
+/**
+ * @brief This function arms SOFT_TIMER_CONN_REQUEST while a connection parameter request waits for its feedback.
+ * The timer is not pushed back by later requests, conn_policy_request_timeout() ignores a request younger than
+ * CON_REQUEST_TIMEOUT_S and the timer is armed again for the ticks left.
+ * @param void
+ * @return void
+ */
+static void conn_request_schedule(void)
+{
+	uint32_t ticks = conn_policy_request_ticks();
+
+	if(ticks && !conn_request_timer_armed)
+	{
+		gecko_cmd_hardware_set_soft_timer(ticks, SOFT_TIMER_CONN_REQUEST, 1);
+		conn_request_timer_armed = true;
+	}
+}
+
+
+/**
+ * @brief This function publishes the cart session id and a new random nonce in the SRAM of the NFC tag.
+ * @param void
+ * @return void
+ */
+static void nfc_publish(void)
+{
+	struct gecko_msg_system_get_random_data_rsp_t *random = gecko_cmd_system_get_random_data(NDEF_TOKEN_NONCE_SIZE);
+
+	if(random->result || (random->data.len != NDEF_TOKEN_NONCE_SIZE))
+	{
+		printf("ERROR: No random data, NFC token not published\n");
+		return;
+	}
+
+	ndef_tag_publish(cart_session.id, random->data.data);
+}
+
+
+/**
+ * @brief This function reacts to what the phone did with the NFC tag, on EVENT_NFC.
+ * A tap starts advertising. Once the phone read the record it only needs a few seconds to connect, and the next
+ * token is published while no phone is reading the SRAM.
+ * @param struct nfc_event* event The event
+ * @return void
+ */
+static void nfc_event_handle(const struct nfc_event* event)
+{
+	switch(event->type)
+	{
+	case NFC_EVENT_FIELD_ON:
+
+		printf("NFC: field on\n");
+		nfc_field_timestamp = event->timestamp;
+		if(!connected)
+		{
+			gecko_cmd_hardware_set_soft_timer(adv_policy_start(event->timestamp), SOFT_TIMER_ADV_STEP, 1);
+			gecko_cmd_hardware_set_soft_timer(TIMER_S_TO_TICKS(NFC_ADVERTISING_S), SOFT_TIMER_NFC_ADVERTISING, 1);
+		}
+		break;
+
+	case NFC_EVENT_READ_DONE:
+
+		printf("NFC: record read %lu ticks after the tap\n", (unsigned long)(event->timestamp - nfc_field_timestamp));
+		if(!connected)
+		{
+			gecko_cmd_hardware_set_soft_timer(TIMER_S_TO_TICKS(NFC_CONNECT_S), SOFT_TIMER_NFC_ADVERTISING, 1);
+		}
+		nfc_publish();
+		break;
+
+	case NFC_EVENT_FIELD_OFF:
+
+		printf("NFC: field off\n");
+		break;
+
+	default:
+		break;
+	}
+}
+
+
+/**
+ * @brief This function runs a command written by the client on the command characteristic.
+ * @param uint8_t* data The command, a letter followed by its argument
+ * @param uint8_t size Size of the command
+ * @return void
+ */
+static void cart_command_handle(const uint8_t* data, uint8_t size)
+{
+	printf("Total cost: %lu.%02lu, %lu items, %u lines\n", (unsigned long)(cart_ledger.total / CART_PRICE_SCALE),
+			(unsigned long)(cart_ledger.total % CART_PRICE_SCALE), (unsigned long)cart_ledger.item_count, cart_ledger.line_count);
+	if(size == 0)
+	{
+		return;
+	}
+
+	printf("Received response: %c \n", data[0]);
+	if (data[0] == 'B')
+	{
+		printf("Sending Bill\n");
+
+		/* The bill goes after the scans already queued */
+		control_pending |= CONTROL_BILL;
+		ble_tx_resume();
+	}
+	else if (data[0] == 'P')
+	{
+		printf("Total Cost set to 0\n");
+		cart_session_init();
+		journal_schedule();
+		kv_store_schedule();
+		nfc_publish();
+		gecko_cmd_le_connection_close(connection_handle);		//Closing the connection since payment is completed
+	}
+	else if ((size >= CART_SESSION_CMD_RESUME_SIZE) && (data[0] == CART_SESSION_CMD_RESUME))
+	{
+		uint32_t acked = data[1] | (data[2] << 8) | (data[3] << 16) | ((uint32_t)data[4] << 24);
+
+		/* Announce the session first, then send the changes the client missed */
+		cart_session_resume(acked);
+		control_pending |= CONTROL_SESSION;
+		ble_tx_resume();
+	}
+	else if ((size >= CART_SESSION_CMD_PRODUCT_SIZE) &&
+			 ((data[0] == CART_SESSION_CMD_REMOVE) || (data[0] == CART_SESSION_CMD_VOID)))
+	{
+		uint32_t product_id = data[1] | (data[2] << 8) | (data[3] << 16) | ((uint32_t)data[4] << 24);
+		struct cart_item item;
+
+		/* The removal goes out like a scan, through the resend path if the scan queue cannot take it now */
+		if(cart_session_remove(product_id, (data[0] == CART_SESSION_CMD_VOID), &item) == 0)
+		{
+			if(cart_session_resend_pending() || !scan_queue_push_item(&item))
+			{
+				cart_session_defer(item.sequence);
+			}
+			journal_schedule();
+			ble_tx_resume();
+		}
+	}
+}
+
+
+/**
+ * @brief This function answers a read of the cart summary or of the catalog sync characteristic. The summary is
+ * a session record followed by a bill record, a value longer than the MTU is read in parts at increasing offsets.
+ * @param uint8_t connection The connection handle
+ * @param uint16_t characteristic The characteristic read
+ * @param uint16_t offset Offset of the part read
+ * @return void
+ */
+static void cart_read_handle(uint8_t connection, uint16_t characteristic, uint16_t offset)
+{
+	uint8_t value[CART_SESSION_MAXSIZE + CART_BILL_MAXSIZE > CART_CATALOG_MAXSIZE ?
+				  CART_SESSION_MAXSIZE + CART_BILL_MAXSIZE : CART_CATALOG_MAXSIZE];
+	uint8_t size = 0;
+
+	if(characteristic == gattdb_cart_summary)
+	{
+		struct cart_session_info session;
+		struct cart_bill bill = {.total = cart_ledger.total, .item_count = cart_ledger.item_count};
+
+		cart_session_info_get(&session);
+		size += cart_codec_session_encode(&value[size], &session);
+		size += cart_codec_bill_encode(&value[size], &bill);
+	}
+	else if(characteristic == gattdb_catalog_sync)
+	{
+		struct cart_catalog_info info = {0};
+
+		if(catalog.ready)
+		{
+			info.record_count = catalog.header.record_count;
+			info.seed = catalog.header.seed;
+		}
+		size = cart_codec_catalog_encode(value, &info);
+	}
+	else
+	{
+		gecko_cmd_gatt_server_send_user_read_response(connection, characteristic, (uint8_t)bg_err_att_read_not_permitted, 0, NULL);
+		return;
+	}
+
+	if(offset > size)
+	{
+		gecko_cmd_gatt_server_send_user_read_response(connection, characteristic, (uint8_t)bg_err_att_invalid_offset, 0, NULL);
+		return;
+	}
+
+	gecko_cmd_gatt_server_send_user_read_response(connection, characteristic, 0, size - offset, &value[offset]);
+}
+
+
+/**
+ * @brief This function queues the control record asked for by the client, the session record first.
+ * @note A control record can only go in between two scan records, it waits while a scan is only partly packed.
+ * @param void
+ * @return true if a record was queued.
+ */
+static bool control_send(void)
+{
+	uint8_t record[CART_BILL_MAXSIZE > CART_SESSION_MAXSIZE ? CART_BILL_MAXSIZE : CART_SESSION_MAXSIZE];
+	uint8_t *notification = ble_tx_reserve();
+	uint8_t control;
+	uint8_t size;
+	uint16_t notification_size;
+
+	if(notification == NULL)
+	{
+		return false;
+	}
+
+	if(control_pending & CONTROL_SESSION)
+	{
+		struct cart_session_info session;
+
+		cart_session_info_get(&session);
+		size = cart_codec_session_encode(record, &session);
+		control = CONTROL_SESSION;
+	}
+	else
+	{
+		struct cart_bill bill = {.total = cart_ledger.total, .item_count = cart_ledger.item_count};
+
+		size = cart_codec_bill_encode(record, &bill);
+		control = CONTROL_BILL;
+	}
+
+	notification_size = ble_packer_wrap(&ble_packer, notification, record, size);
+	if(notification_size == 0)
+	{
+		return false;
+	}
+
+	ble_tx_commit(notification_size);
+	control_pending &= ~control;
+	return true;
+}
+
+
+/**
+ * @brief This function hands the pending notifications to the stack. It is called whenever the stack may take them
+ * again: after queuing new notifications, when the client enables the item stream and on the retry timer. It rearms
+ * the retry timer while the stack is out of buffers, a client with the item stream disabled is waited for without
+ * timer, and wakes up the scan sender once the transmit queue has room for more scans.
+ * @param void
+ * @return void
+ */
+static void ble_tx_resume(void)
 {
-	struct gecko_msg_system_get_bt_address_rsp_t *add = gecko_cmd_system_get_bt_address();
-	char address[40];
-	snprintf(address, 40, "%02x:%02x:%02x:%02x:%02x:%02x",
-			add->address.addr[5],
-			add->address.addr[4],
-			add->address.addr[3],
-			add->address.addr[2],
-			add->address.addr[1],
-			add->address.addr[0]
-	);
-
-	uint8_t bluegecko_address[17] = {((add->address.addr[5] & (0xF0)) >> 4), (add->address.addr[5] & (0x0F)), 58, ((add->address.addr[4] & (0xF0)) >> 4), (add->address.addr[4] & (0x0F)), 0x3A,
-									 ((add->address.addr[3] & (0xF0)) >> 4), (add->address.addr[3] & (0x0F)), 58, ((add->address.addr[2] & (0xF0)) >> 4), (add->address.addr[2] & (0x0F)), 0x3A,
-									 ((add->address.addr[1] & (0xF0)) >> 4), (add->address.addr[1] & (0x0F)), 58, ((add->address.addr[0] & (0xF0)) >> 4), (add->address.addr[0] & (0x0F))};
-	char bluegecko_char_address[17];
-	printf("Blue Gecko Address : ");
-	char *bt_ptr = bluegecko_char_address;
-	for(int i = 0; i < 17; i++)
+	bool done = ble_tx_submit();
+
+	while(done && control_pending && control_send())
 	{
-		//printf("%x", bluegecko_address[i]);
-		bt_ptr = itoa(bluegecko_address[i], bt_ptr, 16);
-		bt_ptr++;
+		done = ble_tx_submit();
 	}
-	for (int i = 0; i < 17; i++)
+
+	if(!done)
 	{
-		if (i == 2 || i == 5 || i == 8 || i == 11 || i == 14)
+		if(!ble_tx.client_disabled)
 		{
-			bluegecko_char_address[i] = ':';
+			gecko_cmd_hardware_set_soft_timer(conn_policy_interval_ticks(), SOFT_TIMER_BLE_TX_RETRY, 1);
 		}
+		return;
+	}
+
+#ifdef LINK_BENCHMARK
+	link_benchmark_run();
+#endif
+
+	if((scan_queue_count() || cart_session_resend_pending()) && (ble_tx_reserve() != NULL))
+	{
+		external_event_set(EVENT_SCAN_READY);
 	}
-	printf("Blue gecko char add :");
-	for (int i = 0; i < 17; i++)
-	printf("%d\n", bluegecko_char_address[i]);
-	for (int i = 9; i < 16; i++)
-		write_nfc_row[i] = bluegecko_char_address[i-9];
-	for(int i = 0; i < 10; i++)
-		write_nfc_row_1[i] = bluegecko_char_address[i + 7];
-
-//	printf("Writw row 1 %s\n", (char *)write_nfc_row);
-	printf("Writw row 2 %s\n", write_nfc_row_1);
-	i2c_write_poll(0x02, write_nfc_row_1);
-	for(int i = 0; i < 1000000; i++);
-	i2c_write_poll(0x01, write_nfc_row);
-	printf("Address written in NFC Module\n");
 }
 
 
@@ -0,0 +1,156 @@
+/*
+ * @file adv_policy.c
+ * @brief This file consists of the advertising policy. After an NFC tap the cart advertises at 20 ms for a couple
+ * of seconds, the phone that tapped connects during the burst, then backs off to a 1 s interval until the
+ * advertising window of the tap is over.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "native_gecko.h"
+#include "em_rtcc.h"
+#include "inc/adv_policy.h"
+#include "inc/connection_param.h"
+#include "inc/ndef.h"
+
+
+#define ADV_POLICY_RTCC_FREQ					(32768)							/* RTCC counter frequency */
+#define ADV_POLICY_MS_TO_TICKS(ms)				(((ms) * ADV_POLICY_RTCC_FREQ) / 1000)
+
+
+/* Flags only, LE general discoverable and no BR/EDR. The rest is in the scan response */
+static const uint8_t adv_policy_data[] = {0x02, 0x01, 0x06};
+
+
+/**
+ * @brief This function returns the RTCC time in milliseconds for the timeline.
+ * @param void
+ * @return Time in milliseconds.
+ */
+static uint32_t adv_policy_time_ms(void)
+{
+	return (uint32_t)(((uint64_t)RTCC_CounterGet() * 1000) / ADV_POLICY_RTCC_FREQ);
+}
+
+
+/**
+ * @brief This function restarts advertising at a new interval, the interval only applies from a start.
+ * @param uint16_t interval Advertising interval in units of 0.625 ms
+ * @return void
+ */
+static void adv_policy_advertise(uint16_t interval)
+{
+	uint16_t result;
+
+	if(adv_policy.advertising)
+	{
+		gecko_cmd_le_gap_stop_advertising(ADV_HANDLE);
+	}
+
+	gecko_cmd_le_gap_set_advertise_timing(ADV_HANDLE, interval, interval, ADV_TIMING_DURATION, ADV_MAXEVENTS);
+	result = gecko_cmd_le_gap_start_advertising(ADV_HANDLE, le_gap_user_data, le_gap_connectable_scannable)->result;
+
+	printf("Timeline %lu ms: advertising every %lu us, result %x\n", (unsigned long)adv_policy_time_ms(),
+			(unsigned long)interval * 625, result);
+
+	adv_policy.interval = interval;
+	adv_policy.advertising = (result == bg_err_success);
+}
+
+
+/**
+ * @brief This function starts the burst after an NFC tap, with the token the phone just read in the scan response.
+ * A tap while advertising starts the burst again.
+ * @param uint32_t tap_timestamp RTCC counter value of the tap
+ * @return Ticks until adv_policy_step().
+ */
+uint32_t adv_policy_start(uint32_t tap_timestamp)
+{
+	uint8_t scan_response[NDEF_SCAN_RESPONSE_MAXSIZE];
+	uint8_t size = ndef_scan_response_build(scan_response);
+
+	gecko_cmd_le_gap_bt5_set_adv_data(ADV_HANDLE, 0, sizeof(adv_policy_data), adv_policy_data);
+	gecko_cmd_le_gap_bt5_set_adv_data(ADV_HANDLE, 1, size, scan_response);
+
+	adv_policy.tap_timestamp = tap_timestamp;
+	adv_policy.tap_pending = true;
+	adv_policy.start_count++;
+
+	adv_policy_advertise(ADV_BURST_INTERVAL);
+	return ADV_POLICY_MS_TO_TICKS(ADV_BURST_MS);
+}
+
+
+/**
+ * @brief This function doubles the advertising interval, up to ADV_INTERVAL_MAX.
+ * @param void
+ * @return Ticks until the next step, 0 once the interval is ADV_INTERVAL_MAX or advertising stopped.
+ */
+uint32_t adv_policy_step(void)
+{
+	uint32_t interval = (uint32_t)adv_policy.interval * 2;
+
+	if(!adv_policy.advertising || (adv_policy.interval >= ADV_INTERVAL_MAX))
+	{
+		return 0;
+	}
+
+	adv_policy.step_count++;
+	adv_policy_advertise((interval < ADV_INTERVAL_MAX) ? interval : ADV_INTERVAL_MAX);
+
+	return (adv_policy.interval < ADV_INTERVAL_MAX) ? ADV_POLICY_MS_TO_TICKS(ADV_BACKOFF_STEP_MS) : 0;
+}
+
+
+/**
+ * @brief This function stops advertising once the window of the tap is over.
+ * @param void
+ * @return void
+ */
+void adv_policy_stop(void)
+{
+	gecko_cmd_le_gap_stop_advertising(ADV_HANDLE);
+	adv_policy.advertising = false;
+
+	if(adv_policy.tap_pending)
+	{
+		adv_policy.tap_pending = false;
+		adv_policy.timeout_count++;
+	}
+}
+
+
+/**
+ * @brief This function records the tap to connection time, on gecko_evt_le_connection_opened_id. The stack stops
+ * advertising when the connection opens.
+ * @param void
+ * @return void
+ */
+void adv_policy_connected(void)
+{
+	uint32_t ms;
+
+	adv_policy.advertising = false;
+	if(!adv_policy.tap_pending)
+	{
+		return;
+	}
+
+	ms = (uint32_t)(((uint64_t)(RTCC_CounterGet() - adv_policy.tap_timestamp) * 1000) / ADV_POLICY_RTCC_FREQ);
+	adv_policy.tap_pending = false;
+	adv_policy.connect_count++;
+	adv_policy.connect_ms_last = ms;
+	adv_policy.connect_ms_total += ms;
+	if(ms > adv_policy.connect_ms_max)
+	{
+		adv_policy.connect_ms_max = ms;
+	}
+
+	printf("Timeline %lu ms: connected %lu ms after the tap, at %lu us advertising\n", (unsigned long)adv_policy_time_ms(),
+			(unsigned long)ms, (unsigned long)adv_policy.interval * 625);
+}
@@ -11,86 +11,312 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "inc/barcode.h"
 #include "inc/leuart.h"
+#include "inc/payload_pool.h"
 
 
 /**
- * @brief This function fetches the payload size from the barcode packet structure and converts it to an integer.
- * @param struct barcode_packet* barcode_packet The pointer to the barcode packet structure
- * @return The payload size
+ * @brief This function drops a malformed or incomplete frame and restarts the search for a preamble
+ * right after the preamble of the dropped frame.
+ * @param struct barcode_parser* parser The pointer to the barcode parser structure
+ * @return void
  */
-static int barcode_payload_size_fetch(struct barcode_packet* barcode_packet)
+static void barcode_parser_resync(struct barcode_parser* parser)
 {
-	int payload_size = 0;
+	parser->truncated_count++;
+	leuart_buffer_consume(1);
+	barcode_parser_init(parser);
+}
 
-	barcode_packet->payload_size[0] = leuart_buffer_pop();
-	barcode_packet->payload_size[1] = leuart_buffer_pop();
-	barcode_packet->payload_size[2] = leuart_buffer_pop();
 
-	payload_size += (barcode_packet->payload_size[0] - ASCII_DIGIT_START) * 100;
-	payload_size += (barcode_packet->payload_size[1] - ASCII_DIGIT_START) * 10;
-	payload_size += (barcode_packet->payload_size[2] - ASCII_DIGIT_START) * 1;
+/**
+ * @brief This function accumulates one ascii digit of the payload size or cost field.
+ * @param struct barcode_parser* parser The pointer to the barcode parser structure
+ * @param char data The received character
+ * @return true if the character was a digit, false otherwise
+ */
+static bool barcode_parser_digit(struct barcode_parser* parser, char data)
+{
+	if(data < ASCII_DIGIT_START || data > (ASCII_DIGIT_START + 9))
+	{
+		return false;
+	}
 
-	return payload_size;
+	parser->field = (parser->field * 10) + (data - ASCII_DIGIT_START);
+	parser->digits++;
 
+	return true;
 }
 
 
 /**
- * @brief This function fetches the cost from the barcode packet structure and converts it to an integer.
- * @param struct barcode_packet* barcode_packet The pointer to the barcode packet structure
- * @return The cost
+ * @brief This function fills the frame descriptor with the payload spans of the current frame.
+ * @param struct barcode_parser* parser The pointer to the barcode parser structure
+ * @param struct barcode_frame* frame The frame descriptor to fill
+ * @return void
  */
-static int barcode_cost_fetch(struct barcode_packet* barcode_packet)
+static void barcode_frame_fill(struct barcode_parser* parser, struct barcode_frame* frame)
 {
-	int cost = 0;
+	uint32_t size;
 
-	barcode_packet->cost[0] = leuart_buffer_pop();
-	barcode_packet->cost[1] = leuart_buffer_pop();
-	barcode_packet->cost[2] = leuart_buffer_pop();
+	memset(frame, 0, sizeof(struct barcode_frame));
+	frame->payload_size = parser->payload_size;
+	frame->cost = parser->cost;
+	frame->frame_size = parser->offset;
 
-	cost += (barcode_packet->cost[0] - ASCII_DIGIT_START) * 100;
-	cost += (barcode_packet->cost[1] - ASCII_DIGIT_START) * 10;
-	cost += (barcode_packet->cost[2] - ASCII_DIGIT_START) * 1;
+	if(parser->state == BARCODE_STATE_CODE)
+	{
+		frame->code = parser->code;
+		frame->code_digits = parser->digits;
+		return;
+	}
 
-	return cost;
+	if(parser->payload_size == 0)
+	{
+		return;
+	}
+
+	size = leuart_buffer_peek(BARCODE_HEADER_SIZE, &frame->span[0]);
+	if(size >= parser->payload_size)
+	{
+		frame->span_size[0] = parser->payload_size;
+	}
+	else
+	{
+		/* The payload wraps around the end of leuart_circbuff */
+		frame->span_size[0] = size;
+		frame->span_size[1] = parser->payload_size - size;
+		leuart_buffer_peek(BARCODE_HEADER_SIZE + size, &frame->span[1]);
+	}
 }
 
 
 /**
- * @brief This function creates a barcode packet structure as per the data received from the leuart_buffer on pop()
- * and returns the payload size to a pointer passed as a parameter
- * @param struct barcode_packet* barcode_packet, int *payload_size
+ * @brief This function resets the barcode parser to wait for the next preamble.
+ * @note The statistics are not reset.
+ * @param struct barcode_parser* parser The pointer to the barcode parser structure
  * @return void
  */
-int barcode_packet_create(struct barcode_packet* barcode_packet, int *payload_size)
+void barcode_parser_init(struct barcode_parser* parser)
+{
+	parser->state = BARCODE_STATE_PREAMBLE;
+	parser->offset = 0;
+	parser->field = 0;
+	parser->digits = 0;
+	parser->payload_size = 0;
+	parser->cost = 0;
+	parser->code = 0;
+}
+
+
+/**
+ * @brief This function parses the data available in leuart_circbuff and stops at the end of the first complete frame.
+ * It can be called with partial data, the parser resumes from where it stopped on the next call.
+ * Data received between frames is consumed and malformed frames are dropped.
+ * @note The bytes of a complete frame stay in leuart_circbuff until barcode_frame_release() is called.
+ * @param struct barcode_parser* parser The pointer to the barcode parser structure
+ * @param struct barcode_frame* frame Filled with the frame descriptor when a complete frame is found
+ * @return true if a complete frame was found, false if more data is needed
+ */
+bool barcode_parser_run(struct barcode_parser* parser, struct barcode_frame* frame)
 {
+	const char *data;
+	uint32_t size;
 
-	if( barcode_packet->payload == NULL && leuart_circbuff.read_index < LEUART_BUFFER_MAXSIZE)
+	for(;;)
 	{
-		int local_payload_size, cost;
+		size = leuart_buffer_peek(parser->offset, &data);
 
-		barcode_packet->preamble = leuart_buffer_pop();
+		/* leuart_circbuff dropped its unread data after an overrun or an LDMA error, the partial frame is gone */
+		if(parser->overrun_count != leuart_circbuff.overrun_count)
+		{
+			parser->overrun_count = leuart_circbuff.overrun_count;
+			if(parser->offset)
+			{
+				parser->truncated_count++;
+			}
+			barcode_parser_init(parser);
+			continue;
+		}
 
-		/* Fetching and converting the character data of Payload size and Cost size here into integer digits */
-		local_payload_size = barcode_payload_size_fetch(barcode_packet);
-		printf("Payload_size: %d\n", local_payload_size);
+		if(size == 0)
+		{
+			break;
+		}
 
-		cost = barcode_cost_fetch(barcode_packet);
-		printf("Cost: %d\n", cost);
+		switch(parser->state)
+		{
+		case BARCODE_STATE_PREAMBLE:
+		{
+			/* Everything before the preamble is dropped */
+			const char *preamble = memchr(data, BARCODE_PREAMBLE, size);
+			uint32_t garbage = (preamble == NULL) ? size : (uint32_t)(preamble - data);
+
+			parser->garbage_count += garbage;
+			leuart_buffer_consume(garbage);
+
+			if(preamble != NULL)
+			{
+				parser->offset = 1;
+				parser->state = BARCODE_STATE_PAYLOAD_SIZE;
+			}
+			break;
+		}
 
-		barcode_packet->payload = malloc(sizeof(char) * (local_payload_size + 1));
-		if(barcode_packet->payload == NULL)
+		case BARCODE_STATE_PAYLOAD_SIZE:
+		case BARCODE_STATE_COST:
+			/* The code marker right after the preamble starts a code frame */
+			if((parser->offset == 1) && (*data == BARCODE_CODE_MARKER))
+			{
+				parser->offset++;
+				parser->state = BARCODE_STATE_CODE;
+				break;
+			}
+
+			if(!barcode_parser_digit(parser, *data))
+			{
+				barcode_parser_resync(parser);
+				break;
+			}
+			parser->offset++;
+
+			if(parser->digits == BARCODE_FIELD_DIGITS)
+			{
+				if(parser->state == BARCODE_STATE_PAYLOAD_SIZE)
+				{
+					parser->payload_size = parser->field;
+					parser->state = BARCODE_STATE_COST;
+
+					/* A frame bigger than leuart_circbuff can never be completed */
+					if(parser->payload_size > BARCODE_PAYLOAD_MAXSIZE)
+					{
+						barcode_parser_resync(parser);
+						break;
+					}
+				}
+				else
+				{
+					parser->cost = parser->field;
+					parser->state = (parser->payload_size > 0) ? BARCODE_STATE_PAYLOAD : BARCODE_STATE_POSTAMBLE;
+				}
+
+				parser->field = 0;
+				parser->digits = 0;
+			}
+			break;
+
+		case BARCODE_STATE_PAYLOAD:
 		{
-			printf("ERROR: Cannot Malloc Payload data in barcode_packet_create() function./n");
+			/* Skip over the payload without touching it */
+			uint32_t remaining = BARCODE_HEADER_SIZE + parser->payload_size - parser->offset;
+
+			parser->offset += (size < remaining) ? size : remaining;
+			if(parser->offset == (BARCODE_HEADER_SIZE + parser->payload_size))
+			{
+				parser->state = BARCODE_STATE_POSTAMBLE;
+			}
+			break;
+		}
+
+		case BARCODE_STATE_POSTAMBLE:
+			if(*data != BARCODE_POSTAMBLE)
+			{
+				barcode_parser_resync(parser);
+				break;
+			}
+			parser->offset++;
+			parser->frame_count++;
+
+			barcode_frame_fill(parser, frame);
+			return true;
+
+		case BARCODE_STATE_CODE:
+			if((*data == BARCODE_POSTAMBLE) && (parser->digits > 0))
+			{
+				parser->offset++;
+				parser->frame_count++;
+
+				barcode_frame_fill(parser, frame);
+				return true;
+			}
+
+			if((parser->digits == BARCODE_CODE_MAXDIGITS) || (*data < ASCII_DIGIT_START) || (*data > (ASCII_DIGIT_START + 9)))
+			{
+				barcode_parser_resync(parser);
+				break;
+			}
+			parser->code = (parser->code * 10) + (*data - ASCII_DIGIT_START);
+			parser->digits++;
+			parser->offset++;
+			break;
 		}
+	}
+
+	return false;
+}
+
+
+/**
+ * @brief This function removes a frame returned by barcode_parser_run() from leuart_circbuff and
+ * gets the parser ready for the next frame.
+ * @param struct barcode_parser* parser The pointer to the barcode parser structure
+ * @param struct barcode_frame* frame The frame descriptor returned by barcode_parser_run()
+ * @return void
+ */
+void barcode_frame_release(struct barcode_parser* parser, const struct barcode_frame* frame)
+{
+	leuart_buffer_consume(frame->frame_size);
+	barcode_parser_init(parser);
+}
+
 
-		*payload_size = local_payload_size;
-		return cost;
+/**
+ * @brief This function creates a barcode packet structure from a complete frame. The payload is copied
+ * out of leuart_circbuff, handling the wrap around, so that the frame can be released before the packet is sent.
+ * @param struct barcode_packet* barcode_packet The packet to fill
+ * @param struct barcode_frame* frame The frame descriptor returned by barcode_parser_run()
+ * @note The payload is borrowed from the payload pool and must be given back with payload_pool_free().
+ * @return The cost of the product, -1 if the payload could not be allocated
+ */
+int barcode_packet_create(struct barcode_packet* barcode_packet, const struct barcode_frame* frame)
+{
+	uint16_t size = frame->payload_size;
+	uint16_t cost = frame->cost;
+
+	barcode_packet->preamble = BARCODE_PREAMBLE;
+	barcode_packet->postamble = BARCODE_POSTAMBLE;
+
+	/* Keep the ascii representation of the payload size and cost fields */
+	for(int i = BARCODE_FIELD_DIGITS - 1; i >= 0; i--)
+	{
+		barcode_packet->payload_size[i] = ASCII_DIGIT_START + (size % 10);
+		barcode_packet->cost[i] = ASCII_DIGIT_START + (cost % 10);
+		size /= 10;
+		cost /= 10;
+	}
+	printf("Payload_size: %d\n", frame->payload_size);
+	printf("Cost: %d\n", frame->cost);
+
+	barcode_packet->payload = payload_pool_alloc(frame->payload_size + 1);
+	if(barcode_packet->payload == NULL)
+	{
+		printf("ERROR: Cannot allocate Payload data in barcode_packet_create() function.\n");
+		return -1;
+	}
+
+	if(frame->span_size[0])
+	{
+		memcpy(&barcode_packet->payload[0], frame->span[0], frame->span_size[0]);
+	}
+	if(frame->span_size[1])
+	{
+		memcpy(&barcode_packet->payload[frame->span_size[0]], frame->span[1], frame->span_size[1]);
 	}
+	barcode_packet->payload[frame->payload_size] = '\0';						/* Adding a NULL character at the end of string*/
 
-	return -1;
+	return frame->cost;
 }
 
 
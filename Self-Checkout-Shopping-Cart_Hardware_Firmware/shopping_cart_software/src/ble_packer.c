@@ -0,0 +1,182 @@
+/*
+ * @file ble_packer.c
+ * @brief This file consists of the functions packing the queued scans into bluetooth notifications.
+ * The notification size follows the ATT MTU negotiated with the client, several scans share one notification
+ * and scans bigger than a notification are fragmented.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <string.h>
+#include "inc/ble_packer.h"
+
+
+/**
+ * @brief This function returns the number of bytes a scan record takes in the notification stream.
+ * @param struct scan_record* record The queued scan
+ * @return Size of the record in bytes.
+ */
+static uint16_t ble_packer_record_size(const struct scan_record* record)
+{
+	return record->header_size + record->payload_size;
+}
+
+
+/**
+ * @brief This function copies a part of the encoded item record of a scan. The encoded header is followed
+ * by the product name taken straight from the payload.
+ * @param struct scan_record* record The queued scan
+ * @param uint16_t offset Offset of the first byte to copy inside the record
+ * @param uint8_t* dest Destination buffer
+ * @param uint16_t size Space left in the destination buffer
+ * @return Number of bytes copied.
+ */
+static uint16_t ble_packer_record_copy(const struct scan_record* record, uint16_t offset, uint8_t* dest, uint16_t size)
+{
+	uint16_t copied = 0;
+
+	/* Type, length and fixed fields */
+	if(offset < record->header_size)
+	{
+		uint16_t count = record->header_size - offset;
+
+		count = (count < size) ? count : size;
+		memcpy(dest, &record->header[offset], count);
+		copied = count;
+		offset += count;
+	}
+
+	/* Product name */
+	if(copied < size)
+	{
+		uint16_t count = ble_packer_record_size(record) - offset;
+
+		count = (count < (size - copied)) ? count : (size - copied);
+		memcpy(&dest[copied], &record->packet.payload[offset - record->header_size], count);
+		copied += count;
+	}
+
+	return copied;
+}
+
+
+/**
+ * @brief This function initializes the packer for a new connection.
+ * @param struct ble_packer* packer The pointer to the packer structure
+ * @return void
+ */
+void ble_packer_init(struct ble_packer* packer)
+{
+	memset(packer, 0, sizeof(struct ble_packer));
+	packer->mtu = BLE_ATT_MTU_DEFAULT;
+}
+
+
+/**
+ * @brief This function sets the ATT MTU reported by the gecko_evt_gatt_mtu_exchanged_id event.
+ * @param struct ble_packer* packer The pointer to the packer structure
+ * @param uint16_t mtu The negotiated ATT MTU
+ * @return void
+ */
+void ble_packer_set_mtu(struct ble_packer* packer, uint16_t mtu)
+{
+	if(mtu < BLE_ATT_MTU_DEFAULT)
+	{
+		mtu = BLE_ATT_MTU_DEFAULT;
+	}
+	else if(mtu > BLE_ATT_MTU_MAX)
+	{
+		mtu = BLE_ATT_MTU_MAX;
+	}
+
+	packer->mtu = mtu;
+}
+
+
+/**
+ * @brief This function packs the records at the front of scan_queue into one notification.
+ * Records completely packed are removed from the queue.
+ * @param struct ble_packer* packer The pointer to the packer structure
+ * @param uint8_t* notification Buffer of at least BLE_PACKER_NOTIFICATION_MAXSIZE bytes
+ * @return Size of the notification, 0 if there is nothing to send.
+ */
+uint16_t ble_packer_fill(struct ble_packer* packer, uint8_t* notification)
+{
+	uint16_t capacity = packer->mtu - BLE_ATT_HEADER_SIZE;
+	uint16_t size = BLE_PACKER_HEADER_SIZE;
+	uint8_t flags = 0;
+	uint32_t items = 0;
+	struct scan_record *record;
+
+	if(scan_queue_front() == NULL)
+	{
+		return 0;
+	}
+
+	if(packer->record_offset)
+	{
+		flags |= BLE_PACKER_FLAG_CONTINUED;
+	}
+
+	while((size < capacity) && ((record = scan_queue_front()) != NULL))
+	{
+		uint16_t count = ble_packer_record_copy(record, packer->record_offset, &notification[size], capacity - size);
+
+		size += count;
+		packer->record_offset += count;
+
+		if(packer->record_offset == ble_packer_record_size(record))
+		{
+			scan_queue_pop();
+			packer->record_offset = 0;
+			items++;
+		}
+	}
+
+	if(packer->record_offset)
+	{
+		flags |= BLE_PACKER_FLAG_MORE;
+		packer->fragment_count++;
+	}
+
+	notification[0] = packer->sequence++;
+	notification[1] = (CART_CODEC_VERSION << BLE_PACKER_VERSION_SHIFT) | flags;
+
+	packer->notification_count++;
+	packer->item_count += items;
+	if(items > packer->items_max)
+	{
+		packer->items_max = items;
+	}
+
+	return size;
+}
+
+
+/**
+ * @brief This function puts a single record, such as the bill, in a notification of its own.
+ * @note Must not be called while a record of scan_queue is only partly sent.
+ * @param struct ble_packer* packer The pointer to the packer structure
+ * @param uint8_t* notification Buffer of at least size + BLE_PACKER_HEADER_SIZE bytes
+ * @param uint8_t* record The encoded record
+ * @param uint16_t size Size of the record, must fit in one notification of the current MTU
+ * @return Size of the notification, 0 if the record does not fit.
+ */
+uint16_t ble_packer_wrap(struct ble_packer* packer, uint8_t* notification, const uint8_t* record, uint16_t size)
+{
+	if((packer->record_offset != 0) || ((size + BLE_PACKER_HEADER_SIZE) > (packer->mtu - BLE_ATT_HEADER_SIZE)))
+	{
+		return 0;
+	}
+
+	notification[0] = packer->sequence++;
+	notification[1] = (CART_CODEC_VERSION << BLE_PACKER_VERSION_SHIFT);
+	memcpy(&notification[BLE_PACKER_HEADER_SIZE], record, size);
+
+	packer->notification_count++;
+
+	return size + BLE_PACKER_HEADER_SIZE;
+}
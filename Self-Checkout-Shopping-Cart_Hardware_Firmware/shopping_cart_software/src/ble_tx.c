@@ -0,0 +1,142 @@
+/*
+ * @file ble_tx.c
+ * @brief This file consists of the transmit queue between the notification packer and the bluetooth stack.
+ * The stack refuses notifications while its buffers are full or an indication is not confirmed yet,
+ * the queue keeps them and submits them again once the stack has room, so no scan is lost during bursts.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "native_gecko.h"
+#include "inc/ble_tx.h"
+
+
+/**
+ * @brief This function initializes the transmit queue for a new connection and clears the statistics.
+ * @param uint8_t connection The connection handle
+ * @param uint16_t characteristic The characteristic the notifications are sent on
+ * @return void
+ */
+void ble_tx_init(uint8_t connection, uint16_t characteristic)
+{
+	memset(&ble_tx, 0, sizeof(struct ble_tx));
+	ble_tx.connection = connection;
+	ble_tx.characteristic = characteristic;
+}
+
+
+/**
+ * @brief This function drops all the pending notifications, they are added to the drop count.
+ * @param void
+ * @return void
+ */
+void ble_tx_flush(void)
+{
+	if(ble_tx_count())
+	{
+		printf("Transmit queue: %lu notifications dropped on disconnect\n", (unsigned long)ble_tx_count());
+	}
+
+	ble_tx.drop_count += ble_tx_count();
+	ble_tx.head = ble_tx.tail;
+	ble_tx.attempts = 0;
+}
+
+
+/**
+ * @brief This function returns the number of notifications not accepted by the stack yet.
+ * @param void
+ * @return Number of pending notifications.
+ */
+uint32_t ble_tx_count(void)
+{
+	return ble_tx.tail - ble_tx.head;
+}
+
+
+/**
+ * @brief This function returns the buffer of the next free entry so the notification can be built in place.
+ * @param void
+ * @return Buffer of BLE_PACKER_NOTIFICATION_MAXSIZE bytes, NULL if the queue is full.
+ */
+uint8_t* ble_tx_reserve(void)
+{
+	if(ble_tx_count() >= BLE_TX_QUEUE_SIZE)
+	{
+		return NULL;
+	}
+
+	return ble_tx.entry[ble_tx.tail & BLE_TX_QUEUE_MASK].data;
+}
+
+
+/**
+ * @brief This function queues the notification built in the buffer returned by ble_tx_reserve().
+ * @param uint16_t size Size of the notification
+ * @return void
+ */
+void ble_tx_commit(uint16_t size)
+{
+	ble_tx.entry[ble_tx.tail & BLE_TX_QUEUE_MASK].size = size;
+	ble_tx.tail++;
+
+	if(ble_tx_count() > ble_tx.high_water)
+	{
+		ble_tx.high_water = ble_tx_count();
+	}
+}
+
+
+/**
+ * @brief This function hands the pending notifications to the stack, in order, as long as the stack accepts them.
+ * A notification refused for lack of buffers or while the client has the item stream disabled is kept, however long
+ * it takes, so that neither a scan nor the order of the stream is lost. ble_tx.client_disabled tells the two apart:
+ * buffers come back with the next connection events, the item stream only with a write of the client configuration.
+ * Only a notification rejected with any other error is dropped, the stack will never take it.
+ * @param void
+ * @return true if the queue is empty, false if the stack refused a notification and it has to be retried later.
+ */
+bool ble_tx_submit(void)
+{
+	while(ble_tx_count())
+	{
+		struct ble_tx_entry *entry = &ble_tx.entry[ble_tx.head & BLE_TX_QUEUE_MASK];
+		uint16_t result = gecko_cmd_gatt_server_send_characteristic_notification(ble_tx.connection, ble_tx.characteristic,
+																				  entry->size, entry->data)->result;
+
+		if(result == bg_err_success)
+		{
+			if(ble_tx.attempts > ble_tx.attempts_max)
+			{
+				ble_tx.attempts_max = ble_tx.attempts;
+			}
+			ble_tx.head++;
+			ble_tx.attempts = 0;
+			ble_tx.client_disabled = false;
+			ble_tx.sent_count++;
+			ble_tx.sent_bytes += entry->size;
+			continue;
+		}
+
+		/* No buffer left, or notifications are not enabled, try again later */
+		if((result == bg_err_out_of_memory) || (result == bg_err_wrong_state))
+		{
+			ble_tx.client_disabled = (result == bg_err_wrong_state);
+			ble_tx.attempts++;
+			ble_tx.retry_count++;
+			return false;
+		}
+
+		printf("ERROR: Notification dropped, send result %x\n", result);
+		ble_tx.head++;
+		ble_tx.attempts = 0;
+		ble_tx.drop_count++;
+	}
+
+	return true;
+}
@@ -0,0 +1,338 @@
+/*
+ * @file cart_codec.c
+ * @brief This file consists of the encoder and decoder of the binary cart records sent over bluetooth.
+ * It only depends on the C library so that the same file can be built into host side tools.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <string.h>
+#include "inc/cart_codec.h"
+
+
+#define FNV1A_OFFSET_BASIS						(2166136261u)
+#define FNV1A_PRIME								(16777619u)
+
+
+/**
+ * @brief This function encodes a varint.
+ * @param uint8_t* dest Destination buffer of at least CART_VARINT_MAXSIZE bytes
+ * @param uint32_t value Value to encode
+ * @return Number of bytes written.
+ */
+uint8_t cart_codec_varint_put(uint8_t* dest, uint32_t value)
+{
+	uint8_t size = 0;
+
+	while(value >= 0x80)
+	{
+		dest[size++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	dest[size++] = (uint8_t)value;
+
+	return size;
+}
+
+
+/**
+ * @brief This function decodes a varint.
+ * @param uint8_t* src Source buffer
+ * @param uint16_t size Number of bytes available in the source buffer
+ * @param uint32_t* value Decoded value
+ * @return Number of bytes read, 0 if the varint is truncated or longer than 32 bits.
+ */
+uint8_t cart_codec_varint_get(const uint8_t* src, uint16_t size, uint32_t* value)
+{
+	uint32_t result = 0;
+
+	for(uint8_t i = 0; (i < size) && (i < CART_VARINT_MAXSIZE); i++)
+	{
+		result |= (uint32_t)(src[i] & 0x7F) << (7 * i);
+		if((src[i] & 0x80) == 0)
+		{
+			/* The fifth byte only has 4 significant bits */
+			if((i == (CART_VARINT_MAXSIZE - 1)) && (src[i] > 0x0F))
+			{
+				return 0;
+			}
+			*value = result;
+			return i + 1;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief This function derives the product id from the product name with a 32 bit FNV-1a hash.
+ * @param char* name Product name, does not need to be NULL terminated
+ * @param uint16_t size Size of the product name
+ * @return The product id.
+ */
+uint32_t cart_codec_product_id(const char* name, uint16_t size)
+{
+	uint32_t hash = FNV1A_OFFSET_BASIS;
+
+	for(uint16_t i = 0; i < size; i++)
+	{
+		hash ^= (uint8_t)name[i];
+		hash *= FNV1A_PRIME;
+	}
+
+	return hash;
+}
+
+
+/**
+ * @brief This function encodes the type, length and fixed fields of an item record.
+ * With CART_ITEM_FLAG_NAME the name_size bytes of the name have to be sent right after the header. The product id is
+ * left out when the decoder can derive it from the name.
+ * @param uint8_t* dest Destination buffer of at least CART_ITEM_HEADER_MAXSIZE bytes
+ * @param struct cart_item* item The item to encode
+ * @return Number of bytes written.
+ */
+uint8_t cart_codec_item_header(uint8_t* dest, const struct cart_item* item)
+{
+	uint8_t fields[(4 * CART_VARINT_MAXSIZE) + 1];
+	uint8_t fields_size = 0;
+	uint8_t flags = (item->flags & ~CART_ITEM_FLAG_CODEC) | CART_ITEM_FLAG_ID;
+	uint16_t value_size;
+	uint8_t size = 0;
+
+	if((item->flags & CART_ITEM_FLAG_NAME) && (cart_codec_product_id(item->name, item->name_size) == item->product_id))
+	{
+		flags &= ~CART_ITEM_FLAG_ID;
+	}
+	if(item->quantity != 1)
+	{
+		flags |= CART_ITEM_FLAG_QUANTITY;
+	}
+
+	fields[fields_size++] = flags;
+	if(flags & CART_ITEM_FLAG_ID)
+	{
+		fields_size += cart_codec_varint_put(&fields[fields_size], item->product_id);
+	}
+	fields_size += cart_codec_varint_put(&fields[fields_size], item->price);
+	if(flags & CART_ITEM_FLAG_QUANTITY)
+	{
+		fields_size += cart_codec_varint_put(&fields[fields_size], item->quantity);
+	}
+	if(flags & CART_ITEM_FLAG_SEQUENCE)
+	{
+		fields_size += cart_codec_varint_put(&fields[fields_size], item->sequence);
+	}
+
+	value_size = fields_size + ((item->flags & CART_ITEM_FLAG_NAME) ? item->name_size : 0);
+
+	dest[size++] = CART_TLV_ITEM;
+	size += cart_codec_varint_put(&dest[size], value_size);
+	memcpy(&dest[size], fields, fields_size);
+
+	return size + fields_size;
+}
+
+
+/**
+ * @brief This function encodes a record made of two varints.
+ * @param uint8_t* dest Destination buffer of at least 1 + CART_LENGTH_MAXSIZE + 2 * CART_VARINT_MAXSIZE bytes
+ * @param uint8_t type The record type
+ * @param uint32_t first The first field
+ * @param uint32_t second The second field
+ * @return Number of bytes written.
+ */
+static uint8_t cart_codec_pair_encode(uint8_t* dest, uint8_t type, uint32_t first, uint32_t second)
+{
+	uint8_t fields[2 * CART_VARINT_MAXSIZE];
+	uint8_t fields_size = 0;
+	uint8_t size = 0;
+
+	fields_size += cart_codec_varint_put(&fields[fields_size], first);
+	fields_size += cart_codec_varint_put(&fields[fields_size], second);
+
+	dest[size++] = type;
+	size += cart_codec_varint_put(&dest[size], fields_size);
+	memcpy(&dest[size], fields, fields_size);
+
+	return size + fields_size;
+}
+
+
+/**
+ * @brief This function decodes the two varints of a bill, session or catalog record.
+ * @param uint8_t* value The record value
+ * @param uint16_t size Size of the record value
+ * @param uint32_t* first The first field
+ * @param uint32_t* second The second field
+ * @return 0 on success, -1 if the value is malformed.
+ */
+static int cart_codec_pair_decode(const uint8_t* value, uint16_t size, uint32_t* first, uint32_t* second)
+{
+	uint8_t count = cart_codec_varint_get(value, size, first);
+
+	if((count == 0) || (cart_codec_varint_get(&value[count], size - count, second) == 0))
+	{
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief This function encodes a bill record.
+ * @param uint8_t* dest Destination buffer of at least CART_BILL_MAXSIZE bytes
+ * @param struct cart_bill* bill The bill to encode
+ * @return Number of bytes written.
+ */
+uint8_t cart_codec_bill_encode(uint8_t* dest, const struct cart_bill* bill)
+{
+	return cart_codec_pair_encode(dest, CART_TLV_BILL, bill->total, bill->item_count);
+}
+
+
+/**
+ * @brief This function encodes a session record.
+ * @param uint8_t* dest Destination buffer of at least CART_SESSION_MAXSIZE bytes
+ * @param struct cart_session_info* session The session to encode
+ * @return Number of bytes written.
+ */
+uint8_t cart_codec_session_encode(uint8_t* dest, const struct cart_session_info* session)
+{
+	return cart_codec_pair_encode(dest, CART_TLV_SESSION, session->id, session->sequence);
+}
+
+
+/**
+ * @brief This function encodes a catalog record.
+ * @param uint8_t* dest Destination buffer of at least CART_CATALOG_MAXSIZE bytes
+ * @param struct cart_catalog_info* catalog The catalog to encode
+ * @return Number of bytes written.
+ */
+uint8_t cart_codec_catalog_encode(uint8_t* dest, const struct cart_catalog_info* catalog)
+{
+	return cart_codec_pair_encode(dest, CART_TLV_CATALOG, catalog->record_count, catalog->seed);
+}
+
+
+/**
+ * @brief This function decodes one record. The name of an item points into the source buffer.
+ * @param uint8_t* src Source buffer
+ * @param uint16_t size Number of bytes available in the source buffer
+ * @param struct cart_record* record Decoded record, the type is left as read for unknown types
+ * @return Number of bytes of the record, -1 if the record is truncated or malformed.
+ */
+int32_t cart_codec_decode(const uint8_t* src, uint16_t size, struct cart_record* record)
+{
+	uint32_t value_size;
+	uint16_t offset = 1;
+	uint8_t count;
+
+	memset(record, 0, sizeof(struct cart_record));
+	if(size < 2)
+	{
+		return -1;
+	}
+	record->type = src[0];
+
+	count = cart_codec_varint_get(&src[offset], size - offset, &value_size);
+	if((count == 0) || (value_size > (uint32_t)(size - offset - count)))
+	{
+		return -1;
+	}
+	offset += count;
+
+	const uint8_t *value = &src[offset];
+	uint16_t end = offset + value_size;
+	uint16_t pos = 0;
+
+	switch(record->type)
+	{
+	case CART_TLV_ITEM:
+	{
+		uint32_t *fields[3] = {&record->item.product_id, &record->item.price, &record->item.quantity};
+		uint8_t first;
+		uint8_t last;
+
+		if(value_size == 0)
+		{
+			return -1;
+		}
+		record->item.flags = value[pos++];
+
+		/* Without the id the name has to be there to derive it */
+		if(!(record->item.flags & (CART_ITEM_FLAG_ID | CART_ITEM_FLAG_NAME)))
+		{
+			return -1;
+		}
+
+		first = (record->item.flags & CART_ITEM_FLAG_ID) ? 0 : 1;
+		last = (record->item.flags & CART_ITEM_FLAG_QUANTITY) ? 3 : 2;
+		record->item.quantity = 1;
+		for(uint8_t i = first; i < last; i++)
+		{
+			count = cart_codec_varint_get(&value[pos], value_size - pos, fields[i]);
+			if(count == 0)
+			{
+				return -1;
+			}
+			pos += count;
+		}
+
+		if(record->item.flags & CART_ITEM_FLAG_SEQUENCE)
+		{
+			count = cart_codec_varint_get(&value[pos], value_size - pos, &record->item.sequence);
+			if(count == 0)
+			{
+				return -1;
+			}
+			pos += count;
+		}
+
+		if(record->item.flags & CART_ITEM_FLAG_NAME)
+		{
+			record->item.name = (const char *)&value[pos];
+			record->item.name_size = value_size - pos;
+		}
+
+		if(!(record->item.flags & CART_ITEM_FLAG_ID))
+		{
+			record->item.product_id = cart_codec_product_id(record->item.name, record->item.name_size);
+		}
+		record->item.flags &= ~CART_ITEM_FLAG_CODEC;
+		break;
+	}
+
+	case CART_TLV_BILL:
+		if(cart_codec_pair_decode(value, value_size, &record->bill.total, &record->bill.item_count) < 0)
+		{
+			return -1;
+		}
+		break;
+
+	case CART_TLV_SESSION:
+		if(cart_codec_pair_decode(value, value_size, &record->session.id, &record->session.sequence) < 0)
+		{
+			return -1;
+		}
+		break;
+
+	case CART_TLV_CATALOG:
+		if(cart_codec_pair_decode(value, value_size, &record->catalog.record_count, &record->catalog.seed) < 0)
+		{
+			return -1;
+		}
+		break;
+
+	default:
+		/* Unknown type, skipped by the caller */
+		break;
+	}
+
+	return end;
+}
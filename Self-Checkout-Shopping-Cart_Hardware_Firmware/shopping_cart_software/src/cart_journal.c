@@ -0,0 +1,519 @@
+/*
+ * @file cart_journal.c
+ * @brief This file consists of the cart journal in the MX25 external flash. Every change of the cart is appended
+ * as a small CRC protected record and the journal is replayed at boot to rebuild the cart session and ledger.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "em_rtcc.h"
+#include "inc/cart_journal.h"
+#include "inc/cart_session.h"
+#include "inc/flash_spi.h"
+
+
+/**
+ * @brief This function computes the CRC-16/CCITT of a record.
+ * @param uint8_t* data The record
+ * @param uint16_t size Number of bytes
+ * @return The CRC.
+ */
+static uint16_t cart_journal_crc(const uint8_t* data, uint16_t size)
+{
+	uint16_t crc = 0xFFFF;
+
+	for(uint16_t i = 0; i < size; i++)
+	{
+		crc ^= (uint16_t)data[i] << 8;
+		for(uint8_t bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+
+/**
+ * @brief This function returns the flash address of a position in the journal.
+ * @param uint8_t sector Sector of the ring
+ * @param uint16_t offset Offset in the sector
+ * @return The address.
+ */
+static uint32_t cart_journal_address(uint8_t sector, uint16_t offset)
+{
+	return CART_JOURNAL_ADDRESS + ((uint32_t)sector * CART_JOURNAL_SECTOR_SIZE) + offset;
+}
+
+
+/**
+ * @brief This function returns the sector following another one in the ring.
+ * @param uint8_t sector Sector of the ring
+ * @return The next sector.
+ */
+static uint8_t cart_journal_next(uint8_t sector)
+{
+	return (sector + 1) % CART_JOURNAL_SECTOR_COUNT;
+}
+
+
+/**
+ * @brief This function starts the background erase of the sector after the write position, unless it holds
+ * the start of the current session.
+ * @param void
+ * @return void
+ */
+static void cart_journal_erase_next(void)
+{
+	uint8_t next = cart_journal_next(cart_journal.sector);
+
+	if(cart_journal.next != CART_JOURNAL_NEXT_DIRTY)
+	{
+		return;
+	}
+
+	if(next == cart_journal.session_sector)
+	{
+		if(!cart_journal.full)
+		{
+			printf("ERROR: Cart journal full, the changes after the end of sector %u are not kept.\n", cart_journal.sector);
+		}
+		cart_journal.full = true;
+		return;
+	}
+
+	/* Retried by cart_journal_service() if the flash is busy */
+	if(flash_spi_erase_start(cart_journal_address(next, 0)) == 0)
+	{
+		cart_journal.next = CART_JOURNAL_NEXT_ERASING;
+		cart_journal.erase_count++;
+	}
+}
+
+
+/**
+ * @brief This function programs the bytes of the page not programmed yet.
+ * @param bool wait true to wait for the end of the background erase, false to give up while it runs
+ * @return 0 on success, -1 if nothing could be programmed.
+ */
+static int cart_journal_flush(bool wait)
+{
+	if(cart_journal.flushed == cart_journal.fill)
+	{
+		return 0;
+	}
+
+	if(flash_spi_erase_busy())
+	{
+		if(!wait || (flash_spi_erase_wait() < 0))
+		{
+			return -1;
+		}
+	}
+
+	if(flash_spi_program(cart_journal_address(cart_journal.sector, cart_journal.page_start + cart_journal.flushed),
+			&cart_journal.page[cart_journal.flushed], cart_journal.fill - cart_journal.flushed) < 0)
+	{
+		printf("ERROR: Cart journal page program failed.\n");
+		return -1;
+	}
+
+	cart_journal.flushed = cart_journal.fill;
+	cart_journal.program_count++;
+	flash_spi_sleep();
+
+	return 0;
+}
+
+
+/**
+ * @brief This function moves the write position to the first page of the next sector.
+ * @param void
+ * @return 0 on success, -1 if the next sector cannot be used.
+ */
+static int cart_journal_sector_open(void)
+{
+	/* The erase could not be started in the background, the flash was busy */
+	cart_journal_erase_next();
+
+	if(cart_journal.next == CART_JOURNAL_NEXT_ERASING)
+	{
+		/* The erase is followed again by cart_journal_service() */
+		if(flash_spi_erase_wait() < 0)
+		{
+			return -1;
+		}
+		cart_journal.next = CART_JOURNAL_NEXT_ERASED;
+	}
+
+	if(cart_journal.next != CART_JOURNAL_NEXT_ERASED)
+	{
+		return -1;
+	}
+
+	cart_journal.sector = cart_journal_next(cart_journal.sector);
+	cart_journal.generation++;
+	cart_journal.page_start = 0;
+
+	/* The header is programmed with the first records of the sector */
+	uint32_t header[3] = {CART_JOURNAL_MAGIC, cart_journal.generation, ~cart_journal.generation};
+	memcpy(cart_journal.page, header, CART_JOURNAL_HEADER_SIZE);
+	cart_journal.fill = CART_JOURNAL_HEADER_SIZE;
+
+	cart_journal.next = CART_JOURNAL_NEXT_DIRTY;
+	cart_journal_erase_next();
+
+	return 0;
+}
+
+
+/**
+ * @brief This function adds a record to the page, moving to the next page or sector when it does not fit.
+ * @param uint8_t* record The record, followed by room for its CRC
+ * @param uint16_t size Size of the record without its CRC
+ * @return void
+ */
+static void cart_journal_append(uint8_t* record, uint16_t size)
+{
+	uint16_t crc = cart_journal_crc(record, size);
+
+	record[size++] = (uint8_t)crc;
+	record[size++] = (uint8_t)(crc >> 8);
+
+	if((cart_journal.fill + size) > CART_JOURNAL_PAGE_SIZE)
+	{
+		/* The page is programmed again by cart_journal_service() */
+		if(cart_journal_flush(true) < 0)
+		{
+			cart_journal.drop_count++;
+			return;
+		}
+
+		memset(cart_journal.page, 0xFF, CART_JOURNAL_PAGE_SIZE);
+		cart_journal.page_start += CART_JOURNAL_PAGE_SIZE;
+		cart_journal.fill = 0;
+		cart_journal.flushed = 0;
+
+		if((cart_journal.page_start >= CART_JOURNAL_SECTOR_SIZE) && (cart_journal_sector_open() < 0))
+		{
+			/* Stay on a full page, the next append tries again */
+			cart_journal.page_start -= CART_JOURNAL_PAGE_SIZE;
+			cart_journal.fill = CART_JOURNAL_PAGE_SIZE;
+			cart_journal.flushed = CART_JOURNAL_PAGE_SIZE;
+			cart_journal.drop_count++;
+			return;
+		}
+	}
+
+	memcpy(&cart_journal.page[cart_journal.fill], record, size);
+	cart_journal.fill += size;
+	cart_journal.append_count++;
+
+	/* A page without room for the smallest record is programmed right away */
+	if((CART_JOURNAL_PAGE_SIZE - cart_journal.fill) < (CART_JOURNAL_CRC_SIZE + 3))
+	{
+		cart_journal_flush(true);
+	}
+}
+
+
+/**
+ * @brief This function returns the size of the record at a position of a page read back from the flash.
+ * @param uint8_t* data The record
+ * @param uint16_t size Bytes left in the page
+ * @return Size of the record with its CRC, 0 if there is no valid record.
+ */
+static uint16_t cart_journal_record_size(const uint8_t* data, uint16_t size)
+{
+	uint32_t value_size;
+	uint8_t count;
+
+	if(size < (2 + CART_JOURNAL_CRC_SIZE))
+	{
+		return 0;
+	}
+
+	count = cart_codec_varint_get(&data[1], size - 1, &value_size);
+	if((count == 0) || ((1 + count + value_size + CART_JOURNAL_CRC_SIZE) > size))
+	{
+		return 0;
+	}
+
+	uint16_t record_size = 1 + count + value_size;
+	uint16_t crc = data[record_size] | (data[record_size + 1] << 8);
+	if(crc != cart_journal_crc(data, record_size))
+	{
+		return 0;
+	}
+
+	return record_size + CART_JOURNAL_CRC_SIZE;
+}
+
+
+/**
+ * @brief This function checks if a page is erased.
+ * @param uint8_t sector Sector of the ring
+ * @param uint16_t page_start Offset of the page in the sector
+ * @return true if every byte of the page reads 0xFF.
+ */
+static bool cart_journal_page_blank(uint8_t sector, uint16_t page_start)
+{
+	if(flash_spi_read(cart_journal_address(sector, page_start), cart_journal.page, CART_JOURNAL_PAGE_SIZE) < 0)
+	{
+		return false;
+	}
+
+	for(uint16_t i = 0; i < CART_JOURNAL_PAGE_SIZE; i++)
+	{
+		if(cart_journal.page[i] != 0xFF)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/**
+ * @brief This function replays the records of a sector into the cart session.
+ * @param uint8_t sector Sector of the ring
+ * @return Offset right after the last page used in the sector.
+ */
+static uint16_t cart_journal_sector_replay(uint8_t sector)
+{
+	/* The first page holds the header */
+	uint16_t end = CART_JOURNAL_PAGE_SIZE;
+
+	for(uint16_t page_start = 0; page_start < CART_JOURNAL_SECTOR_SIZE; page_start += CART_JOURNAL_PAGE_SIZE)
+	{
+		uint16_t pos = (page_start == 0) ? CART_JOURNAL_HEADER_SIZE : 0;
+
+		if(flash_spi_read(cart_journal_address(sector, page_start), cart_journal.page, CART_JOURNAL_PAGE_SIZE) < 0)
+		{
+			break;
+		}
+
+		/* Pages are used in order, the first one starting erased ends the sector */
+		if(cart_journal.page[pos] == 0xFF)
+		{
+			break;
+		}
+		end = page_start + CART_JOURNAL_PAGE_SIZE;
+
+		while((pos < CART_JOURNAL_PAGE_SIZE) && (cart_journal.page[pos] != 0xFF))
+		{
+			uint16_t size = cart_journal_record_size(&cart_journal.page[pos], CART_JOURNAL_PAGE_SIZE - pos);
+			struct cart_record record;
+
+			/* Most likely a program cut by a reset, nothing was written after it in this page */
+			if((size == 0) || (cart_codec_decode(&cart_journal.page[pos], size - CART_JOURNAL_CRC_SIZE, &record) < 0))
+			{
+				cart_journal.corrupt_count++;
+				break;
+			}
+			pos += size;
+
+			if(record.type == CART_TLV_SESSION)
+			{
+				cart_session_restore(record.session.id);
+				cart_journal.session_sector = sector;
+				cart_journal.replay_count = 0;
+			}
+			else if((record.type == CART_TLV_ITEM) && (cart_journal.session_sector != CART_JOURNAL_SECTOR_NONE))
+			{
+				record.item.flags &= ~CART_ITEM_FLAG_SEQUENCE;
+				if(cart_session_append(&record.item) < 0)
+				{
+					cart_journal.corrupt_count++;
+				}
+				cart_journal.replay_count++;
+			}
+		}
+	}
+
+	return end;
+}
+
+
+/**
+ * @brief This function finds the journal in the flash and replays the current session. Writing resumes on a new
+ * page after the last one used, the sector after it is erased in the background.
+ * @note Must be called after flash_spi_init().
+ * @param void
+ * @return Number of changes replayed, -1 if there is no session to resume.
+ */
+int cart_journal_init(void)
+{
+	uint32_t header[CART_JOURNAL_SECTOR_COUNT][3];
+	uint8_t order[CART_JOURNAL_SECTOR_COUNT];
+	uint8_t count = 0;
+	uint16_t end = 0;
+	uint32_t start = RTCC_CounterGet();
+
+	memset(&cart_journal, 0, sizeof(struct cart_journal));
+	cart_journal.session_sector = CART_JOURNAL_SECTOR_NONE;
+
+	/* Valid sectors, oldest generation first */
+	for(uint8_t sector = 0; sector < CART_JOURNAL_SECTOR_COUNT; sector++)
+	{
+		if((flash_spi_read(cart_journal_address(sector, 0), header[sector], CART_JOURNAL_HEADER_SIZE) < 0) ||
+		   (header[sector][0] != CART_JOURNAL_MAGIC) || (header[sector][1] == 0xFFFFFFFF) ||
+		   (header[sector][2] != ~header[sector][1]))
+		{
+			continue;
+		}
+
+		uint8_t i = count++;
+		while((i > 0) && (header[order[i - 1]][1] > header[sector][1]))
+		{
+			order[i] = order[i - 1];
+			i--;
+		}
+		order[i] = sector;
+	}
+
+	cart_journal.replaying = true;
+	for(uint8_t i = 0; i < count; i++)
+	{
+		end = cart_journal_sector_replay(order[i]);
+	}
+	cart_journal.replaying = false;
+
+	/* Start on a page never written, the page after the last one used may hold a program cut by a reset */
+	if(count)
+	{
+		cart_journal.sector = order[count - 1];
+		cart_journal.generation = header[cart_journal.sector][1];
+		cart_journal.page_start = end;
+		while((cart_journal.page_start < CART_JOURNAL_SECTOR_SIZE) && !cart_journal_page_blank(cart_journal.sector, cart_journal.page_start))
+		{
+			cart_journal.page_start += CART_JOURNAL_PAGE_SIZE;
+		}
+	}
+	else
+	{
+		cart_journal.sector = CART_JOURNAL_SECTOR_COUNT - 1;
+		cart_journal.page_start = CART_JOURNAL_SECTOR_SIZE;
+	}
+
+	/* The position is kept on the page before, marked full, so that the first append moves to it */
+	cart_journal.page_start -= CART_JOURNAL_PAGE_SIZE;
+	cart_journal.fill = CART_JOURNAL_PAGE_SIZE;
+	cart_journal.flushed = CART_JOURNAL_PAGE_SIZE;
+
+	cart_journal.ready = true;
+	cart_journal.next = CART_JOURNAL_NEXT_DIRTY;
+	cart_journal_erase_next();
+	cart_journal.replay_ticks = RTCC_CounterGet() - start;
+
+	printf("Cart journal: %u sectors, %lu changes replayed, %lu corrupt records, %lu ticks\n", count,
+			(unsigned long)cart_journal.replay_count, (unsigned long)cart_journal.corrupt_count,
+			(unsigned long)cart_journal.replay_ticks);
+
+	if(cart_journal.session_sector == CART_JOURNAL_SECTOR_NONE)
+	{
+		return -1;
+	}
+
+	return cart_journal.replay_count;
+}
+
+
+/**
+ * @brief This function records the start of a new session, the older records are not needed anymore.
+ * @param struct cart_session_info* session The new session
+ * @return void
+ */
+void cart_journal_session(const struct cart_session_info* session)
+{
+	uint8_t record[CART_SESSION_MAXSIZE + CART_JOURNAL_CRC_SIZE];
+
+	if(!cart_journal.ready || cart_journal.replaying)
+	{
+		return;
+	}
+
+	cart_journal_append(record, cart_codec_session_encode(record, session));
+
+	/* Everything before this sector can be erased */
+	cart_journal.session_sector = cart_journal.sector;
+	cart_journal.full = false;
+	cart_journal_erase_next();
+}
+
+
+/**
+ * @brief This function records a change of the cart.
+ * @param struct cart_item* item The change, with its sequence number
+ * @return void
+ */
+void cart_journal_item(const struct cart_item* item)
+{
+	uint8_t record[CART_JOURNAL_RECORD_MAXSIZE];
+	struct cart_item copy = *item;
+
+	if(!cart_journal.ready || cart_journal.replaying)
+	{
+		return;
+	}
+
+	/* The name is kept like in the cart session log */
+	if(copy.name_size > CART_SESSION_NAME_MAXSIZE)
+	{
+		copy.name_size = CART_SESSION_NAME_MAXSIZE;
+	}
+	if(!(copy.flags & CART_ITEM_FLAG_NAME))
+	{
+		copy.name_size = 0;
+	}
+
+	uint8_t size = cart_codec_item_header(record, &copy);
+	memcpy(&record[size], copy.name, copy.name_size);
+
+	cart_journal_append(record, size + copy.name_size);
+}
+
+
+/**
+ * @brief This function programs the pending records and follows the background erase, on SOFT_TIMER_JOURNAL.
+ * @param void
+ * @return void
+ */
+void cart_journal_service(void)
+{
+	if((cart_journal.next == CART_JOURNAL_NEXT_ERASING) && !flash_spi_erase_busy())
+	{
+		cart_journal.next = CART_JOURNAL_NEXT_ERASED;
+	}
+
+	cart_journal_flush(false);
+	cart_journal_erase_next();
+}
+
+
+/**
+ * @brief This function tells when cart_journal_service() has to be called next.
+ * @param void
+ * @return Delay in soft timer ticks, 0 if there is nothing to do.
+ */
+uint32_t cart_journal_service_ticks(void)
+{
+	if(cart_journal.flushed != cart_journal.fill)
+	{
+		return CART_JOURNAL_FLUSH_TICKS;
+	}
+
+	if(cart_journal.next != CART_JOURNAL_NEXT_ERASED)
+	{
+		return (cart_journal.full || !cart_journal.ready) ? 0 : CART_JOURNAL_ERASE_POLL_TICKS;
+	}
+
+	return 0;
+}
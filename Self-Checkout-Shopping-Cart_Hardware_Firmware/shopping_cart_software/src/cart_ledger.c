@@ -0,0 +1,229 @@
+/*
+ * @file cart_ledger.c
+ * @brief This file consists of the cart ledger. It keeps one line per product with its unit price and quantity,
+ * and maintains the total in minor units on every operation so that the item list is never walked.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "inc/cart_ledger.h"
+
+
+/**
+ * @brief This function returns the home slot of a product id in the index.
+ * @param uint32_t product_id The product id
+ * @return Slot of the index.
+ */
+static uint16_t cart_ledger_slot(uint32_t product_id)
+{
+	/* Fibonacci hashing, the product ids of the catalog are not uniformly distributed in the low bits */
+	return (uint16_t)((product_id * 2654435769u) >> 16) & CART_LEDGER_INDEX_MASK;
+}
+
+
+/**
+ * @brief This function finds the slot of the index holding a product.
+ * @param uint32_t product_id The product id
+ * @return Slot of the product, or of the empty slot ending the probe sequence if the product is not in the cart.
+ */
+static uint16_t cart_ledger_probe(uint32_t product_id)
+{
+	uint16_t slot = cart_ledger_slot(product_id);
+
+	while((cart_ledger.index[slot] != CART_LEDGER_INDEX_EMPTY) && (cart_ledger.line[cart_ledger.index[slot]].product_id != product_id))
+	{
+		slot = (slot + 1) & CART_LEDGER_INDEX_MASK;
+	}
+
+	return slot;
+}
+
+
+/**
+ * @brief This function removes a line, the last line is moved into its place to keep the lines packed.
+ * @param uint16_t slot Slot of the index holding the line
+ * @return void
+ */
+static void cart_ledger_line_delete(uint16_t slot)
+{
+	uint16_t position = cart_ledger.index[slot];
+	uint16_t last = cart_ledger.line_count - 1;
+
+	/* Backward shift deletion, moves up the entries of the probe sequence instead of leaving a tombstone */
+	uint16_t hole = slot;
+	uint16_t next = (slot + 1) & CART_LEDGER_INDEX_MASK;
+	while(cart_ledger.index[next] != CART_LEDGER_INDEX_EMPTY)
+	{
+		uint16_t home = cart_ledger_slot(cart_ledger.line[cart_ledger.index[next]].product_id);
+
+		/* The entry can move to the hole if its home slot is not between the hole and its current slot */
+		if(((next - home) & CART_LEDGER_INDEX_MASK) >= ((next - hole) & CART_LEDGER_INDEX_MASK))
+		{
+			cart_ledger.index[hole] = cart_ledger.index[next];
+			hole = next;
+		}
+		next = (next + 1) & CART_LEDGER_INDEX_MASK;
+	}
+	cart_ledger.index[hole] = CART_LEDGER_INDEX_EMPTY;
+
+	/* Fill the gap in the lines with the last line */
+	if(position != last)
+	{
+		cart_ledger.line[position] = cart_ledger.line[last];
+		cart_ledger.index[cart_ledger_probe(cart_ledger.line[position].product_id)] = position;
+	}
+	cart_ledger.line_count--;
+}
+
+
+/**
+ * @brief This function empties the cart.
+ * @param void
+ * @return void
+ */
+void cart_ledger_init(void)
+{
+	cart_ledger.line_count = 0;
+	cart_ledger.total = 0;
+	cart_ledger.item_count = 0;
+	memset(cart_ledger.index, 0xFF, sizeof(cart_ledger.index));
+}
+
+
+/**
+ * @brief This function returns the line of a product.
+ * @param uint32_t product_id The product id
+ * @return Pointer to the line, NULL if the product is not in the cart.
+ */
+const struct cart_ledger_line* cart_ledger_find(uint32_t product_id)
+{
+	uint16_t slot = cart_ledger_probe(product_id);
+
+	if(cart_ledger.index[slot] == CART_LEDGER_INDEX_EMPTY)
+	{
+		return NULL;
+	}
+
+	return &cart_ledger.line[cart_ledger.index[slot]];
+}
+
+
+/**
+ * @brief This function adds units of a product. If the product is already in the cart with another price,
+ * the whole line is repriced to the last scanned price.
+ * @param uint32_t product_id The product id
+ * @param uint32_t price Unit price in minor units
+ * @param uint16_t quantity Number of units
+ * @return 0 on success, -1 if the cart is full or the total would overflow.
+ */
+int cart_ledger_add(uint32_t product_id, uint32_t price, uint16_t quantity)
+{
+	uint16_t slot = cart_ledger_probe(product_id);
+	struct cart_ledger_line *line;
+	uint64_t total;
+
+	if(cart_ledger.index[slot] == CART_LEDGER_INDEX_EMPTY)
+	{
+		if(cart_ledger.line_count >= CART_LEDGER_LINES_MAX)
+		{
+			printf("ERROR: Cart ledger full, product %lx not added.\n", (unsigned long)product_id);
+			return -1;
+		}
+
+		total = (uint64_t)cart_ledger.total + ((uint64_t)price * quantity);
+		if(total > UINT32_MAX)
+		{
+			return -1;
+		}
+
+		line = &cart_ledger.line[cart_ledger.line_count];
+		line->product_id = product_id;
+		line->price = price;
+		line->quantity = quantity;
+		cart_ledger.index[slot] = cart_ledger.line_count++;
+	}
+	else
+	{
+		line = &cart_ledger.line[cart_ledger.index[slot]];
+		if(((uint32_t)line->quantity + quantity) > CART_LEDGER_QUANTITY_MAX)
+		{
+			return -1;
+		}
+
+		total = (uint64_t)cart_ledger.total - ((uint64_t)line->price * line->quantity) +
+				((uint64_t)price * (line->quantity + quantity));
+		if(total > UINT32_MAX)
+		{
+			return -1;
+		}
+
+		line->price = price;
+		line->quantity += quantity;
+	}
+
+	cart_ledger.total = (uint32_t)total;
+	cart_ledger.item_count += quantity;
+
+	return 0;
+}
+
+
+/**
+ * @brief This function takes units of a product out of the cart. The line is removed with its last unit.
+ * @param uint32_t product_id The product id
+ * @param uint16_t quantity Number of units
+ * @return 0 on success, -1 if the cart does not hold that many units of the product.
+ */
+int cart_ledger_remove(uint32_t product_id, uint16_t quantity)
+{
+	uint16_t slot = cart_ledger_probe(product_id);
+
+	if(cart_ledger.index[slot] == CART_LEDGER_INDEX_EMPTY)
+	{
+		return -1;
+	}
+
+	struct cart_ledger_line *line = &cart_ledger.line[cart_ledger.index[slot]];
+	if(quantity > line->quantity)
+	{
+		return -1;
+	}
+
+	cart_ledger.total -= line->price * quantity;
+	cart_ledger.item_count -= quantity;
+	line->quantity -= quantity;
+
+	if(line->quantity == 0)
+	{
+		cart_ledger_line_delete(slot);
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief This function takes a product out of the cart whatever its quantity.
+ * @param uint32_t product_id The product id
+ * @return Number of units removed, -1 if the product is not in the cart.
+ */
+int cart_ledger_void(uint32_t product_id)
+{
+	const struct cart_ledger_line *line = cart_ledger_find(product_id);
+	int quantity;
+
+	if(line == NULL)
+	{
+		return -1;
+	}
+
+	quantity = line->quantity;
+	cart_ledger_remove(product_id, quantity);
+
+	return quantity;
+}
@@ -0,0 +1,257 @@
+/*
+ * @file cart_session.c
+ * @brief This file consists of the cart session. It keeps the log of the changes made to the cart so that
+ * a client reconnecting after a dropped link only receives the changes it missed, instead of the shopper rescanning.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "em_rtcc.h"
+#include "inc/cart_session.h"
+#include "inc/cart_journal.h"
+#include "inc/kv_store.h"
+
+
+/**
+ * @brief This function starts a new empty cart session, after the payment or at boot.
+ * @param void
+ * @return void
+ */
+void cart_session_init(void)
+{
+	/* Kept in the internal flash, the RTCC starts over at every reset */
+	uint32_t id = kv_store_get_u32(KV_KEY_CART_ID, cart_session.id);
+
+	memset(&cart_session, 0, sizeof(struct cart_session));
+
+	/* A new id every time, a client still holding the previous cart must not resume into this one */
+	cart_session.id = (id + 1) ^ (RTCC_CounterGet() << 8);
+	kv_store_set_u32(KV_KEY_CART_ID, cart_session.id);
+	cart_session.resend_next = 1;
+
+	cart_ledger_init();
+
+	struct cart_session_info info = {.id = cart_session.id, .sequence = 0};
+	cart_journal_session(&info);
+}
+
+
+/**
+ * @brief This function starts an empty cart session with a known id, the journal replays its changes after.
+ * @param uint32_t id The session id
+ * @return void
+ */
+void cart_session_restore(uint32_t id)
+{
+	memset(&cart_session, 0, sizeof(struct cart_session));
+
+	cart_session.id = id;
+	cart_session.resend_next = 1;
+
+	cart_ledger_init();
+}
+
+
+/**
+ * @brief This function applies a change to the cart ledger, records it and gives it the next sequence number.
+ * The name is only kept when the product enters the cart, the client already has it for the products in the cart.
+ * @param struct cart_item* item The change, its sequence number is set, CART_ITEM_FLAG_SEQUENCE added and
+ * CART_ITEM_FLAG_NAME removed for a product already in the cart
+ * @return 0 on success, -1 if the ledger refused the change or its quantity does not fit a line, it is then not
+ * recorded.
+ */
+int cart_session_append(struct cart_item* item)
+{
+	struct cart_session_delta *delta;
+	int ret;
+
+	/* The ledger and the log keep 16 bit quantities, a larger one would be recorded truncated */
+	if(item->quantity > CART_LEDGER_QUANTITY_MAX)
+	{
+		return -1;
+	}
+
+	if(item->flags & CART_ITEM_FLAG_REMOVED)
+	{
+		ret = cart_ledger_remove(item->product_id, item->quantity);
+	}
+	else
+	{
+		if(cart_ledger_find(item->product_id) != NULL)
+		{
+			item->flags &= ~CART_ITEM_FLAG_NAME;
+		}
+		ret = cart_ledger_add(item->product_id, item->price, item->quantity);
+	}
+
+	if(!(item->flags & CART_ITEM_FLAG_NAME))
+	{
+		item->name_size = 0;
+	}
+
+	if(ret < 0)
+	{
+		return -1;
+	}
+
+	cart_session.sequence++;
+	item->sequence = cart_session.sequence;
+	item->flags |= CART_ITEM_FLAG_SEQUENCE;
+
+	delta = &cart_session.delta[cart_session.sequence & CART_SESSION_LOG_MASK];
+	delta->product_id = item->product_id;
+	delta->price = item->price;
+	delta->quantity = item->quantity;
+	delta->flags = item->flags;
+	delta->name_size = (item->name_size < CART_SESSION_NAME_MAXSIZE) ? item->name_size : CART_SESSION_NAME_MAXSIZE;
+	memcpy(delta->name, item->name, delta->name_size);
+
+	cart_journal_item(item);
+
+	/* Changes made while nothing is being resent go out through the scan queue directly */
+	if(cart_session.resend_next == item->sequence)
+	{
+		cart_session.resend_next++;
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief This function takes a product out of the cart and records the change.
+ * @param uint32_t product_id The product id
+ * @param bool whole_line true to take out every unit of the product, false for one unit
+ * @param struct cart_item* item The recorded change, without name
+ * @return 0 on success, -1 if the product is not in the cart.
+ */
+int cart_session_remove(uint32_t product_id, bool whole_line, struct cart_item* item)
+{
+	const struct cart_ledger_line *line = cart_ledger_find(product_id);
+
+	if(line == NULL)
+	{
+		printf("ERROR: Product %lx is not in the cart.\n", (unsigned long)product_id);
+		return -1;
+	}
+
+	item->product_id = product_id;
+	item->price = line->price;
+	item->quantity = whole_line ? line->quantity : 1;
+	item->flags = CART_ITEM_FLAG_REMOVED;
+	item->name = "";
+	item->name_size = 0;
+
+	return cart_session_append(item);
+}
+
+
+/**
+ * @brief This function sends a recorded change again through the resend path, when it could not be queued directly.
+ * @param uint32_t sequence Sequence number of the change
+ * @return void
+ */
+void cart_session_defer(uint32_t sequence)
+{
+	if(sequence < cart_session.resend_next)
+	{
+		cart_session.resend_next = sequence;
+	}
+}
+
+
+/**
+ * @brief This function handles the resume command of a reconnecting client. The changes after the
+ * acknowledged sequence number are queued to be sent again.
+ * @param uint32_t acked Last sequence number received by the client, 0 for a client without history
+ * @return void
+ */
+void cart_session_resume(uint32_t acked)
+{
+	uint32_t oldest = (cart_session.sequence > CART_SESSION_LOG_SIZE) ? (cart_session.sequence - CART_SESSION_LOG_SIZE + 1) : 1;
+
+	if(acked > cart_session.sequence)
+	{
+		acked = cart_session.sequence;
+	}
+
+	if((acked + 1) < oldest)
+	{
+		printf("ERROR: Changes %lu to %lu are not in the cart session log anymore.\n", (unsigned long)(acked + 1),
+				(unsigned long)(oldest - 1));
+		cart_session.lost_count += oldest - (acked + 1);
+		acked = oldest - 1;
+	}
+
+	cart_session.resend_next = acked + 1;
+	cart_session.resume_count++;
+
+	printf("Cart session %lu: resuming after %lu, %lu changes to resend\n", (unsigned long)cart_session.id,
+			(unsigned long)acked, (unsigned long)(cart_session.sequence - acked));
+}
+
+
+/**
+ * @brief This function returns the next change to send again, without removing it.
+ * @param struct cart_item* item The change, the name points into the log
+ * @return true if there is a change to send again.
+ */
+bool cart_session_resend_peek(struct cart_item* item)
+{
+	if(!cart_session_resend_pending())
+	{
+		return false;
+	}
+
+	const struct cart_session_delta *delta = &cart_session.delta[cart_session.resend_next & CART_SESSION_LOG_MASK];
+
+	item->product_id = delta->product_id;
+	item->price = delta->price;
+	item->quantity = delta->quantity;
+	item->flags = delta->flags;
+	item->sequence = cart_session.resend_next;
+	item->name = delta->name;
+	item->name_size = delta->name_size;
+
+	return true;
+}
+
+
+/**
+ * @brief This function moves to the next change once the one returned by cart_session_resend_peek() is queued.
+ * @param void
+ * @return void
+ */
+void cart_session_resend_done(void)
+{
+	cart_session.resend_next++;
+	cart_session.resent_count++;
+}
+
+
+/**
+ * @brief This function checks if changes are waiting to be sent again.
+ * @param void
+ * @return true if changes are waiting.
+ */
+bool cart_session_resend_pending(void)
+{
+	return (cart_session.resend_next <= cart_session.sequence);
+}
+
+
+/**
+ * @brief This function returns the session id and the last sequence number, sent to a resuming client.
+ * @param struct cart_session_info* info The session information
+ * @return void
+ */
+void cart_session_info_get(struct cart_session_info* info)
+{
+	info->id = cart_session.id;
+	info->sequence = cart_session.sequence;
+}
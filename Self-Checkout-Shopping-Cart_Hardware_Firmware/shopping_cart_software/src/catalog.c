@@ -0,0 +1,237 @@
+/*
+ * @file catalog.c
+ * @brief This file consists of the product catalog stored in the MX25 external flash. Barcodes only carrying
+ * a product code are looked up here to get the name and the price of the product.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "em_rtcc.h"
+#include "mx25flash_spi.h"
+#include "inc/catalog.h"
+#include "inc/flash_spi.h"
+
+
+/**
+ * @brief This function reads bytes of the catalog image.
+ * @param uint32_t offset Offset from the start of the image
+ * @param void* data Buffer receiving the bytes
+ * @param uint32_t size Number of bytes
+ * @return 0 on success, -1 if the read is outside of the flash.
+ */
+static int catalog_flash_read(uint32_t offset, void* data, uint32_t size)
+{
+	catalog.read_count++;
+
+	if((CATALOG_FLASH_ADDRESS + offset + size) > FlashSize)
+	{
+		return -1;
+	}
+
+	return flash_spi_read(CATALOG_FLASH_ADDRESS + offset, data, size);
+}
+
+
+/**
+ * @brief This function prints a product code, the printf of newlib nano has no 64 bit conversion.
+ * @param uint64_t code The product code
+ * @return void
+ */
+static void catalog_code_print(uint64_t code)
+{
+	if(code >= 1000000000ull)
+	{
+		printf("%lu%09lu", (unsigned long)(code / 1000000000ull), (unsigned long)(code % 1000000000ull));
+	}
+	else
+	{
+		printf("%lu", (unsigned long)code);
+	}
+}
+
+
+/**
+ * @brief This function looks up a product code in the cache.
+ * @param uint64_t code The product code
+ * @param struct catalog_record* record Filled with the product on a hit
+ * @return true on a hit.
+ */
+static bool catalog_cache_get(uint64_t code, struct catalog_record* record)
+{
+	struct catalog_cache *cache = &catalog.cache;
+
+	for(uint16_t i = 0; i < cache->count; i++)
+	{
+		if(cache->code[i] == code)
+		{
+			cache->referenced[i] = true;
+			cache->hit_count++;
+			memcpy(record, &cache->record[i], sizeof(struct catalog_record));
+			return true;
+		}
+	}
+
+	cache->miss_count++;
+	return false;
+}
+
+
+/**
+ * @brief This function adds a product read from the flash to the cache.
+ * @param struct catalog_record* record The product
+ * @return void
+ */
+static void catalog_cache_put(const struct catalog_record* record)
+{
+	struct catalog_cache *cache = &catalog.cache;
+	uint16_t entry;
+
+	if(cache->count < CATALOG_CACHE_SIZE)
+	{
+		entry = cache->count++;
+	}
+	else
+	{
+		/* At most one pass clearing the referenced bits before an entry is found */
+		while(cache->referenced[cache->hand])
+		{
+			cache->referenced[cache->hand] = false;
+			cache->hand = (cache->hand + 1) % CATALOG_CACHE_SIZE;
+		}
+		entry = cache->hand;
+		cache->hand = (cache->hand + 1) % CATALOG_CACHE_SIZE;
+	}
+
+	/* A new entry has to be hit again before the hand passes to stay */
+	cache->code[entry] = record->code;
+	cache->referenced[entry] = false;
+	memcpy(&cache->record[entry], record, sizeof(struct catalog_record));
+}
+
+
+/**
+ * @brief This function opens the catalog image in the external flash and checks its header.
+ * @note Must be called after flash_spi_init().
+ * The flash is left in deep power down, flash_spi wakes it up for each lookup.
+ * @param void
+ * @return 0 on success, -1 if there is no valid catalog, codes are then not accepted.
+ */
+int catalog_init(void)
+{
+	struct catalog_header *header = &catalog.header;
+
+	memset(&catalog, 0, sizeof(struct catalog));
+
+	if(catalog_flash_read(0, header, sizeof(struct catalog_header)) < 0)
+	{
+		flash_spi_sleep();
+		return -1;
+	}
+
+	if((header->magic != CATALOG_MAGIC) || (header->version != CATALOG_VERSION) ||
+	   (header->record_size != CATALOG_RECORD_SIZE) || (header->record_count == 0) || (header->bucket_count == 0) ||
+	   (header->index_offset + (header->bucket_count * sizeof(uint16_t)) > header->image_size) ||
+	   (header->record_offset + (header->record_count * CATALOG_RECORD_SIZE) > header->image_size) ||
+	   ((CATALOG_FLASH_ADDRESS + header->image_size) > CATALOG_FLASH_MAXSIZE))
+	{
+		printf("ERROR: No valid catalog in the external flash.\n");
+		flash_spi_sleep();
+		return -1;
+	}
+
+	if(header->bucket_count <= CATALOG_INDEX_CACHE_SIZE)
+	{
+		catalog.index_cached = (catalog_flash_read(header->index_offset, catalog.index_cache,
+				header->bucket_count * sizeof(uint16_t)) == 0);
+	}
+
+	flash_spi_sleep();
+	catalog.ready = true;
+
+	printf("Catalog: %lu products, %lu buckets, index %s\n", (unsigned long)header->record_count,
+			(unsigned long)header->bucket_count, catalog.index_cached ? "in RAM" : "in flash");
+
+	return 0;
+}
+
+
+/**
+ * @brief This function reads the record a product code maps to.
+ * @param uint64_t code The product code
+ * @param struct catalog_record* record Filled with the record
+ * @return 0 on success, -1 if the flash could not be read.
+ */
+static int catalog_record_read(uint64_t code, struct catalog_record* record)
+{
+	const struct catalog_header *header = &catalog.header;
+	uint64_t hash = catalog_hash(code, header->seed);
+	uint32_t bucket = catalog_bucket(hash, header->bucket_count);
+	uint16_t displacement;
+
+	if(catalog.index_cached)
+	{
+		displacement = catalog.index_cache[bucket];
+	}
+	else if(catalog_flash_read(header->index_offset + (bucket * sizeof(uint16_t)), &displacement, sizeof(uint16_t)) < 0)
+	{
+		return -1;
+	}
+
+	uint32_t slot = catalog_slot(hash, displacement, header->record_count);
+
+	return catalog_flash_read(header->record_offset + (slot * CATALOG_RECORD_SIZE), record, CATALOG_RECORD_SIZE);
+}
+
+
+/**
+ * @brief This function looks up a product code in the catalog.
+ * @param uint64_t code The product code scanned
+ * @param struct catalog_record* record Filled with the product
+ * @return 0 if the product was found, -1 otherwise.
+ */
+int catalog_lookup(uint64_t code, struct catalog_record* record)
+{
+	uint32_t start = RTCC_CounterGet();
+	int ret;
+
+	if(!catalog.ready)
+	{
+		return -1;
+	}
+	catalog.lookup_count++;
+
+	if(catalog_cache_get(code, record))
+	{
+		return 0;
+	}
+
+	ret = catalog_record_read(code, record);
+	flash_spi_sleep();
+
+	/* Codes that are not in the catalog land on the record of another product */
+	if((ret == 0) && (record->code == code) && (record->name_size <= CATALOG_NAME_MAXSIZE))
+	{
+		catalog_cache_put(record);
+	}
+	else
+	{
+		catalog.miss_count++;
+		printf("ERROR: Product code ");
+		catalog_code_print(code);
+		printf(" is not in the catalog.\n");
+		ret = -1;
+	}
+
+	uint32_t ticks = RTCC_CounterGet() - start;
+	if(ticks > catalog.lookup_ticks_max)
+	{
+		catalog.lookup_ticks_max = ticks;
+	}
+
+	return ret;
+}
@@ -0,0 +1,227 @@
+/*
+ * @file conn_policy.c
+ * @brief This file consists of the connection parameter policy. A short interval without slave latency is
+ * requested while scans are arriving so they reach the phone quickly, a long interval with slave latency
+ * once the cart has been quiet for CON_QUIET_PERIOD_S seconds to save current.
+ * A central that rejects or ignores a request sends no feedback. After CON_REQUEST_TIMEOUT_S the request is taken
+ * as rejected and sent again, up to CON_REQUEST_RETRIES times before the policy keeps the parameters in use.
+ * Every change is logged with the RTCC time so that it can be lined up with the scans.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "native_gecko.h"
+#include "em_rtcc.h"
+#include "inc/conn_policy.h"
+#include "inc/connection_param.h"
+
+
+#define CONN_POLICY_RTCC_FREQ					(32768)							/* RTCC counter frequency */
+#define CONN_POLICY_REQUEST_TIMEOUT_TICKS		(CON_REQUEST_TIMEOUT_S * CONN_POLICY_RTCC_FREQ)
+
+
+/**
+ * @brief This function returns the RTCC time in milliseconds for the timeline.
+ * @param void
+ * @return Time in milliseconds.
+ */
+static uint32_t conn_policy_time_ms(void)
+{
+	return (uint32_t)(((uint64_t)RTCC_CounterGet() * 1000) / CONN_POLICY_RTCC_FREQ);
+}
+
+
+/**
+ * @brief This function asks the central for the parameters of a mode. Only one request is in flight at a time,
+ * a mode change during a request is sent when the feedback of the previous one arrives.
+ * @param enum conn_policy_mode mode The mode to request
+ * @return void
+ */
+static void conn_policy_request(enum conn_policy_mode mode)
+{
+	uint16_t result;
+
+	if(mode == CONN_POLICY_ACTIVE)
+	{
+		result = gecko_cmd_le_connection_set_timing_parameters(conn_policy.connection, CON_ACTIVE_INTERVAL_MIN, CON_ACTIVE_INTERVAL_MAX,
+															   CON_ACTIVE_LATENCY, CON_ACTIVE_TIMEOUT, 0, 0xFFFF)->result;
+		conn_policy.active_count++;
+	}
+	else
+	{
+		result = gecko_cmd_le_connection_set_timing_parameters(conn_policy.connection, CON_IDLE_INTERVAL_MIN, CON_IDLE_INTERVAL_MAX,
+															   CON_IDLE_LATENCY, CON_IDLE_TIMEOUT, 0, 0xFFFF)->result;
+		conn_policy.idle_count++;
+	}
+
+	printf("Timeline %lu ms: request %s parameters, result %x\n", (unsigned long)conn_policy_time_ms(),
+			(mode == CONN_POLICY_ACTIVE) ? "active" : "idle", result);
+
+	if(result == bg_err_success)
+	{
+		conn_policy.requested_mode = mode;
+		conn_policy.request_pending = true;
+		conn_policy.request_timestamp = RTCC_CounterGet();
+	}
+}
+
+
+/**
+ * @brief This function initializes the policy for a new connection and requests the active parameters,
+ * the shopper starts scanning right after tapping the cart.
+ * @param uint8_t connection The connection handle
+ * @return void
+ */
+void conn_policy_init(uint8_t connection)
+{
+	memset(&conn_policy, 0, sizeof(struct conn_policy));
+	conn_policy.connection = connection;
+	conn_policy.mode = CONN_POLICY_ACTIVE;
+
+	conn_policy_request(CONN_POLICY_ACTIVE);
+}
+
+
+/**
+ * @brief This function is called when scans arrive, it switches to the active parameters if the cart was idle.
+ * @param void
+ * @return void
+ */
+void conn_policy_activity(void)
+{
+	printf("Timeline %lu ms: scan\n", (unsigned long)conn_policy_time_ms());
+
+	if(conn_policy.mode == CONN_POLICY_ACTIVE)
+	{
+		return;
+	}
+
+	conn_policy.mode = CONN_POLICY_ACTIVE;
+	conn_policy.retries = 0;
+	if(!conn_policy.request_pending)
+	{
+		conn_policy_request(CONN_POLICY_ACTIVE);
+	}
+}
+
+
+/**
+ * @brief This function is called once no scan arrived and nothing was waiting to be sent for the quiet period,
+ * it switches to the idle parameters.
+ * @param void
+ * @return void
+ */
+void conn_policy_quiet(void)
+{
+	if(conn_policy.mode == CONN_POLICY_IDLE)
+	{
+		return;
+	}
+
+	conn_policy.mode = CONN_POLICY_IDLE;
+	conn_policy.retries = 0;
+	if(!conn_policy.request_pending)
+	{
+		conn_policy_request(CONN_POLICY_IDLE);
+	}
+}
+
+
+/**
+ * @brief This function takes the parameters reported by the gecko_evt_le_connection_parameters_id event.
+ * If the mode changed while the previous request was in flight, the new mode is requested now.
+ * @param uint16_t interval Connection interval in units of 1.25 ms
+ * @param uint16_t latency Slave latency in connection events
+ * @param uint16_t timeout Supervision timeout in units of 10 ms
+ * @return void
+ */
+void conn_policy_parameters(uint16_t interval, uint16_t latency, uint16_t timeout)
+{
+	conn_policy.interval = interval;
+	conn_policy.latency = latency;
+	conn_policy.timeout = timeout;
+	conn_policy.update_count++;
+
+	printf("Timeline %lu ms: parameters interval %lu us, latency %d, timeout %d ms\n", (unsigned long)conn_policy_time_ms(),
+			(unsigned long)interval * 1250, latency, timeout * 10);
+
+	if(conn_policy.request_pending)
+	{
+		conn_policy.request_pending = false;
+		if(conn_policy.requested_mode != conn_policy.mode)
+		{
+			conn_policy_request(conn_policy.mode);
+		}
+		else
+		{
+			conn_policy.retries = 0;
+		}
+	}
+}
+
+
+/**
+ * @brief This function returns the ticks left before the pending request times out, for the soft timer of
+ * conn_policy_request_timeout().
+ * @param void
+ * @return Ticks of the 32768 Hz soft timer clock, at least 1, or 0 when no request is pending.
+ */
+uint32_t conn_policy_request_ticks(void)
+{
+	uint32_t elapsed = RTCC_CounterGet() - conn_policy.request_timestamp;
+
+	if(!conn_policy.request_pending)
+	{
+		return 0;
+	}
+
+	return (elapsed < CONN_POLICY_REQUEST_TIMEOUT_TICKS) ? (CONN_POLICY_REQUEST_TIMEOUT_TICKS - elapsed) : 1;
+}
+
+
+/**
+ * @brief This function is called when the timer armed with conn_policy_request_ticks() fires. A request without
+ * feedback for CON_REQUEST_TIMEOUT_S is taken as rejected: the mode wanted now is requested again, or after
+ * CON_REQUEST_RETRIES retries the parameters in use are kept until the next mode change.
+ * @param void
+ * @return void
+ */
+void conn_policy_request_timeout(void)
+{
+	if(!conn_policy.request_pending || ((RTCC_CounterGet() - conn_policy.request_timestamp) < CONN_POLICY_REQUEST_TIMEOUT_TICKS))
+	{
+		return;
+	}
+
+	conn_policy.request_pending = false;
+	conn_policy.timeout_count++;
+
+	if(conn_policy.retries >= CON_REQUEST_RETRIES)
+	{
+		conn_policy.give_up_count++;
+		printf("Timeline %lu ms: %s parameters rejected, keeping interval %lu us\n", (unsigned long)conn_policy_time_ms(),
+				(conn_policy.mode == CONN_POLICY_ACTIVE) ? "active" : "idle", (unsigned long)conn_policy.interval * 1250);
+		return;
+	}
+
+	conn_policy.retries++;
+	conn_policy_request(conn_policy.mode);
+}
+
+
+/**
+ * @brief This function returns the connection interval in soft timer ticks.
+ * @param void
+ * @return Connection interval in ticks of the 32768 Hz soft timer clock.
+ */
+uint32_t conn_policy_interval_ticks(void)
+{
+	uint16_t interval = (conn_policy.interval) ? conn_policy.interval : CON_ACTIVE_INTERVAL_MAX;
+
+	return ((uint32_t)interval * 5 * CONN_POLICY_RTCC_FREQ) / 4000;
+}
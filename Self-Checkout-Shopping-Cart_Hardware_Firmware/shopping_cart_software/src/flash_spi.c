@@ -0,0 +1,532 @@
+/*
+ * @file flash_spi.c
+ * @brief This file consists of the transport of the MX25 external flash. The SPI clock is raised to
+ * FLASH_SPI_BAUDRATE and the data bytes of reads are moved by the LDMA instead of one USART_SpiTransfer() per byte.
+ * Page programs, background sector erases and the deep power down of the flash are also handled here, the
+ * commands themselves still go through mx25flash_spi.c on the same USART.
+ * @note The board only routes MOSI and MISO to the flash, the dual and quad I/O reads of the MX25 cannot be used.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include "em_core.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "em_usart.h"
+#include "em_bus.h"
+#include "native_gecko.h"
+#include "sleep.h"
+#include "dmadrv_config.h"
+#include "mx25flash_spi.h"
+#include "inc/flash_spi.h"
+#include "inc/external_events.h"
+#include "inc/timing.h"
+
+
+/* Clocked out while reading, the flash ignores its input */
+static const uint8_t flash_spi_dummy = 0xFF;
+
+
+/**
+ * @brief This function reads the write in progress bit of the status register.
+ * @param void
+ * @return true while the flash is programming or erasing.
+ */
+static bool flash_spi_wip(void)
+{
+	uint8_t status;
+
+	MX25_RDSR(&status);
+
+	return ((status & FLASH_WIP_MASK) != 0);
+}
+
+
+/**
+ * @brief This function suspends the background erase so that the flash can be read.
+ * @param void
+ * @return 0 if the flash can be read, -1 if the erase did not suspend in time.
+ */
+static int flash_spi_erase_suspend(void)
+{
+	if(!flash_spi.erasing || !flash_spi_wip())
+	{
+		return 0;
+	}
+
+	MX25_PGM_ERS_S();
+
+	/* The status shows ready once the erase is suspended */
+	uint32_t deadline = timing_deadline_us(FLASH_SPI_SUSPEND_TIMEOUT_US);
+	while(flash_spi_wip())
+	{
+		if(timing_expired(deadline))
+		{
+			/* The erase must not stay suspended if it gets there after all, the flash would report it over */
+			MX25_PGM_ERS_R();
+			return -1;
+		}
+	}
+
+	flash_spi.suspended = true;
+	flash_spi.suspend_count++;
+
+	return 0;
+}
+
+
+/**
+ * @brief This function starts the LDMA transfer of the next part of the current read.
+ * @param void
+ * @return void
+ */
+static void flash_spi_transfer_start(void)
+{
+	uint32_t channel_mask = (1 << FLASH_SPI_RX_LDMA_CHANNEL) | (1 << FLASH_SPI_TX_LDMA_CHANNEL);
+	uint32_t size = (flash_spi.remaining < FLASH_SPI_LDMA_MAXSIZE) ? flash_spi.remaining : FLASH_SPI_LDMA_MAXSIZE;
+	uint32_t ctrl = LDMA_CH_CTRL_STRUCTTYPE_TRANSFER
+				  | ((size - 1) << _LDMA_CH_CTRL_XFERCNT_SHIFT)
+				  | LDMA_CH_CTRL_BLOCKSIZE_UNIT1
+				  | LDMA_CH_CTRL_REQMODE_BLOCK
+				  | LDMA_CH_CTRL_SRCINC_NONE
+				  | LDMA_CH_CTRL_SIZE_BYTE
+				  | LDMA_CH_CTRL_SRCMODE_ABSOLUTE
+				  | LDMA_CH_CTRL_DSTMODE_ABSOLUTE;
+
+	flash_spi.transfer_size = size;
+
+	/* RX stores the received bytes, its done interrupt ends the transfer */
+	LDMA->CH[FLASH_SPI_RX_LDMA_CHANNEL].CTRL = ctrl | LDMA_CH_CTRL_DSTINC_ONE | LDMA_CH_CTRL_DONEIFSEN;
+	LDMA->CH[FLASH_SPI_RX_LDMA_CHANNEL].SRC = (uint32_t)&MX25_USART->RXDATA;
+	LDMA->CH[FLASH_SPI_RX_LDMA_CHANNEL].DST = (uint32_t)flash_spi.data;
+	LDMA->CH[FLASH_SPI_RX_LDMA_CHANNEL].LINK = 0;
+
+	/* TX writes the same dummy byte for every byte to receive */
+	LDMA->CH[FLASH_SPI_TX_LDMA_CHANNEL].CTRL = ctrl | LDMA_CH_CTRL_DSTINC_NONE;
+	LDMA->CH[FLASH_SPI_TX_LDMA_CHANNEL].SRC = (uint32_t)&flash_spi_dummy;
+	LDMA->CH[FLASH_SPI_TX_LDMA_CHANNEL].DST = (uint32_t)&MX25_USART->TXDATA;
+	LDMA->CH[FLASH_SPI_TX_LDMA_CHANNEL].LINK = 0;
+
+	LDMA->IFC = channel_mask;
+	BUS_RegMaskedSet(&LDMA->CHEN, channel_mask);
+}
+
+
+/**
+ * @brief This function ends the current read and hands it over to the bluetooth event loop if it was asynchronous.
+ * @param int status 0 on success, -1 on error
+ * @return void
+ */
+static void flash_spi_read_end(int status)
+{
+	GPIO_PinOutSet(MX25_PORT_CS, MX25_PIN_CS);
+
+	if(flash_spi.suspended)
+	{
+		MX25_PGM_ERS_R();
+		flash_spi.suspended = false;
+	}
+
+	flash_spi.status = status;
+	flash_spi.busy = false;
+	SLEEP_SleepBlockEnd(sleepEM2);
+
+	if(flash_spi.callback != NULL)
+	{
+		flash_spi.complete = true;
+
+		CORE_AtomicDisableIrq();
+		external_event |= EVENT_FLASH;
+		gecko_external_signal(external_event);
+		CORE_AtomicEnableIrq();
+	}
+}
+
+
+/**
+ * @brief This function stops the LDMA channels and ends the current read with an error.
+ * @param void
+ * @return void
+ */
+static void flash_spi_read_abort(void)
+{
+	BUS_RegMaskedClear(&LDMA->CHEN, (1 << FLASH_SPI_RX_LDMA_CHANNEL) | (1 << FLASH_SPI_TX_LDMA_CHANNEL));
+	flash_spi.error_count++;
+	flash_spi_read_end(-1);
+}
+
+
+/**
+ * @brief This function sends the read command and starts clocking the data in.
+ * @param uint32_t address Address in the flash
+ * @param void* data Buffer receiving the bytes
+ * @param uint32_t size Number of bytes
+ * @return 0 if the read is started, -1 if a read is already running, the range is outside of the flash or the
+ * background erase could not be suspended.
+ */
+static int flash_spi_read_start(uint32_t address, void* data, uint32_t size)
+{
+	if(flash_spi.busy || flash_spi.complete || (size == 0) || ((address + size) > FlashSize))
+	{
+		return -1;
+	}
+
+	flash_spi_wake();
+	if(flash_spi_erase_suspend() < 0)
+	{
+		flash_spi.error_count++;
+		return -1;
+	}
+
+	/* USART1 and the LDMA stop in EM2 */
+	SLEEP_SleepBlockBegin(sleepEM2);
+	flash_spi.busy = true;
+	flash_spi.data = data;
+	flash_spi.remaining = size;
+	flash_spi.read_count++;
+	flash_spi.byte_count += size;
+
+	/* Nothing must be left from the byte by byte commands */
+	MX25_USART->CMD = USART_CMD_CLEARRX | USART_CMD_CLEARTX;
+
+	GPIO_PinOutClear(MX25_PORT_CS, MX25_PIN_CS);
+	USART_SpiTransfer(MX25_USART, FLASH_CMD_READ);
+	USART_SpiTransfer(MX25_USART, (uint8_t)(address >> 16));
+	USART_SpiTransfer(MX25_USART, (uint8_t)(address >> 8));
+	USART_SpiTransfer(MX25_USART, (uint8_t)address);
+
+	flash_spi_transfer_start();
+
+	return 0;
+}
+
+
+/**
+ * @brief This function sets up the USART of the flash at FLASH_SPI_BAUDRATE and the two LDMA channels.
+ * @param void
+ * @return void
+ */
+void flash_spi_init(void)
+{
+	uint32_t channel_mask = (1 << FLASH_SPI_RX_LDMA_CHANNEL) | (1 << FLASH_SPI_TX_LDMA_CHANNEL);
+
+	flash_spi.busy = false;
+	flash_spi.complete = false;
+	flash_spi.callback = NULL;
+	flash_spi.erasing = false;
+	flash_spi.suspended = false;
+	flash_spi.sleep_requested = false;
+
+	/* initBoard() leaves the flash in deep power down, it ignores every command until the first access wakes it up */
+	flash_spi.asleep = true;
+
+	MX25_init();
+	USART_BaudrateSyncSet(MX25_USART, 0, FLASH_SPI_BAUDRATE);
+
+	CMU_ClockEnable(cmuClock_LDMA, true);
+	BUS_RegMaskedClear(&LDMA->CHEN, channel_mask);
+	LDMA->CTRL = (EMDRV_DMADRV_DMA_CH_PRIORITY << _LDMA_CTRL_NUMFIXED_SHIFT);
+
+	LDMA->CH[FLASH_SPI_RX_LDMA_CHANNEL].REQSEL = LDMA_CH_REQSEL_SOURCESEL_USART1 | LDMA_CH_REQSEL_SIGSEL_USART1RXDATAV;
+	LDMA->CH[FLASH_SPI_TX_LDMA_CHANNEL].REQSEL = LDMA_CH_REQSEL_SOURCESEL_USART1 | LDMA_CH_REQSEL_SIGSEL_USART1TXBL;
+	LDMA->CH[FLASH_SPI_RX_LDMA_CHANNEL].CFG = 0;
+	LDMA->CH[FLASH_SPI_TX_LDMA_CHANNEL].CFG = 0;
+	LDMA->CH[FLASH_SPI_RX_LDMA_CHANNEL].LOOP = 0;
+	LDMA->CH[FLASH_SPI_TX_LDMA_CHANNEL].LOOP = 0;
+
+	LDMA->IFC = channel_mask | LDMA_IF_ERROR;
+	LDMA->IEN |= (1 << FLASH_SPI_RX_LDMA_CHANNEL) | LDMA_IEN_ERROR;
+	NVIC_ClearPendingIRQ(LDMA_IRQn);
+	NVIC_SetPriority(LDMA_IRQn, EMDRV_DMADRV_DMA_IRQ_PRIORITY);
+	NVIC_EnableIRQ(LDMA_IRQn);
+}
+
+
+/**
+ * @brief This function releases the flash from deep power down, same sequence as the wake up done in MX25_DP().
+ * @param void
+ * @return void
+ */
+void flash_spi_wake(void)
+{
+	flash_spi.sleep_requested = false;
+	if(!flash_spi.asleep)
+	{
+		return;
+	}
+
+	GPIO_PinOutClear(MX25_PORT_CS, MX25_PIN_CS);
+	timing_wait_us(20);								/* tCRDP */
+	GPIO_PinOutSet(MX25_PORT_CS, MX25_PIN_CS);
+	timing_wait_us(35);								/* tRDP */
+
+	flash_spi.asleep = false;
+}
+
+
+/**
+ * @brief This function puts the flash in deep power down, or once the background erase is over.
+ * @param void
+ * @return void
+ */
+void flash_spi_sleep(void)
+{
+	if(flash_spi.asleep || flash_spi.busy)
+	{
+		return;
+	}
+
+	/* The flash does not accept deep power down while erasing */
+	if(flash_spi.erasing)
+	{
+		flash_spi.sleep_requested = true;
+		return;
+	}
+
+	MX25_DP();
+	flash_spi.asleep = true;
+}
+
+
+/**
+ * @brief This function reads bytes of the flash and waits for the end of the read.
+ * @note Must not be called from an interrupt handler, the end of the read is signaled by the LDMA interrupt.
+ * @param uint32_t address Address in the flash
+ * @param void* data Buffer receiving the bytes
+ * @param uint32_t size Number of bytes
+ * @return 0 on success, -1 on error.
+ */
+int flash_spi_read(uint32_t address, void* data, uint32_t size)
+{
+	flash_spi.callback = NULL;
+	if(flash_spi_read_start(address, data, size) < 0)
+	{
+		return -1;
+	}
+
+	/* At 8MHz a 64 byte record takes 64us, sleeping would cost more than it saves */
+	uint32_t deadline = timing_deadline_us(((size * 8) / (FLASH_SPI_BAUDRATE / 1000000)) + FLASH_SPI_TIMEOUT_US);
+	while(flash_spi.busy && !timing_expired(deadline));
+
+	if(flash_spi.busy)
+	{
+		CORE_AtomicDisableIrq();
+		if(flash_spi.busy)
+		{
+			flash_spi_read_abort();
+		}
+		CORE_AtomicEnableIrq();
+	}
+
+	return flash_spi.status;
+}
+
+
+/**
+ * @brief This function starts a read of the flash and returns right away. The callback is called from the
+ * bluetooth event loop, through EVENT_FLASH, once the bytes are in the buffer.
+ * @param uint32_t address Address in the flash
+ * @param void* data Buffer receiving the bytes, must stay valid until the callback
+ * @param uint32_t size Number of bytes
+ * @param flash_spi_callback callback Called with the status of the read
+ * @param void* context Passed to the callback
+ * @return 0 if the read is started, -1 if a read is already running or the range is outside of the flash.
+ */
+int flash_spi_read_async(uint32_t address, void* data, uint32_t size, flash_spi_callback callback, void* context)
+{
+	if(flash_spi.busy || flash_spi.complete || (callback == NULL))
+	{
+		return -1;
+	}
+
+	flash_spi.callback = callback;
+	flash_spi.context = context;
+	if(flash_spi_read_start(address, data, size) < 0)
+	{
+		flash_spi.callback = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief This function checks if a read is running or waiting for its callback.
+ * @param void
+ * @return true if a new read cannot be started yet.
+ */
+bool flash_spi_busy(void)
+{
+	return (flash_spi.busy || flash_spi.complete);
+}
+
+
+/**
+ * @brief This function calls the callback of the asynchronous read that just ended, on EVENT_FLASH.
+ * @param void
+ * @return void
+ */
+void flash_spi_complete(void)
+{
+	flash_spi_callback callback = flash_spi.callback;
+
+	if(!flash_spi.complete || (callback == NULL))
+	{
+		return;
+	}
+
+	/* The callback may start the next read */
+	flash_spi.callback = NULL;
+	flash_spi.complete = false;
+	callback(flash_spi.status, flash_spi.context);
+}
+
+
+/**
+ * @brief This function handles the LDMA interrupt flags of the flash channels, called by LDMA_IRQHandler().
+ * @param uint32_t flags The LDMA interrupt flags, already cleared
+ * @return void
+ */
+void flash_spi_ldma_irq(uint32_t flags)
+{
+	if(!flash_spi.busy)
+	{
+		return;
+	}
+
+	if(flags & LDMA_IF_ERROR)
+	{
+		flash_spi_read_abort();
+		return;
+	}
+
+	if(flags & (1 << FLASH_SPI_RX_LDMA_CHANNEL))
+	{
+		flash_spi.data += flash_spi.transfer_size;
+		flash_spi.remaining -= flash_spi.transfer_size;
+
+		/* The flash keeps streaming the next addresses as long as the clock runs */
+		if(flash_spi.remaining)
+		{
+			flash_spi_transfer_start();
+		}
+		else
+		{
+			flash_spi_read_end(0);
+		}
+	}
+}
+
+
+/**
+ * @brief This function programs bytes of one page of the flash and waits for the end of the program.
+ * @note The bytes must be erased, the flash can only clear bits.
+ * @param uint32_t address Address in the flash
+ * @param void* data Bytes to program
+ * @param uint32_t size Number of bytes, the range must not cross a page boundary
+ * @return 0 on success, -1 if an erase is running, the range crosses a page or the program failed.
+ */
+int flash_spi_program(uint32_t address, const void* data, uint32_t size)
+{
+	if(flash_spi_busy() || flash_spi_erase_busy() || (size == 0) ||
+	   ((address & (Page_Offset - 1)) + size > Page_Offset))
+	{
+		return -1;
+	}
+
+	flash_spi_wake();
+	flash_spi.program_count++;
+
+	if(MX25_PP(address, (uint8_t *)data, size) != FlashOperationSuccess)
+	{
+		flash_spi.error_count++;
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief This function starts the erase of a sector and returns right away, flash_spi_erase_busy() tells when it is over.
+ * @param uint32_t address Address of the sector
+ * @return 0 if the erase is started, -1 if the flash is busy.
+ */
+int flash_spi_erase_start(uint32_t address)
+{
+	if(flash_spi_busy() || flash_spi_erase_busy() || (address >= FlashSize))
+	{
+		return -1;
+	}
+
+	flash_spi_wake();
+	MX25_WREN();
+
+	GPIO_PinOutClear(MX25_PORT_CS, MX25_PIN_CS);
+	USART_SpiTransfer(MX25_USART, FLASH_CMD_SE);
+	USART_SpiTransfer(MX25_USART, (uint8_t)(address >> 16));
+	USART_SpiTransfer(MX25_USART, (uint8_t)(address >> 8));
+	USART_SpiTransfer(MX25_USART, (uint8_t)address);
+	GPIO_PinOutSet(MX25_PORT_CS, MX25_PIN_CS);
+
+	flash_spi.erasing = true;
+	flash_spi.erase_count++;
+
+	return 0;
+}
+
+
+/**
+ * @brief This function checks if the background erase is still running, and finishes it when it is over.
+ * @param void
+ * @return true while erasing.
+ */
+bool flash_spi_erase_busy(void)
+{
+	if(!flash_spi.erasing || flash_spi.busy)
+	{
+		return flash_spi.erasing;
+	}
+
+	if(flash_spi_wip())
+	{
+		return true;
+	}
+
+	flash_spi.erasing = false;
+	if(flash_spi.sleep_requested)
+	{
+		flash_spi.sleep_requested = false;
+		flash_spi_sleep();
+	}
+
+	return false;
+}
+
+
+/**
+ * @brief This function waits for the end of the background erase, sleeping between two polls of the status register.
+ * @param void
+ * @return 0 once the erase is over, -1 if it is still running after FLASH_SPI_ERASE_TIMEOUT_MS.
+ */
+int flash_spi_erase_wait(void)
+{
+	uint32_t deadline = timing_deadline_us(FLASH_SPI_ERASE_TIMEOUT_MS * 1000);
+
+	while(flash_spi_erase_busy())
+	{
+		if(timing_expired(deadline))
+		{
+			flash_spi.error_count++;
+			return -1;
+		}
+		timing_wait_ms(FLASH_SPI_ERASE_POLL_MS);
+	}
+
+	return 0;
+}
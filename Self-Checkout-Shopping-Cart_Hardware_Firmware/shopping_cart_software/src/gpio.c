@@ -31,7 +31,7 @@ void gpio_init(void)
 	/* Clear all the Gpio interrupts Flags */
 	GPIO_IntClear(GPIO_NFC_INTERRUPT_FLAG);
 
-	/* Configure and Enable GPIO Interrupt For Push Button 1 */
+	/* Configure and Enable GPIO Interrupt on both edges of FD, the NFC event service tells them apart */
 	GPIO_IntConfig(GPIO_NFC_PORT, GPIO_NFC_PIN, GPIO_RISING_EDGE, GPIO_FALLING_EDGE, GPIO_INTERRUPT_ENABLE);
 
 	/* Enable NVIC interrupt */
@@ -54,13 +54,10 @@ void GPIO_ODD_IRQHandler(void)
 
 	if (flags & GPIO_NFC_INTERRUPT_FLAG)
 	{
-		/* Update the External Event after every NFC FD PIN interrupt */
+		/* Update the External Event after every NFC FD PIN interrupt, edges coming in before the event loop
+		 * runs are read as one */
 		external_event |= EVENT_NFC_GPIO;
 		gecko_external_signal(external_event);
-
-		/* Disable the GPIO interrupt here to remove multiple NFC interrupts and enable only after bluetooth
-		 connection is established or set a software timer to enable enable interrupt after a certain amount of time */
-		GPIO_IntDisable(GPIO_NFC_INTERRUPT_FLAG);
 	}
 
 	/* Enable All Interrupts */
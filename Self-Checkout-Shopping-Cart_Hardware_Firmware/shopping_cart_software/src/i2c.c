@@ -1,6 +1,7 @@
 /*
  * @file i2c.c
- * @brief This file consists of functions related to I2C0 peripheral.
+ * @brief This file consists of functions related to I2C0 peripheral. Transfers are run by a state machine in
+ * I2C0_IRQHandler() so that the bluetooth event loop never waits on the bus.
  *
  * @author: Satya Mehta
  * @date 11/05/2019
@@ -10,28 +11,21 @@
 
 
 #include <stdio.h>
+#include <string.h>
 #include "em_gpio.h"
 #include "em_i2c.h"
 #include "em_cmu.h"
 #include "em_core.h"
-#include "em_cmu.h"
+#include "native_gecko.h"
+#include "sleep.h"
 #include "inc/i2c.h"
+#include "inc/external_events.h"
+#include "inc/timing.h"
 
 
 
-#define DELAY_TIME						(1000000)
-
-
-/**
- * @brief Delay function used to add additional delays required in I2C Initialization.
- * @param uint32_t time A random time number tick.
- * @return void
- */
-static inline void delay(uint32_t time)
-{
-	uint32_t i;
-	for(i = 0; i < time; i++);
-}
+#define I2C_INTERRUPTS					(I2C_IEN_ACK | I2C_IEN_NACK | I2C_IEN_RXDATAV | I2C_IEN_MSTOP | \
+										 I2C_IEN_ARBLOST | I2C_IEN_BUSERR | I2C_IEN_CLTO)
 
 
 /**
@@ -50,6 +44,23 @@ static void i2c_gpio_init(void)
 }
 
 
+/**
+ * @brief This function frees the bus from a slave left in the middle of a byte by a reset. SCL is toggled 9 times
+ * as specified in the datasheet at 100kHz, with the pins not routed to I2C0 yet.
+ * @param void
+ * @return void
+ */
+static void i2c_bus_recover(void)
+{
+	for (int i=0; i<9; i++)
+	{
+		GPIO_PinOutClear(SCL_PORT, SCL_PIN);
+		timing_wait_us(5);
+		GPIO_PinOutSet(SCL_PORT, SCL_PIN);
+		timing_wait_us(5);
+	}
+}
+
 
 /**
  * @brief This function is used to initialize I2C0 peripheral.
@@ -59,17 +70,16 @@ static void i2c_gpio_init(void)
  */
 void i2c_init(void)
 {
+	memset(&i2c_engine, 0, sizeof(struct i2c_engine));
+
 	/* Enabling GPIO required for I2C */
 	i2c_gpio_init();
+	i2c_bus_recover();
 
 	/*I2C clock*/
 	CMU_ClockEnable(cmuClock_I2C0, true);
 	CMU_OscillatorEnable(cmuOsc_LFXO, true, true);
 
-
-	/* Additional delay before ROUTE */
-	delay(200000);
-
 	I2C0 -> ROUTEPEN = I2C_ROUTEPEN_SCLPEN | I2C_ROUTEPEN_SDAPEN;
 	I2C0->ROUTELOC0 |= (I2C0->ROUTELOC0 & (~_I2C_ROUTELOC0_SCLLOC_MASK))| I2C_ROUTELOC0_SCLLOC_LOC14;
 	I2C0->ROUTELOC0 |= (I2C0->ROUTELOC0 & (~_I2C_ROUTELOC0_SDALOC_MASK))| I2C_ROUTELOC0_SDALOC_LOC16;
@@ -78,284 +88,396 @@ void i2c_init(void)
 	const I2C_Init_TypeDef i2cinitialization = I2C_INIT_DEFAULT;
 
 	I2C_Init(I2C0, &i2cinitialization);
-	delay(DELAY_TIME);
-	I2C_Enable(I2C0,true);
-	delay(DELAY_TIME);
 
-	/*Toggle SCL 9 times as specified in datasheet*/
-	for (int i=0; i<9; i++)
-	{
-		GPIO_PinOutClear(SCL_PORT, SCL_PIN);
-		GPIO_PinOutSet(SCL_PORT, SCL_PIN);
-	}
-	delay(200000);
+	/* A slave stretching the clock forever ends the transfer with I2C_STATUS_TIMEOUT */
+	I2C0->CTRL = (I2C0->CTRL & ~_I2C_CTRL_CLTO_MASK) | I2C_CTRL_CLTO_1024PCC;
 
 	if(I2C0->STATE & I2C_STATE_BUSY)
 	{
 		I2C0->CMD = I2C_CMD_ABORT;
 	}
 
-
-	/* Enabling NACK Interrupt for debugging purposes*/
+	I2C_IntClear(I2C0, _I2C_IFC_MASK);
+	NVIC_ClearPendingIRQ(I2C0_IRQn);
 	NVIC_EnableIRQ(I2C0_IRQn);
-	I2C_IntEnable(I2C0, I2C_IFC_NACK);
 }
 
 
 /**
- * @brief This function is a polling write driver for NXP NTAG I2C NFC Device.
- * 16 Bytes are written in a single I2C write transfer.
- * @param add - Address of the starting register you need to write data into. Following 15 bytes will also be written.
- * 		  data - Starting address of the data which is to be written into NFC.
- * @return None.
+ * @brief This function is used to disable the I2C peripheral.
+ * @param None
+ * @return None
  */
-void i2c_write_poll(uint8_t add, uint8_t *data)
+void i2c_disable(void)
 {
-	uint8_t i;
-	I2C0->CMD = I2C_CMD_START;  					/* sending start bit */
-	I2C0->TXDATA = 0x04; 							/* NXP NTAG Address */
-
-	while((I2C0->IF & I2C_IF_ACK) == 0);
-	I2C0->IFC |= I2C_IFC_ACK;
+	I2C_IntDisable(I2C0, I2C_INTERRUPTS);
+	I2C0 -> ROUTEPEN &= ~I2C_ROUTEPEN_SCLPEN;
+	I2C0 -> ROUTEPEN &=~ I2C_ROUTEPEN_SDAPEN;
+	I2C_Enable(I2C0, false);
+	GPIO_PinOutClear(gpioPortC, 10); 					/* SCL line */
+	GPIO_PinOutClear(gpioPortC, 11);					/* SDA Line */
+}
 
-	I2C0->TXDATA = add;
 
-	/*Writing 16 Bytes */
-	for(i = 0; i < 16; i++)
-	{
-		while((I2C0->IF & I2C_IF_ACK) == 0);
-		I2C0->IFC |= I2C_IFC_ACK;
-		I2C0->TXDATA = data[i];
-	}
+/**
+ * @brief This function sends a START and the address of the write or the read phase of the transfer.
+ * @note Called from I2C0_IRQHandler() or with the I2C0 interrupt not enabled yet.
+ * @param bool read true for the read phase
+ * @return void
+ */
+static void i2c_phase_start(bool read)
+{
+	i2c_engine.index = 0;
+	i2c_engine.state = read ? I2C_STATE_READ_ADDRESS : I2C_STATE_WRITE_ADDRESS;
 
-	I2C0->CMD = I2C_CMD_STOP;
-	while(I2C0->CMD & I2C_STATUS_PSTOP);
+	I2C0->CMD = I2C_CMD_START;
+	I2C0->TXDATA = read ? (i2c_engine.transfer->address | 0x01) : i2c_engine.transfer->address;
 }
 
 
 /**
- * @brief This function is used to read the session register inside the NFC using the interrupts
- * @param session_register - Address of the session register which is read.
- * @return uint8_t - Returns data read from the session register.
+ * @brief This function ends the transfer and hands it over to the bluetooth event loop.
+ * @param enum i2c_status status Result of the transfer
+ * @return void
  */
-uint8_t read_session(uint8_t session_register)
+static void i2c_transfer_end(enum i2c_status status)
 {
-	I2C0->CMD = I2C_CMD_START;  								/* send start bit */
-	I2C0->TXDATA = 0x04; 										/* slave address */
+	I2C_IntDisable(I2C0, I2C_INTERRUPTS);
 
-	delay(DELAY_TIME);
-	if(interrupt_flag_ack && ((I2C0->IF & I2C_IF_ACK) == 0))
-	{
-		interrupt_flag_ack = 0;
-		I2C0->TXDATA = 0xFE;
-		delay(DELAY_TIME);
-	}
-	if(interrupt_flag_ack && ((I2C0->IF & I2C_IF_ACK) == 0))
+	if(status != I2C_STATUS_DONE)
 	{
-		interrupt_flag_ack = 0;
-		I2C0->TXDATA = session_register;
+		i2c_engine.error_count++;
 	}
-	if(interrupt_flag_ack && ((I2C0->IF & I2C_IF_ACK) == 0))
-	{
-		interrupt_flag_ack = 0;
-		I2C0->CMD = I2C_CMD_STOP;
-	}
-	delay(DELAY_TIME); 													/* Required for EEPROM Writing */
 
-	for(int i = 0; i < 10; i++);
-	I2C0->CMD = I2C_CMD_START;
-	I2C0->TXDATA = NXP_NTAG_R;
-	uint8_t data = 0;
-	if(interrupt_flag_ack && ((I2C0->IF & I2C_IF_ACK) == 0))
-	{
-		interrupt_flag_ack = 0;
-	}
-	while(I2C0->IF & I2C_IF_RXDATAV)
-	{
-		data = I2C0->RXDATA;
-		delay(DELAY_TIME);
-	}
-
-	I2C0->CMD = I2C_CMD_ACK;
-	I2C0->CMD = I2C_CMD_STOP;
-	delay(DELAY_TIME);
-	return data;
+	i2c_engine.transfer->status = status;
+	i2c_engine.state = I2C_STATE_IDLE;
+	i2c_engine.complete = true;
+	SLEEP_SleepBlockEnd(sleepEM2);
 
+	CORE_AtomicDisableIrq();
+	external_event |= EVENT_I2C;
+	gecko_external_signal(external_event);
+	CORE_AtomicEnableIrq();
 }
 
 
 /**
- * @brief This function is used to read the session register inside the NFC using polling method
- * @param session_register - Address of the session register which is read.
- * @return uint8_t - Returns data read from the session register.
+ * @brief This function starts a transfer, the callback of the transfer is called on EVENT_I2C once it is over.
+ * @param struct i2c_transfer* transfer The transfer, it must stay valid until the callback
+ * @return 0 if the transfer is started, -1 if another transfer is not over or the transfer is empty.
  */
-uint8_t i2c_read_session_poll(uint8_t session_register)
+int i2c_transfer_start(struct i2c_transfer* transfer)
 {
-	I2C0->CMD = I2C_CMD_START;  									/* send start bit */
-	I2C0->TXDATA = 0x04;
-
-	while((I2C0->IF & I2C_IF_ACK) == 0);
-	I2C0->IFC |= I2C_IFC_ACK;
-	//if(interrupt_flag_ack)
+	if(i2c_busy() || (transfer->tx_size > I2C_TX_MAXSIZE) || ((transfer->tx_size == 0) && (transfer->rx_size == 0)))
+	{
+		return -1;
+	}
 
-	I2C0->TXDATA = 0xFE;
+	/* Left busy by an aborted transfer */
+	if(I2C0->STATE & I2C_STATE_BUSY)
+	{
+		I2C0->CMD = I2C_CMD_ABORT;
+	}
 
-	while((I2C0->IF & I2C_IF_ACK) == 0);
-	I2C0->IFC |= I2C_IFC_ACK;
-	//if(interrupt_flag_ack)
+	/* I2C0 needs the HF clock, the bluetooth stack must not go to EM2 while the transfer runs */
+	SLEEP_SleepBlockBegin(sleepEM2);
+	transfer->status = I2C_STATUS_BUSY;
+	i2c_engine.transfer = transfer;
+	i2c_engine.retries = 0;
+	i2c_engine.transfer_count++;
 
-	I2C0->TXDATA = session_register;
-	while((I2C0->IF & I2C_IF_ACK) == 0);
-	I2C0->IFC |= I2C_IFC_ACK;
+	I2C_IntClear(I2C0, _I2C_IFC_MASK);
+	I2C0->CMD = I2C_CMD_CLEARTX | I2C_CMD_CLEARPC;
+	i2c_phase_start(transfer->tx_size == 0);
+	I2C_IntEnable(I2C0, I2C_INTERRUPTS);
 
-	I2C0->CMD = I2C_CMD_STOP;
-	delay(DELAY_TIME); 													/* Required for EEPROM Writing */
+	return 0;
+}
 
 
-	I2C0->CMD = I2C_CMD_START;
-	I2C0->TXDATA = NXP_NTAG_R;
-	uint8_t data;
+/**
+ * @brief This function starts a transfer, or queues it behind the running transfer and the ones already queued.
+ * @param struct i2c_transfer* transfer The transfer, it must stay valid until the callback and not be queued twice
+ * @return 0 if the transfer is started or queued, -1 if the transfer is empty or too long.
+ */
+int i2c_transfer_queue(struct i2c_transfer* transfer)
+{
+	if((transfer->tx_size > I2C_TX_MAXSIZE) || ((transfer->tx_size == 0) && (transfer->rx_size == 0)))
+	{
+		return -1;
+	}
 
-	while((I2C0->IF & I2C_IF_ACK) == 0);
-	I2C0->IFC |= I2C_IFC_ACK;
+	if(!i2c_busy() && (i2c_engine.queue_head == NULL))
+	{
+		return i2c_transfer_start(transfer);
+	}
 
-	while(I2C0->IF & I2C_IF_RXDATAV)
+	transfer->status = I2C_STATUS_BUSY;
+	transfer->next = NULL;
+	if(i2c_engine.queue_tail == NULL)
+	{
+		i2c_engine.queue_head = transfer;
+	}
+	else
 	{
-		data = I2C0->RXDATA;
+		i2c_engine.queue_tail->next = transfer;
 	}
+	i2c_engine.queue_tail = transfer;
+	i2c_engine.queue_count++;
 
-	I2C0->CMD = I2C_CMD_ACK;
-	I2C0->CMD = I2C_CMD_STOP;
-	delay(DELAY_TIME);
-	return data;
+	return 0;
 }
 
 
 /**
- * @brief This function is a polling read driver for NXP NTAG I2C NFC Device.
- * 16 Bytes are read in a single I2C read transfer.
- * @param register_address - Address of the starting register you want to read. Following 15 bytes will be also read.
- * @return None.
+ * @brief This function checks if a transfer is running or waiting for its callback.
+ * @param void
+ * @return true if i2c_transfer_start() would refuse a transfer.
  */
-uint8_t* i2c_read_poll(uint8_t register_address)
+bool i2c_busy(void)
 {
-	uint8_t i;
-
-	/* send start bit and slave address */
-	I2C0->CMD = I2C_CMD_START;
-	I2C0->TXDATA = 0x04;
-
-	while((I2C0->IF & I2C_IF_ACK) == 0);
-	I2C0->IFC |= I2C_IFC_ACK;
+	return ((i2c_engine.state != I2C_STATE_IDLE) || i2c_engine.complete);
+}
 
-	I2C0->TXDATA = register_address;
-	while((I2C0->IF & I2C_IF_ACK) == 0);
-	I2C0->IFC |= I2C_IFC_ACK;
 
-	I2C0->CMD = I2C_CMD_STOP;
-	delay(DELAY_TIME);
+/**
+ * @brief This function calls the callback of the transfer that just ended, on EVENT_I2C.
+ * @param void
+ * @return void
+ */
+void i2c_complete(void)
+{
+	struct i2c_transfer *transfer = i2c_engine.transfer;
 
-	I2C0->CMD = I2C_CMD_START;
-	I2C0->TXDATA = NXP_NTAG_R;
+	if(!i2c_engine.complete)
+	{
+		return;
+	}
 
-	while((I2C0->IF & I2C_IF_ACK) == 0);
-	I2C0->IFC |= I2C_IFC_ACK;
+	/* The callback may start the next transfer */
+	i2c_engine.transfer = NULL;
+	i2c_engine.complete = false;
 
-	for(i = 0; i < 16; i++)
+	if(transfer->status != I2C_STATUS_DONE)
 	{
-		while((I2C0->IF & I2C_IF_RXDATAV) == 0);
-		read[i] = I2C0->RXDATA;
-		I2C0->CMD = I2C_CMD_ACK;
+		printf("ERROR: I2C transfer to %x failed, status %u.\n", transfer->address, transfer->status);
 	}
 
+	if(transfer->callback != NULL)
+	{
+		transfer->callback(transfer);
+	}
 
-	I2C0->CMD = I2C_CMD_STOP;
-	delay(DELAY_TIME);
-	while(I2C0->CMD & I2C_STATUS_PSTOP);
-	return &read[0];
-
+	/* Unless the callback started another transfer, the bus goes to the oldest queued one */
+	if(!i2c_busy() && (i2c_engine.queue_head != NULL))
+	{
+		transfer = i2c_engine.queue_head;
+		i2c_engine.queue_head = transfer->next;
+		if(i2c_engine.queue_head == NULL)
+		{
+			i2c_engine.queue_tail = NULL;
+		}
+
+		if(i2c_transfer_start(transfer) < 0)
+		{
+			transfer->status = I2C_STATUS_BUSERR;
+			if(transfer->callback != NULL)
+			{
+				transfer->callback(transfer);
+			}
+		}
+	}
 }
 
 
 /**
- * @brief This function is used to disable the I2C peripheral.
- * @param None
- * @return None
+ * @brief This function fills a transfer writing one block of the NTAG memory.
+ * @param struct i2c_transfer* transfer The transfer, callback and context are left to the caller
+ * @param uint8_t block Block address
+ * @param uint8_t* data NXP_NTAG_BLOCK_SIZE bytes
+ * @return void
  */
-void i2c_disable(void)
+void i2c_ntag_block_write(struct i2c_transfer* transfer, uint8_t block, const uint8_t* data)
 {
-	I2C0 -> ROUTEPEN &= ~I2C_ROUTEPEN_SCLPEN;
-	I2C0 -> ROUTEPEN &=~ I2C_ROUTEPEN_SDAPEN;
-	I2C_Enable(I2C0, false);
-	GPIO_PinOutClear(gpioPortC, 10); 					/* SCL line */
-	GPIO_PinOutClear(gpioPortC, 11);					/* SDA Line */
+	transfer->address = NXP_NTAG_W;
+	transfer->tx[0] = block;
+	memcpy(&transfer->tx[1], data, NXP_NTAG_BLOCK_SIZE);
+	transfer->tx_size = 1 + NXP_NTAG_BLOCK_SIZE;
+	transfer->rx = NULL;
+	transfer->rx_size = 0;
 }
 
 
 /**
- * @brief Testing function to check whether I2C is working
- * @note The output printfs should be 0x70, 0x2E, 0x6F, 0x6F, 0x62, 0x08, 0x00, 0x90, 0xE6, 0xb1, 0x29, 0xef, 0x57, 0x0b, 0x00, 0x6D, 0x6F.
- * @param void
+ * @brief This function fills a transfer reading one block of the NTAG memory.
+ * @param struct i2c_transfer* transfer The transfer, callback and context are left to the caller
+ * @param uint8_t block Block address
+ * @param uint8_t* data Room for NXP_NTAG_BLOCK_SIZE bytes, it must stay valid until the callback
  * @return void
  */
-void i2c_test_blocking(void)
+void i2c_ntag_block_read(struct i2c_transfer* transfer, uint8_t block, uint8_t* data)
 {
-	uint8_t i;
-	uint8_t write_nfc_row[16] = {0x70, 0x2E, 0x6F, 0x6F, 0x62, 0x08, 0x00, 0x90, 0xE6, 0xE1, 0xA6, 0xA8, 0xBC, 0xFE, 0x6D, 0x6F};
-	uint8_t blue_gecko_addr[6] = {0xb1, 0x29, 0xef, 0x57, 0x0b, 0x00};
-
-	for (i = 7; i <= 12; i++)
-	{
-		write_nfc_row[i] = blue_gecko_addr[i-7];
-	}
-
-	i2c_write_poll(0x01, write_nfc_row);
-
-	delay(DELAY_TIME);
-
-	uint8_t* received_i2c = i2c_read_poll(0x03);
-	for (i= 0; i < 16; i++)
-	{
-		printf("Data into the address %x -- %x\n", (0x03+i), received_i2c[i]);
-	}
+	transfer->address = NXP_NTAG_W;
+	transfer->tx[0] = block;
+	transfer->tx_size = 1;
+	transfer->rx = data;
+	transfer->rx_size = NXP_NTAG_BLOCK_SIZE;
 }
 
 
-void nxp_ntag_nfc_write(uint8_t *arr, uint8_t row)
+/**
+ * @brief This function fills a transfer reading one session register of the NTAG.
+ * @param struct i2c_transfer* transfer The transfer, callback and context are left to the caller
+ * @param uint8_t reg Register address
+ * @param uint8_t* data Room for the register value, it must stay valid until the callback
+ * @return void
+ */
+void i2c_ntag_register_read(struct i2c_transfer* transfer, uint8_t reg, uint8_t* data)
 {
-	i2c_write_poll(row, arr);
+	transfer->address = NXP_NTAG_W;
+	transfer->tx[0] = NXP_NTAG_SESSION_MEMA;
+	transfer->tx[1] = reg;
+	transfer->tx_size = 2;
+	transfer->rx = data;
+	transfer->rx_size = 1;
 }
 
 
-uint8_t* nxp_ntag_nfc_read(uint8_t *arr, uint8_t row)
+/**
+ * @brief This function fills a transfer writing some bits of one session register of the NTAG.
+ * @param struct i2c_transfer* transfer The transfer, callback and context are left to the caller
+ * @param uint8_t reg Register address
+ * @param uint8_t mask Bits to write, the others keep their value
+ * @param uint8_t value New value of the bits
+ * @return void
+ */
+void i2c_ntag_register_write(struct i2c_transfer* transfer, uint8_t reg, uint8_t mask, uint8_t value)
 {
-	arr = i2c_read_poll(row);
-	return arr;
+	transfer->address = NXP_NTAG_W;
+	transfer->tx[0] = NXP_NTAG_SESSION_MEMA;
+	transfer->tx[1] = reg;
+	transfer->tx[2] = mask;
+	transfer->tx[3] = value;
+	transfer->tx_size = 4;
+	transfer->rx = NULL;
+	transfer->rx_size = 0;
 }
 
 
 /**
- * @brief- IRQ Handler for I2C0 Peripheral
+ * @brief- IRQ Handler for I2C0 Peripheral. Moves the current transfer one step forward on every bus event.
  * @param- None
  * @return- None
  */
 void I2C0_IRQHandler()
 {
-	/* Disable All Interrupts */
-	CORE_AtomicDisableIrq();
+	uint32_t flags = I2C_IntGetEnabled(I2C0);
+	struct i2c_transfer *transfer = i2c_engine.transfer;
+
+	I2C_IntClear(I2C0, flags);
 
-	if(I2C0->IF & I2C_IF_ACK)
+	if((transfer == NULL) || (i2c_engine.state == I2C_STATE_IDLE))
 	{
-		I2C0->IFC |= I2C_IFC_ACK;
-		interrupt_flag_ack = 1;
+		return;
 	}
-	if(I2C0->IF & I2C_IF_NACK)
+
+	/* Lost bus, the controller goes back to idle without a STOP */
+	if(flags & (I2C_IF_ARBLOST | I2C_IF_BUSERR | I2C_IF_CLTO))
 	{
-		printf("NACK Received\n");
-		I2C0->IFC |= I2C_IFC_NACK;
+		I2C0->CMD = I2C_CMD_ABORT;
+		i2c_transfer_end((flags & I2C_IF_CLTO) ? I2C_STATUS_TIMEOUT :
+						 (flags & I2C_IF_ARBLOST) ? I2C_STATUS_ARBLOST : I2C_STATUS_BUSERR);
+		return;
 	}
 
-	/* Enable All Interrupts */
-	CORE_AtomicEnableIrq();
-}
+	if(flags & I2C_IF_NACK)
+	{
+		I2C0->CMD = I2C_CMD_STOP;
+
+		/* The NTAG is busy programming its EEPROM, the phase is started again after the STOP */
+		if(((i2c_engine.state == I2C_STATE_WRITE_ADDRESS) || (i2c_engine.state == I2C_STATE_READ_ADDRESS)) &&
+		   (i2c_engine.retries < I2C_ADDRESS_RETRIES))
+		{
+			i2c_engine.retries++;
+			i2c_engine.retry_count++;
+			i2c_engine.index = (i2c_engine.state == I2C_STATE_READ_ADDRESS);			/* Phase to start again */
+			i2c_engine.state = I2C_STATE_RETRY_STOP;
+		}
+		else
+		{
+			i2c_engine.state = I2C_STATE_FAIL_STOP;
+		}
+		return;
+	}
 
+	if(flags & I2C_IF_ACK)
+	{
+		if((i2c_engine.state == I2C_STATE_WRITE_ADDRESS) || (i2c_engine.state == I2C_STATE_WRITE_DATA))
+		{
+			if(i2c_engine.index < transfer->tx_size)
+			{
+				I2C0->TXDATA = transfer->tx[i2c_engine.index++];
+				i2c_engine.state = I2C_STATE_WRITE_DATA;
+			}
+			else
+			{
+				I2C0->CMD = I2C_CMD_STOP;
+				i2c_engine.state = I2C_STATE_WRITE_STOP;
+			}
+		}
+		else if(i2c_engine.state == I2C_STATE_READ_ADDRESS)
+		{
+			/* The controller clocks the first byte in by itself */
+			i2c_engine.state = I2C_STATE_READ_DATA;
+		}
+	}
+
+	if((flags & I2C_IF_RXDATAV) && (i2c_engine.state == I2C_STATE_READ_DATA))
+	{
+		transfer->rx[i2c_engine.index++] = I2C0->RXDATA;
+
+		if(i2c_engine.index < transfer->rx_size)
+		{
+			I2C0->CMD = I2C_CMD_ACK;
+		}
+		else
+		{
+			/* The last byte is not acknowledged */
+			I2C0->CMD = I2C_CMD_NACK;
+			I2C0->CMD = I2C_CMD_STOP;
+			i2c_engine.state = I2C_STATE_READ_STOP;
+		}
+	}
+
+	if(flags & I2C_IF_MSTOP)
+	{
+		switch(i2c_engine.state)
+		{
+		case I2C_STATE_WRITE_STOP:
+			if(transfer->rx_size)
+			{
+				i2c_phase_start(true);
+			}
+			else
+			{
+				i2c_transfer_end(I2C_STATUS_DONE);
+			}
+			break;
+
+		case I2C_STATE_READ_STOP:
+			i2c_transfer_end(I2C_STATUS_DONE);
+			break;
+
+		case I2C_STATE_RETRY_STOP:
+			i2c_phase_start(i2c_engine.index != 0);
+			break;
+
+		case I2C_STATE_FAIL_STOP:
+			i2c_transfer_end(I2C_STATUS_NACK);
+			break;
+
+		default:
+			break;
+		}
+	}
+}
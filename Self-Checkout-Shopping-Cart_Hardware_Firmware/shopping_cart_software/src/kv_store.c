@@ -0,0 +1,488 @@
+/*
+ * @file kv_store.c
+ * @brief This file consists of the key/value store in the internal flash. It keeps the cart id, the settings and
+ * the lifetime statistics across resets and firmware updates.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "em_msc.h"
+#include "inc/kv_store.h"
+
+
+/* Region reserved in efr32bg13p632f512gm48.ld */
+extern uint32_t __kvstoreBase[];
+extern uint32_t __kvstoreSize[];
+
+
+/**
+ * @brief This function continues the CRC-16/CCITT of a record.
+ * @param uint16_t crc CRC of the bytes before, 0xFFFF to start
+ * @param uint8_t* data Bytes
+ * @param uint8_t size Number of bytes
+ * @return The CRC.
+ */
+static uint16_t kv_store_crc(uint16_t crc, const uint8_t* data, uint8_t size)
+{
+	for(uint8_t i = 0; i < size; i++)
+	{
+		crc ^= (uint16_t)data[i] << 8;
+		for(uint8_t bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+
+/**
+ * @brief This function returns the address of a page of the store.
+ * @param uint8_t page Page of the ring
+ * @return The first word of the page.
+ */
+static uint32_t* kv_store_page_address(uint8_t page)
+{
+	return &__kvstoreBase[(page * FLASH_PAGE_SIZE) / 4];
+}
+
+
+/**
+ * @brief This function checks if a page can be used without an erase. The erase count word is not checked.
+ * @param uint8_t page Page of the ring
+ * @return true if every other word of the page is erased.
+ */
+static bool kv_store_page_blank(uint8_t page)
+{
+	const uint32_t *word = kv_store_page_address(page);
+
+	if(word[0] != KV_STORE_BLANK)
+	{
+		return false;
+	}
+
+	for(uint16_t i = 2; i < (FLASH_PAGE_SIZE / 4); i++)
+	{
+		if(word[i] != KV_STORE_BLANK)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/**
+ * @brief This function erases a page and writes its new erase count in its header.
+ * @param uint8_t page Page of the ring
+ * @return void
+ */
+static void kv_store_page_erase(uint8_t page)
+{
+	uint32_t *word = kv_store_page_address(page);
+	uint32_t count = kv_store.erase_count[page] + 1;
+	uint32_t header = (count & 0xFFFF) | ((~count & 0xFFFF) << 16);
+
+	MSC_ErasePage(word);
+	MSC_WriteWord(&word[1], &header, 4);
+
+	kv_store.erase_count[page] = count;
+}
+
+
+/**
+ * @brief This function encodes the record of a key.
+ * @param uint32_t* record Room for KV_STORE_RECORD_MAXSIZE bytes
+ * @param uint8_t key The key
+ * @param bool open true to leave KV_STORE_RECORD_OPEN set in the header
+ * @return Size of the record in bytes, a multiple of 4.
+ */
+static uint16_t kv_store_record(uint32_t* record, uint8_t key, bool open)
+{
+	uint8_t size = kv_store.size[key];
+	uint8_t prefix[2] = {key, size};
+	uint16_t crc = kv_store_crc(kv_store_crc(0xFFFF, prefix, 2), kv_store.value[key], size);
+
+	record[0] = key | ((uint32_t)(size | (open ? KV_STORE_RECORD_OPEN : 0)) << 8) | ((uint32_t)crc << 16);
+
+	/* Padding is left erased */
+	memset(&record[1], 0xFF, KV_STORE_VALUE_MAXSIZE);
+	memcpy(&record[1], kv_store.value[key], size);
+
+	return 4 + ((size + 3) & ~3);
+}
+
+
+/**
+ * @brief This function reads the records of the page in use into RAM, later records of a key replace earlier ones.
+ * @param void
+ * @return void
+ */
+static void kv_store_replay(void)
+{
+	const uint32_t *word = kv_store_page_address(kv_store.page);
+	uint16_t offset = KV_STORE_HEADER_WORDS * 4;
+
+	while((offset < FLASH_PAGE_SIZE) && (word[offset / 4] != KV_STORE_BLANK))
+	{
+		uint32_t header = word[offset / 4];
+		uint8_t prefix[2] = {header & 0xFF, (header >> 8) & 0xFF};
+		uint8_t key = prefix[0];
+		uint8_t size = prefix[1];
+		uint16_t record_size = 4 + ((size + 3) & ~3);
+		const uint8_t *value = (const uint8_t *)&word[(offset / 4) + 1];
+
+		/* A write cut by a reset, nothing was written after it */
+		if((size & KV_STORE_RECORD_OPEN) || (size > KV_STORE_VALUE_MAXSIZE) || ((offset + record_size) > FLASH_PAGE_SIZE) ||
+		   ((header >> 16) != kv_store_crc(kv_store_crc(0xFFFF, prefix, 2), value, size)))
+		{
+			kv_store.corrupt_count++;
+			kv_store.compact_pending = true;
+			break;
+		}
+		offset += record_size;
+
+		/* Keys written by a newer firmware are dropped at the next page change */
+		if((key >= KV_KEY_COUNT) || (size == 0))
+		{
+			continue;
+		}
+
+		memcpy(kv_store.value[key], value, size);
+		kv_store.size[key] = size;
+	}
+
+	kv_store.offset = offset;
+}
+
+
+/**
+ * @brief This function writes all the values to the next page of the ring and erases the page used until now.
+ * @param void
+ * @return 0 on success, -1 if the flash could not be written, the page in use is kept.
+ */
+static int kv_store_compact(void)
+{
+	uint32_t record[(KV_KEY_COUNT * KV_STORE_RECORD_MAXSIZE) / 4];
+	uint16_t size = 0;
+	uint8_t next = (kv_store.page + 1) % KV_STORE_PAGE_COUNT;
+	uint32_t *word = kv_store_page_address(next);
+	uint32_t generation[2] = {kv_store.generation + 1, ~(kv_store.generation + 1)};
+	uint32_t magic = KV_STORE_MAGIC;
+
+	/* The magic guards the whole page, the records are written closed */
+	for(uint8_t key = 0; key < KV_KEY_COUNT; key++)
+	{
+		if(kv_store.size[key])
+		{
+			size += kv_store_record(&record[size / 4], key, false);
+		}
+	}
+
+	if(!kv_store_page_blank(next))
+	{
+		kv_store_page_erase(next);
+	}
+
+	/* The page is only valid once the magic is written, after the values */
+	if((MSC_WriteWord(&word[2], generation, 8) != mscReturnOk) ||
+	   (size && (MSC_WriteWord(&word[KV_STORE_HEADER_WORDS], record, size) != mscReturnOk)) ||
+	   (MSC_WriteWord(&word[0], &magic, 4) != mscReturnOk))
+	{
+		printf("ERROR: KV store page %u could not be written.\n", next);
+		return -1;
+	}
+
+	if(!kv_store_page_blank(kv_store.page))
+	{
+		kv_store_page_erase(kv_store.page);
+	}
+
+	kv_store.page = next;
+	kv_store.generation = generation[0];
+	kv_store.offset = (KV_STORE_HEADER_WORDS * 4) + size;
+	kv_store.dirty = 0;
+	kv_store.compact_pending = false;
+	kv_store.compact_count++;
+	kv_store.write_count++;
+
+	return 0;
+}
+
+
+/**
+ * @brief This function finds the page in use and reads all the values into RAM. Pages left over by a page change
+ * cut by a reset are erased, and the store is formatted if no page is valid.
+ * @param void
+ * @return 0 on success, -1 if the region reserved by the linker script does not match KV_STORE_PAGE_COUNT.
+ */
+int kv_store_init(void)
+{
+	uint32_t erase_max = 0;
+	bool found = false;
+
+	memset(&kv_store, 0, sizeof(struct kv_store));
+
+	if((uint32_t)__kvstoreSize != (KV_STORE_PAGE_COUNT * FLASH_PAGE_SIZE))
+	{
+		printf("ERROR: KV store region is %lu bytes.\n", (unsigned long)__kvstoreSize);
+		return -1;
+	}
+
+	MSC_Init();
+
+	for(uint8_t page = 0; page < KV_STORE_PAGE_COUNT; page++)
+	{
+		const uint32_t *word = kv_store_page_address(page);
+
+		/* A count left blank or half written by a reset is lost */
+		kv_store.erase_count[page] = ((word[1] >> 16) == (~word[1] & 0xFFFF)) ? (word[1] & 0xFFFF) : KV_STORE_BLANK;
+		if((kv_store.erase_count[page] != KV_STORE_BLANK) && (kv_store.erase_count[page] > erase_max))
+		{
+			erase_max = kv_store.erase_count[page];
+		}
+
+		if((word[0] == KV_STORE_MAGIC) && (word[3] == ~word[2]) && (!found || (word[2] > kv_store.generation)))
+		{
+			found = true;
+			kv_store.page = page;
+			kv_store.generation = word[2];
+		}
+	}
+
+	if(found)
+	{
+		/* A count lost by a reset right after an erase. The pages are erased in turn, the one before in the ring
+		 * has the same count. Only a blank count can be written again */
+		for(uint8_t page = 0; page < KV_STORE_PAGE_COUNT; page++)
+		{
+			uint8_t previous = page;
+			uint32_t header;
+
+			if(kv_store.erase_count[page] != KV_STORE_BLANK)
+			{
+				continue;
+			}
+
+			do
+			{
+				previous = (previous + KV_STORE_PAGE_COUNT - 1) % KV_STORE_PAGE_COUNT;
+			} while((kv_store.erase_count[previous] == KV_STORE_BLANK) && (previous != page));
+
+			kv_store.erase_count[page] = (previous != page) ? kv_store.erase_count[previous] : 0;
+			header = (kv_store.erase_count[page] & 0xFFFF) | ((~kv_store.erase_count[page] & 0xFFFF) << 16);
+			if(kv_store_page_address(page)[1] == KV_STORE_BLANK)
+			{
+				MSC_WriteWord(&kv_store_page_address(page)[1], &header, 4);
+			}
+		}
+
+		kv_store_replay();
+
+		for(uint8_t page = 0; page < KV_STORE_PAGE_COUNT; page++)
+		{
+			if((page != kv_store.page) && !kv_store_page_blank(page))
+			{
+				kv_store_page_erase(page);
+			}
+		}
+	}
+	else
+	{
+		/* Never formatted, the region may hold anything */
+		for(uint8_t page = 0; page < KV_STORE_PAGE_COUNT; page++)
+		{
+			kv_store.erase_count[page] = 0;
+			if(!kv_store_page_blank(page) || (kv_store_page_address(page)[1] != KV_STORE_BLANK))
+			{
+				kv_store_page_erase(page);
+			}
+		}
+
+		/* The first page change moves to page 0 */
+		kv_store.page = KV_STORE_PAGE_COUNT - 1;
+		kv_store_compact();
+	}
+
+	kv_store.ready = true;
+
+	uint32_t erase_min = kv_store.erase_count[0];
+	for(uint8_t page = 0; page < KV_STORE_PAGE_COUNT; page++)
+	{
+		erase_min = (kv_store.erase_count[page] < erase_min) ? kv_store.erase_count[page] : erase_min;
+		erase_max = (kv_store.erase_count[page] > erase_max) ? kv_store.erase_count[page] : erase_max;
+	}
+	printf("KV store: page %u, generation %lu, %u bytes used, %lu to %lu erases per page, %lu corrupt records\n",
+			kv_store.page, (unsigned long)kv_store.generation, kv_store.offset, (unsigned long)erase_min,
+			(unsigned long)erase_max, (unsigned long)kv_store.corrupt_count);
+
+	return 0;
+}
+
+
+/**
+ * @brief This function reads the value of a key from RAM.
+ * @param enum kv_key key The key
+ * @param void* data Room for the value
+ * @param uint8_t size Size of data
+ * @return Number of bytes copied, -1 if the key has no value.
+ */
+int kv_store_get(enum kv_key key, void* data, uint8_t size)
+{
+	if((key >= KV_KEY_COUNT) || (kv_store.size[key] == 0))
+	{
+		return -1;
+	}
+
+	if(size > kv_store.size[key])
+	{
+		size = kv_store.size[key];
+	}
+	memcpy(data, kv_store.value[key], size);
+
+	return size;
+}
+
+
+/**
+ * @brief This function changes the value of a key in RAM, it is written to the flash by the next kv_store_flush().
+ * @param enum kv_key key The key
+ * @param void* data The value
+ * @param uint8_t size Size of the value, 1 to KV_STORE_VALUE_MAXSIZE
+ * @return 0 on success, -1 if the key or size is not valid.
+ */
+int kv_store_set(enum kv_key key, const void* data, uint8_t size)
+{
+	if((key >= KV_KEY_COUNT) || (size == 0) || (size > KV_STORE_VALUE_MAXSIZE))
+	{
+		return -1;
+	}
+
+	/* Nothing to write if the value did not change */
+	if((size == kv_store.size[key]) && (memcmp(kv_store.value[key], data, size) == 0))
+	{
+		return 0;
+	}
+
+	memcpy(kv_store.value[key], data, size);
+	kv_store.size[key] = size;
+	kv_store.dirty |= (1UL << key);
+
+	return 0;
+}
+
+
+/**
+ * @brief This function reads a uint32_t value.
+ * @param enum kv_key key The key
+ * @param uint32_t value Returned if the key has no value
+ * @return The value.
+ */
+uint32_t kv_store_get_u32(enum kv_key key, uint32_t value)
+{
+	uint32_t stored;
+
+	if(kv_store_get(key, &stored, sizeof(stored)) != sizeof(stored))
+	{
+		return value;
+	}
+
+	return stored;
+}
+
+
+/**
+ * @brief This function changes a uint32_t value.
+ * @param enum kv_key key The key
+ * @param uint32_t value The value
+ * @return 0 on success, -1 if the key is not valid.
+ */
+int kv_store_set_u32(enum kv_key key, uint32_t value)
+{
+	return kv_store_set(key, &value, sizeof(value));
+}
+
+
+/**
+ * @brief This function writes the values changed since the last call with a single flash write of their records,
+ * moving to the next page when they do not fit. The CPU stalls while the flash is written, about 20us per word and
+ * 20ms per page erase, plus one word per record to close it.
+ * @param void
+ * @return 0 on success, -1 if the flash could not be written, the values are kept for the next call.
+ */
+int kv_store_flush(void)
+{
+	uint32_t record[(KV_KEY_COUNT * KV_STORE_RECORD_MAXSIZE) / 4];
+	uint16_t header[KV_KEY_COUNT];
+	uint8_t count = 0;
+	uint16_t size = 0;
+	uint32_t *word;
+
+	if(!kv_store.ready)
+	{
+		return -1;
+	}
+
+	if(kv_store.dirty == 0)
+	{
+		return 0;
+	}
+
+	for(uint8_t key = 0; key < KV_KEY_COUNT; key++)
+	{
+		if(kv_store.dirty & (1UL << key))
+		{
+			header[count++] = size / 4;
+			size += kv_store_record(&record[size / 4], key, true);
+		}
+	}
+
+	if(kv_store.compact_pending || ((kv_store.offset + size) > FLASH_PAGE_SIZE))
+	{
+		return kv_store_compact();
+	}
+
+	/* The second write of a header closes its record, a word can be written twice between two erases */
+	word = &kv_store_page_address(kv_store.page)[kv_store.offset / 4];
+	if(MSC_WriteWord(word, record, size) != mscReturnOk)
+	{
+		printf("ERROR: KV store write failed.\n");
+		kv_store.compact_pending = true;
+		return -1;
+	}
+
+	for(uint8_t i = 0; i < count; i++)
+	{
+		record[header[i]] &= ~((uint32_t)KV_STORE_RECORD_OPEN << 8);
+		if(MSC_WriteWord(&word[header[i]], &record[header[i]], 4) != mscReturnOk)
+		{
+			printf("ERROR: KV store write failed.\n");
+			kv_store.compact_pending = true;
+			return -1;
+		}
+	}
+
+	kv_store.offset += size;
+	kv_store.dirty = 0;
+	kv_store.write_count++;
+
+	return 0;
+}
+
+
+/**
+ * @brief This function tells if some values are not written to the flash yet.
+ * @param void
+ * @return true if kv_store_flush() has something to write.
+ */
+bool kv_store_dirty(void)
+{
+	return (kv_store.ready && (kv_store.dirty != 0));
+}
@@ -15,6 +15,17 @@
 #include "inc/leuart.h"
 #include "inc/connection_param.h"
 #include "inc/external_events.h"
+#include "inc/barcode.h"
+#include "inc/flash_spi.h"
+
+#ifdef LEUART_RX_LDMA
+#include "em_bus.h"
+#include "dmadrv_config.h"
+
+
+/* Two linked descriptors, each filling one half of leuart_circbuff.buffer and then linking to the other one */
+static DMA_DESCRIPTOR_TypeDef leuart_rx_descriptor[2];
+#endif
 
 
 
@@ -37,49 +48,225 @@ static void leuart_gpio_init(void)
 
 
 
+#ifdef LEUART_RX_LDMA
+/**
+ * @brief This function publishes the bytes written by the LDMA since the last call by advancing the head
+ * of leuart_circbuff to the current LDMA destination address.
+ * @note Only called from interrupt context, i.e. by the producer side of the ring buffer.
+ * It must be called at least once every LEUART_RX_LDMA_HALF_SIZE bytes, which the done interrupt guarantees.
+ * @param void
+ * @return void
+ */
+static void leuart_rx_ldma_sync(void)
+{
+	uint32_t write_index = (LDMA->CH[LEUART_RX_LDMA_CHANNEL].DST - (uint32_t)&leuart_circbuff.buffer[0]) & LEUART_BUFFER_MASK;
+	uint32_t received = (write_index - leuart_circbuff.head) & LEUART_BUFFER_MASK;
+
+	/* The LDMA has already written the data, make sure it is visible before the new head */
+	__DMB();
+	leuart_circbuff.head += received;
+}
+
+
+/**
+ * @brief This function configures the LDMA channel to copy every received byte of LEUART0 into
+ * leuart_circbuff.buffer. The buffer is split into two halves, each one described by its own descriptor,
+ * so that the LDMA raises a done interrupt on every half and full transfer and runs forever.
+ * @param void
+ * @return void
+ */
+static void leuart_rx_ldma_init(void)
+{
+	uint32_t channel_mask = (1 << LEUART_RX_LDMA_CHANNEL);
+
+	CMU_ClockEnable(cmuClock_LDMA, true);
+
+	/* The LDMA restarts at the beginning of the buffer, hence discard whatever was left from the previous connection */
+	leuart_circbuff.head = 0;
+	leuart_circbuff.tail = 0;
+
+	for(uint8_t i = 0; i < 2; i++)
+	{
+		leuart_rx_descriptor[i].CTRL = LDMA_CH_CTRL_STRUCTTYPE_TRANSFER
+									 | ((LEUART_RX_LDMA_HALF_SIZE - 1) << _LDMA_CH_CTRL_XFERCNT_SHIFT)
+									 | LDMA_CH_CTRL_BLOCKSIZE_UNIT1
+									 | LDMA_CH_CTRL_DONEIFSEN
+									 | LDMA_CH_CTRL_REQMODE_BLOCK
+									 | LDMA_CH_CTRL_SRCINC_NONE
+									 | LDMA_CH_CTRL_SIZE_BYTE
+									 | LDMA_CH_CTRL_DSTINC_ONE
+									 | LDMA_CH_CTRL_SRCMODE_ABSOLUTE
+									 | LDMA_CH_CTRL_DSTMODE_ABSOLUTE;
+		leuart_rx_descriptor[i].SRC = (void *)&LEUART0->RXDATA;
+		leuart_rx_descriptor[i].DST = (void *)&leuart_circbuff.buffer[i * LEUART_RX_LDMA_HALF_SIZE];
+		leuart_rx_descriptor[i].LINK = (void *)(((uint32_t)&leuart_rx_descriptor[(i + 1) % 2] & _LDMA_CH_LINK_LINKADDR_MASK)
+									 | LDMA_CH_LINK_LINKMODE_ABSOLUTE | LDMA_CH_LINK_LINK);
+	}
+
+	/* Stop the channel in case it is still running from the previous connection */
+	BUS_RegMaskedClear(&LDMA->CHEN, channel_mask);
+	LDMA->CTRL = (EMDRV_DMADRV_DMA_CH_PRIORITY << _LDMA_CTRL_NUMFIXED_SHIFT);
+
+	LDMA->CH[LEUART_RX_LDMA_CHANNEL].REQSEL = LDMA_CH_REQSEL_SOURCESEL_LEUART0 | LDMA_CH_REQSEL_SIGSEL_LEUART0RXDATAV;
+	LDMA->CH[LEUART_RX_LDMA_CHANNEL].CFG = 0;
+	LDMA->CH[LEUART_RX_LDMA_CHANNEL].LOOP = 0;
+	LDMA->CH[LEUART_RX_LDMA_CHANNEL].LINK = (uint32_t)&leuart_rx_descriptor[0] & _LDMA_CH_LINK_LINKADDR_MASK;
+
+	LDMA->IFC = channel_mask | LDMA_IF_ERROR;
+	LDMA->IEN |= channel_mask | LDMA_IEN_ERROR;
+	NVIC_ClearPendingIRQ(LDMA_IRQn);
+	NVIC_SetPriority(LDMA_IRQn, EMDRV_DMADRV_DMA_IRQ_PRIORITY);
+	NVIC_EnableIRQ(LDMA_IRQn);
+
+	/* Load the first descriptor which starts the channel */
+	LDMA->REQCLEAR = channel_mask;
+	LDMA->LINKLOAD = channel_mask;
+}
+
+
+/**
+ * @brief This function stops the LDMA channel used for LEUART0 RX.
+ * @param void
+ * @return void
+ */
+static void leuart_rx_ldma_disable(void)
+{
+	uint32_t channel_mask = (1 << LEUART_RX_LDMA_CHANNEL);
+
+	LDMA->IEN &= ~channel_mask;
+	BUS_RegMaskedClear(&LDMA->CHEN, channel_mask);
+	LDMA->IFC = channel_mask;
+}
+
+
+/**
+ * @brief This function restarts the LDMA channel after a transfer error, on the consumer side. The bytes still
+ * in the buffer may belong to a frame the LDMA did not finish, they are discarded and counted in overrun_count.
+ * @note The channel is stopped, but a signal frame interrupt can still publish a head, hence the critical section.
+ * @param void
+ * @return void
+ */
+static void leuart_rx_ldma_resync(void)
+{
+	CORE_DECLARE_IRQ_STATE;
+
+	printf("ERROR: LDMA transfer error, restarting LEUART RX channel.\n");
+
+	CORE_ENTER_CRITICAL();
+	leuart_circbuff.overrun_count += leuart_circbuff.head - leuart_circbuff.tail;
+	leuart_circbuff.resync = false;
+	leuart_circbuff.resync_count++;
+	leuart_rx_ldma_init();
+	CORE_EXIT_CRITICAL();
+}
+
+
+#endif
+
+
+/**
+ * @brief Interrupt handler for LDMA, shared with the reads of the external flash. The LEUART0 RX channel raises
+ * this interrupt every time one half of leuart_circbuff.buffer is filled. Only a barcode longer than half of the
+ * buffer wakes up the event loop from here.
+ * @param void
+ * @return void
+ */
+void LDMA_IRQHandler(void)
+{
+	/* Acknowledge and Clear the Interrupt */
+	uint32_t flags = LDMA->IF;
+	LDMA->IFC = flags;
+
+	flash_spi_ldma_irq(flags);
+
+#ifdef LEUART_RX_LDMA
+	if (flags & (1 << LEUART_RX_LDMA_CHANNEL))
+	{
+		leuart_rx_ldma_sync();
+
+		//Update the External Event after every half of the buffer is filled
+		CORE_AtomicDisableIrq();
+		external_event |= EVENT_LEUART;
+		gecko_external_signal(external_event);
+		CORE_AtomicEnableIrq();
+	}
+
+	/* The ring indexes are left alone, the consumer restarts the channel once it sees resync */
+	if (flags & LDMA_IF_ERROR)
+	{
+		leuart_rx_ldma_disable();
+		leuart_circbuff.resync = true;
+
+		CORE_AtomicDisableIrq();
+		external_event |= EVENT_LEUART;
+		gecko_external_signal(external_event);
+		CORE_AtomicEnableIrq();
+	}
+#endif
+}
+
+
+/**
+ * @brief This function blocks the LEUART0 receiver until the next start frame, i.e. BARCODE_PREAMBLE.
+ * Everything received between two barcode frames (the scanner's carriage return, noise) is dropped in hardware.
+ * @param void
+ * @return void
+ */
+static inline void leuart_rx_block(void)
+{
+	LEUART0->CMD = LEUART_CMD_RXBLOCKEN;
+}
+
+
 /**
  * @brief Interrupt handler for LEUART
+ * @note The ring buffer is lock free, interrupts are only disabled around the shared external_event update.
  * @param void
  * @return void
  */
 void LEUART0_IRQHandler(void)
 {
-	/* Disable All Interrupts */
-	CORE_AtomicDisableIrq();
-
 	/* Acknowledge and Clear the Interrupt */
 	uint32_t flags = LEUART_IntGet(LEUART0);
 	LEUART_IntClear(LEUART0, flags);
 
+#ifndef LEUART_RX_LDMA
 	/* RX portion of the interrupt handler */
 	if (flags & LEUART_IF_RXDATAV)
 	{
-
-		if(leuart_circbuff.buffer_interrupt_count == LEUART_BUFFER_INTERRUPT_SIZE)
-		{
-			//Update the External Event after every BUFFER_INTERRUPT_SIZE(define in leuart.h) bytes of receiving data
-			external_event |= EVENT_LEUART;
-			gecko_external_signal(external_event);
-			leuart_circbuff.buffer_interrupt_count = 0;
-		}
-		else
+		/*  While there is still incoming data */
+		while (LEUART0->STATUS & LEUART_STATUS_RXDATAV)
 		{
-			leuart_circbuff.buffer_interrupt_count++;
+			leuart_buffer_push();
 		}
+	}
+#endif
 
-		while (LEUART0->STATUS & LEUART_STATUS_RXDATAV)
+	/* The postamble of a barcode has been received, the frame is complete */
+	if (flags & LEUART_IF_SIGF)
+	{
+		leuart_rx_block();
+
+#ifdef LEUART_RX_LDMA
+		/* The LDMA moves the postamble right after the signal frame is detected. The wait is bounded since a stopped
+		 * channel never empties RXDATA. If the postamble is still there, the LDMA handler publishes it afterwards */
+		for (uint32_t polls = 0; (LEUART0->STATUS & LEUART_STATUS_RXDATAV) && (polls < LEUART_RX_LDMA_DRAIN_POLLS); polls++);
+
+		if (LEUART0->STATUS & LEUART_STATUS_RXDATAV)
 		{
-			/*  While there is still incoming data */
-			if(leuart_circbuff.buffer_count != LEUART_BUFFER_MAXSIZE)					/* Push data only if buffer is not full. This will prevent overwriting of old data
-			 	 	 	 	 	 	 	 	 	 	 	 	 	 	 	 	 	 	 	 by the new data. Preference is given to the old data and not the new data */
-			{
-				leuart_buffer_push();
-			}
+			leuart_circbuff.drain_timeout_count++;
+			LDMA->IFS = (1 << LEUART_RX_LDMA_CHANNEL);
 		}
+		leuart_rx_ldma_sync();
+#endif
+		leuart_circbuff.frame_count++;
+
+		/* Wake up the bluetooth event loop exactly once per complete barcode */
+		CORE_AtomicDisableIrq();
+		external_event |= EVENT_LEUART;
+		gecko_external_signal(external_event);
+		CORE_AtomicEnableIrq();
 	}
-
-	/* Enable All Interrupts */
-	CORE_AtomicEnableIrq();
 }
 
 
@@ -109,8 +296,27 @@ void leuart_init(void)
 	LEUART0->ROUTELOC0 |= (LEUART0->ROUTELOC0 & (~_LEUART_ROUTELOC0_TXLOC_MASK)) | LEUART_ROUTELOC0_TXLOC_LOC18;
 	LEUART0->ROUTELOC0 |= (LEUART0->ROUTELOC0 & (~_LEUART_ROUTELOC0_RXLOC_MASK)) | LEUART_ROUTELOC0_RXLOC_LOC18;
 
+	/* Hardware framing: the receiver is unblocked by the preamble and the postamble raises the signal frame interrupt */
+	LEUART0->STARTFRAME = BARCODE_PREAMBLE;
+	LEUART0->SIGFRAME = BARCODE_POSTAMBLE;
+	while (LEUART0->SYNCBUSY & (LEUART_SYNCBUSY_STARTFRAME | LEUART_SYNCBUSY_SIGFRAME));
+
+	LEUART0->CTRL |= LEUART_CTRL_SFUBRX;
+	while (LEUART0->SYNCBUSY & LEUART_SYNCBUSY_CTRL);
+	leuart_rx_block();
+
+#ifdef LEUART_RX_LDMA
+	/* Let the LDMA move the received data while the core stays in EM2 */
+	LEUART_RxDmaInEM2Enable(LEUART0, true);
+	leuart_rx_ldma_init();
+
+	LEUART_IntClear(LEUART0, LEUART_IFC_SIGF);
+	LEUART_IntEnable(LEUART0, LEUART_IEN_SIGF);
+#else
 	/* Enable LEUART0 RX interrupts */
-	LEUART_IntEnable(LEUART0, LEUART_IEN_RXDATAV);
+	LEUART_IntClear(LEUART0, LEUART_IFC_SIGF);
+	LEUART_IntEnable(LEUART0, LEUART_IEN_RXDATAV | LEUART_IEN_SIGF);
+#endif
 	NVIC_EnableIRQ(LEUART0_IRQn);
 }
 
@@ -119,26 +325,114 @@ void leuart_init(void)
 
 /**
  * @brief This function pushes the data received over UART into the Circular Buffer. i.e leuart_circbuff
- * @note This function must be enclosed in CORE_AtomicDisableIrq() and CORE_AtomicEnableIrq().
+ * @note Producer side of the ring buffer, must only be called from the LEUART0 interrupt.
+ * If the buffer is full the received byte is dropped and counted in overrun_count. Preference is given
+ * to the old data and not the new data.
  * @param void
  * @return void
  */
 void leuart_buffer_push(void)
 {
-	if(leuart_circbuff.write_index < LEUART_BUFFER_MAXSIZE)
+	/* Reading the UART register also clears RXDATAV, so it is read even when the data has to be dropped */
+	char data = leuart_rcv(LEUART0);
+	uint32_t head = leuart_circbuff.head;
+
+	if((head - leuart_circbuff.tail) < LEUART_BUFFER_MAXSIZE)
 	{
 		/* Save UART register data into the circular buffer */
-		leuart_circbuff.buffer[leuart_circbuff.write_index] = leuart_rcv(LEUART0);
+		leuart_circbuff.buffer[head & LEUART_BUFFER_MASK] = data;
+
+		/* The data must be stored before the consumer can see the new head */
+		__DMB();
+		leuart_circbuff.head = head + 1;
+	}
+	else
+	{
+		leuart_circbuff.overrun_count++;
+	}
+}
 
-		/* Increment the write index value */
-		leuart_circbuff.write_index = leuart_circbuff_index_increment(leuart_circbuff.write_index);
 
-		/* Incrementing the buffer count variable if the buffer is not full or else keeping it the same i.e the maximum value here according to the if loop */
-		if(leuart_circbuff.buffer_count < LEUART_BUFFER_MAXSIZE)
-		{
-			leuart_circbuff.buffer_count++;
-		}
+/**
+ * @brief This function returns the number of bytes available in the Circular Buffer. i.e leuart_circbuff
+ * @note Consumer side of the ring buffer. In LDMA mode the producer cannot be stopped, so if it has wrapped
+ * over unread data, all the unread data is discarded and counted in overrun_count. A channel stopped on a
+ * transfer error is restarted from here.
+ * @param void
+ * @return Number of bytes which can be read
+ */
+uint32_t leuart_buffer_count(void)
+{
+	uint32_t head;
+	uint32_t count;
+
+#ifdef LEUART_RX_LDMA
+	if(leuart_circbuff.resync)
+	{
+		leuart_rx_ldma_resync();
 	}
+#endif
+
+	head = leuart_circbuff.head;
+	count = head - leuart_circbuff.tail;
+
+	if(count > LEUART_BUFFER_MAXSIZE)
+	{
+		leuart_circbuff.overrun_count += count;
+		leuart_circbuff.tail = head;
+		count = 0;
+	}
+
+	/* Data must not be read before the head it belongs to */
+	__DMB();
+	return count;
+}
+
+
+/**
+ * @brief This function returns a pointer to the data stored at a given offset from the read position
+ * without removing it from the Circular Buffer. i.e leuart_circbuff
+ * @note The returned span ends either at the last available byte or at the end of the buffer memory.
+ * Call the function again with offset + returned length to get the part after the wrap.
+ * @param offset Number of bytes to skip from the read position.
+ * @param data Filled with the address of the first byte of the span.
+ * @return Number of contiguous bytes available at data. 0 if there is no data at the given offset.
+ */
+uint32_t leuart_buffer_peek(uint32_t offset, const char **data)
+{
+	uint32_t count = leuart_buffer_count();
+	uint32_t index = (leuart_circbuff.tail + offset) & LEUART_BUFFER_MASK;
+	uint32_t contiguous = LEUART_BUFFER_MAXSIZE - index;
+
+	if(offset >= count)
+	{
+		return 0;
+	}
+
+	*data = &leuart_circbuff.buffer[index];
+
+	return ((count - offset) < contiguous) ? (count - offset) : contiguous;
+}
+
+
+/**
+ * @brief This function removes data from the Circular Buffer. i.e leuart_circbuff
+ * @note Consumer side of the ring buffer. Count is limited to the number of available bytes.
+ * @param count Number of bytes to remove.
+ * @return void
+ */
+void leuart_buffer_consume(uint32_t count)
+{
+	uint32_t available = leuart_buffer_count();
+
+	if(count > available)
+	{
+		count = available;
+	}
+
+	/* Finish reading the data before the producer is allowed to overwrite it */
+	__DMB();
+	leuart_circbuff.tail += count;
 }
 
 
@@ -147,22 +441,20 @@ void leuart_buffer_push(void)
  * @note The function return -1 when the buffer is empty. The received data needs to be typecasted to a signed integer
  * to print the -1 value.
  * @param void
- * @return Data from the circular buffer using the read_index. -1 signifies no valid data present
+ * @return Data from the circular buffer using the tail. -1 signifies no valid data present
  */
 char leuart_buffer_pop(void)
 {
-	if((leuart_circbuff.read_index < LEUART_BUFFER_MAXSIZE) && (leuart_circbuff.buffer_count > 0))
-	{
-		uint32_t temp_read_index = leuart_circbuff.read_index;
+	const char *data;
 
-		/* Increment the write index value */
-		leuart_circbuff.read_index = leuart_circbuff_index_increment(leuart_circbuff.read_index);
+	if(leuart_buffer_peek(0, &data))
+	{
+		char value = *data;
 
-		/* Decrementing the buffer count variable if the buffer is not empty */
-		leuart_circbuff.buffer_count--;
+		leuart_buffer_consume(1);
 
-		printf("POP: %c\n", leuart_circbuff.buffer[temp_read_index]);
-		return leuart_circbuff.buffer[temp_read_index];
+		printf("POP: %c\n", value);
+		return value;
 	}
 
 	return -1;
@@ -176,7 +468,7 @@ char leuart_buffer_pop(void)
  */
 bool leuart_buffer_empty_status(void)
 {
-	if(leuart_circbuff.buffer_count == 0)
+	if(leuart_buffer_count() == 0)
 	{
 		return true;
 	}
@@ -194,6 +486,9 @@ void leuart_disable(void)
 {
 	LEUART0 -> ROUTEPEN &= ~LEUART_ROUTEPEN_RXPEN;
 	LEUART0 -> ROUTEPEN &=~ LEUART_ROUTEPEN_TXPEN;
+#ifdef LEUART_RX_LDMA
+	leuart_rx_ldma_disable();
+#endif
 	LEUART_Enable(LEUART0, false);
 	GPIO_PinOutClear(LEUART_TX_PORT, LEUART_TX_PIN); 					/* TX line */
 	GPIO_PinOutClear(LEUART_RX_PORT, LEUART_RX_PIN);					/* RX Line */
@@ -0,0 +1,189 @@
+/*
+ * @file link_opt.c
+ * @brief This file consists of the link optimization done on every connection. The 2M PHY is requested,
+ * 1M stays in use when the phone does not support or refuses it. The data length is extended by the stack on its own,
+ * the resulting link layer payload size is reported together with the PHY and the ATT MTU.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "native_gecko.h"
+#include "em_rtcc.h"
+#include "inc/link_opt.h"
+#include "inc/ble_packer.h"
+#include "inc/ble_tx.h"
+#include "inc/scan_queue.h"
+
+
+#define LINK_OPT_TXSIZE_DEFAULT					(27)							/* Link layer payload size without DLE */
+
+
+/**
+ * @brief This function prints the negotiated link configuration.
+ * @param void
+ * @return void
+ */
+static void link_opt_report(void)
+{
+	printf("Link: PHY %s%s, LL payload %d bytes, ATT MTU %d\n", (link_opt.phy == le_gap_phy_2m) ? "2M" : "1M",
+			link_opt.fallback ? " (2M refused)" : "", link_opt.txsize, link_opt.mtu);
+}
+
+
+/**
+ * @brief This function starts the link optimization of a new connection by requesting the 2M PHY.
+ * @param uint8_t connection The connection handle
+ * @return void
+ */
+void link_opt_init(uint8_t connection)
+{
+	uint16_t result;
+
+	memset(&link_opt, 0, sizeof(struct link_opt));
+	link_opt.connection = connection;
+	link_opt.phy = le_gap_phy_1m;
+	link_opt.txsize = LINK_OPT_TXSIZE_DEFAULT;
+	link_opt.mtu = BLE_ATT_MTU_DEFAULT;
+
+	/* Prefer 2M but keep accepting 1M so that phones without 2M stay connected */
+	result = gecko_cmd_le_connection_set_preferred_phy(connection, le_gap_phy_2m, le_gap_phy_1m | le_gap_phy_2m)->result;
+	if(result != bg_err_success)
+	{
+		printf("ERROR: 2M PHY request failed with result %x, staying on 1M.\n", result);
+		link_opt.fallback = true;
+	}
+}
+
+
+/**
+ * @brief This function takes the PHY reported by the gecko_evt_le_connection_phy_status_id event.
+ * @param uint8_t phy The PHY in use
+ * @return void
+ */
+void link_opt_phy(uint8_t phy)
+{
+	link_opt.phy = phy;
+	link_opt.fallback = (phy != le_gap_phy_2m);
+	link_opt_report();
+}
+
+
+/**
+ * @brief This function takes the link layer payload size reported by the gecko_evt_le_connection_parameters_id event.
+ * @param uint16_t txsize Maximum link layer payload size
+ * @return void
+ */
+void link_opt_txsize(uint16_t txsize)
+{
+	if(txsize != link_opt.txsize)
+	{
+		link_opt.txsize = txsize;
+		link_opt_report();
+	}
+}
+
+
+/**
+ * @brief This function takes the ATT MTU reported by the gecko_evt_gatt_mtu_exchanged_id event.
+ * @param uint16_t mtu The negotiated ATT MTU
+ * @return void
+ */
+void link_opt_mtu(uint16_t mtu)
+{
+	link_opt.mtu = mtu;
+	link_opt_report();
+}
+
+
+#ifdef LINK_BENCHMARK
+
+/* Product names of the synthetic basket */
+static const char * const link_benchmark_names[] =
+{
+	"organic_bananas", "whole_milk_1gal", "sourdough_bread", "free_range_eggs_12ct",
+	"greek_yogurt_plain", "cheddar_cheese_block", "baby_spinach", "chicken_breast_2lb",
+	"pasta_penne", "tomato_sauce", "coffee_beans_dark_roast", "orange_juice_no_pulp",
+};
+
+static uint32_t link_benchmark_remaining;
+static uint32_t link_benchmark_start_ms;
+static uint32_t link_benchmark_start_bytes;
+
+
+/**
+ * @brief This function returns the RTCC time in milliseconds.
+ * @param void
+ * @return Time in milliseconds.
+ */
+static uint32_t link_benchmark_time_ms(void)
+{
+	return (uint32_t)(((uint64_t)RTCC_CounterGet() * 1000) / 32768);
+}
+
+
+/**
+ * @brief This function starts streaming the synthetic basket.
+ * @param void
+ * @return void
+ */
+void link_benchmark_start(void)
+{
+	link_benchmark_remaining = LINK_BENCHMARK_ITEMS;
+	link_benchmark_start_ms = link_benchmark_time_ms();
+	link_benchmark_start_bytes = ble_tx.sent_bytes;
+
+	printf("Benchmark: streaming %d items\n", LINK_BENCHMARK_ITEMS);
+	link_opt_report();
+	link_benchmark_run();
+}
+
+
+/**
+ * @brief This function tops up the scan queue with synthetic scans and prints the throughput once the
+ * whole basket has been accepted by the stack. Called by the scan sender.
+ * @param void
+ * @return void
+ */
+void link_benchmark_run(void)
+{
+	while(link_benchmark_remaining && !scan_queue_full())
+	{
+		const char *name = link_benchmark_names[link_benchmark_remaining % (sizeof(link_benchmark_names) / sizeof(link_benchmark_names[0]))];
+		struct cart_item item =
+		{
+			.product_id = cart_codec_product_id(name, strlen(name)),
+			.price = (link_benchmark_remaining % 1000) * CART_PRICE_SCALE,
+			.quantity = 1,
+			.flags = CART_ITEM_FLAG_NAME | CART_ITEM_FLAG_SEQUENCE,
+			.sequence = link_benchmark_remaining,
+			.name = name,
+			.name_size = strlen(name),
+		};
+
+		/* Straight into the scan queue, the synthetic items are not added to the cart */
+		if(!scan_queue_push_item(&item))
+		{
+			break;
+		}
+		link_benchmark_remaining--;
+	}
+
+	if(link_benchmark_remaining || scan_queue_count() || ble_tx_count() || (link_benchmark_start_ms == 0))
+	{
+		return;
+	}
+
+	uint32_t elapsed = link_benchmark_time_ms() - link_benchmark_start_ms;
+	uint32_t bytes = ble_tx.sent_bytes - link_benchmark_start_bytes;
+
+	printf("Benchmark: %lu bytes in %lu ms, %lu bytes/s\n", (unsigned long)bytes, (unsigned long)elapsed,
+			(unsigned long)((elapsed) ? ((uint64_t)bytes * 1000 / elapsed) : 0));
+	link_benchmark_start_ms = 0;
+}
+
+#endif
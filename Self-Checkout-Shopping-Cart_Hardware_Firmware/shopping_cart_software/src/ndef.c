@@ -0,0 +1,440 @@
+/*
+ * @file ndef.c
+ * @brief This file consists of the NDEF message of the NFC tag. The phone reads a Bluetooth LE out of band pairing
+ * record and connects to the cart without scanning.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "em_rtcc.h"
+#include "inc/ndef.h"
+
+
+#define NDEF_TLV_MESSAGE					(0x03)
+#define NDEF_TLV_TERMINATOR					(0xFE)
+#define NDEF_HEADER_MB						(0x80)								/* Message begin */
+#define NDEF_HEADER_ME						(0x40)								/* Message end */
+#define NDEF_HEADER_SR						(0x10)								/* Short record, payload length on one byte */
+#define NDEF_TNF_MEDIA						(0x02)
+#define NDEF_AD_LOCAL_NAME					(0x09)
+#define NDEF_AD_LE_ADDRESS					(0x1B)
+#define NDEF_AD_LE_ROLE						(0x1C)
+#define NDEF_AD_MANUFACTURER				(0xFF)
+#define NDEF_COMPANY_ID						(0xFFFF)							/* No company identifier, for internal use */
+#define NDEF_LE_ADDRESS_PUBLIC				(0x00)
+#define NDEF_LE_ROLE_PERIPHERAL				(0x00)								/* Only the peripheral role is supported */
+
+#define NDEF_TAG_LAST_BLOCK_ADDRESS			(NDEF_TAG_FIRST_BLOCK + NDEF_BLE_OOB_BLOCKS - 1)
+#define NDEF_TAG_NC_MASK					(NXP_NTAG_NC_SRAM_MIRROR | NXP_NTAG_NC_FD_ON_MASK | NXP_NTAG_NC_FD_OFF_MASK)
+#define NDEF_TAG_NC							(NXP_NTAG_NC_SRAM_MIRROR | NXP_NTAG_NC_FD_ON_FIELD | NXP_NTAG_NC_FD_OFF_NDEF_READ)
+
+#define NDEF_BLE_OOB_TYPE					"application/vnd.bluetooth.le.oob"
+#define NDEF_BLE_OOB_NAME					"Ashwathama"						/* Device name of gatt.xml */
+#define NDEF_BLE_OOB_TYPE_SIZE				(sizeof(NDEF_BLE_OOB_TYPE) - 1)
+#define NDEF_BLE_OOB_NAME_SIZE				(sizeof(NDEF_BLE_OOB_NAME) - 1)
+
+
+/* The tag content, from the NDEF message TLV to the terminator TLV. Every field is a byte, the lengths and the
+ * offsets are worked out by the compiler from the type and the name */
+struct ndef_ble_oob
+{
+	uint8_t tlv_type;
+	uint8_t tlv_length;
+
+	/* NDEF record */
+	uint8_t header;
+	uint8_t type_length;
+	uint8_t payload_length;
+	char type[NDEF_BLE_OOB_TYPE_SIZE];
+
+	/* Payload, advertising data structures */
+	uint8_t address_length;
+	uint8_t address_ad;
+	uint8_t address[NDEF_BLE_ADDRESS_SIZE];								/* Least significant byte first, like bd_addr */
+	uint8_t address_type;
+	uint8_t role_length;
+	uint8_t role_ad;
+	uint8_t role;
+	uint8_t name_length;
+	uint8_t name_ad;
+	char name[NDEF_BLE_OOB_NAME_SIZE];
+
+	uint8_t terminator;
+};
+
+
+/* The same record in the SRAM, the name gives way to the session token so that it fits in the 64 bytes */
+struct ndef_ble_oob_session
+{
+	uint8_t tlv_type;
+	uint8_t tlv_length;
+
+	/* NDEF record */
+	uint8_t header;
+	uint8_t type_length;
+	uint8_t payload_length;
+	char type[NDEF_BLE_OOB_TYPE_SIZE];
+
+	/* Payload, advertising data structures */
+	uint8_t address_length;
+	uint8_t address_ad;
+	uint8_t address[NDEF_BLE_ADDRESS_SIZE];
+	uint8_t address_type;
+	uint8_t role_length;
+	uint8_t role_ad;
+	uint8_t role;
+	uint8_t token_length;
+	uint8_t token_ad;
+	uint8_t company[2];													/* Least significant byte first */
+	uint8_t token[NDEF_TOKEN_SIZE];
+
+	uint8_t terminator;
+};
+
+
+#define NDEF_RECORD_SIZE(record)			(offsetof(struct record, terminator) - offsetof(struct record, header))
+#define NDEF_PAYLOAD_SIZE(record)			(offsetof(struct record, terminator) - offsetof(struct record, address_length))
+#define NDEF_AD_LENGTH(record, first, next)	(offsetof(struct record, next) - offsetof(struct record, first) - 1)
+
+
+typedef char ndef_ble_oob_size_check[(sizeof(struct ndef_ble_oob) <= NDEF_BLE_OOB_SIZE) ? 1 : -1];
+typedef char ndef_ble_oob_record_check[(NDEF_RECORD_SIZE(ndef_ble_oob) < 0xFF) ? 1 : -1];
+typedef char ndef_ble_oob_session_size_check[(sizeof(struct ndef_ble_oob_session) <= NDEF_BLE_OOB_SIZE) ? 1 : -1];
+
+
+/* The name of the EEPROM record and the token of the SRAM record, the AD structures phones accept in a scan response */
+#define NDEF_SCAN_RESPONSE_NAME_SIZE		(offsetof(struct ndef_ble_oob, terminator) - offsetof(struct ndef_ble_oob, name_length))
+#define NDEF_SCAN_RESPONSE_TOKEN_SIZE		(offsetof(struct ndef_ble_oob_session, terminator) - offsetof(struct ndef_ble_oob_session, token_length))
+
+
+typedef char ndef_scan_response_size_check[((NDEF_SCAN_RESPONSE_NAME_SIZE + NDEF_SCAN_RESPONSE_TOKEN_SIZE) <= NDEF_SCAN_RESPONSE_MAXSIZE) ? 1 : -1];
+
+
+static const struct ndef_ble_oob ndef_ble_oob_template =
+{
+	.tlv_type = NDEF_TLV_MESSAGE,
+	.tlv_length = NDEF_RECORD_SIZE(ndef_ble_oob),
+	.header = NDEF_HEADER_MB | NDEF_HEADER_ME | NDEF_HEADER_SR | NDEF_TNF_MEDIA,
+	.type_length = NDEF_BLE_OOB_TYPE_SIZE,
+	.payload_length = NDEF_PAYLOAD_SIZE(ndef_ble_oob),
+	.type = NDEF_BLE_OOB_TYPE,
+	.address_length = NDEF_AD_LENGTH(ndef_ble_oob, address_length, role_length),
+	.address_ad = NDEF_AD_LE_ADDRESS,
+	.address_type = NDEF_LE_ADDRESS_PUBLIC,
+	.role_length = NDEF_AD_LENGTH(ndef_ble_oob, role_length, name_length),
+	.role_ad = NDEF_AD_LE_ROLE,
+	.role = NDEF_LE_ROLE_PERIPHERAL,
+	.name_length = NDEF_AD_LENGTH(ndef_ble_oob, name_length, terminator),
+	.name_ad = NDEF_AD_LOCAL_NAME,
+	.name = NDEF_BLE_OOB_NAME,
+	.terminator = NDEF_TLV_TERMINATOR,
+};
+
+
+static const struct ndef_ble_oob_session ndef_ble_oob_session_template =
+{
+	.tlv_type = NDEF_TLV_MESSAGE,
+	.tlv_length = NDEF_RECORD_SIZE(ndef_ble_oob_session),
+	.header = NDEF_HEADER_MB | NDEF_HEADER_ME | NDEF_HEADER_SR | NDEF_TNF_MEDIA,
+	.type_length = NDEF_BLE_OOB_TYPE_SIZE,
+	.payload_length = NDEF_PAYLOAD_SIZE(ndef_ble_oob_session),
+	.type = NDEF_BLE_OOB_TYPE,
+	.address_length = NDEF_AD_LENGTH(ndef_ble_oob_session, address_length, role_length),
+	.address_ad = NDEF_AD_LE_ADDRESS,
+	.address_type = NDEF_LE_ADDRESS_PUBLIC,
+	.role_length = NDEF_AD_LENGTH(ndef_ble_oob_session, role_length, token_length),
+	.role_ad = NDEF_AD_LE_ROLE,
+	.role = NDEF_LE_ROLE_PERIPHERAL,
+	.token_length = NDEF_AD_LENGTH(ndef_ble_oob_session, token_length, terminator),
+	.token_ad = NDEF_AD_MANUFACTURER,
+	.company = {(NDEF_COMPANY_ID & 0xFF), (NDEF_COMPANY_ID >> 8)},
+	.terminator = NDEF_TLV_TERMINATOR,
+};
+
+
+/**
+ * @brief This function builds the tag image from the template, only the address is filled in.
+ * @param uint8_t* image NDEF_BLE_OOB_SIZE bytes, zero after the terminator
+ * @param uint8_t* address Bluetooth address, least significant byte first
+ * @return void
+ */
+void ndef_ble_oob_build(uint8_t *image, const uint8_t *address)
+{
+	memset(image, 0, NDEF_BLE_OOB_SIZE);
+	memcpy(image, &ndef_ble_oob_template, sizeof(struct ndef_ble_oob));
+	memcpy(&image[offsetof(struct ndef_ble_oob, address)], address, NDEF_BLE_ADDRESS_SIZE);
+}
+
+
+/**
+ * @brief This function builds the SRAM image from the template, only the address and the token are filled in.
+ * @param uint8_t* image NDEF_BLE_OOB_SIZE bytes, zero after the terminator
+ * @param uint8_t* address Bluetooth address, least significant byte first
+ * @param uint8_t* token NDEF_TOKEN_SIZE bytes
+ * @return void
+ */
+void ndef_ble_oob_session_build(uint8_t *image, const uint8_t *address, const uint8_t *token)
+{
+	memset(image, 0, NDEF_BLE_OOB_SIZE);
+	memcpy(image, &ndef_ble_oob_session_template, sizeof(struct ndef_ble_oob_session));
+	memcpy(&image[offsetof(struct ndef_ble_oob_session, address)], address, NDEF_BLE_ADDRESS_SIZE);
+	memcpy(&image[offsetof(struct ndef_ble_oob_session, token)], token, NDEF_TOKEN_SIZE);
+}
+
+
+/**
+ * @brief This function builds the scan response out of the handover records, with the token last published. The
+ * address and the role only belong in out of band data, the phone finds the cart it tapped by the token.
+ * @param uint8_t* data Room for NDEF_SCAN_RESPONSE_MAXSIZE bytes
+ * @return Size of the scan response.
+ */
+uint8_t ndef_scan_response_build(uint8_t *data)
+{
+	uint8_t session[NDEF_BLE_OOB_SIZE];
+
+	ndef_ble_oob_session_build(session, ndef_tag.address, ndef_tag.token);
+	memcpy(data, &ndef_ble_oob_template.name_length, NDEF_SCAN_RESPONSE_NAME_SIZE);
+	memcpy(&data[NDEF_SCAN_RESPONSE_NAME_SIZE], &session[offsetof(struct ndef_ble_oob_session, token_length)], NDEF_SCAN_RESPONSE_TOKEN_SIZE);
+
+	return NDEF_SCAN_RESPONSE_NAME_SIZE + NDEF_SCAN_RESPONSE_TOKEN_SIZE;
+}
+
+
+/**
+ * @brief This function starts the transfer of the current step, behind the other I2C transfers waiting for the bus.
+ * @param void
+ * @return void
+ */
+static void ndef_tag_start(void)
+{
+	if(i2c_transfer_queue(&ndef_tag.transfer) < 0)
+	{
+		ndef_tag.error_count++;
+		ndef_tag.step = NDEF_TAG_IDLE;
+	}
+}
+
+
+/**
+ * @brief This function starts writing the session record to the SRAM, with the last token published.
+ * @param void
+ * @return void
+ */
+static void ndef_tag_sram_start(void)
+{
+	ndef_tag.publish_pending = false;
+	ndef_ble_oob_session_build(ndef_tag.session, ndef_tag.address, ndef_tag.token);
+
+	ndef_tag.index = 0;
+	ndef_tag.step = NDEF_TAG_SRAM_WRITE;
+	i2c_ntag_block_write(&ndef_tag.transfer, NXP_NTAG_SRAM_BLOCK, ndef_tag.session);
+	ndef_tag_start();
+}
+
+
+/**
+ * @brief This function reads back the next block of the EEPROM record, from the last one. Once the first block is
+ * checked the SRAM record follows if a token was published in the meantime.
+ * @param void
+ * @return void
+ */
+static void ndef_tag_eeprom_next(void)
+{
+	if(ndef_tag.index == 0)
+	{
+		ndef_tag.step = NDEF_TAG_IDLE;
+		printf("NFC tag: %lu blocks written, %lu unchanged\n", (unsigned long)ndef_tag.write_count, (unsigned long)ndef_tag.skip_count);
+
+		if(ndef_tag.publish_pending)
+		{
+			ndef_tag_sram_start();
+		}
+		return;
+	}
+
+	ndef_tag.index--;
+	ndef_tag.step = NDEF_TAG_EEPROM_READ;
+	i2c_ntag_block_read(&ndef_tag.transfer, NDEF_TAG_FIRST_BLOCK + ndef_tag.index, ndef_tag.block);
+	ndef_tag_start();
+}
+
+
+/**
+ * @brief This function runs the update on EVENT_I2C, one transfer per step.
+ * @param struct i2c_transfer* transfer The transfer that is over
+ * @return void
+ */
+static void ndef_tag_transfer_complete(struct i2c_transfer* transfer)
+{
+	const uint8_t *expected = &ndef_tag.image[ndef_tag.index * NXP_NTAG_BLOCK_SIZE];
+
+	if(transfer->status != I2C_STATUS_DONE)
+	{
+		ndef_tag.error_count++;
+		ndef_tag.step = NDEF_TAG_IDLE;
+		return;
+	}
+
+	switch(ndef_tag.step)
+	{
+	case NDEF_TAG_EEPROM_READ:
+
+		if(memcmp(ndef_tag.block, expected, NXP_NTAG_BLOCK_SIZE) == 0)
+		{
+			ndef_tag.skip_count++;
+			ndef_tag_eeprom_next();
+			break;
+		}
+
+		ndef_tag.step = NDEF_TAG_EEPROM_WRITE;
+		i2c_ntag_block_write(transfer, NDEF_TAG_FIRST_BLOCK + ndef_tag.index, expected);
+		ndef_tag_start();
+		break;
+
+	case NDEF_TAG_EEPROM_WRITE:
+
+		ndef_tag.write_count++;
+		ndef_tag_eeprom_next();
+		break;
+
+	case NDEF_TAG_SRAM_WRITE:
+
+		ndef_tag.index++;
+		if(ndef_tag.index < NDEF_BLE_OOB_BLOCKS)
+		{
+			i2c_ntag_block_write(transfer, NXP_NTAG_SRAM_BLOCK + ndef_tag.index, &ndef_tag.session[ndef_tag.index * NXP_NTAG_BLOCK_SIZE]);
+		}
+		else if(!ndef_tag.mirror)
+		{
+			/* The SRAM is only mirrored once it holds a whole record */
+			ndef_tag.step = NDEF_TAG_MIRROR_BLOCK;
+			i2c_ntag_register_write(transfer, NXP_NTAG_REG_SRAM_MIRROR_BLOCK, 0xFF, NDEF_TAG_FIRST_BLOCK);
+		}
+		else
+		{
+			ndef_tag.step = NDEF_TAG_UNLOCK;
+			i2c_ntag_register_write(transfer, NXP_NTAG_REG_NS, NXP_NTAG_NS_I2C_LOCKED, 0);
+		}
+		ndef_tag_start();
+		break;
+
+	case NDEF_TAG_MIRROR_BLOCK:
+
+		ndef_tag.step = NDEF_TAG_LAST_BLOCK;
+		i2c_ntag_register_write(transfer, NXP_NTAG_REG_LAST_NDEF_BLOCK, 0xFF, NDEF_TAG_LAST_BLOCK_ADDRESS);
+		ndef_tag_start();
+		break;
+
+	case NDEF_TAG_LAST_BLOCK:
+
+		/* FD tells the cart about the field and about the phone reading the end of the record */
+		ndef_tag.step = NDEF_TAG_MIRROR_ON;
+		i2c_ntag_register_write(transfer, NXP_NTAG_REG_NC, NDEF_TAG_NC_MASK, NDEF_TAG_NC);
+		ndef_tag_start();
+		break;
+
+	case NDEF_TAG_MIRROR_ON:
+
+		ndef_tag.mirror = true;
+		ndef_tag.step = NDEF_TAG_UNLOCK;
+		i2c_ntag_register_write(transfer, NXP_NTAG_REG_NS, NXP_NTAG_NS_I2C_LOCKED, 0);
+		ndef_tag_start();
+		break;
+
+	case NDEF_TAG_UNLOCK:
+
+		ndef_tag.step = NDEF_TAG_IDLE;
+		ndef_tag.publish_count++;
+		if((RTCC_CounterGet() - ndef_tag.publish_start) > ndef_tag.publish_ticks_max)
+		{
+			ndef_tag.publish_ticks_max = RTCC_CounterGet() - ndef_tag.publish_start;
+		}
+
+		/* Published again while the SRAM was being written */
+		if(ndef_tag.publish_pending)
+		{
+			ndef_tag_sram_start();
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+
+/**
+ * @brief This function starts bringing the EEPROM record up to date with the address of the cart. The blocks are
+ * checked from the last one, so that the TLV length in the first block only changes once the rest is written.
+ * @param uint8_t* address Bluetooth address, least significant byte first
+ * @return 0 if the update is started, -1 if an update is running.
+ */
+int ndef_tag_update(const uint8_t *address)
+{
+	if(ndef_tag.step != NDEF_TAG_IDLE)
+	{
+		return -1;
+	}
+
+	memcpy(ndef_tag.address, address, NDEF_BLE_ADDRESS_SIZE);
+	ndef_tag.ready = true;
+	ndef_ble_oob_build(ndef_tag.image, address);
+	ndef_tag.transfer.callback = ndef_tag_transfer_complete;
+
+	/* ndef_tag_eeprom_next() moves to the last block */
+	ndef_tag.index = NDEF_BLE_OOB_BLOCKS;
+	ndef_tag_eeprom_next();
+
+	return (ndef_tag.step != NDEF_TAG_IDLE) ? 0 : -1;
+}
+
+
+/**
+ * @brief This function publishes a new token in the SRAM. It is written right away if the tag is idle, otherwise once
+ * the running update is over, only the last token is written. The mirror is set up again if it was lost.
+ * @param uint32_t session_id Id of the cart session
+ * @param uint8_t* nonce NDEF_TOKEN_NONCE_SIZE random bytes
+ * @return void
+ */
+void ndef_tag_publish(uint32_t session_id, const uint8_t *nonce)
+{
+	ndef_tag.token[0] = session_id;
+	ndef_tag.token[1] = session_id >> 8;
+	ndef_tag.token[2] = session_id >> 16;
+	ndef_tag.token[3] = session_id >> 24;
+	memcpy(&ndef_tag.token[4], nonce, NDEF_TOKEN_NONCE_SIZE);
+
+	if(!ndef_tag.publish_pending)
+	{
+		ndef_tag.publish_start = RTCC_CounterGet();
+	}
+	ndef_tag.publish_pending = true;
+
+	if(ndef_tag.ready && (ndef_tag.step == NDEF_TAG_IDLE))
+	{
+		ndef_tag_sram_start();
+	}
+}
+
+
+/**
+ * @brief This function checks the NC_REG value read by the NFC event service. The session registers are loaded
+ * again from the configuration registers when the NTAG loses power, the mirror is then set up again on the next publish.
+ * @param uint8_t nc Value of NC_REG
+ * @return true if the mirror and FD are set up.
+ */
+bool ndef_tag_configured(uint8_t nc)
+{
+	if(ndef_tag.mirror && ((nc & NDEF_TAG_NC_MASK) != NDEF_TAG_NC))
+	{
+		ndef_tag.mirror = false;
+	}
+
+	return ndef_tag.mirror;
+}
@@ -0,0 +1,208 @@
+/*
+ * @file nfc_event.c
+ * @brief This file consists of the NFC event service. It turns the FD pin edges of the NTAG into field on, field off
+ * and read done events for the application.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "em_core.h"
+#include "em_gpio.h"
+#include "em_rtcc.h"
+#include "native_gecko.h"
+#include "inc/nfc_event.h"
+#include "inc/ndef.h"
+#include "inc/gpio.h"
+#include "inc/external_events.h"
+
+
+/**
+ * @brief This function queues an event for the application.
+ * @param enum nfc_event_type type Event
+ * @param uint32_t timestamp RTCC counter value of the edge that told it
+ * @return void
+ */
+static void nfc_event_push(enum nfc_event_type type, uint32_t timestamp)
+{
+	struct nfc_event *event;
+
+	nfc_event_service.event_count[type]++;
+
+	if((nfc_event_service.head - nfc_event_service.tail) == NFC_EVENT_QUEUE_SIZE)
+	{
+		nfc_event_service.dropped_count++;
+		return;
+	}
+
+	event = &nfc_event_service.event[nfc_event_service.head & NFC_EVENT_QUEUE_MASK];
+	event->type = type;
+	event->timestamp = timestamp;
+	nfc_event_service.head++;
+}
+
+
+/**
+ * @brief This function reads NS_REG, NC_REG follows from the callback.
+ * @param void
+ * @return void
+ */
+static void nfc_event_read(void)
+{
+	nfc_event_service.reading = true;
+	nfc_event_service.again = false;
+
+	i2c_ntag_register_read(&nfc_event_service.transfer, NXP_NTAG_REG_NS, &nfc_event_service.ns);
+	if(i2c_transfer_queue(&nfc_event_service.transfer) < 0)
+	{
+		nfc_event_service.error_count++;
+		nfc_event_service.reading = false;
+	}
+}
+
+
+/**
+ * @brief This function works out the events from the session registers. FD is pulled low when the field comes on
+ * and released when the phone read the end of the record or the field goes off. After a read there is no edge
+ * when the field goes off, the next field on ends the previous tap. Edges coming in during a read are folded into
+ * the next one, the field on keeps the time of its own edge.
+ * @param void
+ * @return void
+ */
+static void nfc_event_classify(void)
+{
+	bool field = (nfc_event_service.ns & NXP_NTAG_NS_RF_FIELD_PRESENT);
+	bool mirror = ndef_tag.mirror;
+	uint32_t head = nfc_event_service.head;
+
+	if(!ndef_tag_configured(nfc_event_service.nc) && mirror)
+	{
+		nfc_event_service.config_lost_count++;
+	}
+
+	if(nfc_event_service.field_edge && nfc_event_service.field)
+	{
+		nfc_event_push(NFC_EVENT_FIELD_OFF, nfc_event_service.field_timestamp);
+	}
+
+	if(nfc_event_service.field_edge || (field && !nfc_event_service.field))
+	{
+		nfc_event_service.field = true;
+		nfc_event_push(NFC_EVENT_FIELD_ON, nfc_event_service.field_edge ? nfc_event_service.field_timestamp :
+					   nfc_event_service.edge_timestamp);
+	}
+	nfc_event_service.field_edge = false;
+
+	if(nfc_event_service.ns & NXP_NTAG_NS_NDEF_DATA_READ)
+	{
+		nfc_event_push(NFC_EVENT_READ_DONE, nfc_event_service.edge_timestamp);
+	}
+
+	if(!field && nfc_event_service.field)
+	{
+		nfc_event_service.field = false;
+		nfc_event_push(NFC_EVENT_FIELD_OFF, nfc_event_service.edge_timestamp);
+	}
+
+	if(nfc_event_service.head != head)
+	{
+		CORE_AtomicDisableIrq();
+		external_event |= EVENT_NFC;
+		gecko_external_signal(external_event);
+		CORE_AtomicEnableIrq();
+	}
+}
+
+
+/**
+ * @brief This function runs the register reads on EVENT_I2C.
+ * @param struct i2c_transfer* transfer The register read that is over
+ * @return void
+ */
+static void nfc_event_transfer_complete(struct i2c_transfer* transfer)
+{
+	if(transfer->status != I2C_STATUS_DONE)
+	{
+		nfc_event_service.error_count++;
+	}
+	else if(transfer->rx == &nfc_event_service.ns)
+	{
+		i2c_ntag_register_read(transfer, NXP_NTAG_REG_NC, &nfc_event_service.nc);
+		if(i2c_transfer_queue(transfer) == 0)
+		{
+			return;
+		}
+		nfc_event_service.error_count++;
+	}
+	else
+	{
+		nfc_event_classify();
+	}
+
+	nfc_event_service.reading = false;
+	if(nfc_event_service.again)
+	{
+		nfc_event_read();
+	}
+}
+
+
+/**
+ * @brief This function initializes the NFC event service.
+ * @param void
+ * @return void
+ */
+void nfc_event_init(void)
+{
+	memset(&nfc_event_service, 0, sizeof(struct nfc_event_service));
+	nfc_event_service.transfer.callback = nfc_event_transfer_complete;
+}
+
+
+/**
+ * @brief This function starts reading the session registers after an FD edge, on EVENT_NFC_GPIO.
+ * @param void
+ * @return void
+ */
+void nfc_event_edge(void)
+{
+	nfc_event_service.edge_count++;
+	nfc_event_service.edge_timestamp = RTCC_CounterGet();
+
+	/* Only the field coming on pulls FD low */
+	if(!GPIO_PinInGet(GPIO_NFC_PORT, GPIO_NFC_PIN))
+	{
+		nfc_event_service.field_edge = true;
+		nfc_event_service.field_timestamp = nfc_event_service.edge_timestamp;
+	}
+
+	if(nfc_event_service.reading)
+	{
+		nfc_event_service.again = true;
+		return;
+	}
+
+	nfc_event_read();
+}
+
+
+/**
+ * @brief This function takes the oldest event off the queue.
+ * @param struct nfc_event* event Filled with the event
+ * @return true if there was an event.
+ */
+bool nfc_event_get(struct nfc_event* event)
+{
+	if(nfc_event_service.head == nfc_event_service.tail)
+	{
+		return false;
+	}
+
+	*event = nfc_event_service.event[nfc_event_service.tail & NFC_EVENT_QUEUE_MASK];
+	nfc_event_service.tail++;
+	return true;
+}
@@ -0,0 +1,148 @@
+/*
+ * @file payload_pool.c
+ * @brief This file consists of a fixed size block allocator for the barcode payloads.
+ * It replaces malloc()/free() on the scan path so that the heap does not fragment over a long shift.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "inc/payload_pool.h"
+
+
+/* A size class of the pool. Free blocks are linked together through their first word */
+struct payload_pool_class
+{
+	uint32_t *storage;
+	uint16_t block_size;
+	uint16_t block_count;
+	void *free_list;
+};
+
+
+/* Block storage, uint32_t to keep every block word aligned */
+static uint32_t payload_pool_small[PAYLOAD_POOL_SMALL_COUNT][PAYLOAD_POOL_SMALL_SIZE / 4];
+static uint32_t payload_pool_medium[PAYLOAD_POOL_MEDIUM_COUNT][PAYLOAD_POOL_MEDIUM_SIZE / 4];
+static uint32_t payload_pool_large[PAYLOAD_POOL_LARGE_COUNT][PAYLOAD_POOL_LARGE_SIZE / 4];
+static uint32_t payload_pool_max[PAYLOAD_POOL_MAX_COUNT][PAYLOAD_POOL_MAX_SIZE / 4];
+
+
+/* Size classes ordered by block size */
+static struct payload_pool_class payload_pool_classes[PAYLOAD_POOL_CLASS_COUNT] =
+{
+	{&payload_pool_small[0][0], PAYLOAD_POOL_SMALL_SIZE, PAYLOAD_POOL_SMALL_COUNT, NULL},
+	{&payload_pool_medium[0][0], PAYLOAD_POOL_MEDIUM_SIZE, PAYLOAD_POOL_MEDIUM_COUNT, NULL},
+	{&payload_pool_large[0][0], PAYLOAD_POOL_LARGE_SIZE, PAYLOAD_POOL_LARGE_COUNT, NULL},
+	{&payload_pool_max[0][0], PAYLOAD_POOL_MAX_SIZE, PAYLOAD_POOL_MAX_COUNT, NULL},
+};
+
+
+static struct payload_pool_stats payload_pool_stats;
+
+
+/**
+ * @brief This function links all the blocks of every size class into their free lists and clears the statistics.
+ * @note All the blocks previously allocated become invalid.
+ * @param void
+ * @return void
+ */
+void payload_pool_init(void)
+{
+	for(uint8_t i = 0; i < PAYLOAD_POOL_CLASS_COUNT; i++)
+	{
+		struct payload_pool_class *pool_class = &payload_pool_classes[i];
+
+		pool_class->free_list = NULL;
+		for(uint16_t j = 0; j < pool_class->block_count; j++)
+		{
+			void **block = (void **)&pool_class->storage[j * (pool_class->block_size / 4)];
+
+			*block = pool_class->free_list;
+			pool_class->free_list = block;
+		}
+	}
+
+	memset(&payload_pool_stats, 0, sizeof(struct payload_pool_stats));
+}
+
+
+/**
+ * @brief This function allocates a block of at least size bytes in constant time.
+ * The smallest size class with a free block is used.
+ * @note Must only be called from the bluetooth event loop, the pool is not interrupt safe.
+ * @param size Number of bytes required.
+ * @return Pointer to the block, NULL if no block is available.
+ */
+char* payload_pool_alloc(uint16_t size)
+{
+	for(uint8_t i = 0; i < PAYLOAD_POOL_CLASS_COUNT; i++)
+	{
+		struct payload_pool_class *pool_class = &payload_pool_classes[i];
+
+		if(size <= pool_class->block_size && pool_class->free_list != NULL)
+		{
+			void **block = pool_class->free_list;
+
+			pool_class->free_list = *block;
+
+			payload_pool_stats.alloc_count++;
+			payload_pool_stats.in_use[i]++;
+			if(payload_pool_stats.in_use[i] > payload_pool_stats.high_water[i])
+			{
+				payload_pool_stats.high_water[i] = payload_pool_stats.in_use[i];
+			}
+
+			return (char *)block;
+		}
+	}
+
+	payload_pool_stats.failure_count++;
+	return NULL;
+}
+
+
+/**
+ * @brief This function gives a block back to the size class it was allocated from.
+ * @note Must only be called from the bluetooth event loop, the pool is not interrupt safe.
+ * @param block Pointer returned by payload_pool_alloc(). NULL is ignored.
+ * @return void
+ */
+void payload_pool_free(void* block)
+{
+	if(block == NULL)
+	{
+		return;
+	}
+
+	for(uint8_t i = 0; i < PAYLOAD_POOL_CLASS_COUNT; i++)
+	{
+		struct payload_pool_class *pool_class = &payload_pool_classes[i];
+		uint8_t *start = (uint8_t *)pool_class->storage;
+		uint8_t *end = start + (pool_class->block_size * pool_class->block_count);
+
+		if((uint8_t *)block >= start && (uint8_t *)block < end)
+		{
+			*(void **)block = pool_class->free_list;
+			pool_class->free_list = block;
+			payload_pool_stats.in_use[i]--;
+			return;
+		}
+	}
+
+	printf("ERROR: payload_pool_free() called with a block not allocated from the pool.\n");
+}
+
+
+/**
+ * @brief This function returns the usage statistics of the pool.
+ * @param void
+ * @return Pointer to the statistics structure.
+ */
+const struct payload_pool_stats* payload_pool_stats_get(void)
+{
+	return &payload_pool_stats;
+}
@@ -0,0 +1,276 @@
+/*
+ * @file scan_queue.c
+ * @brief This file consists of the queue of parsed scans waiting to be sent over bluetooth.
+ * It decouples the barcode parser from the bluetooth notifications so that back to back scans
+ * are never lost or overwritten while an earlier one is still being sent.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "em_rtcc.h"
+#include "inc/scan_queue.h"
+#include "inc/payload_pool.h"
+#include "inc/cart_session.h"
+#include "inc/catalog.h"
+
+
+/**
+ * @brief This function initializes the scan queue and clears the statistics.
+ * @note Payloads of records still queued are not given back, use scan_queue_flush() for that.
+ * @param void
+ * @return void
+ */
+void scan_queue_init(void)
+{
+	memset(&scan_queue, 0, sizeof(struct scan_queue));
+}
+
+
+/**
+ * @brief This function drops all the queued records and gives their payloads back to the pool.
+ * The dropped records are added to the drop count, the other statistics are kept.
+ * @param void
+ * @return void
+ */
+void scan_queue_flush(void)
+{
+	while(scan_queue_count())
+	{
+		struct scan_record *record = &scan_queue.record[scan_queue.head & SCAN_QUEUE_MASK];
+
+		payload_pool_free(record->packet.payload);
+		memset(record, 0, sizeof(struct scan_record));
+
+		scan_queue.head++;
+		scan_queue.dropped_count++;
+	}
+}
+
+
+/**
+ * @brief This function returns the number of records in the queue.
+ * @param void
+ * @return Number of queued records.
+ */
+uint32_t scan_queue_count(void)
+{
+	return scan_queue.tail - scan_queue.head;
+}
+
+
+/**
+ * @brief This function checks if the queue can take another record.
+ * @param void
+ * @return true if the queue is full.
+ */
+bool scan_queue_full(void)
+{
+	return (scan_queue_count() >= SCAN_QUEUE_SIZE);
+}
+
+
+/**
+ * @brief This function encodes the item record of a filled record and adds it at the tail of the queue.
+ * @param struct scan_record* record The record at the tail of the queue
+ * @param struct cart_item* item The item, its name must point to the payload of the record
+ * @return void
+ */
+static void scan_queue_commit(struct scan_record* record, const struct cart_item* item)
+{
+	record->timestamp = RTCC_CounterGet();
+	record->header_size = cart_codec_item_header(record->header, item);
+	record->payload_size = item->name_size;
+
+	scan_queue.tail++;
+	scan_queue.enqueued_count++;
+	if(scan_queue_count() > scan_queue.high_water)
+	{
+		scan_queue.high_water = scan_queue_count();
+	}
+}
+
+
+/**
+ * @brief This function looks up the product of a code frame in the catalog and adds it to the cart.
+ * @param struct barcode_frame* frame The code frame
+ * @return true if the product was added to the cart, false if it is not in the catalog or the cart ledger refused it.
+ */
+static bool scan_queue_push_code(const struct barcode_frame* frame)
+{
+	struct catalog_record product;
+
+	if(catalog_lookup(frame->code, &product) < 0)
+	{
+		scan_queue.dropped_count++;
+		return false;
+	}
+
+	struct cart_item item =
+	{
+		.product_id = product.product_id,
+		.price = product.price,
+		.quantity = 1,
+		.flags = CART_ITEM_FLAG_NAME,
+		.name = product.name,
+		.name_size = product.name_size,
+	};
+	if(cart_session_append(&item) < 0)
+	{
+		scan_queue.dropped_count++;
+		return false;
+	}
+
+	/* Sent from the session log if a reconnected client is still catching up or the name cannot be copied now */
+	if(cart_session_resend_pending() || !scan_queue_push_item(&item))
+	{
+		cart_session_defer(item.sequence);
+	}
+
+	return true;
+}
+
+
+/**
+ * @brief This function copies a complete frame into a new record at the tail of the queue and
+ * records it in the cart session. Code frames are looked up in the catalog first.
+ * @note The frame is not released, the caller still has to call barcode_frame_release().
+ * @param struct barcode_frame* frame The frame descriptor returned by barcode_parser_run()
+ * @return true if the frame was added to the cart, false if the queue is full, the payload could not be allocated,
+ * the code is not in the catalog or the cart ledger refused the item.
+ */
+bool scan_queue_push(const struct barcode_frame* frame)
+{
+	if(scan_queue_full())
+	{
+		return false;
+	}
+
+	if(frame->code_digits)
+	{
+		return scan_queue_push_code(frame);
+	}
+
+	struct scan_record *record = &scan_queue.record[scan_queue.tail & SCAN_QUEUE_MASK];
+
+	memset(record, 0, sizeof(struct scan_record));
+	if(barcode_packet_create(&record->packet, frame) < 0)
+	{
+		scan_queue.dropped_count++;
+		return false;
+	}
+	record->payload_size = frame->payload_size;
+	record->cost = frame->cost;
+
+	/* The product id is derived from the name until the items come from a catalog */
+	struct cart_item item =
+	{
+		.product_id = cart_codec_product_id(record->packet.payload, record->payload_size),
+		.price = (uint32_t)record->cost * CART_PRICE_SCALE,
+		.quantity = 1,
+		.flags = CART_ITEM_FLAG_NAME,
+		.name = record->packet.payload,
+		.name_size = record->payload_size,
+	};
+	if(cart_session_append(&item) < 0)
+	{
+		/* The cart ledger is full */
+		payload_pool_free(record->packet.payload);
+		memset(record, 0, sizeof(struct scan_record));
+		scan_queue.dropped_count++;
+		return false;
+	}
+
+	/* A reconnected client is still catching up, the item goes out after the older changes from the session log */
+	if(cart_session_resend_pending())
+	{
+		payload_pool_free(record->packet.payload);
+		memset(record, 0, sizeof(struct scan_record));
+		return true;
+	}
+
+	scan_queue_commit(record, &item);
+	return true;
+}
+
+
+/**
+ * @brief This function copies an item sent again from the cart session into a new record at the tail of the queue.
+ * @param struct cart_item* item The item returned by cart_session_resend_peek()
+ * @return true if the item was queued, false if the queue is full or the payload could not be allocated.
+ */
+bool scan_queue_push_item(const struct cart_item* item)
+{
+	if(scan_queue_full())
+	{
+		return false;
+	}
+
+	struct scan_record *record = &scan_queue.record[scan_queue.tail & SCAN_QUEUE_MASK];
+
+	memset(record, 0, sizeof(struct scan_record));
+	record->packet.payload = payload_pool_alloc(item->name_size + 1);
+	if(record->packet.payload == NULL)
+	{
+		return false;
+	}
+	memcpy(record->packet.payload, item->name, item->name_size);
+	record->packet.payload[item->name_size] = '\0';
+	record->payload_size = item->name_size;
+	record->cost = item->price / CART_PRICE_SCALE;
+
+	struct cart_item copy = *item;
+	copy.name = record->packet.payload;
+	scan_queue_commit(record, &copy);
+
+	return true;
+}
+
+
+/**
+ * @brief This function returns the oldest record of the queue without removing it.
+ * @param void
+ * @return Pointer to the record, NULL if the queue is empty.
+ */
+struct scan_record* scan_queue_front(void)
+{
+	if(scan_queue_count() == 0)
+	{
+		return NULL;
+	}
+
+	return &scan_queue.record[scan_queue.head & SCAN_QUEUE_MASK];
+}
+
+
+/**
+ * @brief This function removes the oldest record once it has been sent, updates the latency
+ * statistics and gives the payload back to the pool.
+ * @param void
+ * @return void
+ */
+void scan_queue_pop(void)
+{
+	struct scan_record *record = scan_queue_front();
+
+	if(record == NULL)
+	{
+		return;
+	}
+
+	uint32_t latency = RTCC_CounterGet() - record->timestamp;
+	if(latency > scan_queue.latency_max)
+	{
+		scan_queue.latency_max = latency;
+	}
+
+	payload_pool_free(record->packet.payload);
+	memset(record, 0, sizeof(struct scan_record));
+
+	scan_queue.head++;
+	scan_queue.sent_count++;
+}
@@ -0,0 +1,200 @@
+/*
+ * @file timing.c
+ * @brief This file consists of the timing service. It replaces the busy loops whose length depended on the
+ * compiler and the core clock with waits and deadlines measured by the RTCC.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <string.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_rtcc.h"
+#include "em_cryotimer.h"
+#include "sleep.h"
+#include "inc/timing.h"
+
+
+/**
+ * @brief This function converts a duration to RTCC ticks, rounded up.
+ * @param uint32_t us Duration in microseconds
+ * @return Number of ticks.
+ */
+static uint32_t timing_us_to_ticks(uint32_t us)
+{
+	return (uint32_t)((((uint64_t)us * TIMING_TICKS_PER_S) + 999999) / 1000000);
+}
+
+
+/**
+ * @brief This function returns the number of ticks left before a deadline.
+ * @param uint32_t deadline RTCC counter value
+ * @return Ticks left, 0 or less once the deadline is reached.
+ */
+static int32_t timing_remaining(uint32_t deadline)
+{
+	return (int32_t)(deadline - RTCC_CounterGet());
+}
+
+
+/**
+ * @brief This function sleeps for 2^exponent ticks at most, until the CRYOTIMER period or another interrupt.
+ * @param uint8_t exponent Period of the CRYOTIMER
+ * @return void
+ */
+static void timing_sleep(uint8_t exponent)
+{
+	CORE_DECLARE_IRQ_STATE;
+
+	/* The counter restarts from 0 when the CRYOTIMER is enabled */
+	CRYOTIMER_Enable(false);
+	CRYOTIMER_PeriodSet(exponent);
+	CRYOTIMER_IntClear(CRYOTIMER_IF_PERIOD);
+	timing.wakeup = false;
+	CRYOTIMER_Enable(true);
+
+	/* The interrupt cannot slip in between the check and the sleep */
+	CORE_ENTER_CRITICAL();
+	if(!timing.wakeup)
+	{
+		SLEEP_Sleep();
+	}
+	CORE_EXIT_CRITICAL();
+
+	CRYOTIMER_Enable(false);
+}
+
+
+/**
+ * @brief This function sets up the CRYOTIMER used to wake up from long waits and the cycle counter used for
+ * short ones. Until then, waits spin on the RTCC, which is running from initMcu() on.
+ * @note Must be called after gecko_init(), which sets up the SLEEP driver.
+ * @param void
+ * @return void
+ */
+void timing_init(void)
+{
+	CRYOTIMER_Init_TypeDef cryotimer_init = CRYOTIMER_INIT_DEFAULT;
+
+	memset(&timing, 0, sizeof(struct timing));
+	/* Rounded up, the 38.4MHz of the HFXO would make the waits short */
+	timing.cycles_per_us = (CMU_ClockFreqGet(cmuClock_CORE) + 999999) / 1000000;
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	CMU_ClockEnable(cmuClock_CRYOTIMER, true);
+	cryotimer_init.enable = false;
+	cryotimer_init.osc = cryotimerOscLFXO;
+	cryotimer_init.presc = cryotimerPresc_1;
+	CRYOTIMER_Init(&cryotimer_init);
+
+	CRYOTIMER_IntClear(CRYOTIMER_IF_PERIOD);
+	CRYOTIMER_IntEnable(CRYOTIMER_IF_PERIOD);
+	NVIC_ClearPendingIRQ(CRYOTIMER_IRQn);
+	NVIC_EnableIRQ(CRYOTIMER_IRQn);
+
+	timing.ready = true;
+}
+
+
+/**
+ * @brief This function returns the deadline of a timeout.
+ * @param uint32_t us Timeout in microseconds, below 36 hours
+ * @return The RTCC counter value to pass to timing_expired() or timing_wait_until().
+ */
+uint32_t timing_deadline_us(uint32_t us)
+{
+	/* One more tick, the counter may be about to move */
+	return RTCC_CounterGet() + timing_us_to_ticks(us) + 1;
+}
+
+
+/**
+ * @brief This function checks a deadline.
+ * @param uint32_t deadline Value returned by timing_deadline_us()
+ * @return true once the deadline is reached.
+ */
+bool timing_expired(uint32_t deadline)
+{
+	return (timing_remaining(deadline) <= 0);
+}
+
+
+/**
+ * @brief This function waits until a deadline, sleeping while it is far enough.
+ * @note Must not be called from an interrupt handler.
+ * @param uint32_t deadline Value returned by timing_deadline_us()
+ * @return void
+ */
+void timing_wait_until(uint32_t deadline)
+{
+	int32_t remaining;
+	uint32_t start = RTCC_CounterGet();
+	uint32_t slept = 0;
+
+	timing.wait_count++;
+
+	while(timing.ready && ((remaining = timing_remaining(deadline)) >= TIMING_SLEEP_MIN_TICKS))
+	{
+		uint32_t sleep_start = RTCC_CounterGet();
+
+		timing_sleep(31 - __CLZ((uint32_t)remaining));
+		slept += RTCC_CounterGet() - sleep_start;
+	}
+
+	while(timing_remaining(deadline) > 0);
+
+	timing.sleep_ticks += slept;
+	timing.spin_ticks += (RTCC_CounterGet() - start) - slept;
+}
+
+
+/**
+ * @brief This function waits for a number of microseconds. Waits of up to TIMING_SPIN_MAX_US count CPU cycles,
+ * longer ones are measured by the RTCC and sleep from 1ms on.
+ * @note Must not be called from an interrupt handler for more than TIMING_SPIN_MAX_US.
+ * @param uint32_t us Duration, the wait is at least that long
+ * @return void
+ */
+void timing_wait_us(uint32_t us)
+{
+	if(timing.ready && (us <= TIMING_SPIN_MAX_US))
+	{
+		uint32_t start = DWT->CYCCNT;
+		uint32_t cycles = us * timing.cycles_per_us;
+
+		while((DWT->CYCCNT - start) < cycles);
+		return;
+	}
+
+	timing_wait_until(timing_deadline_us(us));
+}
+
+
+/**
+ * @brief This function waits for a number of milliseconds, sleeping most of the time.
+ * @param uint32_t ms Duration, the wait is at least that long
+ * @return void
+ */
+void timing_wait_ms(uint32_t ms)
+{
+	timing_wait_until(timing_deadline_us(ms * 1000));
+}
+
+
+/**
+ * @brief IRQ Handler for the CRYOTIMER, ends the sleep of timing_sleep().
+ * @param void
+ * @return void
+ */
+void CRYOTIMER_IRQHandler(void)
+{
+	CRYOTIMER_IntClear(CRYOTIMER_IF_PERIOD);
+	timing.wakeup = true;
+}
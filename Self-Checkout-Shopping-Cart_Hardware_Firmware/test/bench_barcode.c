@@ -0,0 +1,227 @@
+/*
+ * @file bench_barcode.c
+ * @brief Host benchmark of the barcode frame parser, in MB/s of received data.
+ *
+ * Usage:	bench_barcode [corpus]
+ *
+ * The corpus is the raw output of the scanner. Without a file, a corpus of named and code frames is generated with
+ * garbage and truncated frames between them. It is written into leuart_circbuff in chunks of random size, as the LDMA
+ * would, and parsed after every chunk, so the frames wrap around the end of the buffer and are split between calls.
+ * Only the time spent in barcode_parser_run() and barcode_frame_release() is measured.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "stub/stub.h"
+#include "inc/leuart.h"
+#include "inc/barcode.h"
+
+
+#define BENCH_CORPUS_FRAMES						(200000)
+#define BENCH_CHUNK_MAXSIZE						(128)
+#define BENCH_ROUNDS							(10)
+
+
+static char *corpus;
+static size_t corpus_size;
+static uint32_t corpus_frames;
+static uint32_t corpus_cut;
+
+
+void flash_spi_ldma_irq(uint32_t flags)
+{
+	(void)flags;
+}
+
+
+/**
+ * @brief This function generates the corpus. 2% of the frames are cut short and 5% are followed by garbage,
+ * these are not counted in corpus_frames.
+ * @param void
+ * @return void
+ */
+static void bench_corpus_generate(void)
+{
+	static const char charset[] = "abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_";
+	uint32_t seed = 0xBA5C0DE;
+	size_t capacity = (size_t)BENCH_CORPUS_FRAMES * 96;
+
+	corpus = malloc(capacity);
+	corpus_size = 0;
+
+	for(uint32_t i = 0; i < BENCH_CORPUS_FRAMES; i++)
+	{
+		char frame[128];
+		int size;
+		uint32_t r = test_rand(&seed);
+
+		if((r % 4) == 0)
+		{
+			size = sprintf(frame, "~#%llu`\r", 1000000000000ull + (test_rand(&seed) % 9000000000000ull));
+		}
+		else
+		{
+			char name[64];
+			uint32_t name_size = 3 + (test_rand(&seed) % 58);
+
+			for(uint32_t j = 0; j < name_size; j++)
+			{
+				name[j] = charset[test_rand(&seed) % (sizeof(charset) - 1)];
+			}
+			name[name_size] = '\0';
+			size = sprintf(frame, "~%03lu%03lu%s`\r", (unsigned long)name_size, (unsigned long)(test_rand(&seed) % 1000), name);
+		}
+
+		if(((r >> 8) % 50) == 0)
+		{
+			/* Cut short, the scanner was interrupted */
+			size = 1 + (test_rand(&seed) % (size - 2));
+			corpus_cut++;
+		}
+		else
+		{
+			corpus_frames++;
+		}
+		memcpy(&corpus[corpus_size], frame, size);
+		corpus_size += size;
+
+		if(((r >> 16) % 20) == 0)
+		{
+			for(uint32_t j = test_rand(&seed) % 16; j > 0; j--)
+			{
+				char noise = (char)test_rand(&seed);
+
+				corpus[corpus_size++] = (noise == BARCODE_PREAMBLE) ? '?' : noise;
+			}
+		}
+	}
+}
+
+
+/**
+ * @brief This function reads the corpus from a file. The number of valid frames is not known.
+ * @param path Path of the corpus.
+ * @return 0 on success, -1 otherwise
+ */
+static int bench_corpus_load(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	long size;
+
+	if(file == NULL)
+	{
+		return -1;
+	}
+
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	corpus = malloc(size);
+	corpus_size = fread(corpus, 1, size, file);
+	fclose(file);
+
+	return 0;
+}
+
+
+/**
+ * @brief This function parses the corpus once.
+ * @param parse_ns Incremented by the time spent in the parser.
+ * @return Number of frames found
+ */
+static uint32_t bench_parse(uint64_t *parse_ns)
+{
+	struct barcode_frame frame;
+	uint32_t seed = 0x5EED;
+	uint32_t frames = 0;
+	size_t offset = 0;
+	uint64_t start;
+
+	memset(&leuart_circbuff, 0, sizeof(leuart_circbuff));
+	memset(&barcode_parser, 0, sizeof(barcode_parser));
+	barcode_parser_init(&barcode_parser);
+
+	while(offset < corpus_size)
+	{
+		uint32_t free_size = LEUART_BUFFER_MAXSIZE - (leuart_circbuff.head - leuart_circbuff.tail);
+		uint32_t chunk = 1 + (test_rand(&seed) % BENCH_CHUNK_MAXSIZE);
+
+		if(chunk > free_size)
+		{
+			chunk = free_size;
+		}
+		if(chunk > (corpus_size - offset))
+		{
+			chunk = corpus_size - offset;
+		}
+
+		/* Write the chunk as the LDMA would */
+		for(uint32_t i = 0; i < chunk; i++)
+		{
+			leuart_circbuff.buffer[(leuart_circbuff.head + i) & LEUART_BUFFER_MASK] = corpus[offset + i];
+		}
+		leuart_circbuff.head += chunk;
+		offset += chunk;
+
+		start = test_clock_ns();
+		while(barcode_parser_run(&barcode_parser, &frame))
+		{
+			frames++;
+			barcode_frame_release(&barcode_parser, &frame);
+		}
+		*parse_ns += test_clock_ns() - start;
+	}
+
+	return frames;
+}
+
+
+int main(int argc, char *argv[])
+{
+	uint64_t parse_ns = 0;
+	uint32_t frames = 0;
+
+	if(argc > 1)
+	{
+		if(bench_corpus_load(argv[1]) != 0)
+		{
+			fprintf(stderr, "Cannot read %s\n", argv[1]);
+			return 1;
+		}
+	}
+	else
+	{
+		bench_corpus_generate();
+	}
+
+	for(uint32_t round = 0; round < BENCH_ROUNDS; round++)
+	{
+		frames = bench_parse(&parse_ns);
+	}
+
+	/* A generated corpus tells how many frames must be found. A frame cut short swallows the next one when
+	   a postamble of the next frame falls where its own was expected */
+	if(argc == 1)
+	{
+		CHECK(frames <= corpus_frames);
+		CHECK((corpus_frames - frames) <= corpus_cut);
+	}
+	CHECK_EQ(leuart_circbuff.overrun_count, 0);
+
+	fprintf(stderr, "barcode parser: %lu bytes, %lu/%lu frames, %lu garbage bytes, %lu truncated, %.1f MB/s\n",
+			(unsigned long)corpus_size, (unsigned long)frames, (unsigned long)corpus_frames,
+			(unsigned long)barcode_parser.garbage_count / BENCH_ROUNDS,
+			(unsigned long)barcode_parser.truncated_count / BENCH_ROUNDS,
+			((double)corpus_size * BENCH_ROUNDS * 1e3) / (double)parse_ns);
+
+	free(corpus);
+	return test_exit("bench_barcode");
+}
@@ -0,0 +1,254 @@
+/*
+ * @file bench_cart_codec.c
+ * @brief Host benchmark of the binary cart records against the former "%s,$%s\n" text records.
+ *
+ * A shopping trip through a basket of everyday products is encoded both ways, one record per unit scanned: the text
+ * record as main.c used to build it with snprintf() from the scanned name and cost, and the binary item record as
+ * scan_queue_push() and cart_session_append() build it. The first unit of a product carries the name and leaves the
+ * product id out, the decoder derives it from the name; the next units carry the id and not the name, which the
+ * client already has. The bill is compared too, the former text bill being the total in decimal.
+ * The benchmark reports the bytes sent and the encode time per record, the times are host times and only the
+ * ratio carries over to the Cortex-M4.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "test.h"
+#include "inc/cart_codec.h"
+
+
+#define BENCH_ROUNDS							(200000)
+#define BENCH_TEXT_MAXSIZE						(50)									/* MAX_BLUETOOTH_SIZE_SEND of the text format */
+
+
+/* Name, scanned cost in units and units bought of the products of the basket */
+static const struct
+{
+	const char *name;
+	const char *cost;
+	uint8_t units;
+} basket[] =
+{
+	{"Whole Milk 1 gal", "4", 2}, {"Large Eggs 12 ct", "3", 1}, {"Sourdough Bread", "5", 1}, {"Bananas", "1", 1},
+	{"Gala Apples 3 lb", "4", 1}, {"Cheddar Cheese 8 oz", "3", 2}, {"Greek Yogurt", "1", 6}, {"Chicken Breast 2 lb", "9", 2},
+	{"Ground Coffee 12 oz", "8", 1}, {"Orange Juice 52 oz", "4", 2}, {"Spaghetti 1 lb", "2", 3}, {"Marinara Sauce", "3", 2},
+	{"Baby Spinach 5 oz", "4", 1}, {"Peanut Butter 16 oz", "3", 1}, {"Strawberry Jam", "3", 1}, {"Cereal 18 oz", "4", 2},
+	{"Paper Towels 6 rolls", "12", 1}, {"Dish Soap 24 oz", "3", 1}, {"Laundry Detergent 92 oz", "14", 1}, {"Toothpaste", "4", 2},
+	{"Salted Butter 1 lb", "5", 2}, {"Avocados 4 ct", "5", 1}, {"Tortilla Chips", "4", 2}, {"Sparkling Water 12 pk", "6", 2},
+	{"Frozen Pizza", "7", 3}, {"Ice Cream 48 oz", "5", 1}, {"Olive Oil 500 ml", "9", 1}, {"Basmati Rice 2 lb", "4", 1},
+	{"Canned Black Beans", "1", 4}, {"Dark Chocolate Bar", "3", 3},
+};
+
+#define BENCH_BASKET_COUNT						(sizeof(basket) / sizeof(basket[0]))
+#define BENCH_SCAN_MAX							(BENCH_BASKET_COUNT * 8)
+
+
+/* Products of the basket in the order the units are scanned, filled by bench_trip() */
+static uint8_t trip[BENCH_SCAN_MAX];
+static bool trip_first[BENCH_SCAN_MAX];
+static uint32_t trip_count;
+
+/* Encoded records, kept so that the compiler cannot drop the encoding */
+static uint8_t output[BENCH_SCAN_MAX][CART_ITEM_HEADER_MAXSIZE + BENCH_TEXT_MAXSIZE];
+static uint16_t output_size[BENCH_SCAN_MAX];
+
+
+/**
+ * @brief This function lays out the trip, the units of a product are not scanned one after the other.
+ * @param void
+ * @return void
+ */
+static void bench_trip(void)
+{
+	uint8_t scanned[BENCH_BASKET_COUNT] = {0};
+	bool more = true;
+
+	trip_count = 0;
+	while(more)
+	{
+		more = false;
+		for(uint8_t i = 0; i < BENCH_BASKET_COUNT; i++)
+		{
+			if(scanned[i] < basket[i].units)
+			{
+				trip_first[trip_count] = (scanned[i] == 0);
+				trip[trip_count++] = i;
+				scanned[i]++;
+				more = true;
+			}
+		}
+	}
+}
+
+
+/**
+ * @brief This function builds the text record of a scan, as main.c did before the binary records.
+ * @param scan Scan of the trip.
+ * @return Size of the record.
+ */
+static uint16_t bench_text_item(uint32_t scan)
+{
+	uint8_t index = trip[scan];
+	int size = snprintf((char *)output[scan], BENCH_TEXT_MAXSIZE, "%s,$%s\n", basket[index].name, basket[index].cost);
+
+	return (uint16_t)((size < BENCH_TEXT_MAXSIZE) ? size : (BENCH_TEXT_MAXSIZE - 1));
+}
+
+
+/**
+ * @brief This function builds the binary record of a scan, as scan_queue_push(), cart_session_append() and
+ * ble_packer_fill() do. Only the first unit of a product carries the name.
+ * @param scan Scan of the trip.
+ * @return Size of the record.
+ */
+static uint16_t bench_binary_item(uint32_t scan)
+{
+	uint8_t index = trip[scan];
+	uint16_t name_size = strlen(basket[index].name);
+	uint32_t cost = 0;
+
+	for(const char *digit = basket[index].cost; *digit; digit++)
+	{
+		cost = (cost * 10) + (*digit - '0');
+	}
+
+	struct cart_item item =
+	{
+		.product_id = cart_codec_product_id(basket[index].name, name_size),
+		.price = cost * CART_PRICE_SCALE,
+		.quantity = 1,
+		.flags = trip_first[scan] ? CART_ITEM_FLAG_NAME : 0,
+		.name = basket[index].name,
+		.name_size = trip_first[scan] ? name_size : 0,
+	};
+	uint8_t size = cart_codec_item_header(output[scan], &item);
+
+	memcpy(&output[scan][size], item.name, item.name_size);
+	return size + item.name_size;
+}
+
+
+/**
+ * @brief This function encodes the whole trip BENCH_ROUNDS times.
+ * @param encode Item encoder.
+ * @param bytes Bytes of one trip.
+ * @return Time per record in nanoseconds
+ */
+static double bench_items(uint16_t (*encode)(uint32_t), uint32_t *bytes)
+{
+	uint64_t start = test_clock_ns();
+
+	for(uint32_t round = 0; round < BENCH_ROUNDS; round++)
+	{
+		for(uint32_t i = 0; i < trip_count; i++)
+		{
+			output_size[i] = encode(i);
+		}
+		__asm__ volatile("" ::: "memory");
+	}
+
+	uint64_t elapsed = test_clock_ns() - start;
+
+	*bytes = 0;
+	for(uint32_t i = 0; i < trip_count; i++)
+	{
+		*bytes += output_size[i];
+	}
+
+	return (double)elapsed / ((double)BENCH_ROUNDS * trip_count);
+}
+
+
+int main(void)
+{
+	struct cart_bill bill = {.total = 0, .item_count = 0};
+	struct cart_record record;
+	uint32_t text_bytes;
+	uint32_t binary_bytes;
+	uint32_t text_bill_bytes = 0;
+	uint32_t binary_bill_bytes = 0;
+	uint32_t first_count = 0;
+	uint32_t first_text_bytes = 0;
+	uint32_t first_binary_bytes = 0;
+
+	bench_trip();
+	bill.item_count = trip_count;
+
+	double text_ns = bench_items(bench_text_item, &text_bytes);
+	for(uint32_t i = 0; i < trip_count; i++)
+	{
+		if(trip_first[i])
+		{
+			first_text_bytes += output_size[i];
+		}
+	}
+	double binary_ns = bench_items(bench_binary_item, &binary_bytes);
+
+	/* The binary records decode back to the trip, with the product id of the name */
+	for(uint32_t i = 0; i < trip_count; i++)
+	{
+		const char *name = basket[trip[i]].name;
+
+		CHECK_EQ(cart_codec_decode(output[i], output_size[i], &record), output_size[i]);
+		CHECK_EQ(record.type, CART_TLV_ITEM);
+		CHECK_EQ(record.item.product_id, cart_codec_product_id(name, strlen(name)));
+		CHECK_EQ(record.item.name_size, trip_first[i] ? strlen(name) : 0);
+		CHECK(memcmp(record.item.name, name, record.item.name_size) == 0);
+		bill.total += record.item.price;
+
+		if(trip_first[i])
+		{
+			first_count++;
+			first_binary_bytes += output_size[i];
+		}
+	}
+	CHECK_EQ(first_count, BENCH_BASKET_COUNT);
+
+	/* The bill, decimal total against the bill record */
+	char text[16];
+	uint8_t binary[CART_BILL_MAXSIZE];
+	uint64_t start = test_clock_ns();
+	for(uint32_t round = 0; round < BENCH_ROUNDS; round++)
+	{
+		text_bill_bytes = snprintf(text, sizeof(text), "%lu", (unsigned long)(bill.total / CART_PRICE_SCALE));
+		__asm__ volatile("" ::: "memory");
+	}
+	double text_bill_ns = (double)(test_clock_ns() - start) / BENCH_ROUNDS;
+
+	start = test_clock_ns();
+	for(uint32_t round = 0; round < BENCH_ROUNDS; round++)
+	{
+		binary_bill_bytes = cart_codec_bill_encode(binary, &bill);
+		__asm__ volatile("" ::: "memory");
+	}
+	double binary_bill_ns = (double)(test_clock_ns() - start) / BENCH_ROUNDS;
+
+	CHECK_EQ(cart_codec_decode(binary, binary_bill_bytes, &record), binary_bill_bytes);
+	CHECK_EQ(record.bill.total, bill.total);
+	CHECK_EQ(record.bill.item_count, trip_count);
+
+	/* The binary trip is smaller than the text one */
+	CHECK(binary_bytes < text_bytes);
+
+	fprintf(stderr, "trip of %lu scans       text %4lu bytes %6.1f ns/item    binary %4lu bytes %6.1f ns/item    "
+			"size x%.2f, time x%.2f\n", (unsigned long)trip_count, (unsigned long)text_bytes, text_ns,
+			(unsigned long)binary_bytes, binary_ns, (double)binary_bytes / text_bytes, binary_ns / text_ns);
+	fprintf(stderr, "first units, %2lu       text %4lu bytes                  binary %4lu bytes                  size x%.2f\n",
+			(unsigned long)first_count, (unsigned long)first_text_bytes, (unsigned long)first_binary_bytes,
+			(double)first_binary_bytes / first_text_bytes);
+	fprintf(stderr, "next units, %2lu        text %4lu bytes                  binary %4lu bytes                  size x%.2f\n",
+			(unsigned long)(trip_count - first_count), (unsigned long)(text_bytes - first_text_bytes),
+			(unsigned long)(binary_bytes - first_binary_bytes),
+			(double)(binary_bytes - first_binary_bytes) / (text_bytes - first_text_bytes));
+	fprintf(stderr, "bill                    text %4lu bytes %6.1f ns         binary %4lu bytes %6.1f ns\n",
+			(unsigned long)text_bill_bytes, text_bill_ns, (unsigned long)binary_bill_bytes, binary_bill_ns);
+	fprintf(stderr, "the binary records also carry the product id, the price in cents and the quantity\n");
+
+	return test_exit("bench_cart_codec");
+}
@@ -0,0 +1,187 @@
+/*
+ * @file bench_cart_journal.c
+ * @brief Host benchmark of the cart journal on the MX25 model of stub.c: appends per second and the replay of
+ * 1000 changes at boot.
+ *
+ * flash_spi.c, the SDK driver and cart_journal.c run unchanged on the USART1, LDMA and MX25 models. The model keeps
+ * the time of the flash: 8 clocks of FLASH_SPI_BAUDRATE per byte on the bus, STUB_MX25_PROGRAM_NS per page program
+ * and STUB_MX25_ERASE_NS per sector erase, the typical times of the datasheet. The RTCC stand-in follows that clock,
+ * so the replay_ticks the journal measures at boot are the ticks the firmware would log. The CPU time of the codec,
+ * the CRC and the ledger is not part of the model, the times are those of the flash and its bus.
+ *
+ * 1000 changes, half of them with a name, are appended to a new session in two ways:
+ *
+ * 	burst		back to back, pages are programmed when full and the next sector is erased when needed
+ * 	each		cart_journal_service() after every change, every change is programmed on its own, as when the
+ * 				scans are more than CART_JOURNAL_FLUSH_TICKS apart
+ *
+ * The board then boots as in main.c, the flash in deep power down, and the session is replayed.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "stub.h"
+#include "em_rtcc.h"
+#include "inc/cart_journal.h"
+#include "inc/cart_ledger.h"
+#include "inc/cart_session.h"
+#include "inc/flash_spi.h"
+#include "inc/timing.h"
+
+
+#define BENCH_ENTRIES							(1000)
+#define BENCH_PRODUCT_COUNT						(40)
+
+
+static uint32_t seed = 0xbe4c;
+
+
+/* Fakes of timing.c on the clock of the flash model, a wait lets the LDMA run and its interrupt fire */
+void timing_wait_us(uint32_t us)
+{
+	stub_mx25.time_ns += (uint64_t)us * 1000;
+	stub_irq_dispatch();
+}
+
+
+void timing_wait_ms(uint32_t ms)
+{
+	timing_wait_us(ms * 1000);
+}
+
+
+uint32_t timing_deadline_us(uint32_t us)
+{
+	return (uint32_t)(stub_mx25.time_ns / 1000) + us;
+}
+
+
+bool timing_expired(uint32_t deadline)
+{
+	stub_irq_dispatch();
+	return ((int32_t)((uint32_t)(stub_mx25.time_ns / 1000) - deadline) >= 0);
+}
+
+
+/**
+ * @brief This function boots the board as main.c does, the content of the flash is kept.
+ * @param void
+ * @return Value of cart_journal_init().
+ */
+static int bench_boot(void)
+{
+	stub_reset();
+	stub_rtcc.time_ns = &stub_mx25.time_ns;
+	memset(&flash_spi, 0, sizeof(struct flash_spi));
+	memset(&cart_journal, 0, sizeof(struct cart_journal));
+	memset(&cart_session, 0x55, sizeof(struct cart_session));
+	memset(&cart_ledger, 0x55, sizeof(struct cart_ledger));
+
+	stub_mx25_power_up(true);
+	flash_spi_init();
+	return cart_journal_init();
+}
+
+
+/**
+ * @brief This function appends one scan of a product to the session.
+ * @param void
+ * @return void
+ */
+static void bench_change(void)
+{
+	char name[CART_SESSION_NAME_MAXSIZE];
+	struct cart_item item;
+
+	memset(&item, 0, sizeof(item));
+	item.product_id = 1 + (test_rand(&seed) % BENCH_PRODUCT_COUNT);
+	item.price = 99 + (item.product_id * 37);
+	item.quantity = 1;
+	if(test_rand(&seed) & 1)
+	{
+		item.flags = CART_ITEM_FLAG_NAME;
+		item.name = name;
+		item.name_size = snprintf(name, sizeof(name), "Product %lu, %lu g", (unsigned long)item.product_id,
+				(unsigned long)(test_rand(&seed) % 1000));
+	}
+
+	CHECK_EQ(cart_session_append(&item), 0);
+}
+
+
+/**
+ * @brief This function appends BENCH_ENTRIES changes to a new session on a formatted flash, then replays them at
+ * the next boot.
+ * @param name Name of the case
+ * @param each true to program every change on its own
+ * @return void
+ */
+static void bench_case(const char* name, bool each)
+{
+	stub_mx25_format();
+	CHECK_EQ(bench_boot(), -1);
+	cart_session_init();
+	cart_journal_service();
+
+	uint64_t start_ns = stub_mx25.time_ns;
+	uint32_t programs = stub_mx25.program_count;
+	uint32_t erases = stub_mx25.erase_count;
+
+	for(uint32_t i = 0; i < BENCH_ENTRIES; i++)
+	{
+		bench_change();
+		if(each)
+		{
+			cart_journal_service();
+		}
+	}
+	cart_journal_service();
+	CHECK_EQ(cart_journal.flushed, cart_journal.fill);
+	CHECK_EQ(cart_journal.drop_count, 0);
+
+	double append_s = (stub_mx25.time_ns - start_ns) / 1e9;
+	programs = stub_mx25.program_count - programs;
+	erases = stub_mx25.erase_count - erases;
+
+	/* The boot replays the session */
+	uint32_t item_count = cart_ledger.item_count;
+	int ret = bench_boot();
+
+	CHECK_EQ(ret, BENCH_ENTRIES);
+	CHECK_EQ(cart_journal.corrupt_count, 0);
+	CHECK_EQ(stub_mx25.ignored_count, 0);
+	CHECK_EQ(cart_ledger.item_count, item_count);
+	CHECK(cart_journal.replay_ticks > 0);
+
+	double replay_ms = (cart_journal.replay_ticks * 1000.0) / STUB_RTCC_FREQ;
+
+	fprintf(stderr, "   %-6s %8.0f appends/s %8.1f ms %5lu programs %2lu erases, replay %6.1f ms (%5lu ticks, %5.1f us/change)\n",
+			name, BENCH_ENTRIES / append_s, append_s * 1000, (unsigned long)programs, (unsigned long)erases, replay_ms,
+			(unsigned long)cart_journal.replay_ticks, (replay_ms * 1000) / BENCH_ENTRIES);
+}
+
+
+/**
+ * @brief The cases, cart_journal_init() reads the sector headers into its stack.
+ */
+static void bench_main(void)
+{
+	fprintf(stderr, "%u changes, SPI at %.1f MHz, page program %.2f ms, sector erase %.0f ms\n", BENCH_ENTRIES,
+			FLASH_SPI_BAUDRATE / 1e6, STUB_MX25_PROGRAM_NS / 1e6, STUB_MX25_ERASE_NS / 1e6);
+	bench_case("burst", false);
+	bench_case("each", true);
+}
+
+
+int main(void)
+{
+	stub_run(bench_main);
+
+	return test_exit("bench_cart_journal");
+}
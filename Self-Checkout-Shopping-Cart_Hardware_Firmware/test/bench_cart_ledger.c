@@ -0,0 +1,95 @@
+/*
+ * @file bench_cart_ledger.c
+ * @brief Host benchmark of the cart ledger operations on baskets of 1 to 500 lines.
+ *
+ * For every basket size the ledger is filled with that many products, then a mix of the operations of a shopping
+ * trip is timed: one more unit of a product in the cart, one unit taken out, a line voided and scanned again, and a
+ * lookup. The total is read after every operation, it is maintained by the ledger. For comparison the last column
+ * times the same total computed by walking the lines, as a ledger without a running total would have to.
+ * The times are host times, only their evolution with the basket size carries over to the Cortex-M4.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include "test.h"
+#include "inc/cart_ledger.h"
+
+
+#define BENCH_OPS								(4000000)
+
+
+static volatile uint32_t sink;
+
+
+/**
+ * @brief This function computes the total by walking the lines.
+ * @param void
+ * @return Total in minor units
+ */
+static uint32_t __attribute__((noinline)) bench_total_walk(void)
+{
+	uint32_t total = 0;
+
+	for(uint32_t i = 0; i < cart_ledger.line_count; i++)
+	{
+		total += cart_ledger.line[i].price * cart_ledger.line[i].quantity;
+	}
+
+	return total;
+}
+
+
+int main(void)
+{
+	static const uint32_t sizes[] = {1, 10, 50, 100, 250, 500};
+	uint32_t product_id[CART_LEDGER_LINES_MAX];
+	uint32_t seed = 0xbe7c4;
+
+	fprintf(stderr, "lines      ops/s   ns/op   walk ns/total\n");
+
+	for(uint32_t s = 0; s < (sizeof(sizes) / sizeof(sizes[0])); s++)
+	{
+		uint32_t lines = sizes[s];
+
+		cart_ledger_init();
+		for(uint32_t i = 0; i < lines; i++)
+		{
+			product_id[i] = test_rand(&seed);
+			CHECK_EQ(cart_ledger_add(product_id[i], 100 + (test_rand(&seed) % 2000), 2), 0);
+		}
+
+		uint64_t start = test_clock_ns();
+		for(uint32_t op = 0; op < BENCH_OPS; op += 4)
+		{
+			uint32_t id = product_id[test_rand(&seed) % lines];
+
+			cart_ledger_add(id, 150, 1);
+			sink = cart_ledger.total;
+			cart_ledger_remove(id, 1);
+			sink = cart_ledger.total;
+			cart_ledger_add(id, 150, (uint16_t)cart_ledger_void(id));
+			sink = cart_ledger.total;
+			sink = cart_ledger_find(id)->quantity;
+		}
+		double op_ns = (double)(test_clock_ns() - start) / BENCH_OPS;
+
+		start = test_clock_ns();
+		for(uint32_t op = 0; op < (BENCH_OPS / 16); op++)
+		{
+			sink = bench_total_walk();
+		}
+		double walk_ns = (double)(test_clock_ns() - start) / (BENCH_OPS / 16);
+
+		CHECK_EQ(cart_ledger.line_count, lines);
+		CHECK_EQ(cart_ledger.item_count, 2 * lines);
+		CHECK_EQ(bench_total_walk(), cart_ledger.total);
+
+		fprintf(stderr, "%5lu %10.0f %7.1f %15.1f\n", (unsigned long)lines, 1e9 / op_ns, op_ns, walk_ns);
+	}
+
+	return test_exit("bench_cart_ledger");
+}
@@ -0,0 +1,277 @@
+/*
+ * @file bench_catalog.c
+ * @brief Host benchmark of the catalog lookup against a simulated MX25 flash.
+ *
+ * Catalogs of 100 to 14000 products are written as CSV, built by the catalog compiler of catalog_tools and loaded
+ * into a RAM image of the flash. flash_spi is replaced by a model reading that image and counting the time the
+ * transfers take on the board: the READ command and address and every data byte at FLASH_SPI_BAUDRATE, the wake up
+ * from deep power down (tCRDP + tRDP) before the first read and the deep power down sequence of MX25_DP() after
+ * the lookup. Random products are looked up with an empty product cache, then codes that are not in the catalog.
+ * A binary search over records sorted by code is given for comparison, it would read one record per step.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "em_rtcc.h"
+#include "mx25flash_spi.h"
+#include "inc/catalog.h"
+#include "inc/flash_spi.h"
+
+
+#define BENCH_COMPILER							"build/catalog_compiler"
+#define BENCH_CSV								"build/bench_catalog.csv"
+#define BENCH_IMAGE								"build/bench_catalog.bin"
+#define BENCH_PRODUCTS_MAX						(14000)								/* 64 byte records up to CATALOG_FLASH_MAXSIZE */
+#define BENCH_UNKNOWN_CODES						(10000)
+
+/* Time of the transfers on the board, in nanoseconds */
+#define BENCH_BYTE_NS							(1000000000ull * 8 / FLASH_SPI_BAUDRATE)
+#define BENCH_WAKE_NS							((20 + 35) * 1000ull)				/* tCRDP + tRDP */
+#define BENCH_SLEEP_NS							(((20 + 30 + 5) * 1000ull) + BENCH_BYTE_NS)	/* Dummy cycles of MX25_DP() and the command */
+
+
+/* Products of the catalog under test */
+struct bench_product
+{
+	uint64_t code;
+	uint32_t price;
+	char name[CATALOG_NAME_MAXSIZE + 1];
+};
+
+static struct bench_product products[BENCH_PRODUCTS_MAX];
+static uint8_t flash_image[FlashSize];
+static uint64_t flash_time_ns;
+
+/* The RTCC model of stub.c, the lookup times its ticks. The CPU model stays stopped, the reads step the counter */
+struct stub_rtcc stub_rtcc;
+struct stub_clock stub_clock;
+
+
+/**
+ * @brief Model of flash_spi_read(), copies from the flash image and counts the time of the transfer.
+ */
+int flash_spi_read(uint32_t address, void* data, uint32_t size)
+{
+	if((size == 0) || ((address + size) > FlashSize))
+	{
+		return -1;
+	}
+
+	if(flash_spi.asleep)
+	{
+		flash_time_ns += BENCH_WAKE_NS;
+		flash_spi.asleep = false;
+	}
+
+	memcpy(data, &flash_image[address], size);
+	flash_time_ns += (4 + size) * BENCH_BYTE_NS;
+	flash_spi.read_count++;
+	flash_spi.byte_count += size;
+
+	return 0;
+}
+
+
+/**
+ * @brief Model of flash_spi_sleep().
+ */
+void flash_spi_sleep(void)
+{
+	if(!flash_spi.asleep)
+	{
+		flash_time_ns += BENCH_SLEEP_NS;
+		flash_spi.asleep = true;
+	}
+}
+
+
+/**
+ * @brief This function returns an EAN-13 code, the 12 digits of the body and the check digit.
+ * @param body First 12 digits.
+ * @param valid false to return the code with a wrong check digit.
+ * @return The code.
+ */
+static uint64_t bench_ean13(uint64_t body, bool valid)
+{
+	uint32_t sum = 0;
+	uint64_t digits = body;
+
+	for(uint32_t i = 0; i < 12; i++)
+	{
+		sum += (uint32_t)(digits % 10) * ((i % 2) ? 1 : 3);
+		digits /= 10;
+	}
+
+	return (body * 10) + ((((10 - (sum % 10)) % 10) + (valid ? 0 : 1)) % 10);
+}
+
+
+/**
+ * @brief This function writes a catalog of random products, builds it with the catalog compiler and loads the image.
+ * @param count Number of products.
+ * @param seed Random generator state.
+ * @return 0 on success, -1 if the catalog could not be built.
+ */
+static int bench_catalog_build(uint32_t count, uint32_t *seed)
+{
+	FILE *csv = fopen(BENCH_CSV, "w");
+	uint64_t body = 400638100000ull;
+
+	if(csv == NULL)
+	{
+		return -1;
+	}
+
+	fprintf(csv, "code,price,name\n");
+	for(uint32_t i = 0; i < count; i++)
+	{
+		/* Increasing bodies with random gaps, the codes are unique */
+		body += 1 + (test_rand(seed) % 7919);
+		products[i].code = bench_ean13(body, true);
+		products[i].price = test_rand(seed) % 10000;
+		snprintf(products[i].name, sizeof(products[i].name), "Product %lu %.*s", (unsigned long)i,
+				(int)(test_rand(seed) % 24), "of the benchmark catalog");
+		fprintf(csv, "%llu,%lu.%02lu,%s\n", (unsigned long long)products[i].code, (unsigned long)(products[i].price / 100),
+				(unsigned long)(products[i].price % 100), products[i].name);
+	}
+	if(fclose(csv) != 0)
+	{
+		return -1;
+	}
+
+	if(system(BENCH_COMPILER " " BENCH_CSV " " BENCH_IMAGE " > /dev/null") != 0)
+	{
+		return -1;
+	}
+
+	FILE *image = fopen(BENCH_IMAGE, "rb");
+	if(image == NULL)
+	{
+		return -1;
+	}
+	memset(flash_image, 0xFF, sizeof(flash_image));
+	size_t size = fread(&flash_image[CATALOG_FLASH_ADDRESS], 1, CATALOG_FLASH_MAXSIZE, image);
+	fclose(image);
+
+	return (size > sizeof(struct catalog_header)) ? 0 : -1;
+}
+
+
+/**
+ * @brief This function looks up a code with an empty product cache.
+ * @param code The product code
+ * @param record Filled with the product
+ * @param reads Number of reads of the flash of the lookup.
+ * @param time_ns Time of the transfers of the lookup.
+ * @return The return of catalog_lookup().
+ */
+static int bench_lookup(uint64_t code, struct catalog_record *record, uint32_t *reads, uint64_t *time_ns)
+{
+	uint32_t read_count = catalog.read_count;
+	uint64_t start = flash_time_ns;
+
+	catalog.cache.count = 0;
+	catalog.cache.hand = 0;
+
+	int ret = catalog_lookup(code, record);
+
+	*reads = catalog.read_count - read_count;
+	*time_ns = flash_time_ns - start;
+	return ret;
+}
+
+
+int main(void)
+{
+	static const uint32_t sizes[] = {100, 500, 2000, 2100, 8000, 14000};
+	uint32_t seed = 0xca7a1;
+
+	fprintf(stderr, "products buckets index   reads avg/max   flash us avg/max   unknown reads/us   binary search reads/us   host ns\n");
+
+	for(uint32_t s = 0; s < (sizeof(sizes) / sizeof(sizes[0])); s++)
+	{
+		uint32_t count = sizes[s];
+		struct catalog_record record;
+		uint32_t reads;
+		uint64_t time_ns;
+
+		if(bench_catalog_build(count, &seed) < 0)
+		{
+			CHECK(!"catalog built");
+			break;
+		}
+
+		flash_spi.asleep = true;
+		CHECK_EQ(catalog_init(), 0);
+		CHECK_EQ(catalog.header.record_count, count);
+		CHECK(flash_spi.asleep);
+
+		/* As many lookups as products, of random products */
+		uint32_t reads_total = 0;
+		uint32_t reads_max = 0;
+		uint64_t time_total = 0;
+		uint64_t time_max = 0;
+		uint64_t host_ns = 0;
+
+		for(uint32_t i = 0; i < count; i++)
+		{
+			const struct bench_product *product = &products[test_rand(&seed) % count];
+			uint64_t start = test_clock_ns();
+
+			CHECK_EQ(bench_lookup(product->code, &record, &reads, &time_ns), 0);
+			host_ns += test_clock_ns() - start;
+
+			CHECK_EQ(record.code, product->code);
+			CHECK_EQ(record.price, product->price);
+			CHECK((record.name_size == strlen(product->name)) && (memcmp(record.name, product->name, record.name_size) == 0));
+			CHECK(flash_spi.asleep);
+
+			reads_total += reads;
+			reads_max = (reads > reads_max) ? reads : reads_max;
+			time_total += time_ns;
+			time_max = (time_ns > time_max) ? time_ns : time_max;
+		}
+		CHECK(reads_max <= 2);
+		CHECK_EQ(reads_max, catalog.index_cached ? 1 : 2);
+
+		/* Codes that are not in the catalog, same body and a wrong check digit */
+		uint32_t unknown_reads = 0;
+		uint64_t unknown_time = 0;
+
+		for(uint32_t i = 0; i < BENCH_UNKNOWN_CODES; i++)
+		{
+			const struct bench_product *product = &products[test_rand(&seed) % count];
+
+			CHECK_EQ(bench_lookup(bench_ean13(product->code / 10, false), &record, &reads, &time_ns), -1);
+			unknown_reads += reads;
+			unknown_time += time_ns;
+		}
+
+		/* Binary search over sorted records, one record read per step, then the deep power down */
+		uint32_t search_reads = 0;
+		while((1u << search_reads) <= count)
+		{
+			search_reads++;
+		}
+		uint64_t search_ns = BENCH_WAKE_NS + (search_reads * (4 + CATALOG_RECORD_SIZE) * BENCH_BYTE_NS) + BENCH_SLEEP_NS;
+
+		fprintf(stderr, "%8lu %7lu %-5s %9.2f/%lu %12.1f/%.1f %13.2f/%.1f %17lu/%.1f %14.0f\n", (unsigned long)count,
+				(unsigned long)catalog.header.bucket_count, catalog.index_cached ? "RAM" : "flash",
+				(double)reads_total / count, (unsigned long)reads_max, (double)time_total / count / 1000.0,
+				(double)time_max / 1000.0, (double)unknown_reads / BENCH_UNKNOWN_CODES,
+				(double)unknown_time / BENCH_UNKNOWN_CODES / 1000.0, (unsigned long)search_reads, (double)search_ns / 1000.0,
+				(double)host_ns / count);
+	}
+
+	fprintf(stderr, "flash us include the wake up (%.0f us) and the deep power down (%.0f us) around every lookup\n",
+			BENCH_WAKE_NS / 1000.0, BENCH_SLEEP_NS / 1000.0);
+
+	return test_exit("bench_catalog");
+}
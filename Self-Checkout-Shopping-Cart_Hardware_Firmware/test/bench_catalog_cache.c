@@ -0,0 +1,304 @@
+/*
+ * @file bench_catalog_cache.c
+ * @brief Host benchmark of the product cache of the catalog over shopping trips with skewed product popularity.
+ *
+ * The program is built once per cache size, with CATALOG_CACHE_BYTES set by the Makefile. A catalog of 5000
+ * products is built by the catalog compiler and read through the same flash model as bench_catalog.c. The trace
+ * is a run of shopping trips of one cart: baskets of 1 to 80 items drawn from a Zipf popularity, some of them
+ * scanned several times in a row for several units. Two skews are replayed, a flat one (s = 0.8) and a strong one
+ * (s = 1.1). For each, the hit rate of the cache is reported with the flash time per lookup, a miss costing the
+ * wake up, the reads and the deep power down. The hit rate of an exact LRU of the same capacity is given next to it.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "test.h"
+#include "em_rtcc.h"
+#include "mx25flash_spi.h"
+#include "inc/catalog.h"
+#include "inc/flash_spi.h"
+
+
+#define BENCH_COMPILER							"build/catalog_compiler"
+#define BENCH_PRODUCT_COUNT						(5000)
+#define BENCH_TRIPS								(2000)
+#define BENCH_BASKET_MAXSIZE					(80)
+#define BENCH_MULTI_UNIT_PERCENT				(15)								/* Items scanned 2 to 4 times in a row */
+
+/* Time of the transfers on the board, in nanoseconds, see bench_catalog.c */
+#define BENCH_BYTE_NS							(1000000000ull * 8 / FLASH_SPI_BAUDRATE)
+#define BENCH_WAKE_NS							((20 + 35) * 1000ull)
+#define BENCH_SLEEP_NS							(((20 + 30 + 5) * 1000ull) + BENCH_BYTE_NS)
+
+
+static uint64_t product_code[BENCH_PRODUCT_COUNT];
+static double popularity[BENCH_PRODUCT_COUNT];						/* Cumulative distribution of the Zipf law */
+static uint8_t flash_image[FlashSize];
+static uint64_t flash_time_ns;
+
+/* Exact LRU reference, last use of every entry */
+static uint64_t lru_code[CATALOG_CACHE_SIZE];
+static uint64_t lru_used[CATALOG_CACHE_SIZE];
+static uint32_t lru_count;
+
+/* The RTCC model of stub.c, the lookup times its ticks. The CPU model stays stopped, the reads step the counter */
+struct stub_rtcc stub_rtcc;
+struct stub_clock stub_clock;
+
+
+/**
+ * @brief Model of flash_spi_read(), copies from the flash image and counts the time of the transfer.
+ */
+int flash_spi_read(uint32_t address, void* data, uint32_t size)
+{
+	if((size == 0) || ((address + size) > FlashSize))
+	{
+		return -1;
+	}
+
+	if(flash_spi.asleep)
+	{
+		flash_time_ns += BENCH_WAKE_NS;
+		flash_spi.asleep = false;
+	}
+
+	memcpy(data, &flash_image[address], size);
+	flash_time_ns += (4 + size) * BENCH_BYTE_NS;
+	flash_spi.read_count++;
+
+	return 0;
+}
+
+
+/**
+ * @brief Model of flash_spi_sleep().
+ */
+void flash_spi_sleep(void)
+{
+	if(!flash_spi.asleep)
+	{
+		flash_time_ns += BENCH_SLEEP_NS;
+		flash_spi.asleep = true;
+	}
+}
+
+
+/**
+ * @brief This function builds the catalog with the catalog compiler and loads its image in the flash model.
+ * @param seed Random generator state.
+ * @return 0 on success, -1 if the catalog could not be built.
+ */
+static int bench_catalog_build(uint32_t *seed)
+{
+	char csv_path[64];
+	char image_path[64];
+	char command[192];
+	uint64_t code = 4006381000000ull;
+
+	/* One file per cache size, the benchmarks may run in parallel */
+	snprintf(csv_path, sizeof(csv_path), "build/bench_catalog_cache_%d.csv", CATALOG_CACHE_BYTES);
+	snprintf(image_path, sizeof(image_path), "build/bench_catalog_cache_%d.bin", CATALOG_CACHE_BYTES);
+
+	FILE *csv = fopen(csv_path, "w");
+	if(csv == NULL)
+	{
+		return -1;
+	}
+	for(uint32_t i = 0; i < BENCH_PRODUCT_COUNT; i++)
+	{
+		code += 1 + (test_rand(seed) % 50000);
+		product_code[i] = code;
+		fprintf(csv, "%llu,%lu.%02lu,Product %lu\n", (unsigned long long)code, (unsigned long)(test_rand(seed) % 50),
+				(unsigned long)(test_rand(seed) % 100), (unsigned long)i);
+	}
+	if(fclose(csv) != 0)
+	{
+		return -1;
+	}
+
+	snprintf(command, sizeof(command), "%s %s %s > /dev/null", BENCH_COMPILER, csv_path, image_path);
+	if(system(command) != 0)
+	{
+		return -1;
+	}
+
+	FILE *image = fopen(image_path, "rb");
+	if(image == NULL)
+	{
+		return -1;
+	}
+	memset(flash_image, 0xFF, sizeof(flash_image));
+	size_t size = fread(&flash_image[CATALOG_FLASH_ADDRESS], 1, CATALOG_FLASH_MAXSIZE, image);
+	fclose(image);
+
+	return (size > sizeof(struct catalog_header)) ? 0 : -1;
+}
+
+
+/**
+ * @brief This function sets up the Zipf popularity of the products, the product i is drawn with a weight 1 / (i + 1)^s.
+ * The popular products are spread over the catalog.
+ * @param skew The exponent s.
+ * @param seed Random generator state.
+ * @return void
+ */
+static void bench_popularity(double skew, uint32_t *seed)
+{
+	double sum = 0;
+
+	for(uint32_t i = 0; i < BENCH_PRODUCT_COUNT; i++)
+	{
+		uint32_t j = test_rand(seed) % (i + 1);
+		uint64_t code = product_code[i];
+
+		product_code[i] = product_code[j];
+		product_code[j] = code;
+	}
+
+	for(uint32_t i = 0; i < BENCH_PRODUCT_COUNT; i++)
+	{
+		sum += 1.0 / pow(i + 1, skew);
+		popularity[i] = sum;
+	}
+	for(uint32_t i = 0; i < BENCH_PRODUCT_COUNT; i++)
+	{
+		popularity[i] /= sum;
+	}
+}
+
+
+/**
+ * @brief This function draws a product from the popularity.
+ * @param seed Random generator state.
+ * @return Index of the product.
+ */
+static uint32_t bench_draw(uint32_t *seed)
+{
+	double u = (double)test_rand(seed) / 4294967296.0;
+	uint32_t low = 0;
+	uint32_t high = BENCH_PRODUCT_COUNT - 1;
+
+	while(low < high)
+	{
+		uint32_t middle = (low + high) / 2;
+
+		if(popularity[middle] < u)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	return low;
+}
+
+
+/**
+ * @brief This function looks up a code in the exact LRU reference.
+ * @param code The product code
+ * @param now Number of the lookup
+ * @return true on a hit.
+ */
+static bool bench_lru(uint64_t code, uint64_t now)
+{
+	uint32_t oldest = 0;
+
+	for(uint32_t i = 0; i < lru_count; i++)
+	{
+		if(lru_code[i] == code)
+		{
+			lru_used[i] = now;
+			return true;
+		}
+		oldest = (lru_used[i] < lru_used[oldest]) ? i : oldest;
+	}
+
+	uint32_t entry = (lru_count < CATALOG_CACHE_SIZE) ? lru_count++ : oldest;
+	lru_code[entry] = code;
+	lru_used[entry] = now;
+	return false;
+}
+
+
+/**
+ * @brief This function replays the shopping trips of one cart, the cache starts empty.
+ * @param skew The exponent of the Zipf popularity.
+ * @param seed Random generator state.
+ * @return void
+ */
+static void bench_trace(double skew, uint32_t *seed)
+{
+	struct catalog_record record;
+	uint64_t lookups = 0;
+	uint64_t lru_hits = 0;
+	uint64_t host_ns = 0;
+
+	bench_popularity(skew, seed);
+	CHECK_EQ(catalog_init(), 0);
+	flash_time_ns = 0;
+	lru_count = 0;
+
+	for(uint32_t trip = 0; trip < BENCH_TRIPS; trip++)
+	{
+		/* Basket sizes spread from 1 to BENCH_BASKET_MAXSIZE, 25 on average */
+		uint32_t items = 1 + (uint32_t)(-25.0 * log(1.0 - ((double)test_rand(seed) / 4294967296.0)));
+		items = (items > BENCH_BASKET_MAXSIZE) ? BENCH_BASKET_MAXSIZE : items;
+
+		for(uint32_t item = 0; item < items; item++)
+		{
+			uint32_t product = bench_draw(seed);
+			uint32_t units = ((test_rand(seed) % 100) < BENCH_MULTI_UNIT_PERCENT) ? (2 + (test_rand(seed) % 3)) : 1;
+
+			for(uint32_t unit = 0; unit < units; unit++)
+			{
+				uint64_t start = test_clock_ns();
+				int ret = catalog_lookup(product_code[product], &record);
+
+				host_ns += test_clock_ns() - start;
+				CHECK_EQ(ret, 0);
+				CHECK_EQ(record.code, product_code[product]);
+
+				lru_hits += bench_lru(product_code[product], lookups);
+				lookups++;
+			}
+		}
+	}
+
+	CHECK_EQ(catalog.lookup_count, lookups);
+	CHECK_EQ(catalog.cache.hit_count + catalog.cache.miss_count, lookups);
+	CHECK_EQ(catalog.read_count - catalog.index_cached, catalog.cache.miss_count * (catalog.index_cached ? 1 : 2) + 1);
+	CHECK_EQ(catalog.miss_count, 0);
+
+	fprintf(stderr, "   s %.1f: hit %5.1f%% (LRU %5.1f%%) %6.1f us/lookup %4.0f ns", skew,
+			100.0 * catalog.cache.hit_count / lookups, 100.0 * lru_hits / lookups, (double)flash_time_ns / lookups / 1000.0,
+			(double)host_ns / lookups);
+}
+
+
+int main(void)
+{
+	uint32_t seed = 0xcac4e;
+
+	if(bench_catalog_build(&seed) < 0)
+	{
+		CHECK(!"catalog built");
+		return test_exit("bench_catalog_cache");
+	}
+
+	fprintf(stderr, "cache %5d bytes %3d products", CATALOG_CACHE_BYTES, CATALOG_CACHE_SIZE);
+	bench_trace(0.8, &seed);
+	bench_trace(1.1, &seed);
+	fprintf(stderr, "\n");
+
+	return test_exit("bench_catalog_cache");
+}
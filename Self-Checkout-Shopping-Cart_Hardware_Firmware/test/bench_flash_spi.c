@@ -0,0 +1,182 @@
+/*
+ * @file bench_flash_spi.c
+ * @brief Host benchmark of the reads of the MX25 external flash, byte by byte through mx25flash_spi.c against the
+ * LDMA reads of flash_spi.c.
+ *
+ * The SDK driver and flash_spi.c run unchanged on the USART1 and LDMA models of stub.c, wired to the MX25 model
+ * that answers every byte clocked on the bus. The model keeps the time of the bus: each byte takes 8 clocks at the
+ * baudrate of USART1, and a byte moved by USART_SpiTransfer() costs the core STUB_USART_SPI_OVERHEAD_NS more to
+ * write TXDATA and poll the status. Reads of 64 bytes, 4KB and 64KB are timed on:
+ *
+ * 	old		MX25_READ() at HAL_EXTFLASH_FREQUENCY (1MHz), the path of the firmware before flash_spi.c
+ * 	old 8MHz	MX25_READ() at FLASH_SPI_BAUDRATE, to tell the gain of the clock from the gain of the LDMA
+ * 	new		flash_spi_read(), blocking
+ * 	new async	flash_spi_read_async(), the core is free while the LDMA moves the bytes
+ *
+ * The CPU time is the time spent in USART_SpiTransfer() plus BENCH_IRQ_NS per LDMA interrupt. The bytes read are
+ * checked against the memory of the model every time.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "stub.h"
+#include "mx25flash_spi.h"
+#include "inc/external_events.h"
+#include "inc/flash_spi.h"
+#include "inc/timing.h"
+
+
+#define BENCH_IRQ_NS							(2000)								/* Entry, flash_spi_ldma_irq() and the next descriptor, about 80 cycles at 38.4MHz */
+#define BENCH_ADDRESS							(0x00012345)						/* Not aligned, the reads cross pages and sectors */
+#define BENCH_MAXSIZE							(0x10000)
+
+
+static uint8_t buffer[BENCH_MAXSIZE];
+static int async_status;
+static uint32_t async_calls;
+
+
+/* Fakes of timing.c on the clock of the flash model, a wait lets the LDMA run and its interrupt fire */
+void timing_wait_us(uint32_t us)
+{
+	stub_mx25.time_ns += (uint64_t)us * 1000;
+	stub_irq_dispatch();
+}
+
+
+void timing_wait_ms(uint32_t ms)
+{
+	timing_wait_us(ms * 1000);
+}
+
+
+uint32_t timing_deadline_us(uint32_t us)
+{
+	return (uint32_t)(stub_mx25.time_ns / 1000) + us;
+}
+
+
+bool timing_expired(uint32_t deadline)
+{
+	stub_irq_dispatch();
+	return ((int32_t)((uint32_t)(stub_mx25.time_ns / 1000) - deadline) >= 0);
+}
+
+
+/**
+ * @brief Callback of the asynchronous reads.
+ */
+static void bench_callback(int status, void* context)
+{
+	(void)context;
+	async_status = status;
+	async_calls++;
+}
+
+
+/**
+ * @brief This function prints one path and checks the bytes read.
+ * @param name Name of the path
+ * @param size Number of bytes read
+ * @param bus_ns Time of the read on the bus
+ * @param cpu_ns Time the core spent on the read
+ * @return void
+ */
+static void bench_report(const char *name, uint32_t size, uint64_t bus_ns, uint64_t cpu_ns)
+{
+	CHECK(memcmp(buffer, &stub_mx25.memory[BENCH_ADDRESS], size) == 0);
+
+	fprintf(stderr, "   %-10s %9.1f us %6.1f us/KB, CPU %9.1f us (%5.1f%%)\n", name, bus_ns / 1000.0,
+			bus_ns / 1000.0 / (size / 1024.0), cpu_ns / 1000.0, 100.0 * cpu_ns / bus_ns);
+}
+
+
+/**
+ * @brief This function times one read size on all the paths.
+ * @param size Number of bytes
+ * @return void
+ */
+static void bench_size(uint32_t size)
+{
+	uint64_t time_ns;
+	uint64_t cpu_ns;
+	uint32_t irq_count;
+
+	fprintf(stderr, "%u bytes\n", (unsigned)size);
+
+	/* Old path, MX25_init() leaves USART1 at HAL_EXTFLASH_FREQUENCY */
+	MX25_init();
+	memset(buffer, 0, size);
+	time_ns = stub_mx25.time_ns;
+	cpu_ns = stub_mx25.cpu_ns;
+	CHECK_EQ(MX25_READ(BENCH_ADDRESS, buffer, size), FlashOperationSuccess);
+	bench_report("old", size, stub_mx25.time_ns - time_ns, stub_mx25.cpu_ns - cpu_ns);
+
+	USART_BaudrateSyncSet(MX25_USART, 0, FLASH_SPI_BAUDRATE);
+	memset(buffer, 0, size);
+	time_ns = stub_mx25.time_ns;
+	cpu_ns = stub_mx25.cpu_ns;
+	CHECK_EQ(MX25_READ(BENCH_ADDRESS, buffer, size), FlashOperationSuccess);
+	bench_report("old 8MHz", size, stub_mx25.time_ns - time_ns, stub_mx25.cpu_ns - cpu_ns);
+
+	/* New path, blocking */
+	flash_spi_init();
+	memset(buffer, 0, size);
+	time_ns = stub_mx25.time_ns;
+	cpu_ns = stub_mx25.cpu_ns;
+	irq_count = stub_ldma_model.irq_count;
+	CHECK_EQ(flash_spi_read(BENCH_ADDRESS, buffer, size), 0);
+	bench_report("new", size, stub_mx25.time_ns - time_ns,
+				 (stub_mx25.cpu_ns - cpu_ns) + ((stub_ldma_model.irq_count - irq_count) * BENCH_IRQ_NS));
+	CHECK_EQ(stub_ldma_model.irq_count - irq_count, (size + FLASH_SPI_LDMA_MAXSIZE - 1) / FLASH_SPI_LDMA_MAXSIZE);
+
+	/* New path, asynchronous, the callback runs from the event loop */
+	memset(buffer, 0, size);
+	stub_gecko.signals = 0;
+	async_calls = 0;
+	async_status = -1;
+	time_ns = stub_mx25.time_ns;
+	cpu_ns = stub_mx25.cpu_ns;
+	irq_count = stub_ldma_model.irq_count;
+	CHECK_EQ(flash_spi_read_async(BENCH_ADDRESS, buffer, size, bench_callback, NULL), 0);
+	CHECK(flash_spi_busy());
+	stub_irq_dispatch();
+	CHECK(stub_gecko.signals & EVENT_FLASH);
+	flash_spi_complete();
+	CHECK_EQ(async_calls, 1);
+	CHECK_EQ(async_status, 0);
+	CHECK(!flash_spi_busy());
+	bench_report("new async", size, stub_mx25.time_ns - time_ns,
+				 (stub_mx25.cpu_ns - cpu_ns) + ((stub_ldma_model.irq_count - irq_count) * BENCH_IRQ_NS));
+
+	/* Every read gave its EM2 block back and the flash saw no command it ignored */
+	CHECK_EQ(stub_sleep.block[sleepEM2], 0);
+	CHECK_EQ(stub_mx25.ignored_count, 0);
+}
+
+
+int main(void)
+{
+	uint32_t seed = 0xf1a5;
+
+	stub_reset();
+	stub_mx25_power_up(false);
+	for(uint32_t i = 0; i < STUB_MX25_SIZE; i++)
+	{
+		stub_mx25.memory[i] = (uint8_t)test_rand(&seed);
+	}
+
+	bench_size(64);
+	bench_size(4096);
+	bench_size(BENCH_MAXSIZE);
+
+	CHECK_EQ(flash_spi.error_count, 0);
+
+	return test_exit("bench_flash_spi");
+}
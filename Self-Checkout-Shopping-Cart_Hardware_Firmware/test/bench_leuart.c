@@ -0,0 +1,193 @@
+/*
+ * @file bench_leuart.c
+ * @brief Host benchmark of the LEUART0 receive ring, in bytes per second through the producer and the consumer.
+ *
+ * The reference is the previous ring: read/write indexes with a branch on every wrap and a buffer_count shared by
+ * both sides, updated with the interrupts disabled, read one byte at a time with pop. Its printf is left out, as is
+ * the one of leuart_buffer_pop(), so that only the ring itself is measured. The new ring is measured one byte at a time
+ * and with the spans of peek/consume used by the barcode parser.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "stub/stub.h"
+#include "inc/leuart.h"
+
+
+#define BENCH_BYTES								(64u * 1024u * 1024u)
+#define BENCH_CHUNK								(64)								/* Bytes received between two reads */
+
+
+/* Previous ring buffer */
+struct reference_circbuff
+{
+	char buffer[LEUART_BUFFER_MAXSIZE];
+	uint32_t write_index;
+	uint32_t read_index;
+	volatile uint32_t buffer_count;
+};
+
+static struct reference_circbuff reference_circbuff;
+
+
+void flash_spi_ldma_irq(uint32_t flags)
+{
+	(void)flags;
+}
+
+
+static inline uint32_t reference_index_increment(uint32_t index)
+{
+	if(index == LEUART_BUFFER_MAXSIZE - 1)
+	{
+		index = 0;
+	}
+	else
+	{
+		index++;
+	}
+
+	return index;
+}
+
+
+/* Kept out of line, as the functions of leuart.c called from this file */
+__attribute__((noinline)) static void reference_push(void)
+{
+	CORE_AtomicDisableIrq();
+	if(reference_circbuff.buffer_count != LEUART_BUFFER_MAXSIZE)
+	{
+		reference_circbuff.buffer[reference_circbuff.write_index] = leuart_rcv(LEUART0);
+		reference_circbuff.write_index = reference_index_increment(reference_circbuff.write_index);
+		reference_circbuff.buffer_count++;
+	}
+	CORE_AtomicEnableIrq();
+}
+
+
+__attribute__((noinline)) static char reference_pop(void)
+{
+	if(reference_circbuff.buffer_count > 0)
+	{
+		uint32_t read_index = reference_circbuff.read_index;
+
+		reference_circbuff.read_index = reference_index_increment(reference_circbuff.read_index);
+		CORE_AtomicDisableIrq();
+		reference_circbuff.buffer_count--;
+		CORE_AtomicEnableIrq();
+
+		return reference_circbuff.buffer[read_index];
+	}
+
+	return -1;
+}
+
+
+/**
+ * @brief This function puts one byte in the receiver model, as the scanner would.
+ * @param data Received byte.
+ * @return void
+ */
+static inline void bench_receive(uint8_t data)
+{
+	stub_leuart.fifo[0] = data;
+	stub_leuart.fifo_count = 1;
+}
+
+
+/**
+ * @brief This function prints the throughput of one variant.
+ * @param name Name of the variant.
+ * @param start Start time stamp.
+ * @param checksum Sum of the bytes read, must be the same for all the variants.
+ * @return Bytes per second
+ */
+static double bench_report(const char *name, uint64_t start, uint32_t checksum)
+{
+	double seconds = (double)(test_clock_ns() - start) / 1e9;
+	double rate = (double)BENCH_BYTES / seconds;
+
+	fprintf(stderr, "%-28s %8.1f MB/s (checksum %08lx)\n", name, rate / 1e6, (unsigned long)checksum);
+	return rate;
+}
+
+
+int main(void)
+{
+	uint32_t checksum[3] = {0};
+	double rate[3];
+	uint64_t start;
+	const char *data;
+
+	stub_reset();
+
+	/* Previous ring, push and pop */
+	start = test_clock_ns();
+	for(uint32_t n = 0; n < BENCH_BYTES; n += BENCH_CHUNK)
+	{
+		for(uint32_t i = 0; i < BENCH_CHUNK; i++)
+		{
+			bench_receive((uint8_t)(n + i));
+			reference_push();
+		}
+		for(uint32_t i = 0; i < BENCH_CHUNK; i++)
+		{
+			checksum[0] += (uint8_t)reference_pop();
+		}
+	}
+	rate[0] = bench_report("reference push/pop", start, checksum[0]);
+
+	/* SPSC ring, one byte at a time */
+	memset(&leuart_circbuff, 0, sizeof(leuart_circbuff));
+	start = test_clock_ns();
+	for(uint32_t n = 0; n < BENCH_BYTES; n += BENCH_CHUNK)
+	{
+		for(uint32_t i = 0; i < BENCH_CHUNK; i++)
+		{
+			bench_receive((uint8_t)(n + i));
+			leuart_buffer_push();
+		}
+		while(leuart_buffer_peek(0, &data))
+		{
+			checksum[1] += (uint8_t)*data;
+			leuart_buffer_consume(1);
+		}
+	}
+	rate[1] = bench_report("spsc push, peek/consume(1)", start, checksum[1]);
+
+	/* SPSC ring, contiguous spans */
+	memset(&leuart_circbuff, 0, sizeof(leuart_circbuff));
+	start = test_clock_ns();
+	for(uint32_t n = 0; n < BENCH_BYTES; n += BENCH_CHUNK)
+	{
+		uint32_t size;
+
+		for(uint32_t i = 0; i < BENCH_CHUNK; i++)
+		{
+			bench_receive((uint8_t)(n + i));
+			leuart_buffer_push();
+		}
+		while((size = leuart_buffer_peek(0, &data)) > 0)
+		{
+			for(uint32_t i = 0; i < size; i++)
+			{
+				checksum[2] += (uint8_t)data[i];
+			}
+			leuart_buffer_consume(size);
+		}
+	}
+	rate[2] = bench_report("spsc push, peek/consume(n)", start, checksum[2]);
+
+	CHECK_EQ(checksum[1], checksum[0]);
+	CHECK_EQ(checksum[2], checksum[0]);
+	CHECK_EQ(leuart_circbuff.overrun_count, 0);
+	fprintf(stderr, "spsc vs reference: x%.2f byte per byte, x%.2f with spans\n", rate[1] / rate[0], rate[2] / rate[0]);
+
+	return test_exit("bench_leuart");
+}
@@ -0,0 +1,200 @@
+/*
+ * @file bench_ndef_tag.c
+ * @brief Host benchmark of the tap record of the NFC tag, published in the SRAM of the NTAG against the same record
+ * written to its EEPROM.
+ *
+ * ndef.c and i2c.c run unchanged on the I2C0 bus model of stub.c, with the NTAG model as the slave. The model keeps
+ * the time of the bus: 9 clocks per byte, 10 for a START and its address, and the EEPROM programs for
+ * STUB_NTAG_PROGRAM_NS after each block, during which the NTAG does not acknowledge its address. The latency runs
+ * from the request to the record the phone can read:
+ *
+ * 	sram		ndef_tag_publish() with the mirror already set up: 4 SRAM blocks and I2C_LOCKED cleared
+ * 	sram first	the first publish after a boot, the mirror registers are written as well
+ * 	eeprom		the same 4 blocks written to the EEPROM, until the last one is programmed
+ * 	eeprom boot	ndef_tag_update() over the record written above: 4 blocks read back, the last one written, as
+ * 			the token and the name only differ there
+ *
+ * at the I2C0 clock of the firmware, I2C_FREQ_STANDARD_MAX, and at 100kHz.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "stub.h"
+#include "inc/ndef.h"
+#include "inc/i2c.h"
+#include "inc/external_events.h"
+#include "inc/timing.h"
+
+
+#define BENCH_SESSION_ID						(0x00C0FFEE)
+
+
+static const uint8_t address[NDEF_BLE_ADDRESS_SIZE] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+static const uint8_t nonce[NDEF_TOKEN_NONCE_SIZE] = {0xE1, 0xE2, 0xE3, 0xE4};
+
+
+/* Fakes of timing.c, the bus recovery of i2c_init() moves the clock of the bus model */
+void timing_wait_us(uint32_t us)
+{
+	stub_i2c.time_ns += (uint64_t)us * 1000;
+	stub_irq_dispatch();
+}
+
+
+void timing_wait_ms(uint32_t ms)
+{
+	timing_wait_us(ms * 1000);
+}
+
+
+/* The other interrupts of the models are not used */
+void LDMA_IRQHandler(void)
+{
+}
+
+
+void LEUART0_IRQHandler(void)
+{
+}
+
+
+/**
+ * @brief This function runs the bus and hands the ended transfers to their callback, as the event loop does on EVENT_I2C.
+ * @param void
+ * @return void
+ */
+static void bench_run(void)
+{
+	for(uint32_t guard = 0; guard < 1000; guard++)
+	{
+		stub_irq_dispatch();
+		if(!(stub_gecko.signals & EVENT_I2C))
+		{
+			break;
+		}
+
+		stub_gecko.signals &= ~EVENT_I2C;
+		external_event &= ~EVENT_I2C;
+		i2c_complete();
+	}
+
+	CHECK(!i2c_busy());
+	CHECK_EQ(ndef_tag.step, NDEF_TAG_IDLE);
+}
+
+
+/**
+ * @brief This function boots the cart on a tag holding its EEPROM record and sets the clock of the bus.
+ * @param uint32_t hz I2C0 clock
+ * @return void
+ */
+static void bench_boot(uint32_t hz)
+{
+	stub_reset();
+	stub_ntag_power_up();
+	memset(&ndef_tag, 0, sizeof(struct ndef_tag));
+	external_event = 0;
+	i2c_init();
+	stub_i2c.bit_ns = 1000000000ull / hz;
+
+	ndef_ble_oob_build(stub_ntag.memory[NDEF_TAG_FIRST_BLOCK], address);
+	CHECK_EQ(ndef_tag_update(address), 0);
+	bench_run();
+	CHECK_EQ(stub_ntag.program_count, 0);
+}
+
+
+/**
+ * @brief This function prints one line of results.
+ * @param const char* name Path
+ * @param uint64_t start_ns Time of the request
+ * @param uint32_t programs EEPROM blocks programmed
+ * @return Latency in nanoseconds.
+ */
+static uint64_t bench_print(const char *name, uint64_t start_ns, uint32_t programs)
+{
+	uint64_t end_ns = (stub_ntag.busy_until_ns > stub_i2c.time_ns) ? stub_ntag.busy_until_ns : stub_i2c.time_ns;
+
+	fprintf(stderr, "   %-12s %6.2f ms, %u EEPROM programs\n", name, (end_ns - start_ns) / 1e6, programs);
+	return end_ns - start_ns;
+}
+
+
+/**
+ * @brief This function times the four paths at one clock of the bus.
+ * @param uint32_t hz I2C0 clock
+ * @return void
+ */
+static void bench_paths(uint32_t hz)
+{
+	struct i2c_transfer transfers[NDEF_BLE_OOB_BLOCKS];
+	uint8_t session[NDEF_BLE_OOB_SIZE];
+	uint64_t start;
+	uint64_t sram;
+	uint64_t eeprom;
+
+	fprintf(stderr, "I2C0 at %.1f kHz\n", hz / 1e3);
+
+	bench_boot(hz);
+	start = stub_i2c.time_ns;
+	ndef_tag_publish(BENCH_SESSION_ID, nonce);
+	bench_run();
+	CHECK_EQ(stub_ntag.program_count, 0);
+	bench_print("sram first", start, stub_ntag.program_count);
+
+	start = stub_i2c.time_ns;
+	ndef_tag_publish(BENCH_SESSION_ID + 1, nonce);
+	bench_run();
+	CHECK_EQ(stub_ntag.program_count, 0);
+	CHECK(memcmp(stub_ntag.memory[NXP_NTAG_SRAM_BLOCK], ndef_tag.session, NDEF_BLE_OOB_SIZE) == 0);
+	sram = bench_print("sram", start, stub_ntag.program_count);
+
+	/* The same record through the EEPROM */
+	bench_boot(hz);
+	ndef_ble_oob_session_build(session, address, ndef_tag.token);
+	start = stub_i2c.time_ns;
+	for(uint8_t n = 0; n < NDEF_BLE_OOB_BLOCKS; n++)
+	{
+		i2c_ntag_block_write(&transfers[n], NDEF_TAG_FIRST_BLOCK + n, &session[n * NXP_NTAG_BLOCK_SIZE]);
+		transfers[n].callback = NULL;
+		CHECK_EQ(i2c_transfer_queue(&transfers[n]), 0);
+	}
+	bench_run();
+	for(uint8_t n = 0; n < NDEF_BLE_OOB_BLOCKS; n++)
+	{
+		CHECK_EQ(transfers[n].status, I2C_STATUS_DONE);
+	}
+	CHECK(memcmp(stub_ntag.memory[NDEF_TAG_FIRST_BLOCK], session, NDEF_BLE_OOB_SIZE) == 0);
+	CHECK_EQ(stub_ntag.program_count, NDEF_BLE_OOB_BLOCKS);
+	eeprom = bench_print("eeprom", start, stub_ntag.program_count);
+
+	/* The update at boot, over the record written above */
+	stub_ntag.program_count = 0;
+	memset(&ndef_tag, 0, sizeof(struct ndef_tag));
+	start = stub_i2c.time_ns;
+	CHECK_EQ(ndef_tag_update(address), 0);
+	bench_run();
+	CHECK_EQ(stub_ntag.program_count, 1);
+	CHECK_EQ(ndef_tag.skip_count, NDEF_BLE_OOB_BLOCKS - 1);
+	bench_print("eeprom boot", start, stub_ntag.program_count);
+
+	CHECK(eeprom >= NDEF_BLE_OOB_BLOCKS * STUB_NTAG_PROGRAM_NS);
+	CHECK(sram * 3 < eeprom);
+	CHECK_EQ(stub_i2c.abort_count, 0);
+	fprintf(stderr, "   sram is %.1f times faster than eeprom\n", (double)eeprom / sram);
+}
+
+
+int main(void)
+{
+	bench_paths(I2C_FREQ_STANDARD_MAX);
+	bench_paths(100000);
+
+	return test_exit("bench_ndef_tag");
+}
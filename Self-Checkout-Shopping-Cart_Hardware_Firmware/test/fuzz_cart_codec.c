@@ -0,0 +1,293 @@
+/*
+ * @file fuzz_cart_codec.c
+ * @brief Fuzz target of the cart record decoder.
+ *
+ * cart_codec_decode() parses what the phone and the client tools send back, so it must survive any byte string:
+ * it either rejects the input or returns a record inside the input, which encodes back to a record decoding to the
+ * same fields, and any shorter prefix of it is rejected. The target builds for libFuzzer:
+ * 	clang -fsanitize=fuzzer,address,undefined -DFUZZ_LIBFUZZER -I . -I stub -I ../shopping_cart_software \
+ * 		fuzz_cart_codec.c ../shopping_cart_software/src/cart_codec.c
+ * Without libFuzzer the main() below runs the inputs given on the command line, or a fixed number of random inputs
+ * and mutations of valid records, under the gcc address and undefined behaviour sanitizers.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "inc/cart_codec.h"
+
+
+#define FUZZ_INPUT_MAXSIZE						(600)
+#define FUZZ_RUNS								(2000000)
+
+
+/**
+ * @brief This function encodes a decoded record again.
+ * @param dest Destination buffer of at least CART_ITEM_HEADER_MAXSIZE + name size bytes.
+ * @param record The decoded record.
+ * @return Number of bytes written, 0 for the types the codec does not know.
+ */
+static uint16_t fuzz_encode(uint8_t *dest, const struct cart_record *record)
+{
+	uint16_t size;
+
+	switch(record->type)
+	{
+	case CART_TLV_ITEM:
+		size = cart_codec_item_header(dest, &record->item);
+		if(record->item.flags & CART_ITEM_FLAG_NAME)
+		{
+			memcpy(&dest[size], record->item.name, record->item.name_size);
+			size += record->item.name_size;
+		}
+		return size;
+
+	case CART_TLV_BILL:
+		return cart_codec_bill_encode(dest, &record->bill);
+
+	case CART_TLV_SESSION:
+		return cart_codec_session_encode(dest, &record->session);
+
+	case CART_TLV_CATALOG:
+		return cart_codec_catalog_encode(dest, &record->catalog);
+
+	default:
+		return 0;
+	}
+}
+
+
+/**
+ * @brief This function checks the decoder on one input.
+ * @param data Input, the decoder must not read outside of it.
+ * @param size Size of the input.
+ * @return 0, as libFuzzer expects.
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	struct cart_record record;
+	struct cart_record again;
+	struct cart_record prefix;
+
+	if(size > UINT16_MAX)
+	{
+		return 0;
+	}
+
+	int32_t used = cart_codec_decode(data, (uint16_t)size, &record);
+	if(used < 0)
+	{
+		CHECK_EQ(used, -1);
+		return 0;
+	}
+	CHECK((used >= 2) && ((size_t)used <= size));
+
+	/* A record is rejected until it is complete, the client relies on it to wait for the next fragment */
+	CHECK_EQ(cart_codec_decode(data, (uint16_t)(used - 1), &prefix), -1);
+
+	if((record.type == CART_TLV_ITEM) && (record.item.flags & CART_ITEM_FLAG_NAME))
+	{
+		/* The name is the tail of the value */
+		CHECK((const uint8_t *)record.item.name >= data);
+		CHECK((const uint8_t *)record.item.name + record.item.name_size == data + used);
+	}
+	else if(record.type == CART_TLV_ITEM)
+	{
+		CHECK(record.item.name == NULL);
+		CHECK_EQ(record.item.name_size, 0);
+	}
+	/* The flags of the codec do not reach the caller */
+	CHECK_EQ(record.item.flags & CART_ITEM_FLAG_CODEC, 0);
+
+	/* Varints may be padded, the bytes can differ but the fields must come back */
+	uint8_t *encoded = malloc(CART_ITEM_HEADER_MAXSIZE + size);
+	uint16_t encoded_size = fuzz_encode(encoded, &record);
+	if(encoded_size)
+	{
+		/* Fields after the known ones are skipped by the decoder and dropped by the encoder */
+		CHECK_EQ(cart_codec_decode(encoded, encoded_size, &again), encoded_size);
+		CHECK_EQ(again.type, record.type);
+		CHECK_EQ(again.item.product_id, record.item.product_id);
+		CHECK_EQ(again.item.price, record.item.price);
+		CHECK_EQ(again.item.quantity, record.item.quantity);
+		CHECK_EQ(again.item.flags, record.item.flags);
+		CHECK_EQ(again.item.sequence, record.item.sequence);
+		CHECK_EQ(again.item.name_size, record.item.name_size);
+		CHECK((again.item.name_size == 0) || (memcmp(again.item.name, record.item.name, record.item.name_size) == 0));
+		CHECK_EQ(again.bill.total, record.bill.total);
+		CHECK_EQ(again.bill.item_count, record.bill.item_count);
+		CHECK_EQ(again.session.id, record.session.id);
+		CHECK_EQ(again.session.sequence, record.session.sequence);
+		CHECK_EQ(again.catalog.record_count, record.catalog.record_count);
+		CHECK_EQ(again.catalog.seed, record.catalog.seed);
+	}
+	free(encoded);
+
+	return 0;
+}
+
+
+#ifndef FUZZ_LIBFUZZER
+
+/**
+ * @brief This function runs the target on an exact size copy of the input, so that the sanitizer sees any read past it.
+ * @param data Input.
+ * @param size Size of the input.
+ * @return void
+ */
+static void fuzz_run(const uint8_t *data, size_t size)
+{
+	uint8_t *copy = malloc(size ? size : 1);
+
+	memcpy(copy, data, size);
+	LLVMFuzzerTestOneInput(copy, size);
+	free(copy);
+}
+
+
+/**
+ * @brief This function builds a valid record of a random type.
+ * @param dest Destination buffer of FUZZ_INPUT_MAXSIZE bytes.
+ * @param seed Random generator state.
+ * @return Size of the record.
+ */
+static uint16_t fuzz_valid_record(uint8_t *dest, uint32_t *seed)
+{
+	struct cart_record record;
+	char name[FUZZ_INPUT_MAXSIZE - CART_ITEM_HEADER_MAXSIZE];
+
+	memset(&record, 0, sizeof(record));
+	record.type = CART_TLV_ITEM + (test_rand(seed) % 4);
+	record.item.product_id = test_rand(seed) >> (test_rand(seed) % 32);
+	record.item.price = test_rand(seed) >> (test_rand(seed) % 32);
+	record.item.quantity = test_rand(seed) >> (test_rand(seed) % 32);
+	record.item.flags = test_rand(seed) & (CART_ITEM_FLAG_NAME | CART_ITEM_FLAG_REMOVED | CART_ITEM_FLAG_SEQUENCE);
+	record.item.sequence = (record.item.flags & CART_ITEM_FLAG_SEQUENCE) ? test_rand(seed) : 0;
+	record.item.name_size = (record.item.flags & CART_ITEM_FLAG_NAME) ? (test_rand(seed) % sizeof(name)) : 0;
+	for(uint16_t i = 0; i < record.item.name_size; i++)
+	{
+		name[i] = (char)test_rand(seed);
+	}
+	record.item.name = name;
+
+	/* Mostly the id of the name and a single unit, as the scans are sent */
+	if(test_rand(seed) & 1)
+	{
+		record.item.product_id = cart_codec_product_id(name, record.item.name_size);
+		record.item.quantity = 1;
+	}
+	record.bill.total = record.session.id = record.catalog.record_count = record.item.price;
+	record.bill.item_count = record.session.sequence = record.catalog.seed = record.item.quantity;
+
+	return fuzz_encode(dest, &record);
+}
+
+
+int main(int argc, char *argv[])
+{
+	uint8_t input[FUZZ_INPUT_MAXSIZE];
+	uint32_t seed = 0xc0dec;
+
+	/* Reproduce the inputs saved by a fuzzer */
+	if(argc > 1)
+	{
+		for(int i = 1; i < argc; i++)
+		{
+			FILE *file = fopen(argv[i], "rb");
+			size_t size;
+
+			if(file == NULL)
+			{
+				perror(argv[i]);
+				return 1;
+			}
+			size = fread(input, 1, sizeof(input), file);
+			fclose(file);
+			fuzz_run(input, size);
+		}
+		return test_exit("fuzz_cart_codec");
+	}
+
+	/* Edge cases first */
+	static const uint8_t cases[][8] =
+	{
+		{0},
+		{CART_TLV_ITEM},
+		{CART_TLV_ITEM, 0x00},
+		{CART_TLV_ITEM, 0x80},
+		{CART_TLV_ITEM, 0xff, 0xff, 0xff, 0xff, 0x0f},
+		{CART_TLV_ITEM, 0xff, 0xff, 0xff, 0xff, 0x1f},
+		{CART_TLV_ITEM, 0x04, 0x01, 0x01, 0x01, 0x04},
+		{CART_TLV_BILL, 0x01, 0x01},
+		{CART_TLV_SESSION, 0x06, 0x80, 0x80, 0x80, 0x80, 0x10, 0x00},
+		{0x7f, 0x00},
+	};
+	for(size_t i = 0; i < (sizeof(cases) / sizeof(cases[0])); i++)
+	{
+		for(size_t size = 0; size <= sizeof(cases[0]); size++)
+		{
+			fuzz_run(cases[i], size);
+		}
+	}
+
+	/* An item with its name and without the id takes the id of the name, a single unit without the quantity */
+	static const uint8_t named[] = {CART_TLV_ITEM, 0x03, CART_ITEM_FLAG_NAME, 0x05, 'A'};
+	struct cart_record record;
+	uint8_t header[CART_ITEM_HEADER_MAXSIZE];
+
+	CHECK_EQ(cart_codec_decode(named, sizeof(named), &record), sizeof(named));
+	CHECK_EQ(record.item.product_id, cart_codec_product_id("A", 1));
+	CHECK_EQ(record.item.price, 5);
+	CHECK_EQ(record.item.quantity, 1);
+	CHECK_EQ(cart_codec_item_header(header, &record.item), 4);
+	CHECK(memcmp(header, named, 4) == 0);
+
+	/* A name cut by the session log does not give the id back, the id is sent */
+	record.item.name_size = 0;
+	CHECK_EQ(cart_codec_item_header(header, &record.item), 4 + CART_VARINT_MAXSIZE);
+	CHECK_EQ(header[2], CART_ITEM_FLAG_NAME | CART_ITEM_FLAG_ID);
+
+	for(uint32_t run = 0; run < FUZZ_RUNS; run++)
+	{
+		uint16_t size;
+
+		if(run & 1)
+		{
+			/* Random bytes, mostly short, the type byte often a known one */
+			size = test_rand(&seed) % ((run & 2) ? 16 : FUZZ_INPUT_MAXSIZE);
+			for(uint16_t i = 0; i < size; i++)
+			{
+				input[i] = (uint8_t)test_rand(&seed);
+			}
+			if(size && (run & 4))
+			{
+				input[0] = CART_TLV_ITEM + (test_rand(&seed) % 4);
+			}
+		}
+		else
+		{
+			/* A valid record with a few bytes flipped and cut or extended at a random length */
+			size = fuzz_valid_record(input, &seed);
+			fuzz_run(input, size);
+
+			for(uint32_t flips = test_rand(&seed) % 4; flips > 0; flips--)
+			{
+				input[test_rand(&seed) % size] ^= (uint8_t)(1 << (test_rand(&seed) % 8));
+			}
+			size = test_rand(&seed) % (size + 8);
+			size = (size < FUZZ_INPUT_MAXSIZE) ? size : FUZZ_INPUT_MAXSIZE;
+		}
+
+		fuzz_run(input, size);
+	}
+
+	return test_exit("fuzz_cart_codec");
+}
+
+#endif /* FUZZ_LIBFUZZER */
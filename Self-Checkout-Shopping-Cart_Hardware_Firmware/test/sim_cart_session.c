@@ -0,0 +1,499 @@
+/*
+ * @file sim_cart_session.c
+ * @brief Host simulation of the resumable cart session over a link that drops at random.
+ *
+ * The shopper scans products and the phone takes some out again with the remove and void commands. The link drops
+ * at random: the notifications the stack accepted but did not deliver yet, the transmit queue and the scan queue are
+ * lost, as in the connection closed handler of main.c. On every reconnection the phone sends the resume command with
+ * the last sequence number it applied, and the cart answers with the session record and the changes after it.
+ * The phone applies the changes by sequence number. Whenever the link is idle the view of the phone must be the
+ * cart ledger, and a reconnection must only resend the changes the phone missed, none twice.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+#include "stub/stub.h"
+#include "inc/leuart.h"
+#include "inc/barcode.h"
+#include "inc/external_events.h"
+#include "inc/payload_pool.h"
+#include "inc/scan_queue.h"
+#include "inc/cart_session.h"
+#include "inc/ble_packer.h"
+#include "inc/ble_tx.h"
+
+
+#define SIM_STEPS								(2000000)							/* Connection intervals */
+#define SIM_PRODUCT_COUNT						(60)
+#define SIM_AIR_SIZE							(6)									/* Notifications the stack buffers */
+#define SIM_CONNECTION							(1)
+#define SIM_CHARACTERISTIC						(21)
+
+#define CONTROL_SESSION							(0x01)								/* As in main.c */
+
+
+/* Notifications accepted by the stack and not delivered yet */
+static uint8_t air[SIM_AIR_SIZE][BLE_PACKER_NOTIFICATION_MAXSIZE];
+static uint8_t air_size[SIM_AIR_SIZE];
+static uint32_t air_head;
+static uint32_t air_tail;
+
+/* Firmware state of main.c */
+static bool connected;
+static uint8_t control_pending;
+
+/* The phone */
+struct sim_phone_line
+{
+	uint32_t product_id;
+	uint32_t quantity;
+};
+
+static struct
+{
+	uint32_t session_id;
+	uint32_t last;									/* Sequence number of the last change applied */
+	bool resumed;									/* The session record of this connection was received */
+	struct sim_phone_line line[SIM_PRODUCT_COUNT];
+	uint32_t line_count;
+	uint8_t stream[2 * BLE_PACKER_NOTIFICATION_MAXSIZE];
+	uint16_t stream_size;
+	uint8_t next_sequence;
+	uint32_t applied_count;
+	uint32_t duplicate_count;						/* Changes received again, a resume must not cause any */
+} phone;
+
+/* Statistics */
+static uint32_t seed = 0xd15c;
+static uint32_t disconnect_count;
+static uint32_t converge_count;
+static uint32_t resend_max;
+
+
+/**
+ * @brief This function is the stack: a notification is accepted while there is room in its buffers.
+ * @param connection The connection handle.
+ * @param characteristic The characteristic.
+ * @param size Size of the notification.
+ * @param data The notification.
+ * @return Result of gecko_cmd_gatt_server_send_characteristic_notification()
+ */
+static uint16_t sim_stack_notify(uint8_t connection, uint16_t characteristic, uint8_t size, const uint8_t *data)
+{
+	if(!connected)
+	{
+		return bg_err_invalid_conn_handle;
+	}
+	if((air_tail - air_head) >= SIM_AIR_SIZE)
+	{
+		return bg_err_out_of_memory;
+	}
+
+	memcpy(air[air_tail % SIM_AIR_SIZE], data, size);
+	air_size[air_tail % SIM_AIR_SIZE] = size;
+	air_tail++;
+	return bg_err_success;
+}
+
+
+/**
+ * @brief This function returns the line of a product in the view of the phone, created when missing.
+ * @param product_id The product id.
+ * @return The line.
+ */
+static struct sim_phone_line* sim_phone_line(uint32_t product_id)
+{
+	for(uint32_t i = 0; i < phone.line_count; i++)
+	{
+		if(phone.line[i].product_id == product_id)
+		{
+			return &phone.line[i];
+		}
+	}
+
+	CHECK(phone.line_count < SIM_PRODUCT_COUNT);
+	phone.line[phone.line_count].product_id = product_id;
+	phone.line[phone.line_count].quantity = 0;
+	return &phone.line[phone.line_count++];
+}
+
+
+/**
+ * @brief This function applies one record received by the phone.
+ * @param record The decoded record.
+ * @return void
+ */
+static void sim_phone_record(const struct cart_record *record)
+{
+	if(record->type == CART_TLV_SESSION)
+	{
+		/* Another cart, the phone starts over */
+		if(record->session.id != phone.session_id)
+		{
+			CHECK_EQ(phone.last, 0);
+			phone.session_id = record->session.id;
+		}
+		CHECK(record->session.sequence >= phone.last);
+		phone.resumed = true;
+		return;
+	}
+
+	/* A scan made right after the reconnection, when the phone missed nothing, may overtake the session record */
+	CHECK_EQ(record->type, CART_TLV_ITEM);
+	CHECK(record->item.flags & CART_ITEM_FLAG_SEQUENCE);
+
+	if(record->item.sequence <= phone.last)
+	{
+		phone.duplicate_count++;
+		return;
+	}
+
+	/* The changes must come without gaps */
+	CHECK_EQ(record->item.sequence, phone.last + 1);
+	phone.last = record->item.sequence;
+	phone.applied_count++;
+
+	struct sim_phone_line *line = sim_phone_line(record->item.product_id);
+	if(record->item.flags & CART_ITEM_FLAG_REMOVED)
+	{
+		CHECK(line->quantity >= record->item.quantity);
+		line->quantity -= record->item.quantity;
+	}
+	else
+	{
+		line->quantity += record->item.quantity;
+	}
+}
+
+
+/**
+ * @brief This function hands one delivered notification to the phone.
+ * @param data The notification.
+ * @param size Size of the notification.
+ * @return void
+ */
+static void sim_phone_receive(const uint8_t *data, uint8_t size)
+{
+	struct cart_record record;
+	int32_t used;
+
+	CHECK_EQ(data[0], phone.next_sequence);
+	phone.next_sequence = data[0] + 1;
+	CHECK_EQ(!!(data[1] & BLE_PACKER_FLAG_CONTINUED), phone.stream_size != 0);
+
+	memcpy(&phone.stream[phone.stream_size], &data[BLE_PACKER_HEADER_SIZE], size - BLE_PACKER_HEADER_SIZE);
+	phone.stream_size += size - BLE_PACKER_HEADER_SIZE;
+
+	while((used = cart_codec_decode(phone.stream, phone.stream_size, &record)) > 0)
+	{
+		sim_phone_record(&record);
+		memmove(phone.stream, &phone.stream[used], phone.stream_size - used);
+		phone.stream_size -= used;
+	}
+}
+
+
+/**
+ * @brief This function queues the session record, as control_send() of main.c.
+ * @param void
+ * @return true if the record was queued.
+ */
+static bool sim_control_send(void)
+{
+	uint8_t record[CART_SESSION_MAXSIZE];
+	uint8_t *notification = ble_tx_reserve();
+	struct cart_session_info session;
+	uint16_t notification_size;
+
+	if(notification == NULL)
+	{
+		return false;
+	}
+
+	cart_session_info_get(&session);
+	notification_size = ble_packer_wrap(&ble_packer, notification, record, cart_codec_session_encode(record, &session));
+	if(notification_size == 0)
+	{
+		return false;
+	}
+
+	ble_tx_commit(notification_size);
+	control_pending &= ~CONTROL_SESSION;
+	return true;
+}
+
+
+/**
+ * @brief This function runs the EVENT_SCAN_READY handler and ble_tx_resume() of main.c.
+ * @param void
+ * @return void
+ */
+static void sim_scan_ready_event(void)
+{
+	struct cart_item item;
+	uint8_t *notification;
+	uint16_t notification_size;
+
+	while(!(control_pending & CONTROL_SESSION) && cart_session_resend_peek(&item) && scan_queue_push_item(&item))
+	{
+		cart_session_resend_done();
+	}
+
+	while(((notification = ble_tx_reserve()) != NULL) && ((notification_size = ble_packer_fill(&ble_packer, notification)) > 0))
+	{
+		ble_tx_commit(notification_size);
+	}
+
+	bool done = ble_tx_submit();
+	while(done && control_pending && sim_control_send())
+	{
+		done = ble_tx_submit();
+	}
+
+	if(scan_queue.stalled && !scan_queue_full())
+	{
+		scan_queue.stalled = false;
+		stub_gecko.signals |= EVENT_LEUART;
+	}
+}
+
+
+/**
+ * @brief This function runs the EVENT_LEUART handler of main.c when the event was signalled.
+ * @param void
+ * @return void
+ */
+static void sim_leuart_event(void)
+{
+	struct barcode_frame frame;
+
+	if(!(stub_gecko.signals & EVENT_LEUART))
+	{
+		return;
+	}
+	stub_gecko.signals &= ~EVENT_LEUART;
+	external_event &= ~EVENT_LEUART;
+
+	while(!scan_queue_full() && barcode_parser_run(&barcode_parser, &frame))
+	{
+		CHECK(scan_queue_push(&frame));
+		barcode_frame_release(&barcode_parser, &frame);
+	}
+
+	if(scan_queue_full() && (leuart_buffer_count() > barcode_parser.offset))
+	{
+		scan_queue.stalled = true;
+		scan_queue.stall_count++;
+	}
+}
+
+
+/**
+ * @brief This function opens the connection and sends the resume command of the phone, as main.c handles them.
+ * @param void
+ * @return void
+ */
+static void sim_connect(void)
+{
+	connected = true;
+	leuart_init();
+	barcode_parser_init(&barcode_parser);
+	ble_packer_init(&ble_packer);
+	ble_tx_init(SIM_CONNECTION, SIM_CHARACTERISTIC);
+	control_pending = 0;
+
+	phone.resumed = false;
+	phone.stream_size = 0;
+	phone.next_sequence = 0;
+
+	cart_session_resume(phone.last);
+	control_pending |= CONTROL_SESSION;
+	CHECK_EQ(cart_session.resend_next, phone.last + 1);
+}
+
+
+/**
+ * @brief This function drops the link, as the connection closed handler of main.c.
+ * @param void
+ * @return void
+ */
+static void sim_disconnect(void)
+{
+	connected = false;
+	air_head = air_tail;
+
+	leuart_disable();
+	scan_queue_flush();
+	scan_queue.stalled = false;
+	ble_tx_flush();
+	disconnect_count++;
+}
+
+
+/**
+ * @brief This function checks that the phone has the content of the cart ledger.
+ * @param void
+ * @return void
+ */
+static void sim_check_converged(void)
+{
+	uint32_t lines = 0;
+
+	CHECK_EQ(phone.last, cart_session.sequence);
+	for(uint32_t i = 0; i < phone.line_count; i++)
+	{
+		const struct cart_ledger_line *line = cart_ledger_find(phone.line[i].product_id);
+
+		CHECK_EQ(phone.line[i].quantity, line ? line->quantity : 0);
+		lines += (phone.line[i].quantity != 0);
+	}
+	CHECK_EQ(lines, cart_ledger.line_count);
+	converge_count++;
+}
+
+
+/**
+ * @brief This function checks that a change of more units than a line holds is refused instead of being recorded
+ * truncated, and that the largest quantity is resent whole.
+ * @param void
+ * @return void
+ */
+static void sim_quantity_limit(void)
+{
+	struct cart_item item = {.product_id = 0xBEEF, .price = 1, .quantity = CART_LEDGER_QUANTITY_MAX, .flags = CART_ITEM_FLAG_NAME,
+							 .name = "bulk", .name_size = 4};
+	struct cart_item resent;
+
+	cart_session_init();
+	CHECK_EQ(cart_session_append(&item), 0);
+	CHECK_EQ(cart_session.delta[item.sequence & CART_SESSION_LOG_MASK].quantity, CART_LEDGER_QUANTITY_MAX);
+
+	/* One more unit does not fit the line, a new product with 70000 units does not fit either */
+	item.quantity = 1;
+	CHECK_EQ(cart_session_append(&item), -1);
+	item.product_id = 0xCAFE;
+	item.quantity = 70000;
+	item.flags = CART_ITEM_FLAG_NAME;
+	CHECK_EQ(cart_session_append(&item), -1);
+	CHECK(cart_ledger_find(0xCAFE) == NULL);
+	CHECK_EQ(cart_session.sequence, 1);
+	CHECK_EQ(cart_ledger.item_count, CART_LEDGER_QUANTITY_MAX);
+
+	cart_session_resume(0);
+	CHECK(cart_session_resend_peek(&resent));
+	CHECK_EQ(resent.product_id, 0xBEEF);
+	CHECK_EQ(resent.quantity, CART_LEDGER_QUANTITY_MAX);
+}
+
+
+int main(void)
+{
+	alarm(120);
+
+	stub_reset();
+	stub_gecko.notify = sim_stack_notify;
+	memset(&leuart_circbuff, 0, sizeof(leuart_circbuff));
+	memset(&barcode_parser, 0, sizeof(barcode_parser));
+	payload_pool_init();
+	scan_queue_init();
+	cart_session_init();
+	memset(&phone, 0, sizeof(phone));
+	sim_connect();
+
+	for(uint32_t step = 0; step < SIM_STEPS; step++)
+	{
+		uint32_t draw = test_rand(&seed) % 1000;
+
+		if(!connected)
+		{
+			/* Back in range after a while */
+			if(draw < 50)
+			{
+				uint32_t sequence = cart_session.sequence;
+
+				sim_connect();
+				if((sequence - phone.last) > resend_max)
+				{
+					resend_max = sequence - phone.last;
+				}
+			}
+			continue;
+		}
+
+		/* A scan, sometimes a quick run of them, the cost of the product is its number */
+		if(draw < 60)
+		{
+			uint32_t scans = ((test_rand(&seed) % 8) == 0) ? (1 + (test_rand(&seed) % 12)) : 1;
+
+			while(scans--)
+			{
+				char name[32];
+				char frame[64];
+				uint32_t product = test_rand(&seed) % SIM_PRODUCT_COUNT;
+				int size = sprintf(name, "product %02lu%.*s", (unsigned long)product, (int)(product % 17), "-----------------");
+
+				sprintf(frame, "~%03d%03lu%s`", size, (unsigned long)(product + 1), name);
+				stub_leuart_receive_string(frame);
+			}
+			sim_leuart_event();
+		}
+		/* The shopper takes one unit, or the whole line, of a product out from the phone */
+		else if((draw < 75) && phone.resumed && phone.line_count)
+		{
+			struct sim_phone_line *line = &phone.line[test_rand(&seed) % phone.line_count];
+			struct cart_item item;
+
+			if(line->quantity && (cart_session_remove(line->product_id, (draw & 1), &item) == 0))
+			{
+				if(cart_session_resend_pending() || !scan_queue_push_item(&item))
+				{
+					cart_session_defer(item.sequence);
+				}
+			}
+		}
+		/* The link drops */
+		else if(draw < 78)
+		{
+			sim_disconnect();
+			continue;
+		}
+
+		sim_leuart_event();
+		sim_scan_ready_event();
+
+		/* The connection event delivers some of the notifications the stack holds */
+		for(uint32_t count = test_rand(&seed) % 4; (count > 0) && (air_head != air_tail); count--, air_head++)
+		{
+			sim_phone_receive(air[air_head % SIM_AIR_SIZE], air_size[air_head % SIM_AIR_SIZE]);
+		}
+
+		if(!control_pending && !cart_session_resend_pending() && !scan_queue_count() && !ble_tx_count() &&
+				(air_head == air_tail) && !(stub_gecko.signals & EVENT_LEUART) && (leuart_buffer_count() == 0))
+		{
+			sim_check_converged();
+		}
+	}
+
+	CHECK_EQ(cart_session.lost_count, 0);
+	CHECK_EQ(leuart_circbuff.overrun_count, 0);
+	CHECK(converge_count > 1000);
+	CHECK(disconnect_count > 1000);
+	CHECK_EQ(phone.duplicate_count, 0);
+
+	fprintf(stderr, "sim_cart_session: %lu changes, %lu lines in the cart, %lu disconnections, %lu resumes, "
+			"%lu changes resent, at most %lu missed by the phone, %lu duplicates ignored, converged %lu times\n",
+			(unsigned long)cart_session.sequence, (unsigned long)cart_ledger.line_count, (unsigned long)disconnect_count,
+			(unsigned long)cart_session.resume_count, (unsigned long)cart_session.resent_count, (unsigned long)resend_max,
+			(unsigned long)phone.duplicate_count, (unsigned long)converge_count);
+
+	sim_quantity_limit();
+
+	return test_exit("sim_cart_session");
+}
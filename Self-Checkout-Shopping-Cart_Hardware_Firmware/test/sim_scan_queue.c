@@ -0,0 +1,233 @@
+/*
+ * @file sim_scan_queue.c
+ * @brief Host simulation of the scan path at 20 scans per second, from the scanner to the bluetooth sender.
+ *
+ * The scanner model sends a frame every 50 ms with +-20 ms of jitter through the LEUART and LDMA models, the
+ * EVENT_LEUART and EVENT_SCAN_READY handlers of main.c are run as they are in the firmware and the stack takes
+ * 0 to 4 records at every 15 ms connection event. The radio goes quiet for one second in the middle of the run to
+ * push the queue into back-pressure, the held back frames must wait in leuart_circbuff and none may be lost.
+ * The simulation reports the queue depth seen by the sender and the scan to notification latency percentiles.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+#include "stub/stub.h"
+#include "em_rtcc.h"
+#include "inc/leuart.h"
+#include "inc/barcode.h"
+#include "inc/external_events.h"
+#include "inc/payload_pool.h"
+#include "inc/scan_queue.h"
+#include "inc/cart_session.h"
+
+
+#define SIM_TICKS_PER_MS						(32768.0 / 1000.0)
+#define SIM_MS_TO_TICKS(ms)						((uint32_t)((ms) * SIM_TICKS_PER_MS))
+
+#define SIM_DURATION_MS							(120000)
+#define SIM_SCAN_PERIOD_MS						(50)								/* 20 scans per second */
+#define SIM_SCAN_JITTER_MS						(20)
+#define SIM_CONN_INTERVAL_MS					(15)
+#define SIM_CONN_RECORDS_MAX					(4)									/* Records taken by the stack at one connection event */
+#define SIM_OUTAGE_START_MS						(60000)
+#define SIM_OUTAGE_MS							(1000)
+#define SIM_PRODUCT_COUNT						(50)
+#define SIM_SCAN_MAX							((SIM_DURATION_MS / (SIM_SCAN_PERIOD_MS - SIM_SCAN_JITTER_MS)) + 1)
+
+
+/* RTCC time at which every scan left the scanner, in scan order */
+static uint32_t scan_time[SIM_SCAN_MAX];
+static uint32_t scan_count;
+
+/* Scan to notification latency of every sent record, in ticks */
+static uint32_t latency[SIM_SCAN_MAX];
+static uint32_t sent_count;
+
+/* Queue depth seen at every connection event */
+static uint32_t depth_histogram[SCAN_QUEUE_SIZE + 1];
+static uint64_t depth_sum;
+static uint32_t depth_samples;
+
+
+/**
+ * @brief This function runs the EVENT_LEUART handler of main.c when the event was signalled.
+ * @param void
+ * @return void
+ */
+static void sim_leuart_event(void)
+{
+	struct barcode_frame frame;
+
+	if(!(stub_gecko.signals & EVENT_LEUART))
+	{
+		return;
+	}
+	stub_gecko.signals &= ~EVENT_LEUART;
+	external_event &= ~EVENT_LEUART;
+	leuart_circbuff.wakeup_count++;
+
+	while(!scan_queue_full() && barcode_parser_run(&barcode_parser, &frame))
+	{
+		CHECK(scan_queue_push(&frame));
+		barcode_frame_release(&barcode_parser, &frame);
+	}
+
+	if(scan_queue_full() && (leuart_buffer_count() > barcode_parser.offset))
+	{
+		scan_queue.stalled = true;
+		scan_queue.stall_count++;
+	}
+}
+
+
+/**
+ * @brief This function runs one connection event: the stack takes up to records_max records, oldest first,
+ * then the EVENT_SCAN_READY handler resumes a stalled parser.
+ * @param records_max Number of records the stack accepts at this connection event.
+ * @return void
+ */
+static void sim_connection_event(uint32_t records_max)
+{
+	struct scan_record *record;
+	uint32_t depth = scan_queue_count();
+
+	depth_histogram[depth]++;
+	depth_sum += depth;
+	depth_samples++;
+
+	while((records_max > 0) && ((record = scan_queue_front()) != NULL))
+	{
+		/* Nothing is lost, so the n-th record sent is the n-th scan */
+		CHECK(sent_count < scan_count);
+		if(sent_count < scan_count)
+		{
+			latency[sent_count] = stub_rtcc.counter - scan_time[sent_count];
+		}
+		sent_count++;
+
+		scan_queue_pop();
+		records_max--;
+	}
+
+	if(scan_queue.stalled && !scan_queue_full())
+	{
+		scan_queue.stalled = false;
+		stub_gecko.signals |= EVENT_LEUART;
+	}
+}
+
+
+static int sim_compare(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+
+/**
+ * @brief This function returns a latency percentile in milliseconds.
+ * @param sorted Latencies in ticks, sorted.
+ * @param count Number of latencies.
+ * @param percentile Percentile, 0 to 100.
+ * @return Latency in milliseconds
+ */
+static double sim_percentile_ms(const uint32_t *sorted, uint32_t count, double percentile)
+{
+	uint32_t index = (uint32_t)((percentile / 100.0) * (count - 1) + 0.5);
+
+	return sorted[index] / SIM_TICKS_PER_MS;
+}
+
+
+int main(void)
+{
+	uint32_t seed = 0x5ca11e;
+	uint32_t next_scan = SIM_MS_TO_TICKS(SIM_SCAN_PERIOD_MS);
+	uint32_t next_connection = SIM_MS_TO_TICKS(SIM_CONN_INTERVAL_MS);
+	uint32_t end = SIM_MS_TO_TICKS(SIM_DURATION_MS);
+
+	alarm(60);
+
+	stub_reset();
+	memset(&leuart_circbuff, 0, sizeof(leuart_circbuff));
+	memset(&barcode_parser, 0, sizeof(barcode_parser));
+	barcode_parser_init(&barcode_parser);
+	payload_pool_init();
+	scan_queue_init();
+	cart_session_init();
+	external_event = 0;
+	leuart_init();
+
+	/* Both the scanner and the sender run on the simulated RTCC, whichever is due first goes next */
+	while((next_scan < end) || scan_queue_count() || scan_queue.stalled)
+	{
+		if((next_scan < end) && (next_scan <= next_connection))
+		{
+			char frame[64];
+			char name[32];
+			uint32_t product = test_rand(&seed) % SIM_PRODUCT_COUNT;
+			int size = sprintf(name, "product_%02lu%.*s", (unsigned long)product, (int)(product % 13), "_abcdefghijkl");
+
+			stub_rtcc.counter = next_scan;
+			sprintf(frame, "~%03d%03lu%s`", size, (unsigned long)(product + 1), name);
+			scan_time[scan_count++] = next_scan;
+			stub_leuart_receive_string(frame);
+			sim_leuart_event();
+
+			int32_t jitter = (int32_t)(test_rand(&seed) % (2 * SIM_SCAN_JITTER_MS + 1)) - SIM_SCAN_JITTER_MS;
+			next_scan += SIM_MS_TO_TICKS(SIM_SCAN_PERIOD_MS + jitter);
+		}
+		else
+		{
+			uint32_t now_ms = (uint32_t)(next_connection / SIM_TICKS_PER_MS);
+			bool outage = (now_ms >= SIM_OUTAGE_START_MS) && (now_ms < (SIM_OUTAGE_START_MS + SIM_OUTAGE_MS));
+
+			stub_rtcc.counter = next_connection;
+			sim_connection_event(outage ? 0 : (test_rand(&seed) % (SIM_CONN_RECORDS_MAX + 1)));
+			sim_leuart_event();
+			next_connection += SIM_MS_TO_TICKS(SIM_CONN_INTERVAL_MS);
+		}
+	}
+
+	/* Every scan made it to the stack, in order and once */
+	CHECK_EQ(scan_queue.dropped_count, 0);
+	CHECK_EQ(scan_queue.enqueued_count, scan_count);
+	CHECK_EQ(scan_queue.sent_count, scan_count);
+	CHECK_EQ(sent_count, scan_count);
+	CHECK_EQ(leuart_circbuff.overrun_count, 0);
+	CHECK_EQ(barcode_parser.garbage_count, 0);
+	CHECK_EQ(barcode_parser.truncated_count, 0);
+	CHECK(scan_queue.stall_count > 0);
+	CHECK_EQ(scan_queue.high_water, SCAN_QUEUE_SIZE);
+
+	if(sent_count == scan_count)
+	{
+		qsort(latency, sent_count, sizeof(latency[0]), sim_compare);
+
+		fprintf(stderr, "sim_scan_queue: %lu scans in %u s, %lu stalls, queue high water %lu/%u, mean depth %.2f\n",
+				(unsigned long)scan_count, SIM_DURATION_MS / 1000, (unsigned long)scan_queue.stall_count,
+				(unsigned long)scan_queue.high_water, SCAN_QUEUE_SIZE, (double)depth_sum / depth_samples);
+		fprintf(stderr, "sim_scan_queue: depth at connection events:");
+		for(uint32_t depth = 0; depth <= SCAN_QUEUE_SIZE; depth++)
+		{
+			fprintf(stderr, " %lu:%.1f%%", (unsigned long)depth, 100.0 * depth_histogram[depth] / depth_samples);
+		}
+		fprintf(stderr, "\n");
+		fprintf(stderr, "sim_scan_queue: scan to notification latency p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms, "
+				"queue only max %.1f ms\n", sim_percentile_ms(latency, sent_count, 50), sim_percentile_ms(latency, sent_count, 90),
+				sim_percentile_ms(latency, sent_count, 99), sim_percentile_ms(latency, sent_count, 100),
+				scan_queue.latency_max / SIM_TICKS_PER_MS);
+	}
+
+	return test_exit("sim_scan_queue");
+}
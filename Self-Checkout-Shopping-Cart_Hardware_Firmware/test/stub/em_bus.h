@@ -0,0 +1,25 @@
+/*
+ * @file em_bus.h
+ * @brief Host stand-in for emlib em_bus.h, the bit band accesses are plain read-modify-writes.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef STUB_EM_BUS_H_
+#define STUB_EM_BUS_H_
+
+#include "em_device.h"
+
+static inline void BUS_RegMaskedSet(volatile uint32_t *addr, uint32_t mask) { *addr |= mask; }
+static inline void BUS_RegMaskedClear(volatile uint32_t *addr, uint32_t mask) { *addr &= ~mask; }
+static inline void BUS_RegBitWrite(volatile uint32_t *addr, unsigned int bit, unsigned int val)
+{
+	*addr = (*addr & ~(1UL << bit)) | ((uint32_t)(val != 0) << bit);
+}
+static inline unsigned int BUS_RegBitRead(volatile const uint32_t *addr, unsigned int bit) { return (*addr >> bit) & 1; }
+
+
+#endif /* STUB_EM_BUS_H_ */
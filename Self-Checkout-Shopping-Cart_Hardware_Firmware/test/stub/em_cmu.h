@@ -0,0 +1,58 @@
+/*
+ * @file em_cmu.h
+ * @brief Host stand-in for emlib em_cmu.h, the clock tree is not modelled. The core runs at the frequency of the
+ * CPU model of em_device.h, the low frequency clocks at 32768 Hz.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef STUB_EM_CMU_H_
+#define STUB_EM_CMU_H_
+
+#include "em_device.h"
+
+typedef enum
+{
+	cmuClock_HFPER,
+	cmuClock_GPIO,
+	cmuClock_LDMA,
+	cmuClock_LEUART0,
+	cmuClock_LFB,
+	cmuClock_USART1,
+	cmuClock_I2C0,
+	cmuClock_RTCC,
+	cmuClock_CRYOTIMER,
+	cmuClock_CORELE,
+	cmuClock_CORE
+} CMU_Clock_TypeDef;
+
+typedef enum
+{
+	cmuSelect_LFXO,
+	cmuSelect_LFRCO,
+	cmuSelect_ULFRCO
+} CMU_Select_TypeDef;
+
+typedef enum
+{
+	cmuOsc_LFXO,
+	cmuOsc_LFRCO,
+	cmuOsc_HFXO,
+	cmuOsc_HFRCO,
+	cmuOsc_ULFRCO
+} CMU_Osc_TypeDef;
+
+typedef uint32_t CMU_ClkDiv_TypeDef;
+#define cmuClkDiv_1								(1)
+
+static inline void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable) { (void)clock; (void)enable; }
+static inline void CMU_ClockDivSet(CMU_Clock_TypeDef clock, CMU_ClkDiv_TypeDef div) { (void)clock; (void)div; }
+static inline void CMU_ClockSelectSet(CMU_Clock_TypeDef clock, CMU_Select_TypeDef ref) { (void)clock; (void)ref; }
+static inline void CMU_OscillatorEnable(CMU_Osc_TypeDef osc, bool enable, bool wait) { (void)osc; (void)enable; (void)wait; }
+static inline uint32_t CMU_ClockFreqGet(CMU_Clock_TypeDef clock) { return (clock == cmuClock_CORE) ? stub_clock.core_hz : 32768; }
+
+
+#endif /* STUB_EM_CMU_H_ */
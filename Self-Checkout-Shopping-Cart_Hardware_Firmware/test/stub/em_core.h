@@ -0,0 +1,29 @@
+/*
+ * @file em_core.h
+ * @brief Host stand-in for emlib em_core.h. The tests run the interrupt handlers synchronously,
+ * the critical sections only count their nesting so that a test can check where they are taken.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef STUB_EM_CORE_H_
+#define STUB_EM_CORE_H_
+
+#include "em_device.h"
+
+extern uint32_t stub_core_nesting;
+
+#define CORE_DECLARE_IRQ_STATE					uint32_t irqState = 0
+#define CORE_ENTER_CRITICAL()					do { (void)irqState; stub_core_nesting++; } while(0)
+#define CORE_EXIT_CRITICAL()					do { stub_core_nesting--; } while(0)
+#define CORE_ENTER_ATOMIC()						CORE_ENTER_CRITICAL()
+#define CORE_EXIT_ATOMIC()						CORE_EXIT_CRITICAL()
+
+static inline void CORE_AtomicDisableIrq(void) { stub_core_nesting++; }
+static inline void CORE_AtomicEnableIrq(void) { stub_core_nesting--; }
+
+
+#endif /* STUB_EM_CORE_H_ */
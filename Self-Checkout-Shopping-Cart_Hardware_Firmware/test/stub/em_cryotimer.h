@@ -0,0 +1,76 @@
+/*
+ * @file em_cryotimer.h
+ * @brief Host stand-in for emlib em_cryotimer.h. The counter runs on the LFXO ticks of the CPU model of
+ * em_device.h, the period flag is raised when SLEEP_Sleep() wakes the CPU up at the end of the period.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef STUB_EM_CRYOTIMER_H_
+#define STUB_EM_CRYOTIMER_H_
+
+#include "em_device.h"
+
+typedef struct
+{
+	volatile uint32_t CTRL;
+	volatile uint32_t PERIODSEL;
+	volatile uint32_t CNT;
+	volatile uint32_t EN;
+	volatile uint32_t IF;
+	volatile uint32_t IEN;
+} CRYOTIMER_TypeDef;
+
+extern CRYOTIMER_TypeDef stub_cryotimer;
+#define CRYOTIMER								(&stub_cryotimer)
+
+#define CRYOTIMER_IF_PERIOD						(0x1UL << 0)
+
+typedef enum
+{
+	cryotimerOscLFRCO,
+	cryotimerOscLFXO,
+	cryotimerOscULFRCO
+} CRYOTIMER_Osc_TypeDef;
+
+typedef enum
+{
+	cryotimerPresc_1,
+	cryotimerPresc_2,
+	cryotimerPresc_4,
+	cryotimerPresc_8,
+	cryotimerPresc_16,
+	cryotimerPresc_32,
+	cryotimerPresc_64,
+	cryotimerPresc_128
+} CRYOTIMER_Presc_TypeDef;
+
+typedef uint32_t CRYOTIMER_Period_TypeDef;
+#define cryotimerPeriod_4294M					(32)
+
+typedef struct
+{
+	bool enable;
+	bool debugRun;
+	bool em4Wakeup;
+	CRYOTIMER_Osc_TypeDef osc;
+	CRYOTIMER_Presc_TypeDef presc;
+	CRYOTIMER_Period_TypeDef period;
+} CRYOTIMER_Init_TypeDef;
+
+#define CRYOTIMER_INIT_DEFAULT					{true, false, false, cryotimerOscULFRCO, cryotimerPresc_1, cryotimerPeriod_4294M}
+
+/* Implemented in stub.c, the counter restarts from 0 on every enable */
+void CRYOTIMER_Init(const CRYOTIMER_Init_TypeDef *init);
+void CRYOTIMER_Enable(bool enable);
+
+static inline void CRYOTIMER_PeriodSet(uint32_t period) { CRYOTIMER->PERIODSEL = period; }
+static inline void CRYOTIMER_IntClear(uint32_t flags) { CRYOTIMER->IF &= ~flags; }
+static inline void CRYOTIMER_IntEnable(uint32_t flags) { CRYOTIMER->IEN |= flags; }
+static inline void CRYOTIMER_IntDisable(uint32_t flags) { CRYOTIMER->IEN &= ~flags; }
+
+
+#endif /* STUB_EM_CRYOTIMER_H_ */
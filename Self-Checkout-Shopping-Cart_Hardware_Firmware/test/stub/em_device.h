@@ -0,0 +1,220 @@
+/*
+ * @file em_device.h
+ * @brief Host stand-in for the EFR32BG13 device header. Only the registers and bit fields used by the firmware
+ * are declared, the peripherals are plain structures in RAM which the models of stub.c act upon.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef STUB_EM_DEVICE_H_
+#define STUB_EM_DEVICE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/* Core */
+#define __NVIC_PRIO_BITS						(3)
+
+/* Internal flash of the EFR32BG13P632F512GM48 */
+#define FLASH_BASE								(0x00000000UL)
+#define FLASH_SIZE								(0x00080000UL)
+#define FLASH_PAGE_SIZE							(2048U)
+
+/* The interrupt handlers run on the same thread as the event loop, only the compiler has to keep the order.
+   A host fence would cost far more than the DMB of the Cortex-M4 and skew the benchmarks */
+#define __DMB()									__asm__ volatile ("" ::: "memory")
+#define __DSB()									__asm__ volatile ("" ::: "memory")
+#define __CLZ(value)							((uint8_t)((value) ? __builtin_clz(value) : 32))
+
+
+/* Clock of the CPU model, run by the tests of the timing service. With poll_ns set, every read of the RTCC counter
+ * or of the DWT cycle counter costs poll_ns of CPU time, both counters follow time_ns and SLEEP_Sleep() moves it to
+ * the wake up by the CRYOTIMER. With poll_ns at 0 the clock stands still and the RTCC is stepped by its reads */
+#define STUB_CLOCK_TICKS_PER_S					(32768)
+#define STUB_CLOCK_EM2_WAKEUP_NS				(10000)								/* Active, the core waits for the HFXO */
+
+struct stub_clock
+{
+	uint64_t time_ns;
+	uint32_t poll_ns;
+	uint32_t core_hz;
+
+	/* Statistics */
+	uint64_t em1_ns;
+	uint64_t em2_ns;
+	uint32_t sleep_count;
+	uint32_t hang_count;								/* Sleeps without a wake up source, the clock does not move */
+};
+
+extern struct stub_clock stub_clock;
+
+/**
+ * @brief This function returns the time of the CPU model in ticks of the LFXO, which the RTCC and the CRYOTIMER count.
+ * @param void
+ * @return Number of ticks.
+ */
+static inline uint64_t stub_clock_ticks(void)
+{
+	return (stub_clock.time_ns * STUB_CLOCK_TICKS_PER_S) / 1000000000ull;
+}
+
+
+/* Cycle counter of the core, every access through DWT polls it and costs stub_clock.poll_ns */
+typedef struct
+{
+	volatile uint32_t CTRL;
+	volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+	volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+DWT_Type *stub_dwt(void);
+extern CoreDebug_Type stub_core_debug;
+#define DWT										(stub_dwt())
+#define CoreDebug								(&stub_core_debug)
+#define CoreDebug_DEMCR_TRCENA_Msk				(0x1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk					(0x1UL << 0)
+
+typedef enum
+{
+	GPIO_EVEN_IRQn,
+	GPIO_ODD_IRQn,
+	LDMA_IRQn,
+	LEUART0_IRQn,
+	I2C0_IRQn,
+	USART1_IRQn,
+	RTCC_IRQn,
+	CRYOTIMER_IRQn
+} IRQn_Type;
+
+static inline void NVIC_EnableIRQ(IRQn_Type irq) { (void)irq; }
+static inline void NVIC_DisableIRQ(IRQn_Type irq) { (void)irq; }
+static inline void NVIC_ClearPendingIRQ(IRQn_Type irq) { (void)irq; }
+static inline void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) { (void)irq; (void)priority; }
+
+
+/* LDMA */
+typedef struct
+{
+	volatile uint32_t REQSEL;
+	volatile uint32_t CFG;
+	volatile uint32_t LOOP;
+	volatile uint32_t CTRL;
+	volatile uint32_t SRC;
+	volatile uint32_t DST;
+	volatile uint32_t LINK;
+} LDMA_CH_TypeDef;
+
+typedef struct
+{
+	volatile uint32_t CTRL;
+	volatile uint32_t STATUS;
+	volatile uint32_t CHEN;
+	volatile uint32_t CHDONE;
+	volatile uint32_t SWREQ;
+	volatile uint32_t LINKLOAD;
+	volatile uint32_t REQCLEAR;
+	volatile uint32_t IF;
+	volatile uint32_t IFS;
+	volatile uint32_t IFC;
+	volatile uint32_t IEN;
+	LDMA_CH_TypeDef CH[8];
+} LDMA_TypeDef;
+
+/* Descriptor in RAM, the fake LDMA follows the links, the tests are linked without PIE so addresses fit in 32 bits */
+typedef struct
+{
+	volatile uint32_t CTRL;
+	volatile void *SRC;
+	volatile void *DST;
+	volatile void *LINK;
+} DMA_DESCRIPTOR_TypeDef;
+
+extern LDMA_TypeDef stub_ldma;
+#define LDMA									(&stub_ldma)
+#define DMA_CHAN_COUNT							(8)
+
+#define LDMA_CH_CTRL_STRUCTTYPE_TRANSFER		(0x0UL)
+#define _LDMA_CH_CTRL_XFERCNT_SHIFT				(4)
+#define _LDMA_CH_CTRL_XFERCNT_MASK				(0x7FF0UL)
+#define LDMA_CH_CTRL_BLOCKSIZE_UNIT1			(0x0UL << 16)
+#define LDMA_CH_CTRL_DONEIFSEN					(0x1UL << 20)
+#define LDMA_CH_CTRL_REQMODE_BLOCK				(0x0UL << 21)
+#define LDMA_CH_CTRL_SRCINC_ONE					(0x1UL << 24)
+#define LDMA_CH_CTRL_SRCINC_NONE				(0x3UL << 24)
+#define LDMA_CH_CTRL_SIZE_BYTE					(0x0UL << 26)
+#define LDMA_CH_CTRL_DSTINC_ONE					(0x1UL << 28)
+#define LDMA_CH_CTRL_DSTINC_NONE				(0x3UL << 28)
+#define LDMA_CH_CTRL_SRCMODE_ABSOLUTE			(0x0UL << 30)
+#define LDMA_CH_CTRL_DSTMODE_ABSOLUTE			(0x0UL << 31)
+#define _LDMA_CH_LINK_LINKADDR_MASK				(0xFFFFFFFCUL)
+#define LDMA_CH_LINK_LINKMODE_ABSOLUTE			(0x0UL)
+#define LDMA_CH_LINK_LINK						(0x1UL << 1)
+#define _LDMA_CTRL_NUMFIXED_SHIFT				(24)
+#define _LDMA_CH_REQSEL_SOURCESEL_MASK			(0x3F0000UL)
+#define LDMA_CH_REQSEL_SOURCESEL_LEUART0		(0x10UL << 16)
+#define LDMA_CH_REQSEL_SIGSEL_LEUART0RXDATAV	(0x0UL)
+#define LDMA_CH_REQSEL_SOURCESEL_USART1			(0x0DUL << 16)
+#define _LDMA_CH_REQSEL_SIGSEL_MASK				(0xFUL)
+#define LDMA_CH_REQSEL_SIGSEL_USART1RXDATAV		(0x0UL)
+#define LDMA_CH_REQSEL_SIGSEL_USART1TXBL		(0x1UL)
+#define _LDMA_CH_CTRL_SRCINC_MASK				(0x3000000UL)
+#define _LDMA_CH_CTRL_DSTINC_MASK				(0x30000000UL)
+#define LDMA_IF_ERROR							(0x1UL << 31)
+#define LDMA_IEN_ERROR							(0x1UL << 31)
+
+
+/* LEUART */
+typedef struct
+{
+	volatile uint32_t CTRL;
+	volatile uint32_t CMD;
+	volatile uint32_t STATUS;
+	volatile uint32_t STARTFRAME;
+	volatile uint32_t SIGFRAME;
+	volatile uint32_t RXDATA;
+	volatile uint32_t TXDATA;
+	volatile uint32_t IF;
+	volatile uint32_t IFC;
+	volatile uint32_t IEN;
+	volatile uint32_t SYNCBUSY;
+	volatile uint32_t ROUTEPEN;
+	volatile uint32_t ROUTELOC0;
+} LEUART_TypeDef;
+
+extern LEUART_TypeDef stub_leuart0;
+#define LEUART0									(&stub_leuart0)
+
+#define LEUART_CTRL_SFUBRX						(0x1UL << 8)
+#define LEUART_CMD_RXBLOCKEN					(0x1UL << 4)
+#define LEUART_CMD_RXBLOCKDIS					(0x1UL << 5)
+#define LEUART_STATUS_RXBLOCK					(0x1UL << 2)
+#define LEUART_STATUS_RXDATAV					(0x1UL << 5)
+#define LEUART_IF_TXC							(0x1UL << 0)
+#define LEUART_IF_RXDATAV						(0x1UL << 2)
+#define LEUART_IF_RXOF							(0x1UL << 3)
+#define LEUART_IF_SIGF							(0x1UL << 10)
+#define LEUART_IFC_SIGF							LEUART_IF_SIGF
+#define LEUART_IEN_TXC							LEUART_IF_TXC
+#define LEUART_IEN_RXDATAV						LEUART_IF_RXDATAV
+#define LEUART_IEN_SIGF							LEUART_IF_SIGF
+#define LEUART_SYNCBUSY_CTRL					(0x1UL << 0)
+#define LEUART_SYNCBUSY_STARTFRAME				(0x1UL << 3)
+#define LEUART_SYNCBUSY_SIGFRAME				(0x1UL << 4)
+#define LEUART_ROUTEPEN_RXPEN					(0x1UL << 0)
+#define LEUART_ROUTEPEN_TXPEN					(0x1UL << 1)
+#define _LEUART_ROUTELOC0_TXLOC_MASK			(0x1F00UL)
+#define _LEUART_ROUTELOC0_RXLOC_MASK			(0x1FUL)
+#define LEUART_ROUTELOC0_TXLOC_LOC18			(18UL << 8)
+#define LEUART_ROUTELOC0_RXLOC_LOC18			(18UL << 0)
+
+
+#endif /* STUB_EM_DEVICE_H_ */
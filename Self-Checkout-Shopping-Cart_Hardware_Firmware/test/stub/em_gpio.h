@@ -0,0 +1,59 @@
+/*
+ * @file em_gpio.h
+ * @brief Host stand-in for emlib em_gpio.h. The output and input levels of the pins are kept in stub_gpio.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef STUB_EM_GPIO_H_
+#define STUB_EM_GPIO_H_
+
+#include "em_device.h"
+
+typedef enum
+{
+	gpioPortA,
+	gpioPortB,
+	gpioPortC,
+	gpioPortD,
+	gpioPortE,
+	gpioPortF
+} GPIO_Port_TypeDef;
+
+typedef enum
+{
+	gpioModeDisabled,
+	gpioModeInput,
+	gpioModeInputPull,
+	gpioModeInputPullFilter,
+	gpioModePushPull,
+	gpioModeWiredAnd,
+	gpioModeWiredAndPullUp
+} GPIO_Mode_TypeDef;
+
+struct stub_gpio
+{
+	uint32_t out[6];
+	uint32_t in[6];
+};
+
+extern struct stub_gpio stub_gpio;
+
+/* Implemented in stub.c, which wires some of the outputs to the device models, the MX25 chip select */
+void stub_gpio_output(GPIO_Port_TypeDef port, unsigned int pin, unsigned int level);
+
+static inline void GPIO_PinModeSet(GPIO_Port_TypeDef port, unsigned int pin, GPIO_Mode_TypeDef mode, unsigned int out)
+{
+	(void)mode;
+	stub_gpio_output(port, pin, out);
+}
+static inline void GPIO_PinOutSet(GPIO_Port_TypeDef port, unsigned int pin) { stub_gpio_output(port, pin, 1); }
+static inline void GPIO_PinOutClear(GPIO_Port_TypeDef port, unsigned int pin) { stub_gpio_output(port, pin, 0); }
+static inline unsigned int GPIO_PinInGet(GPIO_Port_TypeDef port, unsigned int pin) { return (stub_gpio.in[port] >> pin) & 1; }
+static inline unsigned int GPIO_PinOutGet(GPIO_Port_TypeDef port, unsigned int pin) { return (stub_gpio.out[port] >> pin) & 1; }
+
+
+#endif /* STUB_EM_GPIO_H_ */
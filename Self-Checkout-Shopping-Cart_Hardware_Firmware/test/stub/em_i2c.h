@@ -0,0 +1,103 @@
+/*
+ * @file em_i2c.h
+ * @brief Host stand-in for emlib em_i2c.h and the I2C registers of the device header. The bus behind I2C0 is run
+ * by the controller model of stub.c, with the NTAG model as the slave.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef STUB_EM_I2C_H_
+#define STUB_EM_I2C_H_
+
+#include "em_device.h"
+
+typedef struct
+{
+	volatile uint32_t CTRL;
+	volatile uint32_t CMD;
+	volatile uint32_t STATE;
+	volatile uint32_t STATUS;
+	volatile uint32_t CLKDIV;
+	volatile uint32_t RXDATA;
+	volatile uint32_t TXDATA;
+	volatile uint32_t IF;
+	volatile uint32_t IEN;
+	volatile uint32_t ROUTEPEN;
+	volatile uint32_t ROUTELOC0;
+} I2C_TypeDef;
+
+extern I2C_TypeDef stub_i2c0;
+#define I2C0									(&stub_i2c0)
+
+#define I2C_CTRL_EN								(0x1UL << 0)
+#define _I2C_CTRL_CLTO_MASK						(0x70000UL)
+#define I2C_CTRL_CLTO_1024PCC					(0x5UL << 16)
+#define I2C_CMD_START							(0x1UL << 0)
+#define I2C_CMD_STOP							(0x1UL << 1)
+#define I2C_CMD_ACK								(0x1UL << 2)
+#define I2C_CMD_NACK							(0x1UL << 3)
+#define I2C_CMD_CONT							(0x1UL << 4)
+#define I2C_CMD_ABORT							(0x1UL << 5)
+#define I2C_CMD_CLEARTX							(0x1UL << 6)
+#define I2C_CMD_CLEARPC							(0x1UL << 7)
+#define I2C_STATE_BUSY							(0x1UL << 0)
+#define I2C_STATE_MASTER						(0x1UL << 1)
+#define I2C_IF_RXDATAV							(0x1UL << 5)
+#define I2C_IF_ACK								(0x1UL << 6)
+#define I2C_IF_NACK								(0x1UL << 7)
+#define I2C_IF_MSTOP							(0x1UL << 8)
+#define I2C_IF_ARBLOST							(0x1UL << 9)
+#define I2C_IF_BUSERR							(0x1UL << 10)
+#define I2C_IF_CLTO								(0x1UL << 15)
+#define _I2C_IFC_MASK							(0x0007FFCFUL)
+#define I2C_IEN_RXDATAV							I2C_IF_RXDATAV
+#define I2C_IEN_ACK								I2C_IF_ACK
+#define I2C_IEN_NACK							I2C_IF_NACK
+#define I2C_IEN_MSTOP							I2C_IF_MSTOP
+#define I2C_IEN_ARBLOST							I2C_IF_ARBLOST
+#define I2C_IEN_BUSERR							I2C_IF_BUSERR
+#define I2C_IEN_CLTO							I2C_IF_CLTO
+#define I2C_ROUTEPEN_SDAPEN						(0x1UL << 0)
+#define I2C_ROUTEPEN_SCLPEN						(0x1UL << 1)
+#define _I2C_ROUTELOC0_SDALOC_MASK				(0x1FUL)
+#define _I2C_ROUTELOC0_SCLLOC_MASK				(0x1F00UL)
+#define I2C_ROUTELOC0_SDALOC_LOC16				(16UL << 0)
+#define I2C_ROUTELOC0_SCLLOC_LOC14				(14UL << 8)
+
+#define I2C_FREQ_STANDARD_MAX					(92000)
+
+typedef enum
+{
+	i2cClockHLRStandard,
+	i2cClockHLRAsymetric,
+	i2cClockHLRFast
+} I2C_ClockHLR_TypeDef;
+
+typedef struct
+{
+	bool enable;
+	bool master;
+	uint32_t refFreq;
+	uint32_t freq;
+	I2C_ClockHLR_TypeDef clhr;
+} I2C_Init_TypeDef;
+
+#define I2C_INIT_DEFAULT						{true, true, 0, I2C_FREQ_STANDARD_MAX, i2cClockHLRStandard}
+
+/* Implemented in stub.c, the bus clock of the model follows init->freq */
+void I2C_Init(I2C_TypeDef *i2c, const I2C_Init_TypeDef *init);
+
+static inline void I2C_Enable(I2C_TypeDef *i2c, bool enable)
+{
+	i2c->CTRL = enable ? (i2c->CTRL | I2C_CTRL_EN) : (i2c->CTRL & ~I2C_CTRL_EN);
+}
+static inline void I2C_IntClear(I2C_TypeDef *i2c, uint32_t flags) { i2c->IF &= ~flags; }
+static inline void I2C_IntEnable(I2C_TypeDef *i2c, uint32_t flags) { i2c->IEN |= flags; }
+static inline void I2C_IntDisable(I2C_TypeDef *i2c, uint32_t flags) { i2c->IEN &= ~flags; }
+static inline uint32_t I2C_IntGetEnabled(I2C_TypeDef *i2c) { return i2c->IF & i2c->IEN; }
+
+
+#endif /* STUB_EM_I2C_H_ */
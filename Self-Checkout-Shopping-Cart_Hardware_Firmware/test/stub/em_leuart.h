@@ -0,0 +1,37 @@
+/*
+ * @file em_leuart.h
+ * @brief Host stand-in for emlib em_leuart.h. Received bytes come from the scanner model of stub.c.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef STUB_EM_LEUART_H_
+#define STUB_EM_LEUART_H_
+
+#include "em_device.h"
+#include "em_gpio.h"
+
+typedef struct
+{
+	bool enable;
+	uint32_t baudrate;
+} LEUART_Init_TypeDef;
+
+#define LEUART_INIT_DEFAULT						{ true, 9600 }
+
+void LEUART_Init(LEUART_TypeDef *leuart, const LEUART_Init_TypeDef *init);
+void LEUART_Enable(LEUART_TypeDef *leuart, bool enable);
+void LEUART_RxDmaInEM2Enable(LEUART_TypeDef *leuart, bool enable);
+void LEUART_IntClear(LEUART_TypeDef *leuart, uint32_t flags);
+void LEUART_Tx(LEUART_TypeDef *leuart, uint8_t data);
+uint8_t LEUART_Rx(LEUART_TypeDef *leuart);
+
+static inline uint32_t LEUART_IntGet(LEUART_TypeDef *leuart) { return leuart->IF; }
+static inline void LEUART_IntEnable(LEUART_TypeDef *leuart, uint32_t flags) { leuart->IEN |= flags; }
+static inline void LEUART_IntDisable(LEUART_TypeDef *leuart, uint32_t flags) { leuart->IEN &= ~flags; }
+
+
+#endif /* STUB_EM_LEUART_H_ */
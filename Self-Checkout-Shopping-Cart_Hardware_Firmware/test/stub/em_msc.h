@@ -0,0 +1,31 @@
+/*
+ * @file em_msc.h
+ * @brief Host stand-in for emlib em_msc.h. The writes and erases go to the internal flash model of stub.c, which
+ * holds the region of the KV store.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef STUB_EM_MSC_H_
+#define STUB_EM_MSC_H_
+
+#include "em_device.h"
+
+typedef enum
+{
+	mscReturnOk = 0,
+	mscReturnInvalidAddr = -1,
+	mscReturnLocked = -2,
+	mscReturnTimeOut = -3,
+	mscReturnUnaligned = -4
+} MSC_Status_TypeDef;
+
+void MSC_Init(void);
+MSC_Status_TypeDef MSC_WriteWord(uint32_t *address, void const *data, uint32_t numBytes);
+MSC_Status_TypeDef MSC_ErasePage(uint32_t *startAddress);
+
+
+#endif /* STUB_EM_MSC_H_ */
@@ -0,0 +1,52 @@
+/*
+ * @file em_rtcc.h
+ * @brief Host stand-in for emlib em_rtcc.h. The counter is the simulated time of the tests, in ticks of 32768 Hz.
+ * Every read can move the time forward by stub_rtcc.step, so that a loop polling the counter sees time pass. With the
+ * CPU model of em_device.h running, the counter follows its clock instead. With stub_rtcc.time_ns set, it follows that
+ * clock in nanoseconds, as the clock of the MX25 model.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef STUB_EM_RTCC_H_
+#define STUB_EM_RTCC_H_
+
+#include "em_device.h"
+
+#define STUB_RTCC_FREQ							(32768)
+
+
+struct stub_rtcc
+{
+	uint32_t counter;
+	uint32_t step;
+	uint32_t read_count;
+	const uint64_t *time_ns;					/* Clock the counter follows when not NULL, cleared by stub_reset() */
+};
+
+extern struct stub_rtcc stub_rtcc;
+
+static inline uint32_t RTCC_CounterGet(void)
+{
+	uint32_t counter = stub_rtcc.counter;
+
+	stub_rtcc.read_count++;
+	if(stub_rtcc.time_ns != NULL)
+	{
+		return (uint32_t)((*stub_rtcc.time_ns * STUB_RTCC_FREQ) / 1000000000ull);
+	}
+	if(stub_clock.poll_ns != 0)
+	{
+		stub_clock.time_ns += stub_clock.poll_ns;
+		return (uint32_t)stub_clock_ticks();
+	}
+
+	stub_rtcc.counter += stub_rtcc.step;
+	return counter;
+}
+
+
+#endif /* STUB_EM_RTCC_H_ */
@@ -0,0 +1,75 @@
+/*
+ * @file em_usart.h
+ * @brief Host stand-in for emlib em_usart.h, synchronous mode only. USART1 is wired to the MX25 flash model of
+ * stub.c: every byte clocked out returns the byte the flash drives on MISO.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef STUB_EM_USART_H_
+#define STUB_EM_USART_H_
+
+#include "em_device.h"
+
+
+typedef struct
+{
+	volatile uint32_t CTRL;
+	volatile uint32_t CMD;
+	volatile uint32_t STATUS;
+	volatile uint32_t RXDATA;
+	volatile uint32_t TXDATA;
+	volatile uint32_t IF;
+	volatile uint32_t IFC;
+	volatile uint32_t IEN;
+	volatile uint32_t ROUTEPEN;
+	volatile uint32_t ROUTELOC0;
+} USART_TypeDef;
+
+extern USART_TypeDef stub_usart1;
+#define USART1									(&stub_usart1)
+
+#define USART_CMD_CLEARRX						(0x1UL << 10)
+#define USART_CMD_CLEARTX						(0x1UL << 11)
+#define USART_ROUTEPEN_RXPEN					(0x1UL << 0)
+#define USART_ROUTEPEN_TXPEN					(0x1UL << 1)
+#define USART_ROUTEPEN_CLKPEN					(0x1UL << 3)
+#define _USART_ROUTEPEN_RESETVALUE				(0x00000000UL)
+#define _USART_ROUTELOC0_RESETVALUE				(0x00000000UL)
+#define _USART_ROUTELOC0_RXLOC_SHIFT			(0)
+#define _USART_ROUTELOC0_TXLOC_SHIFT			(8)
+#define _USART_ROUTELOC0_CLKLOC_SHIFT			(24)
+#define _USART_ROUTELOC0_RXLOC_LOC11			(11UL)
+#define _USART_ROUTELOC0_TXLOC_LOC11			(11UL)
+#define _USART_ROUTELOC0_CLKLOC_LOC11			(11UL)
+
+typedef enum
+{
+	usartClockMode0,
+	usartClockMode1,
+	usartClockMode2,
+	usartClockMode3
+} USART_ClockMode_TypeDef;
+
+typedef struct
+{
+	bool enable;
+	uint32_t refFreq;
+	uint32_t baudrate;
+	bool master;
+	bool msbf;
+	USART_ClockMode_TypeDef clockMode;
+} USART_InitSync_TypeDef;
+
+#define USART_INITSYNC_DEFAULT					{ true, 0, 1000000, true, false, usartClockMode0 }
+
+void USART_InitSync(USART_TypeDef *usart, const USART_InitSync_TypeDef *init);
+void USART_BaudrateSyncSet(USART_TypeDef *usart, uint32_t refFreq, uint32_t baudrate);
+uint8_t USART_SpiTransfer(USART_TypeDef *usart, uint8_t data);
+void USART_Reset(USART_TypeDef *usart);
+
+
+#endif /* STUB_EM_USART_H_ */
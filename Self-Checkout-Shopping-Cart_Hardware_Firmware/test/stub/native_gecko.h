@@ -0,0 +1,117 @@
+/*
+ * @file native_gecko.h
+ * @brief Host stand-in for the BGAPI of the Bluetooth stack. The commands used by the firmware are recorded
+ * in stub_gecko so that the tests can check what was sent to the stack.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef STUB_NATIVE_GECKO_H_
+#define STUB_NATIVE_GECKO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/* Result codes of bg_errorcodes.h used by the firmware */
+enum stub_bg_error
+{
+	bg_err_success = 0,
+	bg_err_invalid_conn_handle = 0x0101,
+	bg_err_invalid_param = 0x0180,
+	bg_err_wrong_state = 0x0181,
+	bg_err_out_of_memory = 0x0182,
+	bg_err_att_invalid_handle = 0x0401,
+};
+
+
+struct gecko_msg_gatt_server_send_characteristic_notification_rsp_t
+{
+	uint16_t result;
+	uint16_t sent_len;
+};
+
+/* Modes of the LE GAP advertising */
+enum le_gap_discoverable_mode
+{
+	le_gap_non_discoverable = 0,
+	le_gap_limited_discoverable = 1,
+	le_gap_general_discoverable = 2,
+	le_gap_broadcast = 3,
+	le_gap_user_data = 4
+};
+
+enum le_gap_connectable_mode
+{
+	le_gap_non_connectable = 0,
+	le_gap_directed_connectable = 1,
+	le_gap_undirected_connectable = 2,
+	le_gap_connectable_scannable = 2,
+	le_gap_scannable_non_connectable = 3,
+	le_gap_connectable_non_scannable = 4
+};
+
+struct gecko_msg_le_gap_result_rsp_t
+{
+	uint16_t result;
+};
+
+#define STUB_GECKO_ADV_DATA_MAXSIZE				(31)
+
+struct gecko_msg_le_connection_set_timing_parameters_rsp_t
+{
+	uint16_t result;
+};
+
+
+struct stub_gecko
+{
+	/* External signals raised by the interrupt handlers, or-ed together */
+	uint32_t signals;
+	uint32_t signal_count;
+
+	/* Stack model of the notifications, returns the result of the command. Without it every notification is accepted */
+	uint16_t (*notify)(uint8_t connection, uint16_t characteristic, uint8_t size, const uint8_t *data);
+	uint32_t notify_count;
+
+	/* Advertising set, the timing and the data apply from the next start */
+	bool advertising;
+	uint32_t adv_interval_min;
+	uint32_t adv_interval_max;
+	uint8_t adv_discover;
+	uint8_t adv_connect;
+	uint8_t adv_data[2][STUB_GECKO_ADV_DATA_MAXSIZE];		/* Advertising packet and scan response */
+	uint8_t adv_data_size[2];
+	uint16_t adv_start_result;								/* Result of the starts, bg_err_success after stub_reset() */
+	uint32_t adv_start_count;
+	uint32_t adv_stop_count;
+
+	/* Last connection parameter request, the central answers with gecko_evt_le_connection_parameters_id or not at all */
+	uint16_t conn_interval_min;
+	uint16_t conn_interval_max;
+	uint16_t conn_latency;
+	uint16_t conn_timeout;
+	uint16_t conn_request_result;							/* Result of the requests, bg_err_success after stub_reset() */
+	uint32_t conn_request_count;
+};
+
+extern struct stub_gecko stub_gecko;
+
+void gecko_external_signal(uint32_t signals);
+struct gecko_msg_gatt_server_send_characteristic_notification_rsp_t* gecko_cmd_gatt_server_send_characteristic_notification(
+		uint8_t connection, uint16_t characteristic, uint8_t value_len, const uint8_t *value_data);
+struct gecko_msg_le_gap_result_rsp_t* gecko_cmd_le_gap_set_advertise_timing(uint8_t handle, uint32_t interval_min,
+		uint32_t interval_max, uint16_t duration, uint8_t maxevents);
+struct gecko_msg_le_gap_result_rsp_t* gecko_cmd_le_gap_bt5_set_adv_data(uint8_t handle, uint8_t scan_rsp, uint8_t adv_data_len,
+		const uint8_t *adv_data_data);
+struct gecko_msg_le_gap_result_rsp_t* gecko_cmd_le_gap_start_advertising(uint8_t handle, uint8_t discover, uint8_t connect);
+struct gecko_msg_le_gap_result_rsp_t* gecko_cmd_le_gap_stop_advertising(uint8_t handle);
+struct gecko_msg_le_connection_set_timing_parameters_rsp_t* gecko_cmd_le_connection_set_timing_parameters(uint8_t connection,
+		uint16_t min_interval, uint16_t max_interval, uint16_t latency, uint16_t timeout, uint16_t min_ce_length,
+		uint16_t max_ce_length);
+
+
+#endif /* STUB_NATIVE_GECKO_H_ */
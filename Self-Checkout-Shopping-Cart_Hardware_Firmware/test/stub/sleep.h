@@ -0,0 +1,40 @@
+/*
+ * @file sleep.h
+ * @brief Host stand-in for the SLEEP driver of the SDK. The blocks taken by the drivers are counted in stub_sleep,
+ * so that a test can check that every block is given back.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef STUB_SLEEP_H_
+#define STUB_SLEEP_H_
+
+#include "em_device.h"
+
+typedef enum
+{
+	sleepEM0,
+	sleepEM1,
+	sleepEM2,
+	sleepEM3,
+	sleepEM4
+} SLEEP_EnergyMode_t;
+
+struct stub_sleep
+{
+	int32_t block[5];
+};
+
+extern struct stub_sleep stub_sleep;
+
+static inline void SLEEP_SleepBlockBegin(SLEEP_EnergyMode_t mode) { stub_sleep.block[mode]++; }
+static inline void SLEEP_SleepBlockEnd(SLEEP_EnergyMode_t mode) { stub_sleep.block[mode]--; }
+
+/* Implemented in stub.c, EM2 unless it is blocked, until the CRYOTIMER wakes the CPU model up */
+SLEEP_EnergyMode_t SLEEP_Sleep(void);
+
+
+#endif /* STUB_SLEEP_H_ */
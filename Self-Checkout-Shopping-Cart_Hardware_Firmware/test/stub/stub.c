@@ -0,0 +1,1634 @@
+/*
+ * @file stub.c
+ * @brief Peripheral models behind the host stand-ins of the SDK headers.
+ *
+ * Register writes which have a side effect on the real hardware (CMD, IFC, LINKLOAD) are applied by
+ * stub_apply() before every modelled hardware step and after every interrupt handler.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <string.h>
+#include <ucontext.h>
+#include "stub.h"
+#include "em_rtcc.h"
+#include "inc/flash_spi.h"
+#include "inc/kv_store.h"
+#include "inc/cart_journal.h"
+#include "inc/catalog.h"
+
+
+LDMA_TypeDef stub_ldma;
+LEUART_TypeDef stub_leuart0;
+struct stub_gpio stub_gpio;
+struct stub_gecko stub_gecko;
+struct stub_leuart stub_leuart;
+struct stub_ldma stub_ldma_model;
+uint32_t stub_core_nesting;
+struct stub_rtcc stub_rtcc;
+USART_TypeDef stub_usart1;
+struct stub_sleep stub_sleep;
+struct stub_mx25 stub_mx25;
+struct stub_msc stub_msc;
+I2C_TypeDef stub_i2c0;
+struct stub_i2c stub_i2c;
+struct stub_ntag stub_ntag;
+struct stub_clock stub_clock;
+CoreDebug_Type stub_core_debug;
+CRYOTIMER_TypeDef stub_cryotimer;
+static DWT_Type stub_dwt_registers;
+static uint64_t stub_dwt_cycles;						/* Cycles of the CPU model at the last access */
+static uint64_t stub_cryotimer_start;					/* LFXO tick of the last enable */
+
+/* Stack of stub_run(), in the static RAM so that its addresses fit the 32 bit registers of the LDMA model */
+static uint8_t stub_stack[STUB_STACK_SIZE] __attribute__((aligned(16)));
+
+
+/* MX25 commands of the model, as in mx25flash_spi.h */
+enum stub_mx25_command
+{
+	STUB_MX25_CMD_PP = 0x02,
+	STUB_MX25_CMD_READ = 0x03,
+	STUB_MX25_CMD_WRDI = 0x04,
+	STUB_MX25_CMD_RDSR = 0x05,
+	STUB_MX25_CMD_WREN = 0x06,
+	STUB_MX25_CMD_SE = 0x20,
+	STUB_MX25_CMD_RDSCUR = 0x2B,
+	STUB_MX25_CMD_PGM_ERS_R = 0x30,
+	STUB_MX25_CMD_PGM_ERS_S = 0xB0,
+	STUB_MX25_CMD_DP = 0xB9,
+};
+
+#define STUB_MX25_STATUS_WIP					(0x01)
+#define STUB_MX25_STATUS_WEL					(0x02)
+
+
+/**
+ * @brief This function loads the descriptor linked by a channel into its registers.
+ * @param channel LDMA channel number.
+ * @param link Value of the LINK field, descriptor address and link bit.
+ * @return void
+ */
+static void stub_ldma_load(uint32_t channel, uint32_t link)
+{
+	const DMA_DESCRIPTOR_TypeDef *descriptor = (const DMA_DESCRIPTOR_TypeDef *)(uintptr_t)(link & _LDMA_CH_LINK_LINKADDR_MASK);
+	LDMA_CH_TypeDef *ch = &stub_ldma.CH[channel];
+
+	ch->CTRL = descriptor->CTRL;
+	ch->SRC = (uint32_t)(uintptr_t)descriptor->SRC;
+	ch->DST = (uint32_t)(uintptr_t)descriptor->DST;
+	ch->LINK = (uint32_t)(uintptr_t)descriptor->LINK;
+	stub_ldma_model.remaining[channel] = ((ch->CTRL & _LDMA_CH_CTRL_XFERCNT_MASK) >> _LDMA_CH_CTRL_XFERCNT_SHIFT) + 1;
+	stub_ldma.CHEN |= (1UL << channel);
+}
+
+
+/**
+ * @brief This function applies the register writes which have a side effect on the hardware.
+ * @param void
+ * @return void
+ */
+static void stub_apply(void)
+{
+	stub_ldma.IF |= stub_ldma.IFS;
+	stub_ldma.IF &= ~stub_ldma.IFC;
+	stub_ldma.IFS = 0;
+	stub_ldma.IFC = 0;
+	stub_ldma.REQCLEAR = 0;
+
+	for(uint32_t channel = 0; channel < 8; channel++)
+	{
+		if(stub_ldma.LINKLOAD & (1UL << channel))
+		{
+			stub_ldma_load(channel, stub_ldma.CH[channel].LINK);
+		}
+	}
+	stub_ldma.LINKLOAD = 0;
+
+	if(stub_leuart0.CMD & LEUART_CMD_RXBLOCKEN)
+	{
+		stub_leuart0.STATUS |= LEUART_STATUS_RXBLOCK;
+	}
+	if(stub_leuart0.CMD & LEUART_CMD_RXBLOCKDIS)
+	{
+		stub_leuart0.STATUS &= ~LEUART_STATUS_RXBLOCK;
+	}
+	stub_leuart0.CMD = 0;
+}
+
+
+/**
+ * @brief This function lets the enabled LDMA channels triggered by LEUART0 RXDATAV move the received bytes.
+ * @param void
+ * @return void
+ */
+static void stub_ldma_run(void)
+{
+	for(uint32_t channel = 0; channel < 8; channel++)
+	{
+		LDMA_CH_TypeDef *ch = &stub_ldma.CH[channel];
+
+		if(!(stub_ldma.CHEN & (1UL << channel)) || ((ch->REQSEL & _LDMA_CH_REQSEL_SOURCESEL_MASK) != LDMA_CH_REQSEL_SOURCESEL_LEUART0))
+		{
+			continue;
+		}
+
+		while((stub_ldma.CHEN & (1UL << channel)) && (stub_leuart0.STATUS & LEUART_STATUS_RXDATAV))
+		{
+			*(volatile uint8_t *)(uintptr_t)ch->DST = LEUART_Rx(LEUART0);
+			ch->DST++;
+			stub_ldma_model.transfer_count++;
+
+			if(--stub_ldma_model.remaining[channel] == 0)
+			{
+				if(ch->CTRL & LDMA_CH_CTRL_DONEIFSEN)
+				{
+					stub_ldma.IF |= (1UL << channel);
+				}
+
+				if(ch->LINK & LDMA_CH_LINK_LINK)
+				{
+					stub_ldma_load(channel, ch->LINK);
+				}
+				else
+				{
+					stub_ldma.CHEN &= ~(1UL << channel);
+				}
+			}
+		}
+	}
+}
+
+
+/**
+ * @brief This function checks if the power of the flash was cut.
+ * @param void
+ * @return true once the time of the cut is reached, the flash then stays off until stub_mx25_power_up().
+ */
+static bool stub_mx25_off(void)
+{
+	if((stub_mx25.cut_ns != 0) && (stub_mx25.time_ns >= stub_mx25.cut_ns))
+	{
+		stub_mx25.off = true;
+	}
+
+	return stub_mx25.off;
+}
+
+
+/**
+ * @brief This function finishes the program or erase of the flash once its time is over.
+ * @param void
+ * @return void
+ */
+static void stub_mx25_update(void)
+{
+	if(stub_mx25_off() || (stub_mx25.operation == 0) || stub_mx25.suspended || (stub_mx25.time_ns < stub_mx25.busy_until_ns))
+	{
+		return;
+	}
+
+	if(stub_mx25.operation == STUB_MX25_CMD_PP)
+	{
+		for(uint32_t i = 0; i < STUB_MX25_PAGE_SIZE; i++)
+		{
+			stub_mx25.memory[stub_mx25.operation_address + i] &= stub_mx25.page[i];
+		}
+	}
+	else
+	{
+		memset(&stub_mx25.memory[stub_mx25.operation_address], 0xFF, STUB_MX25_SECTOR_SIZE);
+	}
+
+	stub_mx25.operation = 0;
+	stub_mx25.write_enable = false;
+}
+
+
+/**
+ * @brief This function returns the status register of the flash.
+ * @param void
+ * @return Status register, WIP and WEL.
+ */
+static uint8_t stub_mx25_status(void)
+{
+	bool busy = (stub_mx25.operation != 0) && (!stub_mx25.suspended || (stub_mx25.time_ns < stub_mx25.suspend_ready_ns));
+
+	return (busy ? STUB_MX25_STATUS_WIP : 0) | (stub_mx25.write_enable ? STUB_MX25_STATUS_WEL : 0);
+}
+
+
+/**
+ * @brief This function clocks one byte through the flash.
+ * @param data Byte on MOSI.
+ * @return Byte on MISO, 0xFF when the flash does not drive it.
+ */
+static uint8_t stub_mx25_transfer(uint8_t data)
+{
+	stub_mx25_update();
+
+	if(!stub_mx25.selected || stub_mx25_off())
+	{
+		return 0xFF;
+	}
+
+	uint32_t index = stub_mx25.byte_count++;
+
+	/* Dummy clocks of the wake up sequences are 0xFF */
+	if(stub_mx25.deep_power_down || (stub_mx25.time_ns < stub_mx25.ready_time_ns))
+	{
+		if((index == 0) && (data != 0xFF))
+		{
+			stub_mx25.ignored_count++;
+		}
+		stub_mx25.command = 0xFF;
+		return 0xFF;
+	}
+
+	if(index == 0)
+	{
+		stub_mx25.command = data;
+		stub_mx25.address = 0;
+		stub_mx25.command_count++;
+		if(data == STUB_MX25_CMD_PP)
+		{
+			memset(stub_mx25.page, 0xFF, sizeof(stub_mx25.page));
+		}
+		return 0xFF;
+	}
+
+	switch(stub_mx25.command)
+	{
+		case STUB_MX25_CMD_RDSR:
+			return stub_mx25_status();
+
+		case STUB_MX25_CMD_RDSCUR:
+			return 0x00;									/* 3 byte addresses */
+
+		case STUB_MX25_CMD_READ:
+			if(index <= 3)
+			{
+				stub_mx25.address = ((stub_mx25.address << 8) | data) % STUB_MX25_SIZE;
+				return 0xFF;
+			}
+			if(stub_mx25_status() & STUB_MX25_STATUS_WIP)
+			{
+				stub_mx25.busy_read_count += (index == 4);
+				return 0xFF;
+			}
+			stub_mx25.read_byte_count++;
+			data = stub_mx25.memory[stub_mx25.address];
+			stub_mx25.address = (stub_mx25.address + 1) % STUB_MX25_SIZE;
+			return data;
+
+		case STUB_MX25_CMD_PP:
+		case STUB_MX25_CMD_SE:
+			if(index <= 3)
+			{
+				stub_mx25.address = ((stub_mx25.address << 8) | data) % STUB_MX25_SIZE;
+			}
+			else if(stub_mx25.command == STUB_MX25_CMD_PP)
+			{
+				/* The page buffer wraps, only the last page size bytes are kept */
+				stub_mx25.page[(stub_mx25.address + index - 4) % STUB_MX25_PAGE_SIZE] = data;
+			}
+			return 0xFF;
+
+		default:
+			return 0xFF;
+	}
+}
+
+
+/**
+ * @brief This function ends the command of the flash when the chip select goes high.
+ * @param void
+ * @return void
+ */
+static void stub_mx25_deselect(void)
+{
+	uint32_t bytes = stub_mx25.byte_count;
+
+	if(!stub_mx25.selected)
+	{
+		return;
+	}
+
+	stub_mx25_update();
+	stub_mx25.selected = false;
+	stub_mx25.byte_count = 0;
+
+	if(stub_mx25_off())
+	{
+		return;
+	}
+
+	/* A chip select pulse of tCRDP releases the deep power down */
+	if(stub_mx25.deep_power_down)
+	{
+		if((stub_mx25.time_ns - stub_mx25.select_time_ns) >= STUB_MX25_TCRDP_NS)
+		{
+			stub_mx25.deep_power_down = false;
+			stub_mx25.ready_time_ns = stub_mx25.time_ns + STUB_MX25_TRDP_NS;
+			stub_mx25.wake_count++;
+		}
+		return;
+	}
+
+	if((bytes == 0) || (stub_mx25.time_ns < stub_mx25.ready_time_ns))
+	{
+		return;
+	}
+
+	bool busy = (stub_mx25.operation != 0);
+
+	switch(stub_mx25.command)
+	{
+		case STUB_MX25_CMD_WREN:
+			stub_mx25.write_enable = !busy || stub_mx25.write_enable;
+			break;
+
+		case STUB_MX25_CMD_WRDI:
+			stub_mx25.write_enable = busy && stub_mx25.write_enable;
+			break;
+
+		case STUB_MX25_CMD_PP:
+		case STUB_MX25_CMD_SE:
+			if(!stub_mx25.write_enable || busy || (bytes < 4) || ((stub_mx25.command == STUB_MX25_CMD_SE) && (bytes != 4)))
+			{
+				break;
+			}
+			stub_mx25.operation = stub_mx25.command;
+			if(stub_mx25.command == STUB_MX25_CMD_PP)
+			{
+				stub_mx25.operation_address = stub_mx25.address & ~(STUB_MX25_PAGE_SIZE - 1);
+				stub_mx25.busy_until_ns = stub_mx25.time_ns + stub_mx25.program_ns;
+				stub_mx25.program_count++;
+			}
+			else
+			{
+				stub_mx25.operation_address = stub_mx25.address & ~(STUB_MX25_SECTOR_SIZE - 1);
+				stub_mx25.busy_until_ns = stub_mx25.time_ns + stub_mx25.erase_ns;
+				stub_mx25.erase_count++;
+			}
+			if((stub_mx25.cut_operation != 0) && ((stub_mx25.program_count + stub_mx25.erase_count) == stub_mx25.cut_operation))
+			{
+				stub_mx25.cut_ns = stub_mx25.time_ns + stub_mx25.cut_delay_ns;
+			}
+			break;
+
+		case STUB_MX25_CMD_PGM_ERS_S:
+			if(busy && !stub_mx25.suspended)
+			{
+				stub_mx25.suspended = true;
+				stub_mx25.suspend_ready_ns = stub_mx25.time_ns + stub_mx25.suspend_ns;
+				stub_mx25.suspend_remaining_ns = stub_mx25.busy_until_ns - stub_mx25.time_ns;
+				stub_mx25.suspend_count++;
+			}
+			break;
+
+		case STUB_MX25_CMD_PGM_ERS_R:
+			if(stub_mx25.suspended)
+			{
+				stub_mx25.suspended = false;
+				stub_mx25.busy_until_ns = stub_mx25.time_ns + stub_mx25.suspend_remaining_ns;
+			}
+			break;
+
+		case STUB_MX25_CMD_DP:
+			/* Not accepted while programming or erasing */
+			if(!busy && (bytes == 1))
+			{
+				stub_mx25.deep_power_down = true;
+				stub_mx25.sleep_count++;
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+/**
+ * @brief This function moves the bytes of the USART1 LDMA channels, a TX channel writing to the flash and an RX
+ * channel storing what it returns. A channel started by writing its registers takes the count of its CTRL.
+ * @param void
+ * @return void
+ */
+static void stub_usart_ldma_run(void)
+{
+	LDMA_CH_TypeDef *rx = NULL;
+	LDMA_CH_TypeDef *tx = NULL;
+	uint32_t rx_channel = 0;
+	uint32_t tx_channel = 0;
+
+	for(uint32_t channel = 0; channel < 8; channel++)
+	{
+		LDMA_CH_TypeDef *ch = &stub_ldma.CH[channel];
+
+		if(!(stub_ldma.CHEN & (1UL << channel)) || ((ch->REQSEL & _LDMA_CH_REQSEL_SOURCESEL_MASK) != LDMA_CH_REQSEL_SOURCESEL_USART1))
+		{
+			continue;
+		}
+
+		if(stub_ldma_model.remaining[channel] == 0)
+		{
+			stub_ldma_model.remaining[channel] = ((ch->CTRL & _LDMA_CH_CTRL_XFERCNT_MASK) >> _LDMA_CH_CTRL_XFERCNT_SHIFT) + 1;
+		}
+
+		if((ch->REQSEL & _LDMA_CH_REQSEL_SIGSEL_MASK) == LDMA_CH_REQSEL_SIGSEL_USART1TXBL)
+		{
+			tx = ch;
+			tx_channel = channel;
+		}
+		else
+		{
+			rx = ch;
+			rx_channel = channel;
+		}
+	}
+
+	if((rx == NULL) || (tx == NULL))
+	{
+		return;
+	}
+
+	while(stub_ldma_model.remaining[rx_channel] && stub_ldma_model.remaining[tx_channel])
+	{
+		uint8_t data = *(volatile uint8_t *)(uintptr_t)tx->SRC;
+
+		stub_mx25.time_ns += 8000000000ull / stub_mx25.baudrate;
+		stub_usart1.RXDATA = stub_mx25_transfer(data);
+		*(volatile uint8_t *)(uintptr_t)rx->DST = (uint8_t)stub_usart1.RXDATA;
+		tx->SRC += ((tx->CTRL & _LDMA_CH_CTRL_SRCINC_MASK) == LDMA_CH_CTRL_SRCINC_ONE);
+		rx->DST += ((rx->CTRL & _LDMA_CH_CTRL_DSTINC_MASK) == LDMA_CH_CTRL_DSTINC_ONE);
+		stub_ldma_model.remaining[rx_channel]--;
+		stub_ldma_model.remaining[tx_channel]--;
+		stub_mx25.ldma_byte_count++;
+	}
+
+	LDMA_CH_TypeDef *chs[2] = {rx, tx};
+	uint32_t channels[2] = {rx_channel, tx_channel};
+	for(uint32_t i = 0; i < 2; i++)
+	{
+		if(stub_ldma_model.remaining[channels[i]] == 0)
+		{
+			stub_ldma.CHEN &= ~(1UL << channels[i]);
+			if(chs[i]->CTRL & LDMA_CH_CTRL_DONEIFSEN)
+			{
+				stub_ldma.IF |= (1UL << channels[i]);
+			}
+		}
+	}
+}
+
+
+/* NTAG session registers the model acts upon */
+#define STUB_NTAG_REG_NS						(0x06)
+#define STUB_NTAG_NS_I2C_LOCKED					(0x40)
+#define STUB_NTAG_NS_NDEF_DATA_READ				(0x80)
+
+
+/**
+ * @brief This function powers the NTAG up, the session registers are loaded with their defaults and the memory is kept.
+ * @param void
+ * @return void
+ */
+void stub_ntag_power_up(void)
+{
+	static const uint8_t session[STUB_NTAG_SESSION_SIZE] = {0x01, 0x00, 0xF8, 0x48, 0x08, 0x01, 0x00, 0x00};
+
+	/* Everything but the memory */
+	memset((uint8_t *)&stub_ntag + sizeof(stub_ntag.memory), 0, sizeof(stub_ntag) - sizeof(stub_ntag.memory));
+	memcpy(stub_ntag.session, session, sizeof(session));
+	stub_ntag.reg = -1;
+}
+
+
+/**
+ * @brief This function checks if the address byte selects the NTAG.
+ * @param uint8_t byte Address byte, the read bit included
+ * @return true if the NTAG acknowledges it.
+ */
+static bool stub_ntag_address(uint8_t byte)
+{
+	if((byte & 0xFE) != STUB_NTAG_ADDRESS)
+	{
+		return false;
+	}
+
+	if(stub_i2c.time_ns < stub_ntag.busy_until_ns)
+	{
+		stub_ntag.busy_nack_count++;
+		return false;
+	}
+
+	/* A new START drops a write that was not ended by a STOP */
+	stub_ntag.count = 0;
+	stub_ntag.index = 0;
+	return true;
+}
+
+
+/**
+ * @brief This function gives the NTAG one byte written by the master.
+ * @param uint8_t byte The byte
+ * @return true if the NTAG acknowledges it, a MEMA outside the memory and bytes past the end of a block are not.
+ */
+static bool stub_ntag_write(uint8_t byte)
+{
+	uint8_t mema = (stub_ntag.count > 0) ? stub_ntag.buffer[0] : byte;
+	bool sram = ((mema >= STUB_NTAG_SRAM_BLOCK) && (mema < (STUB_NTAG_SRAM_BLOCK + STUB_NTAG_SRAM_BLOCKS)));
+
+	if((mema >= STUB_NTAG_EEPROM_BLOCKS) && !sram && (mema != STUB_NTAG_SESSION_MEMA))
+	{
+		return false;
+	}
+
+	if(stub_ntag.count >= ((mema == STUB_NTAG_SESSION_MEMA) ? 4 : (1 + STUB_NTAG_BLOCK_SIZE)))
+	{
+		return false;
+	}
+
+	stub_ntag.buffer[stub_ntag.count++] = byte;
+	return true;
+}
+
+
+/**
+ * @brief This function returns the next byte read by the master, from the block or session register the last
+ * write pointed at.
+ * @param void
+ * @return The byte.
+ */
+static uint8_t stub_ntag_read(void)
+{
+	uint8_t data;
+
+	if(stub_ntag.reg >= 0)
+	{
+		data = stub_ntag.session[stub_ntag.reg];
+		if(stub_ntag.reg == STUB_NTAG_REG_NS)
+		{
+			stub_ntag.session[STUB_NTAG_REG_NS] &= ~STUB_NTAG_NS_NDEF_DATA_READ;
+		}
+		return data;
+	}
+
+	if(stub_ntag.index == 0)
+	{
+		stub_ntag.block_read_count++;
+	}
+	if(stub_ntag.pointer >= STUB_NTAG_SRAM_BLOCK)
+	{
+		stub_ntag.session[STUB_NTAG_REG_NS] |= STUB_NTAG_NS_I2C_LOCKED;
+	}
+
+	data = stub_ntag.memory[stub_ntag.pointer][stub_ntag.index];
+	stub_ntag.index = (stub_ntag.index + 1) % STUB_NTAG_BLOCK_SIZE;
+	return data;
+}
+
+
+/**
+ * @brief This function ends a write to the NTAG on the STOP, a whole block or register write is taken.
+ * @param void
+ * @return void
+ */
+static void stub_ntag_stop(void)
+{
+	uint8_t mema = stub_ntag.buffer[0];
+	uint8_t count = stub_ntag.count;
+
+	stub_ntag.count = 0;
+	stub_ntag.index = 0;
+	if(count == 0)
+	{
+		return;
+	}
+
+	if(mema == STUB_NTAG_SESSION_MEMA)
+	{
+		uint8_t reg = stub_ntag.buffer[1] % STUB_NTAG_SESSION_SIZE;
+
+		if(count == 2)
+		{
+			stub_ntag.reg = reg;
+		}
+		else if(count == 4)
+		{
+			stub_ntag.session[reg] = (stub_ntag.session[reg] & ~stub_ntag.buffer[2]) | (stub_ntag.buffer[3] & stub_ntag.buffer[2]);
+			stub_ntag.register_write_count++;
+		}
+		else
+		{
+			stub_ntag.ignored_count++;
+		}
+		return;
+	}
+
+	if(count == 1)
+	{
+		stub_ntag.pointer = mema;
+		stub_ntag.reg = -1;
+	}
+	else if(count == (1 + STUB_NTAG_BLOCK_SIZE))
+	{
+		memcpy(stub_ntag.memory[mema], &stub_ntag.buffer[1], STUB_NTAG_BLOCK_SIZE);
+		stub_ntag.pointer = mema;
+		stub_ntag.reg = -1;
+
+		if(mema >= STUB_NTAG_SRAM_BLOCK)
+		{
+			stub_ntag.session[STUB_NTAG_REG_NS] |= STUB_NTAG_NS_I2C_LOCKED;
+			stub_ntag.sram_write_count++;
+		}
+		else
+		{
+			stub_ntag.busy_until_ns = stub_i2c.time_ns + STUB_NTAG_PROGRAM_NS;
+			stub_ntag.program_count++;
+		}
+	}
+	else
+	{
+		stub_ntag.ignored_count++;
+	}
+}
+
+
+void I2C_Init(I2C_TypeDef *i2c, const I2C_Init_TypeDef *init)
+{
+	stub_i2c.bit_ns = 1000000000ull / init->freq;
+	i2c->TXDATA = STUB_I2C_TXDATA_EMPTY;
+	I2C_Enable(i2c, init->enable);
+}
+
+
+/* Default handler of the tests that do not link i2c.c, as in the startup file */
+__attribute__((weak)) void I2C0_IRQHandler(void)
+{
+}
+
+
+/**
+ * @brief This function counts one byte on the bus and returns the fault injected on it.
+ * @param void
+ * @return The fault, STUB_I2C_FAULT_NONE for most bytes.
+ */
+static enum stub_i2c_fault stub_i2c_fault(void)
+{
+	stub_i2c.byte_count++;
+
+	if((stub_i2c.fault_byte == 0) || (--stub_i2c.fault_byte != 0))
+	{
+		return STUB_I2C_FAULT_NONE;
+	}
+
+	return stub_i2c.fault;
+}
+
+
+/**
+ * @brief This function ends a byte cut short by a fault, the master leaves the bus.
+ * @param enum stub_i2c_fault fault The fault
+ * @return void
+ */
+static void stub_i2c_lost(enum stub_i2c_fault fault)
+{
+	stub_i2c.owned = false;
+	stub_i2c.addressed = false;
+	stub_i2c.receive = false;
+
+	if(fault == STUB_I2C_FAULT_CLOCK_HELD)
+	{
+		stub_i2c.clock_held = true;
+		stub_i2c.time_ns += STUB_I2C_CLTO_NS;
+		stub_i2c0.IF |= I2C_IF_CLTO;
+	}
+	else
+	{
+		stub_i2c0.IF |= (fault == STUB_I2C_FAULT_ARBLOST) ? I2C_IF_ARBLOST : I2C_IF_BUSERR;
+	}
+}
+
+
+/**
+ * @brief This function plays one step of the bus from the latched commands and TXDATA.
+ * @param void
+ * @return false if there is nothing to do.
+ */
+static bool stub_i2c_step(void)
+{
+	bool tx = (stub_i2c0.TXDATA != STUB_I2C_TXDATA_EMPTY);
+	bool work = stub_i2c.start || stub_i2c.stop || stub_i2c.receive || (stub_i2c.rx_full && (stub_i2c.ack || stub_i2c.nack)) ||
+				(tx && stub_i2c.addressed && !stub_i2c.read);
+	enum stub_i2c_fault fault;
+	uint8_t data;
+
+	if(!work)
+	{
+		return false;
+	}
+
+	/* A slave holding SCL low stops everything until the clock low timeout */
+	if(stub_i2c.clock_held)
+	{
+		stub_i2c.start = false;
+		stub_i2c.stop = false;
+		stub_i2c.receive = false;
+		stub_i2c.time_ns += STUB_I2C_CLTO_NS;
+		stub_i2c0.IF |= I2C_IF_CLTO;
+		return true;
+	}
+
+	/* The received byte is acknowledged for the next one, or not acknowledged before the STOP. A STOP written over
+	   the NACK in CMD still ends the read with a NACK */
+	if(stub_i2c.rx_full && (stub_i2c.ack || stub_i2c.nack || stub_i2c.stop))
+	{
+		stub_i2c.rx_full = false;
+		stub_i2c.receive = stub_i2c.ack && !stub_i2c.nack;
+		stub_i2c.ack = false;
+		stub_i2c.nack = false;
+		return true;
+	}
+
+	if(stub_i2c.receive && !stub_i2c.rx_full)
+	{
+		stub_i2c.receive = false;
+		stub_i2c.time_ns += 9 * stub_i2c.bit_ns;
+		fault = stub_i2c_fault();
+		if((fault != STUB_I2C_FAULT_NONE) && (fault != STUB_I2C_FAULT_NACK))
+		{
+			stub_i2c_lost(fault);
+			return true;
+		}
+		stub_i2c0.RXDATA = stub_ntag_read();
+		stub_i2c.rx_full = true;
+		stub_i2c0.IF |= I2C_IF_RXDATAV;
+		return true;
+	}
+
+	if(stub_i2c.stop && !stub_i2c.rx_full)
+	{
+		stub_i2c.stop = false;
+		if(stub_i2c.owned)
+		{
+			stub_i2c.time_ns += stub_i2c.bit_ns;
+			if(stub_i2c.addressed && !stub_i2c.read)
+			{
+				stub_ntag_stop();
+			}
+			stub_i2c.owned = false;
+			stub_i2c.addressed = false;
+			stub_i2c.stop_count++;
+			stub_i2c0.IF |= I2C_IF_MSTOP;
+		}
+		return true;
+	}
+
+	if(stub_i2c.start && tx)
+	{
+		data = (uint8_t)stub_i2c0.TXDATA;
+		stub_i2c0.TXDATA = STUB_I2C_TXDATA_EMPTY;
+		stub_i2c.start = false;
+		stub_i2c.start_count++;
+		stub_i2c.time_ns += 10 * stub_i2c.bit_ns;
+
+		/* SDA held low by a slave, the START is seen as another master on the bus */
+		if(stub_i2c.sda_held_clocks > 0)
+		{
+			stub_i2c_lost(STUB_I2C_FAULT_ARBLOST);
+			return true;
+		}
+
+		stub_i2c.owned = true;
+		fault = stub_i2c_fault();
+		if((fault != STUB_I2C_FAULT_NONE) && (fault != STUB_I2C_FAULT_NACK))
+		{
+			stub_i2c_lost(fault);
+			return true;
+		}
+
+		stub_i2c.addressed = (fault == STUB_I2C_FAULT_NONE) && stub_ntag_address(data);
+		stub_i2c.read = (data & 0x01);
+		stub_i2c.receive = stub_i2c.addressed && stub_i2c.read;		/* The first byte is clocked in right away */
+		stub_i2c0.IF |= stub_i2c.addressed ? I2C_IF_ACK : I2C_IF_NACK;
+		return true;
+	}
+
+	if(tx && stub_i2c.owned && stub_i2c.addressed && !stub_i2c.read && !stub_i2c.start)
+	{
+		data = (uint8_t)stub_i2c0.TXDATA;
+		stub_i2c0.TXDATA = STUB_I2C_TXDATA_EMPTY;
+		stub_i2c.time_ns += 9 * stub_i2c.bit_ns;
+		fault = stub_i2c_fault();
+		if((fault != STUB_I2C_FAULT_NONE) && (fault != STUB_I2C_FAULT_NACK))
+		{
+			stub_i2c_lost(fault);
+			return true;
+		}
+
+		stub_i2c0.IF |= ((fault == STUB_I2C_FAULT_NONE) && stub_ntag_write(data)) ? I2C_IF_ACK : I2C_IF_NACK;
+		return true;
+	}
+
+	return false;
+}
+
+
+/**
+ * @brief This function latches the commands written to I2C0 and plays the bus until an enabled interrupt flag is set.
+ * @param void
+ * @return true if the I2C0 interrupt is pending.
+ */
+static bool stub_i2c_run(void)
+{
+	while(!(stub_i2c0.IF & stub_i2c0.IEN) && (stub_i2c0.CTRL & I2C_CTRL_EN))
+	{
+		uint32_t cmd = stub_i2c0.CMD;
+
+		stub_i2c0.CMD = 0;
+		if(cmd & I2C_CMD_ABORT)
+		{
+			stub_i2c.start = false;
+			stub_i2c.stop = false;
+			stub_i2c.ack = false;
+			stub_i2c.nack = false;
+			stub_i2c.owned = false;
+			stub_i2c.addressed = false;
+			stub_i2c.receive = false;
+			stub_i2c.rx_full = false;
+			stub_i2c.abort_count++;
+		}
+		stub_i2c.start |= ((cmd & I2C_CMD_START) != 0);
+		stub_i2c.stop |= ((cmd & I2C_CMD_STOP) != 0);
+		stub_i2c.ack |= ((cmd & I2C_CMD_ACK) != 0);
+		stub_i2c.nack |= ((cmd & I2C_CMD_NACK) != 0);
+
+		bool stepped = stub_i2c_step();
+
+		/* The bus stays busy after a fault until the master aborts */
+		stub_i2c0.STATE = stub_i2c.owned ? (I2C_STATE_BUSY | I2C_STATE_MASTER) :
+						  ((stub_i2c0.IF & (I2C_IF_ARBLOST | I2C_IF_BUSERR | I2C_IF_CLTO)) ? I2C_STATE_BUSY : 0);
+		if(!stepped)
+		{
+			break;
+		}
+	}
+
+	return ((stub_i2c0.IF & stub_i2c0.IEN) != 0);
+}
+
+
+/**
+ * @brief This function polls the cycle counter of the CPU model, the access costs stub_clock.poll_ns.
+ * @param void
+ * @return The DWT registers.
+ */
+DWT_Type *stub_dwt(void)
+{
+	uint64_t cycles;
+
+	stub_clock.time_ns += stub_clock.poll_ns;
+	cycles = ((stub_clock.time_ns / 1000000000ull) * stub_clock.core_hz) +
+			 (((stub_clock.time_ns % 1000000000ull) * stub_clock.core_hz) / 1000000000ull);
+
+	if((stub_dwt_registers.CTRL & DWT_CTRL_CYCCNTENA_Msk) && (stub_core_debug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk))
+	{
+		stub_dwt_registers.CYCCNT += (uint32_t)(cycles - stub_dwt_cycles);
+	}
+	stub_dwt_cycles = cycles;
+
+	return &stub_dwt_registers;
+}
+
+
+void CRYOTIMER_Init(const CRYOTIMER_Init_TypeDef *init)
+{
+	CRYOTIMER->PERIODSEL = init->period;
+	CRYOTIMER_Enable(init->enable);
+}
+
+
+void CRYOTIMER_Enable(bool enable)
+{
+	if(enable && !CRYOTIMER->EN)
+	{
+		stub_cryotimer_start = stub_clock_ticks();
+	}
+	CRYOTIMER->EN = enable;
+}
+
+
+/* Default handler of the tests that do not link timing.c, as in the startup file */
+__attribute__((weak)) void CRYOTIMER_IRQHandler(void)
+{
+}
+
+
+/**
+ * @brief This function sleeps until the end of the CRYOTIMER period, the only wake up source of the CPU model.
+ * The interrupt handler runs on the wake up.
+ * @param void
+ * @return The energy mode slept in, EM2 unless it is blocked.
+ */
+SLEEP_EnergyMode_t SLEEP_Sleep(void)
+{
+	SLEEP_EnergyMode_t mode = (stub_sleep.block[sleepEM2] > 0) ? sleepEM1 : sleepEM2;
+	uint64_t start = stub_clock.time_ns;
+
+	if(!CRYOTIMER->EN || !(CRYOTIMER->IEN & CRYOTIMER_IF_PERIOD))
+	{
+		stub_clock.hang_count++;
+		return mode;
+	}
+
+	/* First LFXO edge at or after the end of the period */
+	if(!(CRYOTIMER->IF & CRYOTIMER_IF_PERIOD))
+	{
+		uint64_t wakeup = (((stub_cryotimer_start + (1ull << CRYOTIMER->PERIODSEL)) * 1000000000ull) +
+						   STUB_CLOCK_TICKS_PER_S - 1) / STUB_CLOCK_TICKS_PER_S;
+
+		if(wakeup > stub_clock.time_ns)
+		{
+			stub_clock.time_ns = wakeup;
+		}
+		CRYOTIMER->IF |= CRYOTIMER_IF_PERIOD;
+	}
+
+	stub_clock.sleep_count++;
+	if(mode == sleepEM2)
+	{
+		stub_clock.em2_ns += stub_clock.time_ns - start;
+		stub_clock.time_ns += STUB_CLOCK_EM2_WAKEUP_NS;
+	}
+	else
+	{
+		stub_clock.em1_ns += stub_clock.time_ns - start;
+	}
+
+	stub_irq_dispatch();
+	return mode;
+}
+
+
+/**
+ * @brief This function resets all the peripheral models and the recorded stack commands. The MX25 flash is a
+ * separate chip, a reset of the MCU does not change it.
+ * @param void
+ * @return void
+ */
+void stub_reset(void)
+{
+	memset(&stub_ldma, 0, sizeof(stub_ldma));
+	memset(&stub_leuart0, 0, sizeof(stub_leuart0));
+	memset(&stub_gpio, 0, sizeof(stub_gpio));
+	memset(&stub_gecko, 0, sizeof(stub_gecko));
+	memset(&stub_leuart, 0, sizeof(stub_leuart));
+	memset(&stub_ldma_model, 0, sizeof(stub_ldma_model));
+	memset(&stub_rtcc, 0, sizeof(stub_rtcc));
+	memset(&stub_usart1, 0, sizeof(stub_usart1));
+	memset(&stub_sleep, 0, sizeof(stub_sleep));
+	memset(&stub_i2c0, 0, sizeof(stub_i2c0));
+	memset(&stub_i2c, 0, sizeof(stub_i2c));
+	stub_i2c0.TXDATA = STUB_I2C_TXDATA_EMPTY;
+	memset(&stub_clock, 0, sizeof(stub_clock));
+	memset(&stub_core_debug, 0, sizeof(stub_core_debug));
+	memset(&stub_cryotimer, 0, sizeof(stub_cryotimer));
+	memset(&stub_dwt_registers, 0, sizeof(stub_dwt_registers));
+	stub_dwt_cycles = 0;
+	stub_cryotimer_start = 0;
+	stub_core_nesting = 0;
+}
+
+
+/**
+ * @brief This function calls the interrupt handlers of the pending and enabled interrupts until none is left.
+ * @param void
+ * @return void
+ */
+void stub_irq_dispatch(void)
+{
+	bool pending = true;
+
+	while(pending)
+	{
+		pending = false;
+		stub_apply();
+		stub_usart_ldma_run();
+
+		if(stub_ldma.IF & stub_ldma.IEN)
+		{
+			uint32_t flags = stub_ldma.IF;
+
+			stub_ldma_model.irq_count++;
+			/* A plain register cannot keep two writes of IFC, the handler acknowledges the flags it read */
+			LDMA_IRQHandler();
+			if(stub_ldma.IFC)
+			{
+				stub_ldma.IFC |= flags;
+			}
+			pending = true;
+		}
+		else if(stub_leuart0.IF & stub_leuart0.IEN)
+		{
+			LEUART0_IRQHandler();
+			pending = true;
+		}
+		else if(stub_i2c_run())
+		{
+			stub_i2c.irq_count++;
+			I2C0_IRQHandler();
+			pending = true;
+		}
+		else if(stub_cryotimer.IF & stub_cryotimer.IEN)
+		{
+			CRYOTIMER_IRQHandler();
+			pending = true;
+		}
+
+		/* A late LDMA only moves the received bytes once the core left the interrupt handler */
+		if(stub_ldma_model.late)
+		{
+			stub_ldma_run();
+		}
+	}
+}
+
+
+/**
+ * @brief This function receives one byte on the LEUART0 RX line, lets the LDMA move it and runs the interrupt handlers.
+ * @note The receiver blocks and signal frame detection follow the hardware: a blocked receiver drops everything except
+ * the start frame when SFUBRX is set, and the signal frame is compared once the byte is in RXDATA.
+ * @param data Received byte.
+ * @return void
+ */
+void stub_leuart_receive(uint8_t data)
+{
+	/* Even a late LDMA has had a whole byte time, a channel started since the last byte moves what is still
+	   waiting in the receiver first */
+	stub_apply();
+	stub_ldma_run();
+
+	if(stub_leuart0.STATUS & LEUART_STATUS_RXBLOCK)
+	{
+		if(!((stub_leuart0.CTRL & LEUART_CTRL_SFUBRX) && (data == stub_leuart0.STARTFRAME)))
+		{
+			stub_leuart.blocked_count++;
+			return;
+		}
+		stub_leuart0.STATUS &= ~LEUART_STATUS_RXBLOCK;
+	}
+
+	if(stub_leuart.fifo_count == STUB_LEUART_FIFO_SIZE)
+	{
+		stub_leuart.overflow_count++;
+		stub_leuart0.IF |= LEUART_IF_RXOF;
+	}
+	else
+	{
+		stub_leuart.fifo[stub_leuart.fifo_count++] = data;
+		stub_leuart0.STATUS |= LEUART_STATUS_RXDATAV;
+		stub_leuart0.IF |= LEUART_IF_RXDATAV;
+
+		if(data == stub_leuart0.SIGFRAME)
+		{
+			stub_leuart0.IF |= LEUART_IF_SIGF;
+		}
+	}
+
+	if(!stub_ldma_model.late)
+	{
+		stub_ldma_run();
+	}
+	stub_irq_dispatch();
+	stub_ldma_run();
+}
+
+
+/**
+ * @brief This function receives a string on the LEUART0 RX line, one byte at a time.
+ * @param data NULL terminated string.
+ * @return void
+ */
+void stub_leuart_receive_string(const char *data)
+{
+	while(*data)
+	{
+		stub_leuart_receive((uint8_t)*data++);
+	}
+}
+
+
+/**
+ * @brief This function stops a channel on a bus error and raises the error interrupt.
+ * @param channel LDMA channel number.
+ * @return void
+ */
+void stub_ldma_error(uint32_t channel)
+{
+	stub_ldma.CHEN &= ~(1UL << channel);
+	stub_ldma.IF |= LDMA_IF_ERROR;
+	stub_irq_dispatch();
+}
+
+
+/**
+ * @brief This function stops a channel without any interrupt, the received bytes then stay in the LEUART.
+ * @param channel LDMA channel number.
+ * @return void
+ */
+void stub_ldma_halt(uint32_t channel)
+{
+	stub_ldma.CHEN &= ~(1UL << channel);
+}
+
+
+void LEUART_Init(LEUART_TypeDef *leuart, const LEUART_Init_TypeDef *init)
+{
+	(void)leuart;
+	(void)init;
+}
+
+
+void LEUART_Enable(LEUART_TypeDef *leuart, bool enable)
+{
+	(void)leuart;
+	(void)enable;
+}
+
+
+void LEUART_RxDmaInEM2Enable(LEUART_TypeDef *leuart, bool enable)
+{
+	(void)leuart;
+	(void)enable;
+}
+
+
+void LEUART_IntClear(LEUART_TypeDef *leuart, uint32_t flags)
+{
+	leuart->IF &= ~flags;
+}
+
+
+void LEUART_Tx(LEUART_TypeDef *leuart, uint8_t data)
+{
+	leuart->TXDATA = data;
+}
+
+
+uint8_t LEUART_Rx(LEUART_TypeDef *leuart)
+{
+	uint8_t data = 0;
+
+	if(stub_leuart.fifo_count)
+	{
+		data = stub_leuart.fifo[0];
+		memmove(&stub_leuart.fifo[0], &stub_leuart.fifo[1], --stub_leuart.fifo_count);
+	}
+
+	if(stub_leuart.fifo_count == 0)
+	{
+		leuart->STATUS &= ~LEUART_STATUS_RXDATAV;
+	}
+
+	leuart->RXDATA = data;
+	return data;
+}
+
+
+void gecko_external_signal(uint32_t signals)
+{
+	stub_gecko.signals |= signals;
+	stub_gecko.signal_count++;
+}
+
+
+struct gecko_msg_gatt_server_send_characteristic_notification_rsp_t* gecko_cmd_gatt_server_send_characteristic_notification(
+		uint8_t connection, uint16_t characteristic, uint8_t value_len, const uint8_t *value_data)
+{
+	static struct gecko_msg_gatt_server_send_characteristic_notification_rsp_t rsp;
+
+	stub_gecko.notify_count++;
+	rsp.result = stub_gecko.notify ? stub_gecko.notify(connection, characteristic, value_len, value_data) : bg_err_success;
+	rsp.sent_len = (rsp.result == bg_err_success) ? value_len : 0;
+	return &rsp;
+}
+
+
+struct gecko_msg_le_gap_result_rsp_t* gecko_cmd_le_gap_set_advertise_timing(uint8_t handle, uint32_t interval_min,
+		uint32_t interval_max, uint16_t duration, uint8_t maxevents)
+{
+	static struct gecko_msg_le_gap_result_rsp_t rsp;
+
+	(void)handle;
+	(void)duration;
+	(void)maxevents;
+	stub_gecko.adv_interval_min = interval_min;
+	stub_gecko.adv_interval_max = interval_max;
+	rsp.result = ((interval_min < 0x20) || (interval_max < interval_min)) ? bg_err_invalid_param : bg_err_success;
+	return &rsp;
+}
+
+
+struct gecko_msg_le_gap_result_rsp_t* gecko_cmd_le_gap_bt5_set_adv_data(uint8_t handle, uint8_t scan_rsp, uint8_t adv_data_len,
+		const uint8_t *adv_data_data)
+{
+	static struct gecko_msg_le_gap_result_rsp_t rsp;
+
+	(void)handle;
+	rsp.result = bg_err_invalid_param;
+	if((scan_rsp < 2) && (adv_data_len <= STUB_GECKO_ADV_DATA_MAXSIZE))
+	{
+		memcpy(stub_gecko.adv_data[scan_rsp], adv_data_data, adv_data_len);
+		stub_gecko.adv_data_size[scan_rsp] = adv_data_len;
+		rsp.result = bg_err_success;
+	}
+	return &rsp;
+}
+
+
+struct gecko_msg_le_gap_result_rsp_t* gecko_cmd_le_gap_start_advertising(uint8_t handle, uint8_t discover, uint8_t connect)
+{
+	static struct gecko_msg_le_gap_result_rsp_t rsp;
+
+	(void)handle;
+	stub_gecko.adv_start_count++;
+	rsp.result = stub_gecko.advertising ? bg_err_wrong_state : stub_gecko.adv_start_result;
+	if(rsp.result == bg_err_success)
+	{
+		stub_gecko.advertising = true;
+		stub_gecko.adv_discover = discover;
+		stub_gecko.adv_connect = connect;
+	}
+	return &rsp;
+}
+
+
+struct gecko_msg_le_gap_result_rsp_t* gecko_cmd_le_gap_stop_advertising(uint8_t handle)
+{
+	static struct gecko_msg_le_gap_result_rsp_t rsp;
+
+	(void)handle;
+	stub_gecko.adv_stop_count++;
+	stub_gecko.advertising = false;
+	rsp.result = bg_err_success;
+	return &rsp;
+}
+
+
+struct gecko_msg_le_connection_set_timing_parameters_rsp_t* gecko_cmd_le_connection_set_timing_parameters(uint8_t connection,
+		uint16_t min_interval, uint16_t max_interval, uint16_t latency, uint16_t timeout, uint16_t min_ce_length,
+		uint16_t max_ce_length)
+{
+	static struct gecko_msg_le_connection_set_timing_parameters_rsp_t rsp;
+
+	(void)connection;
+	(void)min_ce_length;
+	(void)max_ce_length;
+	stub_gecko.conn_request_count++;
+	rsp.result = stub_gecko.conn_request_result;
+	if(rsp.result == bg_err_success)
+	{
+		stub_gecko.conn_interval_min = min_interval;
+		stub_gecko.conn_interval_max = max_interval;
+		stub_gecko.conn_latency = latency;
+		stub_gecko.conn_timeout = timeout;
+	}
+	return &rsp;
+}
+
+
+/**
+ * @brief This function powers the flash up, the content of the memory is kept.
+ * @param deep_power_down true for a flash put in deep power down before the MCU reset, as initBoard() leaves it.
+ * @return void
+ */
+void stub_mx25_power_up(bool deep_power_down)
+{
+	uint64_t time_ns = stub_mx25.time_ns;
+	uint32_t baudrate = stub_mx25.baudrate;
+
+	/* A program or erase cut short is left half done, its bytes change in a scattered order */
+	if(stub_mx25.operation != 0)
+	{
+		bool program = (stub_mx25.operation == STUB_MX25_CMD_PP);
+		uint64_t cut_ns = stub_mx25.off ? stub_mx25.cut_ns : stub_mx25.time_ns;
+		uint64_t length_ns = program ? stub_mx25.program_ns : stub_mx25.erase_ns;
+		uint64_t remaining_ns = stub_mx25.suspended ? stub_mx25.suspend_remaining_ns :
+								((stub_mx25.busy_until_ns > cut_ns) ? (stub_mx25.busy_until_ns - cut_ns) : 0);
+		uint32_t size = program ? STUB_MX25_PAGE_SIZE : STUB_MX25_SECTOR_SIZE;
+		uint32_t done = size - (uint32_t)((size * ((remaining_ns < length_ns) ? remaining_ns : length_ns)) / length_ns);
+
+		for(uint32_t i = 0; i < size; i++)
+		{
+			/* An odd multiplier is a permutation of the offsets */
+			if(((i * 0x9E3779B1u) & (size - 1)) < done)
+			{
+				stub_mx25.memory[stub_mx25.operation_address + i] = program ?
+						(stub_mx25.memory[stub_mx25.operation_address + i] & stub_mx25.page[i]) : 0xFF;
+			}
+		}
+	}
+
+	/* Everything but the memory */
+	memset((uint8_t *)&stub_mx25 + sizeof(stub_mx25.memory), 0, sizeof(stub_mx25) - sizeof(stub_mx25.memory));
+	stub_mx25.time_ns = time_ns;
+	stub_mx25.baudrate = baudrate ? baudrate : 1000000;
+	stub_mx25.deep_power_down = deep_power_down;
+	stub_mx25.program_ns = STUB_MX25_PROGRAM_NS;
+	stub_mx25.erase_ns = STUB_MX25_ERASE_NS;
+	stub_mx25.suspend_ns = STUB_MX25_TESL_NS;
+}
+
+
+/**
+ * @brief This function erases the whole memory of the flash.
+ * @param void
+ * @return void
+ */
+void stub_mx25_format(void)
+{
+	memset(stub_mx25.memory, 0xFF, sizeof(stub_mx25.memory));
+}
+
+
+/**
+ * @brief This function erases the whole region of the internal flash model and clears its statistics.
+ * @param void
+ * @return void
+ */
+void stub_msc_format(void)
+{
+	memset(&stub_msc, 0, sizeof(stub_msc));
+	memset(stub_msc.memory, 0xFF, sizeof(stub_msc.memory));
+}
+
+
+/**
+ * @brief This function returns the next random bits of a power cut.
+ * @param void
+ * @return 32 random bits.
+ */
+static uint32_t stub_msc_random(void)
+{
+	stub_msc.cut_seed ^= stub_msc.cut_seed << 13;
+	stub_msc.cut_seed ^= stub_msc.cut_seed >> 17;
+	stub_msc.cut_seed ^= stub_msc.cut_seed << 5;
+	return stub_msc.cut_seed;
+}
+
+
+/**
+ * @brief This function counts a word write or page erase and checks if the power is cut during it.
+ * @param void
+ * @return true if the operation is the one of the cut.
+ */
+static bool stub_msc_cut(void)
+{
+	stub_msc.operation_count++;
+	if((stub_msc.cut_operation == 0) || (stub_msc.operation_count != stub_msc.cut_operation))
+	{
+		return false;
+	}
+
+	stub_msc.cut_operation = 0;
+	stub_msc.cut_seed |= 1;
+	return true;
+}
+
+
+/**
+ * @brief This function returns the index of a word of the model.
+ * @param uint32_t* address Address in the region
+ * @param uint32_t size Number of bytes from the address, that must fit in the region
+ * @return Index of the word, -1 if the address is outside the region.
+ */
+static int32_t stub_msc_index(const uint32_t *address, uint32_t size)
+{
+	uintptr_t offset = (uintptr_t)address - (uintptr_t)stub_msc.memory;
+
+	if(((uintptr_t)address < (uintptr_t)stub_msc.memory) || (offset + size > STUB_MSC_SIZE))
+	{
+		return -1;
+	}
+
+	return (int32_t)(offset / 4);
+}
+
+
+void MSC_Init(void)
+{
+}
+
+
+MSC_Status_TypeDef MSC_WriteWord(uint32_t *address, void const *data, uint32_t numBytes)
+{
+	int32_t index = stub_msc_index(address, numBytes);
+
+	if(index < 0)
+	{
+		stub_msc.invalid_count++;
+		return mscReturnInvalidAddr;
+	}
+	if((((uintptr_t)address | numBytes) & 3) != 0)
+	{
+		stub_msc.invalid_count++;
+		return mscReturnUnaligned;
+	}
+
+	for(uint32_t i = 0; i < numBytes / 4; i++, index++)
+	{
+		uint32_t word;
+
+		memcpy(&word, (const uint8_t *)data + (i * 4), 4);
+		stub_msc.time_ns += STUB_MSC_WORD_NS;
+		stub_msc.word_write_count++;
+		if(++stub_msc.write_count[index] > 2)
+		{
+			stub_msc.overwrite_count++;
+		}
+
+		/* Bits only go from 1 to 0, a write cut short clears some of them */
+		if(stub_msc_cut())
+		{
+			uint32_t clear = stub_msc.memory[index] & ~word;
+
+			stub_msc.memory[index] &= ~(clear & stub_msc_random());
+			longjmp(*stub_msc.cut_jump, 1);
+		}
+		stub_msc.memory[index] &= word;
+	}
+
+	return mscReturnOk;
+}
+
+
+MSC_Status_TypeDef MSC_ErasePage(uint32_t *startAddress)
+{
+	int32_t index = stub_msc_index(startAddress, FLASH_PAGE_SIZE);
+
+	if(index < 0)
+	{
+		stub_msc.invalid_count++;
+		return mscReturnInvalidAddr;
+	}
+	if((index % (FLASH_PAGE_SIZE / 4)) != 0)
+	{
+		stub_msc.invalid_count++;
+		return mscReturnUnaligned;
+	}
+
+	stub_msc.time_ns += STUB_MSC_ERASE_NS;
+	stub_msc.erase_count[index / (FLASH_PAGE_SIZE / 4)]++;
+	memset(&stub_msc.write_count[index], 0, FLASH_PAGE_SIZE / 4);
+
+	/* An erase cut short sets a random part of the bits of the page, a quarter, half or three quarters of them */
+	if(stub_msc_cut())
+	{
+		uint32_t part = stub_msc_random() % 3;
+
+		for(uint32_t i = 0; i < FLASH_PAGE_SIZE / 4; i++)
+		{
+			uint32_t bits = stub_msc_random();
+
+			bits = (part == 0) ? (bits & stub_msc_random()) : ((part == 2) ? (bits | stub_msc_random()) : bits);
+			stub_msc.memory[index + i] |= bits;
+		}
+		longjmp(*stub_msc.cut_jump, 1);
+	}
+	memset(&stub_msc.memory[index], 0xFF, FLASH_PAGE_SIZE);
+
+	return mscReturnOk;
+}
+
+
+void stub_gpio_output(GPIO_Port_TypeDef port, unsigned int pin, unsigned int level)
+{
+	bool was_set = (stub_gpio.out[port] >> pin) & 1;
+
+	stub_gpio.out[port] = (stub_gpio.out[port] & ~(1UL << pin)) | ((uint32_t)(level != 0) << pin);
+
+	/* Clocks of the bus recovery, with SCL not routed to I2C0 */
+	if((port == STUB_I2C_SCL_PORT) && (pin == STUB_I2C_SCL_PIN) && !was_set && level && (stub_i2c.sda_held_clocks > 0))
+	{
+		stub_i2c.sda_held_clocks--;
+	}
+
+	if((port == STUB_MX25_CS_PORT) && (pin == STUB_MX25_CS_PIN) && (was_set != (level != 0)))
+	{
+		if(level)
+		{
+			stub_mx25_deselect();
+		}
+		else
+		{
+			stub_mx25_update();
+			stub_mx25.selected = true;
+			stub_mx25.select_time_ns = stub_mx25.time_ns;
+			stub_mx25.byte_count = 0;
+		}
+	}
+}
+
+
+void USART_InitSync(USART_TypeDef *usart, const USART_InitSync_TypeDef *init)
+{
+	(void)usart;
+	stub_mx25.baudrate = init->baudrate;
+}
+
+
+void USART_BaudrateSyncSet(USART_TypeDef *usart, uint32_t refFreq, uint32_t baudrate)
+{
+	(void)usart;
+	(void)refFreq;
+	stub_mx25.baudrate = baudrate;
+}
+
+
+uint8_t USART_SpiTransfer(USART_TypeDef *usart, uint8_t data)
+{
+	uint64_t time_ns = (8000000000ull / stub_mx25.baudrate) + STUB_USART_SPI_OVERHEAD_NS;
+
+	stub_mx25.time_ns += time_ns;
+	stub_mx25.cpu_ns += time_ns;
+	usart->RXDATA = stub_mx25_transfer(data);
+	return (uint8_t)usart->RXDATA;
+}
+
+
+void USART_Reset(USART_TypeDef *usart)
+{
+	memset(usart, 0, sizeof(USART_TypeDef));
+}
+
+
+/**
+ * @brief This function runs a test on a stack below 4GB, like the RAM of the EFR32. The firmware points the LDMA at
+ * buffers on its stack, the host stack is too high for the 32 bit addresses of the descriptors.
+ * @param function The test
+ * @return void
+ */
+void stub_run(void (*function)(void))
+{
+	static ucontext_t caller;
+	static ucontext_t callee;
+
+	getcontext(&callee);
+	callee.uc_stack.ss_sp = stub_stack;
+	callee.uc_stack.ss_size = sizeof(stub_stack);
+	callee.uc_link = &caller;
+	makecontext(&callee, function, 0);
+	swapcontext(&caller, &callee);
+}
+
+
+/*
+ * Defaults of the flash backed modules and of the catalog for the tests that do not link them: no flash read in
+ * flight, a blank store, a journal that keeps nothing and an empty catalog. The tests that link the modules get
+ * theirs instead.
+ */
+__attribute__((weak)) void flash_spi_ldma_irq(uint32_t flags)
+{
+	(void)flags;
+}
+
+
+__attribute__((weak)) uint32_t kv_store_get_u32(enum kv_key key, uint32_t value)
+{
+	(void)key;
+	return value;
+}
+
+
+__attribute__((weak)) int kv_store_set_u32(enum kv_key key, uint32_t value)
+{
+	(void)key;
+	(void)value;
+	return 0;
+}
+
+
+__attribute__((weak)) void cart_journal_session(const struct cart_session_info* session)
+{
+	(void)session;
+}
+
+
+__attribute__((weak)) void cart_journal_item(const struct cart_item* item)
+{
+	(void)item;
+}
+
+
+__attribute__((weak)) int catalog_lookup(uint64_t code, struct catalog_record* record)
+{
+	(void)code;
+	(void)record;
+	return -1;
+}
@@ -0,0 +1,263 @@
+/*
+ * @file stub.h
+ * @brief Models of the peripherals behind the host stand-ins of the SDK headers. A test drives the hardware side
+ * through these functions, the interrupt handlers of the firmware are called synchronously from stub_irq_dispatch().
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef STUB_STUB_H_
+#define STUB_STUB_H_
+
+#include <setjmp.h>
+#include "em_device.h"
+#include "em_core.h"
+#include "em_leuart.h"
+#include "em_gpio.h"
+#include "em_usart.h"
+#include "em_msc.h"
+#include "em_i2c.h"
+#include "sleep.h"
+#include "em_cryotimer.h"
+#include "native_gecko.h"
+
+
+#define STUB_LEUART_FIFO_SIZE					(2)									/* RXDATA and the shift register */
+
+/* MX25R8035F on USART1, chip select on PA4 as in the board configuration */
+#define STUB_MX25_SIZE							(0x100000)
+#define STUB_MX25_PAGE_SIZE						(256)
+#define STUB_MX25_SECTOR_SIZE					(4096)
+#define STUB_MX25_CS_PORT						(gpioPortA)
+#define STUB_MX25_CS_PIN						(4)
+#define STUB_MX25_TCRDP_NS						(20000)								/* Chip select low to release deep power down */
+#define STUB_MX25_TRDP_NS						(35000)								/* Release of deep power down to the first command */
+#define STUB_MX25_TESL_NS						(20000)								/* Erase suspend latency */
+#define STUB_MX25_PROGRAM_NS					(850000)							/* Typical page program, 10ms at most */
+#define STUB_MX25_ERASE_NS						(40000000)							/* Typical sector erase, 240ms at most */
+/* Internal flash region of the KV store, __kvstoreBase and __kvstoreSize are given to the linker by the Makefile */
+#define STUB_MSC_PAGE_COUNT						(8)
+#define STUB_MSC_SIZE							(STUB_MSC_PAGE_COUNT * FLASH_PAGE_SIZE)
+#define STUB_MSC_WORD_NS						(20000)								/* Word write, 20us on the EFR32BG13 */
+#define STUB_MSC_ERASE_NS						(20000000)							/* Page erase, 20ms */
+/* NTAG I2C plus 1k on I2C0, SCL on PC10. It answers at the 8 bit address the firmware uses */
+#define STUB_I2C_SCL_PORT						(gpioPortC)
+#define STUB_I2C_SCL_PIN						(10)
+#define STUB_I2C_CLTO_NS						(1380000)							/* 1024 prescaled clocks, 8 per bit at 92kHz */
+#define STUB_NTAG_ADDRESS						(0x04)
+#define STUB_NTAG_BLOCK_SIZE					(16)
+#define STUB_NTAG_EEPROM_BLOCKS					(0x3B)								/* User memory and configuration of the 1k version */
+#define STUB_NTAG_SRAM_BLOCK					(0xF8)
+#define STUB_NTAG_SRAM_BLOCKS					(4)
+#define STUB_NTAG_SESSION_MEMA					(0xFE)
+#define STUB_NTAG_SESSION_SIZE					(8)
+#define STUB_NTAG_PROGRAM_NS					(4800000)							/* EEPROM programming of a block */
+#define STUB_STACK_SIZE							(256 * 1024)
+#define STUB_USART_SPI_OVERHEAD_NS				(800)								/* USART_SpiTransfer() waits for TXBL and TXC, about 30 cycles at 38.4MHz */
+
+
+/* Model of the LEUART0 receiver fed by the barcode scanner */
+struct stub_leuart
+{
+	uint8_t fifo[STUB_LEUART_FIFO_SIZE];
+	uint8_t fifo_count;
+
+	/* Bytes dropped by the receiver, while blocked or because the core did not read RXDATA in time */
+	uint32_t blocked_count;
+	uint32_t overflow_count;
+};
+
+/* Model of the LDMA, remaining transfers of the current descriptor of every channel */
+struct stub_ldma
+{
+	uint32_t remaining[8];
+	uint32_t transfer_count;
+
+	/* The LDMA is busy with another channel, the LEUART0 interrupt runs before the received byte is moved */
+	bool late;
+
+	uint32_t irq_count;
+};
+
+
+/* Model of the MX25 flash, the commands used by mx25flash_spi.c and flash_spi.c. Its time is the time of the SPI
+ * bus plus the waits of the firmware, which the tests add to time_ns. The flash is a separate chip, stub_reset()
+ * leaves it alone */
+struct stub_mx25
+{
+	uint8_t memory[STUB_MX25_SIZE];
+	uint64_t time_ns;
+	uint32_t baudrate;									/* SPI clock of USART1 */
+
+	/* Current command */
+	bool selected;
+	uint64_t select_time_ns;
+	uint8_t command;
+	uint32_t byte_count;
+	uint32_t address;
+	uint8_t page[STUB_MX25_PAGE_SIZE];					/* Bytes of a page program */
+
+	/* Deep power down, commands are ignored until tRDP after the release */
+	bool deep_power_down;
+	uint64_t ready_time_ns;
+
+	/* Program or erase, the memory changes once busy_until_ns is reached */
+	bool write_enable;
+	uint8_t operation;									/* Command of the page program or sector erase, 0 when idle */
+	uint32_t operation_address;
+	uint64_t busy_until_ns;
+	bool suspended;
+	uint64_t suspend_ready_ns;
+	uint64_t suspend_remaining_ns;
+	uint64_t program_ns;
+	uint64_t erase_ns;
+	uint64_t suspend_ns;
+
+	/* Power cut, the flash stops answering at cut_ns, or cut_delay_ns after the start of the program or erase number
+	 * cut_operation. 0 for none. A program or erase cut short is left half done by stub_mx25_power_up() */
+	uint64_t cut_ns;
+	uint32_t cut_operation;
+	uint64_t cut_delay_ns;
+	bool off;
+
+	/* Statistics */
+	uint32_t command_count;
+	uint32_t ignored_count;								/* Commands sent in deep power down or before tRDP */
+	uint32_t busy_read_count;							/* Reads while programming or erasing */
+	uint32_t read_byte_count;
+	uint32_t program_count;
+	uint32_t erase_count;
+	uint32_t suspend_count;
+	uint32_t sleep_count;
+	uint32_t wake_count;
+	uint32_t ldma_byte_count;
+	uint64_t cpu_ns;									/* Time the core spent in USART_SpiTransfer() */
+};
+
+/* Model of the internal flash behind em_msc.h. The CPU stalls during every write and erase, their time is added to
+ * time_ns. A word may be written twice between two erases, more writes are counted in overwrite_count */
+struct stub_msc
+{
+	uint32_t memory[STUB_MSC_SIZE / 4];					/* First member, __kvstoreBase points to it */
+	uint8_t write_count[STUB_MSC_SIZE / 4];				/* Writes of each word since its erase */
+	uint64_t time_ns;
+
+	/* Power cut at the word write or page erase number cut_operation, 0 for none. The operation is left half
+	 * done, a random part of its bits changed, and the model jumps to cut_jump as the core loses its power */
+	uint32_t operation_count;
+	uint32_t cut_operation;
+	uint32_t cut_seed;
+	jmp_buf *cut_jump;
+
+	/* Statistics */
+	uint32_t erase_count[STUB_MSC_PAGE_COUNT];
+	uint32_t word_write_count;
+	uint32_t overwrite_count;
+	uint32_t invalid_count;								/* Calls outside the region or not aligned */
+};
+
+/* Faults of the I2C bus, injected on a chosen byte */
+enum stub_i2c_fault
+{
+	STUB_I2C_FAULT_NONE,
+	STUB_I2C_FAULT_NACK,								/* The slave does not acknowledge the byte */
+	STUB_I2C_FAULT_ARBLOST,								/* Another master wins the bus */
+	STUB_I2C_FAULT_BUSERR,								/* START or STOP in the middle of the byte */
+	STUB_I2C_FAULT_CLOCK_HELD,							/* The slave holds SCL low until the test lets it go */
+	STUB_I2C_FAULT_COUNT
+};
+
+/* Model of the I2C0 master and its bus. The commands written to CMD are latched and played one bus step at a time
+ * from stub_irq_dispatch(), a step ends with an interrupt flag. TXDATA reads STUB_I2C_TXDATA_EMPTY until the
+ * firmware writes a byte. Its time is the time of the bus, which the tests may also move forward */
+#define STUB_I2C_TXDATA_EMPTY					(0xFFFFFFFFUL)
+
+struct stub_i2c
+{
+	uint64_t time_ns;
+	uint64_t bit_ns;
+
+	/* Latched commands and the state of the bus */
+	bool start;
+	bool stop;
+	bool ack;
+	bool nack;
+	bool owned;											/* Between the START and the STOP of the master */
+	bool addressed;										/* The slave acknowledged its address */
+	bool read;
+	bool receive;										/* The master clocks the next byte in */
+	bool rx_full;										/* RXDATA holds a byte the master has not acknowledged yet */
+
+	/* Fault on the byte number fault_byte from now, 0 for none */
+	enum stub_i2c_fault fault;
+	uint32_t fault_byte;
+	bool clock_held;
+	uint8_t sda_held_clocks;							/* A slave left in the middle of a byte holds SDA for up to 9 clocks */
+
+	/* Statistics */
+	uint32_t byte_count;
+	uint32_t start_count;
+	uint32_t stop_count;
+	uint32_t abort_count;
+	uint32_t irq_count;
+};
+
+/* Model of the NTAG I2C plus, the I2C side. A block write of MEMA and 16 bytes is taken at the STOP, the EEPROM
+ * then programs for STUB_NTAG_PROGRAM_NS and the address is not acknowledged until it is done. The SRAM and the
+ * session registers are written at once. Any other write only sets the block or register the next read returns.
+ * The chip is separate, stub_reset() leaves it alone */
+struct stub_ntag
+{
+	uint8_t memory[256][STUB_NTAG_BLOCK_SIZE];			/* Blocks by MEMA, EEPROM and SRAM */
+	uint8_t session[STUB_NTAG_SESSION_SIZE];
+	uint64_t busy_until_ns;
+
+	/* Current transfer */
+	uint8_t buffer[4 + STUB_NTAG_BLOCK_SIZE];
+	uint8_t count;
+	uint8_t pointer;									/* Block of the next read */
+	int16_t reg;										/* Session register of the next read, -1 for a block */
+	uint8_t index;
+
+	/* Statistics */
+	uint32_t program_count;
+	uint32_t sram_write_count;
+	uint32_t register_write_count;
+	uint32_t busy_nack_count;							/* Addresses not acknowledged while programming */
+	uint32_t block_read_count;
+	uint32_t ignored_count;								/* Writes of an unknown length, dropped at the STOP */
+};
+
+extern struct stub_leuart stub_leuart;
+extern struct stub_ldma stub_ldma_model;
+extern struct stub_mx25 stub_mx25;
+extern struct stub_msc stub_msc;
+extern struct stub_i2c stub_i2c;
+extern struct stub_ntag stub_ntag;
+
+
+/* Function Declarations */
+void stub_reset(void);
+void stub_irq_dispatch(void);
+void stub_leuart_receive(uint8_t data);
+void stub_leuart_receive_string(const char *data);
+void stub_ldma_error(uint32_t channel);
+void stub_ldma_halt(uint32_t channel);
+void stub_mx25_power_up(bool deep_power_down);
+void stub_mx25_format(void);
+void stub_msc_format(void);
+void stub_ntag_power_up(void);
+void stub_run(void (*function)(void));
+
+/* Interrupt handlers of the firmware, the tests link the ones of the modules they use. I2C0_IRQHandler() and
+ * CRYOTIMER_IRQHandler() have a weak default in stub.c, as in the startup file */
+void LDMA_IRQHandler(void);
+void LEUART0_IRQHandler(void);
+void I2C0_IRQHandler(void);
+void CRYOTIMER_IRQHandler(void);
+
+
+#endif /* STUB_STUB_H_ */
@@ -0,0 +1,96 @@
+/*
+ * @file test.h
+ * @brief Assertions and helpers shared by the host tests of the shopping cart firmware.
+ *
+ * A failed check prints the file, line and expression and the test carries on, test_exit() returns the
+ * number of failed checks as the exit status of the test program. The results go to stderr, stdout is left
+ * to the printf of the firmware.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+
+static unsigned long test_checks;
+static unsigned long test_failures;
+
+
+#define CHECK(cond)																				\
+	do																							\
+	{																							\
+		test_checks++;																			\
+		if(!(cond))																				\
+		{																						\
+			test_failures++;																	\
+			fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond);						\
+		}																						\
+	} while(0)
+
+#define CHECK_EQ(a, b)																			\
+	do																							\
+	{																							\
+		long long check_a = (long long)(a);														\
+		long long check_b = (long long)(b);														\
+		test_checks++;																			\
+		if(check_a != check_b)																	\
+		{																						\
+			test_failures++;																	\
+			fprintf(stderr, "%s:%d: CHECK_EQ failed: %s == %s (%lld != %lld)\n", __FILE__, __LINE__,		\
+					#a, #b, check_a, check_b);													\
+		}																						\
+	} while(0)
+
+
+/**
+ * @brief This function returns a monotonic time stamp for the benchmarks.
+ * @param void
+ * @return Time in nanoseconds
+ */
+static inline uint64_t test_clock_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ull) + (uint64_t)now.tv_nsec;
+}
+
+
+/**
+ * @brief This function returns the next value of a xorshift32 generator, the tests replay the same random sequence on every run.
+ * @param state Generator state, must not be 0.
+ * @return Pseudo random value
+ */
+static inline uint32_t test_rand(uint32_t *state)
+{
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+
+/**
+ * @brief This function prints the test summary.
+ * @param name Name of the test program.
+ * @return Number of failed checks, used as the exit status
+ */
+static inline int test_exit(const char *name)
+{
+	fprintf(stderr, "%s: %lu checks, %lu failed\n", name, test_checks, test_failures);
+	return (test_failures != 0);
+}
+
+
+#endif /* TEST_H_ */
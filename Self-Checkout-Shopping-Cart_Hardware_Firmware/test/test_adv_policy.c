@@ -0,0 +1,222 @@
+/*
+ * @file test_adv_policy.c
+ * @brief Host tests of the advertising policy of adv_policy.c on the advertising set of native_gecko.h.
+ *
+ * The event loop arms the soft timer with the ticks adv_policy_start() and adv_policy_step() return and stops it on
+ * 0. The tests do the same on the RTCC counter of em_rtcc.h: the counter moves by the ticks of the timer before each
+ * step. After a tap the cart advertises at 20 ms for 2 s, then the interval doubles every 2 s, 40, 80, 160, 320,
+ * 640 ms, up to 1 s where the timer stops. ndef.c builds the scan response from the token the phone read.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "stub.h"
+#include "em_rtcc.h"
+#include "inc/adv_policy.h"
+#include "inc/connection_param.h"
+#include "inc/ndef.h"
+
+
+#define TEST_RTCC_FREQ							(32768)
+#define TEST_STEP_TICKS							(2 * TEST_RTCC_FREQ)				/* 2 s of the burst and of each step */
+#define TEST_INTERVAL_US(interval)				((uint32_t)(interval) * 625)
+
+
+/* Advertising intervals of the schedule in ms, from the tap */
+static const uint32_t schedule_ms[] = {20, 40, 80, 160, 320, 640, 1000};
+static const uint8_t address[NDEF_BLE_ADDRESS_SIZE] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+static const uint8_t token[NDEF_TOKEN_SIZE] = {0x00, 0xC0, 0xFF, 0xEE, 0xE1, 0xE2, 0xE3, 0xE4};
+
+
+/* Fakes of timing.c, i2c.c is linked for ndef.c and does not run */
+void timing_wait_us(uint32_t us)
+{
+	stub_i2c.time_ns += (uint64_t)us * 1000;
+	stub_irq_dispatch();
+}
+
+
+void timing_wait_ms(uint32_t ms)
+{
+	timing_wait_us(ms * 1000);
+}
+
+
+/* The other interrupts of the models are not used */
+void LDMA_IRQHandler(void)
+{
+}
+
+
+void LEUART0_IRQHandler(void)
+{
+}
+
+
+/**
+ * @brief This function resets the advertising set and the policy, with the token of the tag in ndef_tag.
+ * @param uint32_t counter RTCC counter at the start
+ * @return void
+ */
+static void test_power_up(uint32_t counter)
+{
+	stub_reset();
+	stub_rtcc.counter = counter;
+	memset(&adv_policy, 0, sizeof(struct adv_policy));
+	memset(&ndef_tag, 0, sizeof(struct ndef_tag));
+	memcpy(ndef_tag.address, address, NDEF_BLE_ADDRESS_SIZE);
+	memcpy(ndef_tag.token, token, NDEF_TOKEN_SIZE);
+}
+
+
+/**
+ * @brief This function checks that the advertising set runs at one interval of the schedule.
+ * @param uint32_t ms Interval of the schedule
+ * @return void
+ */
+static void test_check_interval(uint32_t ms)
+{
+	CHECK(stub_gecko.advertising);
+	CHECK(adv_policy.advertising);
+	CHECK_EQ(TEST_INTERVAL_US(adv_policy.interval), ms * 1000);
+	CHECK_EQ(stub_gecko.adv_interval_min, adv_policy.interval);
+	CHECK_EQ(stub_gecko.adv_interval_max, adv_policy.interval);
+	CHECK_EQ(stub_gecko.adv_discover, le_gap_user_data);
+	CHECK_EQ(stub_gecko.adv_connect, le_gap_connectable_scannable);
+}
+
+
+/**
+ * @brief The burst at 20 ms for 2 s, then the interval doubles every 2 s to 1 s, where the timer stops and the
+ * interval stays.
+ */
+static void test_schedule(void)
+{
+	uint8_t scan_response[NDEF_SCAN_RESPONSE_MAXSIZE];
+	uint8_t size;
+	uint32_t tap = 1000;
+	uint32_t ticks;
+	uint8_t n;
+
+	test_power_up(tap);
+	ticks = adv_policy_start(tap);
+	CHECK_EQ(ticks, TEST_STEP_TICKS);
+	CHECK_EQ(adv_policy.interval, ADV_BURST_INTERVAL);
+	test_check_interval(schedule_ms[0]);
+
+	/* Flags in the advertising packet, the token in the scan response */
+	CHECK_EQ(stub_gecko.adv_data_size[0], 3);
+	CHECK_EQ(stub_gecko.adv_data[0][0], 0x02);
+	CHECK_EQ(stub_gecko.adv_data[0][1], 0x01);
+	CHECK_EQ(stub_gecko.adv_data[0][2], 0x06);
+	size = ndef_scan_response_build(scan_response);
+	CHECK_EQ(stub_gecko.adv_data_size[1], size);
+	CHECK(memcmp(stub_gecko.adv_data[1], scan_response, size) == 0);
+
+	for(n = 1; n < sizeof(schedule_ms) / sizeof(schedule_ms[0]); n++)
+	{
+		stub_rtcc.counter += ticks;
+		ticks = adv_policy_step();
+		test_check_interval(schedule_ms[n]);
+		CHECK_EQ(stub_rtcc.counter - tap, n * TEST_STEP_TICKS);
+		CHECK_EQ(ticks, (n < sizeof(schedule_ms) / sizeof(schedule_ms[0]) - 1) ? TEST_STEP_TICKS : 0);
+	}
+
+	/* At ADV_INTERVAL_MAX, 12 s after the tap, the timer stops and a late step changes nothing */
+	CHECK_EQ(adv_policy.interval, ADV_INTERVAL_MAX);
+	CHECK_EQ(adv_policy.step_count, 6);
+	CHECK_EQ(stub_gecko.adv_start_count, 7);
+	CHECK_EQ(stub_gecko.adv_stop_count, 6);
+	CHECK_EQ(adv_policy_step(), 0);
+	CHECK_EQ(adv_policy.step_count, 6);
+	CHECK_EQ(stub_gecko.adv_start_count, 7);
+	test_check_interval(1000);
+
+	/* The window of the tap is over without a connection */
+	adv_policy_stop();
+	CHECK(!stub_gecko.advertising);
+	CHECK(!adv_policy.advertising);
+	CHECK_EQ(adv_policy.timeout_count, 1);
+	CHECK_EQ(adv_policy.connect_count, 0);
+	CHECK_EQ(adv_policy_step(), 0);
+	CHECK_EQ(stub_gecko.adv_start_count, 7);
+}
+
+
+/**
+ * @brief A tap in the backoff starts the burst again, and a connection stops the schedule and records the tap to
+ * connection time.
+ */
+static void test_connect(void)
+{
+	uint32_t ticks;
+
+	test_power_up((uint32_t)(0 - (2 * TEST_STEP_TICKS) - 100));
+	ticks = adv_policy_start(stub_rtcc.counter);
+	stub_rtcc.counter += ticks;
+	ticks = adv_policy_step();
+	stub_rtcc.counter += ticks;
+	CHECK_EQ(adv_policy_step(), TEST_STEP_TICKS);
+	test_check_interval(80);
+
+	/* The second tap, the counter wraps before the connection */
+	CHECK_EQ(adv_policy_start(stub_rtcc.counter), TEST_STEP_TICKS);
+	test_check_interval(20);
+	CHECK_EQ(adv_policy.start_count, 2);
+	stub_rtcc.counter += TEST_RTCC_FREQ * 3 / 8;
+	CHECK(stub_rtcc.counter < adv_policy.tap_timestamp);
+
+	/* The stack stops advertising when the connection opens */
+	stub_gecko.advertising = false;
+	adv_policy_connected();
+	CHECK(!adv_policy.advertising);
+	CHECK_EQ(adv_policy.connect_count, 1);
+	CHECK_EQ(adv_policy.connect_ms_last, 375);
+	CHECK_EQ(adv_policy.connect_ms_max, 375);
+	CHECK_EQ(adv_policy.connect_ms_total, 375);
+	CHECK_EQ(adv_policy_step(), 0);
+	CHECK_EQ(stub_gecko.adv_start_count, 4);
+
+	/* The window of the tap ends after the connection, it is not a timeout */
+	adv_policy_stop();
+	CHECK_EQ(adv_policy.timeout_count, 0);
+}
+
+
+/**
+ * @brief A start the stack refuses leaves the policy not advertising and stops the timer at the first step.
+ */
+static void test_start_fails(void)
+{
+	test_power_up(0);
+	stub_gecko.adv_start_result = bg_err_out_of_memory;
+	CHECK_EQ(adv_policy_start(0), TEST_STEP_TICKS);
+	CHECK(!adv_policy.advertising);
+	CHECK(!stub_gecko.advertising);
+
+	stub_rtcc.counter += TEST_STEP_TICKS;
+	CHECK_EQ(adv_policy_step(), 0);
+	CHECK_EQ(adv_policy.step_count, 0);
+	CHECK_EQ(stub_gecko.adv_start_count, 1);
+
+	/* The next tap starts the burst */
+	stub_gecko.adv_start_result = bg_err_success;
+	CHECK_EQ(adv_policy_start(stub_rtcc.counter), TEST_STEP_TICKS);
+	test_check_interval(20);
+}
+
+
+int main(void)
+{
+	test_schedule();
+	test_connect();
+	test_start_fails();
+
+	return test_exit("test_adv_policy");
+}
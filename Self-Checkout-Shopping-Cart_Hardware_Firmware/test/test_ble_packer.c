@@ -0,0 +1,316 @@
+/*
+ * @file test_ble_packer.c
+ * @brief Host round-trip test of the notification packer.
+ *
+ * Random items, from no name up to the largest barcode payload, are queued in scan_queue and packed by ble_packer_fill()
+ * at every ATT MTU from the default to the largest requested. A client model checks the notification header, appends
+ * the bodies in sequence order and decodes the stream with cart_codec_decode(): every item must come back once, in
+ * order and unchanged. A second pass loses notifications on the way, the client must drop the cut records, resume
+ * at the next record boundary and still decode the items it gets in order.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "stub/stub.h"
+#include "inc/ble_packer.h"
+#include "inc/barcode.h"
+#include "inc/payload_pool.h"
+#include "inc/scan_queue.h"
+#include "inc/cart_session.h"
+
+
+#define TEST_ITEM_COUNT							(20000)
+#define TEST_NAME_MAXSIZE						(BARCODE_PAYLOAD_MAXSIZE)
+#define TEST_STREAM_SIZE						(4 * BARCODE_PAYLOAD_MAXSIZE)
+#define TEST_EXPECTED_SIZE						(64)								/* Power of two, more than the items queued at once */
+
+
+/* Items queued and not yet decoded by the client, oldest first */
+struct test_expected
+{
+	struct cart_item item;
+	char name[TEST_NAME_MAXSIZE];
+};
+
+static struct test_expected expected[TEST_EXPECTED_SIZE];
+static uint32_t expected_head;
+static uint32_t expected_tail;
+
+/* Client model */
+static uint8_t stream[TEST_STREAM_SIZE];
+static uint16_t stream_size;
+static uint8_t next_sequence;
+static bool synced;
+static uint32_t decoded_count;
+static uint32_t skipped_count;
+
+
+/**
+ * @brief This function queues a random item, as the cart session resends them.
+ * @param seed Random generator state.
+ * @return true if the item was queued, false if the queue or the payload pool is full.
+ */
+static bool test_queue_item(uint32_t *seed)
+{
+	struct test_expected *entry = &expected[expected_tail & (TEST_EXPECTED_SIZE - 1)];
+	uint32_t shape = test_rand(seed) % 16;
+
+	/* Mostly short names, a few as big as the scanner allows */
+	uint16_t name_size = (shape < 12) ? (test_rand(seed) % 40) : (shape < 15) ? (test_rand(seed) % 200) : (test_rand(seed) % (TEST_NAME_MAXSIZE + 1));
+	for(uint16_t i = 0; i < name_size; i++)
+	{
+		entry->name[i] = (char)(' ' + (test_rand(seed) % 95));
+	}
+
+	entry->item.product_id = test_rand(seed) >> (test_rand(seed) % 32);
+	entry->item.price = test_rand(seed) >> (test_rand(seed) % 32);
+	entry->item.quantity = 1 + (test_rand(seed) % 3);
+	entry->item.flags = CART_ITEM_FLAG_NAME | ((shape & 1) ? CART_ITEM_FLAG_SEQUENCE : 0) | ((shape & 2) ? CART_ITEM_FLAG_REMOVED : 0);
+	entry->item.sequence = (shape & 1) ? test_rand(seed) : 0;
+	entry->item.name = entry->name;
+	entry->item.name_size = name_size;
+
+	if(scan_queue_push_item(&entry->item))
+	{
+		expected_tail++;
+		return true;
+	}
+	return false;
+}
+
+
+/**
+ * @brief This function decodes the complete records at the start of the client stream.
+ * Records cut by a lost notification are never in the stream, so every record must be the next expected item
+ * or one of the items lost with it.
+ * @param void
+ * @return void
+ */
+static void test_client_decode(void)
+{
+	struct cart_record record;
+	int32_t size;
+
+	while((size = cart_codec_decode(stream, stream_size, &record)) > 0)
+	{
+		CHECK_EQ(record.type, CART_TLV_ITEM);
+
+		/* Items lost with the dropped notifications are skipped */
+		while(expected_head != expected_tail)
+		{
+			const struct cart_item *item = &expected[expected_head & (TEST_EXPECTED_SIZE - 1)].item;
+
+			expected_head++;
+			if((item->product_id == record.item.product_id) && (item->name_size == record.item.name_size) &&
+					(memcmp(item->name, record.item.name, item->name_size) == 0))
+			{
+				CHECK_EQ(record.item.price, item->price);
+				CHECK_EQ(record.item.quantity, item->quantity);
+				CHECK_EQ(record.item.flags, item->flags);
+				CHECK_EQ(record.item.sequence, item->sequence);
+				decoded_count++;
+				break;
+			}
+			skipped_count++;
+		}
+
+		memmove(stream, &stream[size], stream_size - size);
+		stream_size -= size;
+	}
+}
+
+
+/**
+ * @brief This function hands one notification to the client model.
+ * @param notification The notification.
+ * @param size Size of the notification.
+ * @param mtu ATT MTU of the connection.
+ * @return void
+ */
+static void test_client_receive(const uint8_t *notification, uint16_t size, uint16_t mtu)
+{
+	uint8_t flags = notification[1] & 0x0f;
+
+	CHECK(size > BLE_PACKER_HEADER_SIZE);
+	CHECK(size <= (mtu - BLE_ATT_HEADER_SIZE));
+	CHECK_EQ(notification[1] >> BLE_PACKER_VERSION_SHIFT, CART_CODEC_VERSION);
+
+	/* A gap in the sequence numbers, the partial record is lost */
+	if(notification[0] != next_sequence)
+	{
+		synced = false;
+		stream_size = 0;
+	}
+	next_sequence = notification[0] + 1;
+
+	/* The client cannot find the end of a record it did not see the start of, it waits for a body starting on a record */
+	if(!synced)
+	{
+		if(flags & BLE_PACKER_FLAG_CONTINUED)
+		{
+			return;
+		}
+		synced = true;
+	}
+	else
+	{
+		CHECK_EQ(!!(flags & BLE_PACKER_FLAG_CONTINUED), stream_size != 0);
+	}
+
+	CHECK(stream_size + size - BLE_PACKER_HEADER_SIZE <= TEST_STREAM_SIZE);
+	memcpy(&stream[stream_size], &notification[BLE_PACKER_HEADER_SIZE], size - BLE_PACKER_HEADER_SIZE);
+	stream_size += size - BLE_PACKER_HEADER_SIZE;
+
+	test_client_decode();
+
+	/* Only a record continued in the next notification may be left over */
+	CHECK_EQ(!!(flags & BLE_PACKER_FLAG_MORE), stream_size != 0);
+}
+
+
+/**
+ * @brief This function sends TEST_ITEM_COUNT items over a connection with the given MTU.
+ * @param mtu ATT MTU of the connection.
+ * @param loss_per_mille Notifications lost on the way, per thousand.
+ * @return void
+ */
+static void test_round_trip(uint16_t mtu, uint32_t loss_per_mille)
+{
+	uint8_t notification[BLE_PACKER_NOTIFICATION_MAXSIZE];
+	uint32_t seed = 0x9ac4e7 + mtu;
+	uint32_t queued = 0;
+	uint32_t lost = 0;
+	uint16_t size;
+
+	payload_pool_init();
+	scan_queue_init();
+	ble_packer_init(&ble_packer);
+	ble_packer_set_mtu(&ble_packer, mtu);
+	expected_head = expected_tail = 0;
+	stream_size = 0;
+	next_sequence = 0;
+	synced = true;
+	decoded_count = 0;
+	skipped_count = 0;
+
+	while(queued < TEST_ITEM_COUNT)
+	{
+		/* A random number of scans between two connection events */
+		uint32_t burst = 1 + (test_rand(&seed) % SCAN_QUEUE_SIZE);
+		while((burst-- > 0) && (queued < TEST_ITEM_COUNT) && test_queue_item(&seed))
+		{
+			queued++;
+		}
+
+		/* Up to four notifications per connection event */
+		for(uint32_t i = test_rand(&seed) % 5; (i > 0) && ((size = ble_packer_fill(&ble_packer, notification)) > 0); i--)
+		{
+			if((test_rand(&seed) % 1000) < loss_per_mille)
+			{
+				lost++;
+				continue;
+			}
+			test_client_receive(notification, size, mtu);
+		}
+	}
+
+	while((size = ble_packer_fill(&ble_packer, notification)) > 0)
+	{
+		test_client_receive(notification, size, mtu);
+	}
+
+	CHECK_EQ(scan_queue_count(), 0);
+	CHECK_EQ(ble_packer.record_offset, 0);
+	CHECK_EQ(ble_packer.item_count, queued);
+	CHECK_EQ(stream_size, 0);
+	if(loss_per_mille == 0)
+	{
+		CHECK_EQ(decoded_count, queued);
+		CHECK_EQ(skipped_count, 0);
+	}
+	else
+	{
+		CHECK(lost > 0);
+		CHECK(decoded_count + skipped_count <= queued);
+		/* At the default MTU most items span several notifications, one loss costs the items up to the next record boundary */
+		CHECK(decoded_count > queued / 4);
+	}
+
+	fprintf(stderr, "MTU %3u, %2lu/1000 lost: %lu items in %lu notifications, %.2f items per notification, max %lu, "
+			"%lu fragments, %lu decoded\n", mtu, (unsigned long)loss_per_mille, (unsigned long)queued,
+			(unsigned long)ble_packer.notification_count, (double)queued / ble_packer.notification_count,
+			(unsigned long)ble_packer.items_max, (unsigned long)ble_packer.fragment_count, (unsigned long)decoded_count);
+}
+
+
+/**
+ * @brief This function checks a record sent on its own, such as the bill, between the packed items.
+ * @param void
+ * @return void
+ */
+static void test_wrap(void)
+{
+	uint8_t notification[BLE_PACKER_NOTIFICATION_MAXSIZE];
+	uint8_t record[CART_BILL_MAXSIZE];
+	struct cart_bill bill = {.total = 123456789, .item_count = 512};
+	struct cart_record decoded;
+	uint8_t record_size = cart_codec_bill_encode(record, &bill);
+
+	payload_pool_init();
+	scan_queue_init();
+	ble_packer_init(&ble_packer);
+
+	uint16_t size = ble_packer_wrap(&ble_packer, notification, record, record_size);
+	CHECK_EQ(size, record_size + BLE_PACKER_HEADER_SIZE);
+	CHECK_EQ(notification[0], 0);
+	CHECK_EQ(notification[1], CART_CODEC_VERSION << BLE_PACKER_VERSION_SHIFT);
+	CHECK_EQ(cart_codec_decode(&notification[BLE_PACKER_HEADER_SIZE], size - BLE_PACKER_HEADER_SIZE, &decoded), record_size);
+	CHECK_EQ(decoded.type, CART_TLV_BILL);
+	CHECK_EQ(decoded.bill.total, bill.total);
+	CHECK_EQ(decoded.bill.item_count, bill.item_count);
+
+	/* Not while an item is only partly sent, the bill would land in the middle of it */
+	struct cart_item item = {.product_id = 1, .price = 100, .quantity = 1, .flags = CART_ITEM_FLAG_NAME, .name = "0123456789abcdefghijklmnopqrstuvwxyz", .name_size = 36};
+	CHECK(scan_queue_push_item(&item));
+	CHECK(ble_packer_fill(&ble_packer, notification) > 0);
+	CHECK(ble_packer.record_offset != 0);
+	CHECK_EQ(ble_packer_wrap(&ble_packer, notification, record, record_size), 0);
+
+	/* Nor when it does not fit the MTU */
+	ble_packer_init(&ble_packer);
+	uint8_t big[BLE_ATT_MTU_DEFAULT];
+	memset(big, 0, sizeof(big));
+	CHECK_EQ(ble_packer_wrap(&ble_packer, notification, big, BLE_ATT_MTU_DEFAULT - BLE_ATT_HEADER_SIZE - BLE_PACKER_HEADER_SIZE + 1), 0);
+	CHECK(ble_packer_wrap(&ble_packer, notification, big, BLE_ATT_MTU_DEFAULT - BLE_ATT_HEADER_SIZE - BLE_PACKER_HEADER_SIZE) > 0);
+}
+
+
+int main(void)
+{
+	static const uint16_t mtu[] = {BLE_ATT_MTU_DEFAULT, 24, 27, 50, 100, 185, 244, BLE_ATT_MTU_MAX};
+
+	stub_reset();
+	cart_session_init();
+
+	for(uint32_t i = 0; i < (sizeof(mtu) / sizeof(mtu[0])); i++)
+	{
+		test_round_trip(mtu[i], 0);
+	}
+	test_round_trip(BLE_ATT_MTU_DEFAULT, 20);
+	test_round_trip(BLE_ATT_MTU_MAX, 20);
+	test_wrap();
+
+	/* Out of range MTUs are clamped */
+	ble_packer_set_mtu(&ble_packer, 10);
+	CHECK_EQ(ble_packer.mtu, BLE_ATT_MTU_DEFAULT);
+	ble_packer_set_mtu(&ble_packer, 512);
+	CHECK_EQ(ble_packer.mtu, BLE_ATT_MTU_MAX);
+
+	return test_exit("test_ble_packer");
+}
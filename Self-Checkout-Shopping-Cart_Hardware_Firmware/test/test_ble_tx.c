@@ -0,0 +1,425 @@
+/*
+ * @file test_ble_tx.c
+ * @brief Host test of the transmit queue against a bluetooth stack model that refuses notifications at random.
+ *
+ * Scans go through scan_queue, ble_packer and ble_tx as in the event loop of main.c. The stack model takes or refuses
+ * every notification at random, with runs of thousands of bg_err_out_of_memory in a row, and the client turns the item
+ * stream off for thousands of connection intervals. The retry timer only runs while the stack is out of buffers, a
+ * disabled item stream is resumed by the write of the client configuration.
+ * The client model decodes the accepted notifications: every scan must arrive once and in order, the full queues
+ * must hold the parser back through scan_queue.stalled instead of dropping anything. A notification rejected
+ * with a hard error is the only one dropped, and the disconnect flushes what is left.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "stub/stub.h"
+#include "inc/ble_tx.h"
+#include "inc/ble_packer.h"
+#include "inc/payload_pool.h"
+#include "inc/scan_queue.h"
+#include "inc/cart_session.h"
+
+
+#define TEST_SCAN_COUNT							(50000)
+#define TEST_CONNECTION							(1)
+#define TEST_CHARACTERISTIC						(21)
+
+
+/* Stack model */
+static uint32_t seed;
+static uint16_t refuse_result;					/* Result returned for the current run of refusals */
+static uint32_t refuse_left;					/* Refusals left in the current run */
+static uint16_t hard_error;						/* Returned once for the next notification when not bg_err_success */
+static uint32_t disabled_left;					/* Connection intervals before the client enables the item stream again */
+static bool retry_armed;						/* SOFT_TIMER_BLE_TX_RETRY of main.c */
+static uint32_t disabled_submits;				/* Submissions while the item stream was disabled */
+static bool client_connected;					/* The accepted notifications are decoded by the client model */
+
+/* Scanner and client models */
+static uint32_t scan_next;						/* Product id of the next scan */
+static uint32_t scan_waiting;					/* Scans received and held back by the full scan queue, the model does not bound them */
+static uint32_t scan_waiting_max;
+static uint8_t stream[2 * BLE_PACKER_NOTIFICATION_MAXSIZE + BARCODE_PAYLOAD_MAXSIZE];
+static uint16_t stream_size;
+static uint8_t next_sequence;
+static uint32_t next_expected;					/* Product id of the next scan the client must decode */
+
+
+/**
+ * @brief This function decodes one notification accepted by the stack, as the client does.
+ * @param data The notification.
+ * @param size Size of the notification.
+ * @return void
+ */
+static void test_client_receive(const uint8_t *data, uint8_t size)
+{
+	struct cart_record record;
+	int32_t used;
+
+	CHECK_EQ(data[0], next_sequence);
+	next_sequence = data[0] + 1;
+	CHECK_EQ(!!(data[1] & BLE_PACKER_FLAG_CONTINUED), stream_size != 0);
+
+	memcpy(&stream[stream_size], &data[BLE_PACKER_HEADER_SIZE], size - BLE_PACKER_HEADER_SIZE);
+	stream_size += size - BLE_PACKER_HEADER_SIZE;
+
+	while((used = cart_codec_decode(stream, stream_size, &record)) > 0)
+	{
+		CHECK_EQ(record.type, CART_TLV_ITEM);
+		CHECK_EQ(record.item.product_id, next_expected);
+		next_expected++;
+
+		memmove(stream, &stream[used], stream_size - used);
+		stream_size -= used;
+	}
+}
+
+
+/**
+ * @brief This function is the stack model: a run of refusals, a hard error when one is set, bg_err_wrong_state while
+ * the client has the item stream disabled, or the notification is taken.
+ * @param connection The connection handle.
+ * @param characteristic The characteristic.
+ * @param size Size of the notification.
+ * @param data The notification.
+ * @return Result of gecko_cmd_gatt_server_send_characteristic_notification()
+ */
+static uint16_t test_stack_notify(uint8_t connection, uint16_t characteristic, uint8_t size, const uint8_t *data)
+{
+	CHECK_EQ(connection, TEST_CONNECTION);
+	CHECK_EQ(characteristic, TEST_CHARACTERISTIC);
+
+	if(hard_error != bg_err_success)
+	{
+		uint16_t result = hard_error;
+
+		hard_error = bg_err_success;
+		return result;
+	}
+
+	if(disabled_left)
+	{
+		disabled_submits++;
+		return bg_err_wrong_state;
+	}
+
+	if(refuse_left)
+	{
+		refuse_left--;
+		return refuse_result;
+	}
+
+	/* Out of buffers for a while, mostly short, or the client turned the item stream off for longer */
+	uint32_t draw = test_rand(&seed) % 2000;
+	if(draw < 200)
+	{
+		refuse_result = bg_err_out_of_memory;
+		refuse_left = test_rand(&seed) % 4;
+		return bg_err_out_of_memory;
+	}
+	if(draw < 201)
+	{
+		if(test_rand(&seed) & 1)
+		{
+			disabled_left = 100 + (test_rand(&seed) % 2000);
+			disabled_submits++;
+			return bg_err_wrong_state;
+		}
+		refuse_result = bg_err_out_of_memory;
+		refuse_left = 100 + (test_rand(&seed) % 2000);
+		return refuse_result;
+	}
+
+	if(client_connected)
+	{
+		test_client_receive(data, size);
+	}
+	return bg_err_success;
+}
+
+
+/**
+ * @brief This function queues a scan, the name length varies so that records share notifications or are fragmented.
+ * @param void
+ * @return true if the scan was queued.
+ */
+static bool test_push_scan(void)
+{
+	char name[120];
+	uint16_t name_size = sprintf(name, "scan %lu", (unsigned long)scan_next);
+
+	name_size += sprintf(&name[name_size], "%.*s", (int)(scan_next % 97), "................................................................................................");
+
+	struct cart_item item =
+	{
+		.product_id = scan_next,
+		.price = 100,
+		.quantity = 1,
+		.flags = CART_ITEM_FLAG_NAME,
+		.name = name,
+		.name_size = name_size,
+	};
+
+	if(!scan_queue_push_item(&item))
+	{
+		return false;
+	}
+	scan_next++;
+	return true;
+}
+
+
+/**
+ * @brief This function runs the EVENT_LEUART handler: waiting scans are parsed while the scan queue has room. Scans
+ * held back by a full queue or a full payload pool wait for the sender to resume the parser.
+ * @param void
+ * @return void
+ */
+static void test_leuart_event(void)
+{
+	while(scan_waiting && !scan_queue_full() && test_push_scan())
+	{
+		scan_waiting--;
+	}
+
+	if(scan_waiting)
+	{
+		scan_queue.stalled = true;
+		scan_queue.stall_count++;
+	}
+}
+
+
+/**
+ * @brief This function runs the EVENT_SCAN_READY handler and ble_tx_resume() of main.c, which arms the retry timer
+ * unless the client has the item stream disabled.
+ * @param void
+ * @return void
+ */
+static void test_scan_ready_event(void)
+{
+	uint8_t *notification;
+	uint16_t notification_size;
+	bool done;
+
+	do
+	{
+		while(((notification = ble_tx_reserve()) != NULL) && ((notification_size = ble_packer_fill(&ble_packer, notification)) > 0))
+		{
+			ble_tx_commit(notification_size);
+		}
+		done = ble_tx_submit();
+
+		if(scan_queue.stalled && !scan_queue_full())
+		{
+			scan_queue.stalled = false;
+			test_leuart_event();
+		}
+	}
+	/* EVENT_SCAN_READY is set again while scans wait and the transmit queue has room */
+	while(done && scan_queue_count() && (ble_tx_reserve() != NULL));
+
+	retry_armed = !done && !ble_tx.client_disabled;
+}
+
+
+/**
+ * @brief This function starts a new connection.
+ * @param mtu ATT MTU of the connection.
+ * @return void
+ */
+static void test_connect(uint16_t mtu)
+{
+	payload_pool_init();
+	scan_queue_init();
+	ble_packer_init(&ble_packer);
+	ble_packer_set_mtu(&ble_packer, mtu);
+	ble_tx_init(TEST_CONNECTION, TEST_CHARACTERISTIC);
+
+	stub_gecko.notify = test_stack_notify;
+	client_connected = true;
+	refuse_left = 0;
+	hard_error = bg_err_success;
+	disabled_left = 0;
+	retry_armed = false;
+	disabled_submits = 0;
+	scan_next = 0;
+	scan_waiting = 0;
+	scan_waiting_max = 0;
+	stream_size = 0;
+	next_sequence = 0;
+	next_expected = 0;
+}
+
+
+/**
+ * @brief This function sends TEST_SCAN_COUNT scans arriving in bursts through the refusing stack.
+ * @param mtu ATT MTU of the connection.
+ * @return void
+ */
+static void test_random_refusals(uint16_t mtu)
+{
+	uint32_t scanned = 0;
+	uint32_t disabled_intervals = 0;
+	uint32_t scan_events = 0;
+
+	seed = 0x7e57 + mtu;
+	test_connect(mtu);
+
+	/* One pass is one connection interval: the scans of the interval are received, then the retry timer fires or
+	 * the client enables the item stream again */
+	while(next_expected < TEST_SCAN_COUNT)
+	{
+		/* Bursts of up to four scans every eight intervals on average */
+		uint32_t scans = ((scanned < TEST_SCAN_COUNT) && ((test_rand(&seed) % 8) == 0)) ? (1 + (test_rand(&seed) % 4)) : 0;
+
+		scans = ((scanned + scans) <= TEST_SCAN_COUNT) ? scans : (TEST_SCAN_COUNT - scanned);
+		scanned += scans;
+		scan_waiting += scans;
+		if(scan_waiting > scan_waiting_max)
+		{
+			scan_waiting_max = scan_waiting;
+		}
+
+		if(scans)
+		{
+			test_leuart_event();
+			test_scan_ready_event();
+			scan_events += (disabled_left != 0);
+		}
+		else if(retry_armed)
+		{
+			CHECK(!ble_tx.client_disabled);
+			test_scan_ready_event();
+		}
+
+		if(disabled_left)
+		{
+			CHECK(!retry_armed);
+			disabled_intervals++;
+			if(--disabled_left == 0)
+			{
+				/* The write of the client configuration, gecko_evt_gatt_server_characteristic_status_id */
+				test_scan_ready_event();
+			}
+		}
+	}
+
+	CHECK_EQ(next_expected, TEST_SCAN_COUNT);
+	CHECK_EQ(scan_next, TEST_SCAN_COUNT);
+	CHECK_EQ(scan_waiting, 0);
+	CHECK_EQ(scan_queue_count(), 0);
+	CHECK_EQ(ble_tx_count(), 0);
+	CHECK_EQ(scan_queue.dropped_count, 0);
+	CHECK_EQ(ble_tx.drop_count, 0);
+	CHECK_EQ(ble_tx.sent_count, ble_packer.notification_count);
+	CHECK(!scan_queue.stalled);
+
+	/* The stack refused some notifications far longer than a retry limit would have allowed */
+	CHECK(ble_tx.attempts_max > 1000);
+	CHECK(scan_queue.stall_count > 0);
+
+	/* With the item stream disabled the queue was only submitted on new scans, not at every interval */
+	CHECK(disabled_intervals > 1000);
+	CHECK(disabled_submits <= scan_events + 100);
+	CHECK(!ble_tx.client_disabled);
+
+	fprintf(stderr, "MTU %3u: %lu scans in %lu notifications, %lu refused, most refusals %lu, %lu stalls, "
+			"at most %lu scans held back before the parser\n", mtu, (unsigned long)next_expected, (unsigned long)ble_tx.sent_count,
+			(unsigned long)ble_tx.retry_count, (unsigned long)ble_tx.attempts_max, (unsigned long)scan_queue.stall_count,
+			(unsigned long)scan_waiting_max);
+	fprintf(stderr, "MTU %3u: item stream disabled for %lu intervals, %lu submissions refused meanwhile\n", mtu,
+			(unsigned long)disabled_intervals, (unsigned long)disabled_submits);
+}
+
+
+/**
+ * @brief This function checks that only the notification rejected with a hard error is dropped.
+ * @param void
+ * @return void
+ */
+static void test_hard_error(void)
+{
+	seed = 0x4a7d;
+	test_connect(BLE_ATT_MTU_DEFAULT);
+
+	/* The client would see a gap in the sequence numbers, it is left out */
+	client_connected = false;
+
+	/* A long out of memory run first, nothing may be given up on */
+	refuse_result = bg_err_out_of_memory;
+	refuse_left = 5000;
+	scan_waiting = SCAN_QUEUE_SIZE;
+	test_leuart_event();
+	for(uint32_t i = 0; i < 5000; i++)
+	{
+		test_scan_ready_event();
+	}
+	CHECK_EQ(ble_tx.drop_count, 0);
+	CHECK_EQ(ble_tx.sent_count, 0);
+	CHECK_EQ(ble_tx_count(), BLE_TX_QUEUE_SIZE);
+
+	/* The head is rejected for good, the next ones still go out */
+	hard_error = bg_err_invalid_conn_handle;
+	CHECK(!ble_tx_submit() || (ble_tx_count() == 0));
+	CHECK_EQ(ble_tx.drop_count, 1);
+	while(ble_tx_count())
+	{
+		ble_tx_submit();
+	}
+	CHECK_EQ(ble_tx.sent_count, BLE_TX_QUEUE_SIZE - 1);
+}
+
+
+/**
+ * @brief This function checks that the disconnect drops the pending notifications.
+ * @param void
+ * @return void
+ */
+static void test_disconnect(void)
+{
+	test_connect(BLE_ATT_MTU_DEFAULT);
+
+	refuse_result = bg_err_wrong_state;
+	refuse_left = UINT32_MAX;
+	scan_waiting = 20;
+	test_leuart_event();
+	test_scan_ready_event();
+	CHECK(scan_queue.stalled);
+	CHECK_EQ(ble_tx_count(), BLE_TX_QUEUE_SIZE);
+	CHECK_EQ(ble_tx.drop_count, 0);
+
+	/* As the connection closed handler does */
+	scan_queue_flush();
+	scan_queue.stalled = false;
+	ble_tx_flush();
+	CHECK_EQ(ble_tx_count(), 0);
+	CHECK_EQ(ble_tx.drop_count, BLE_TX_QUEUE_SIZE);
+	CHECK_EQ(ble_tx.attempts, 0);
+	CHECK_EQ(scan_queue_count(), 0);
+	for(uint32_t i = 0; i < PAYLOAD_POOL_CLASS_COUNT; i++)
+	{
+		CHECK_EQ(payload_pool_stats_get()->in_use[i], 0);
+	}
+}
+
+
+int main(void)
+{
+	stub_reset();
+	cart_session_init();
+
+	test_random_refusals(BLE_ATT_MTU_DEFAULT);
+	test_random_refusals(BLE_ATT_MTU_MAX);
+	test_hard_error();
+	test_disconnect();
+
+	return test_exit("test_ble_tx");
+}
@@ -0,0 +1,487 @@
+/*
+ * @file test_cart_journal.c
+ * @brief Host tests of the cart journal on the MX25 model of stub.c, through flash_spi.c and the SDK driver.
+ *
+ * The boot follows main.c: the flash is in deep power down as initBoard() leaves it, flash_spi_init() then
+ * cart_journal_init(), and a new session only when there is none to resume. A shopper then adds and removes
+ * products, the journal service runs on its soft timer, and the power is cut:
+ *
+ * 	at a random time, often between two programs
+ * 	a random time into a program or erase, which the model leaves half done
+ * 	in the middle of the erase of the next sector
+ *
+ * A sector header left half erased is checked on its own. After each cut the board boots again and the replayed cart must be the cart of a prefix of the changes: all the
+ * changes whose page was programmed before the cut, possibly some of the ones after, and nothing else. The
+ * shopping goes on from the replayed cart, so the journal wraps around its sectors many times over the run.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "stub.h"
+#include "em_rtcc.h"
+#include "inc/cart_journal.h"
+#include "inc/cart_ledger.h"
+#include "inc/cart_session.h"
+#include "inc/flash_spi.h"
+#include "inc/kv_store.h"
+#include "inc/timing.h"
+
+
+#define TEST_CUTS								(300)
+#define TEST_PRODUCT_COUNT						(40)
+#define TEST_CHANGES_MAX						(4000)
+#define TEST_NEW_SESSION_PERMILLE				(5)									/* Payments, a new session starts */
+#define TEST_REMOVE_PERCENT						(15)
+#define TEST_GAP_MAX_MS							(300)								/* Between two scans */
+#define TEST_TICK_NS							(1000000000ull / 32768)
+
+
+/* Changes of a session as the shopper made them */
+struct test_session
+{
+	uint32_t id;
+	uint64_t session_position;						/* End of the record of the session */
+	uint32_t product_id[TEST_CHANGES_MAX];
+	uint32_t quantity[TEST_CHANGES_MAX];
+	bool removed[TEST_CHANGES_MAX];
+	uint64_t position[TEST_CHANGES_MAX];			/* End of the record in the journal, see test_position() */
+	uint32_t count;
+	uint32_t durable;								/* Changes programmed before the cut */
+	uint16_t in_cart[TEST_PRODUCT_COUNT + 1];		/* Quantity of each product after the count changes */
+};
+
+/* The current session, and the one before while the record of the current one is not programmed yet */
+static struct test_session session[2];
+static uint8_t current;
+static bool pending;
+static uint32_t seed = 0x10c4;
+
+/* Statistics */
+static uint32_t erase_count;
+static uint32_t program_count;
+static uint32_t replay_max;
+static uint32_t lost_max;
+static uint32_t resume_count;
+static uint32_t cut_mode_count[3];
+
+
+/* Fakes of timing.c on the clock of the flash model, a wait lets the LDMA run and its interrupt fire */
+void timing_wait_us(uint32_t us)
+{
+	stub_mx25.time_ns += (uint64_t)us * 1000;
+	stub_irq_dispatch();
+}
+
+
+void timing_wait_ms(uint32_t ms)
+{
+	timing_wait_us(ms * 1000);
+}
+
+
+uint32_t timing_deadline_us(uint32_t us)
+{
+	return (uint32_t)(stub_mx25.time_ns / 1000) + us;
+}
+
+
+bool timing_expired(uint32_t deadline)
+{
+	stub_irq_dispatch();
+	return ((int32_t)((uint32_t)(stub_mx25.time_ns / 1000) - deadline) >= 0);
+}
+
+
+/* The internal flash is not part of this test, the session ids only have to differ */
+uint32_t kv_store_get_u32(enum kv_key key, uint32_t value)
+{
+	return value;
+}
+
+int kv_store_set_u32(enum kv_key key, uint32_t value)
+{
+	return 0;
+}
+
+
+/**
+ * @brief This function returns the price of a product.
+ */
+static uint32_t test_price(uint32_t product_id)
+{
+	return 99 + (product_id * 37);
+}
+
+
+/**
+ * @brief This function returns the position in the journal after the bytes appended or after the bytes programmed.
+ * Pages are only left once programmed and the generation grows with every sector, so the position only grows.
+ * @param programmed true for the bytes programmed
+ * @return The position.
+ */
+static uint64_t test_position(bool programmed)
+{
+	return ((uint64_t)cart_journal.generation << 16) | (uint32_t)(cart_journal.page_start +
+			(programmed ? cart_journal.flushed : cart_journal.fill));
+}
+
+
+/**
+ * @brief This function checks if the flash lost its power.
+ */
+static bool test_cut(void)
+{
+	return stub_mx25.off || ((stub_mx25.cut_ns != 0) && (stub_mx25.time_ns >= stub_mx25.cut_ns));
+}
+
+
+/**
+ * @brief This function rebuilds the quantities of a session after its first count changes.
+ * @param s The session
+ * @param count Number of changes kept
+ * @return void
+ */
+static void test_session_truncate(struct test_session *s, uint32_t count)
+{
+	s->count = count;
+	s->durable = count;
+	memset(s->in_cart, 0, sizeof(s->in_cart));
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		s->in_cart[s->product_id[i]] += s->removed[i] ? -s->quantity[i] : s->quantity[i];
+	}
+}
+
+
+/**
+ * @brief This function boots the board after a power cut, as main.c does.
+ * @return Value of cart_journal_init().
+ */
+static int test_boot(void)
+{
+	/* The RAM is lost, the RTCC runs on the clock of the flash model */
+	stub_reset();
+	stub_rtcc.time_ns = &stub_mx25.time_ns;
+	memset(&flash_spi, 0, sizeof(struct flash_spi));
+	memset(&cart_journal, 0, sizeof(struct cart_journal));
+	memset(&cart_session, 0x55, sizeof(struct cart_session));
+	memset(&cart_ledger, 0x55, sizeof(struct cart_ledger));
+
+	stub_mx25_power_up(true);
+	flash_spi_init();
+	return cart_journal_init();
+}
+
+
+/**
+ * @brief This function starts a new session, the one before is kept until the record of the new one is programmed.
+ */
+static void test_new_session(void)
+{
+	cart_session_init();
+
+	if(!pending)
+	{
+		current ^= 1;
+	}
+	pending = true;
+	session[current].id = cart_session.id;
+	session[current].session_position = test_position(false);
+	test_session_truncate(&session[current], 0);
+}
+
+
+/**
+ * @brief This function makes one change of the cart, as the scan of a product or its removal.
+ */
+static void test_change(void)
+{
+	struct test_session *s = &session[current];
+	char name[CART_SESSION_NAME_MAXSIZE];
+	struct cart_item item;
+
+	if(s->count == TEST_CHANGES_MAX)
+	{
+		return;
+	}
+
+	memset(&item, 0, sizeof(item));
+	item.product_id = 1 + (test_rand(&seed) % TEST_PRODUCT_COUNT);
+	item.price = test_price(item.product_id);
+	item.quantity = 1 + (test_rand(&seed) % 3);
+
+	if(((test_rand(&seed) % 100) < TEST_REMOVE_PERCENT) && s->in_cart[item.product_id])
+	{
+		item.flags = CART_ITEM_FLAG_REMOVED;
+		item.quantity = 1 + (test_rand(&seed) % s->in_cart[item.product_id]);
+	}
+	else if(test_rand(&seed) & 1)
+	{
+		/* Names make the records longer, the sectors fill faster */
+		item.flags = CART_ITEM_FLAG_NAME;
+		item.name = name;
+		item.name_size = snprintf(name, sizeof(name), "Product %lu, %lu g", (unsigned long)item.product_id,
+				(unsigned long)(test_rand(&seed) % 1000));
+	}
+
+	CHECK_EQ(cart_session_append(&item), 0);
+
+	s->product_id[s->count] = item.product_id;
+	s->quantity[s->count] = item.quantity;
+	s->removed[s->count] = (item.flags & CART_ITEM_FLAG_REMOVED) != 0;
+	s->position[s->count] = test_position(false);
+	s->in_cart[item.product_id] += s->removed[s->count] ? -item.quantity : item.quantity;
+	s->count++;
+}
+
+
+/**
+ * @brief This function shops until the power is cut, with the soft timer of the journal service.
+ * @param mode How the cut is placed
+ * @return void
+ */
+static void test_shop(uint32_t mode)
+{
+	uint64_t service_ns = 0;
+
+	stub_mx25.cut_ns = 0;
+	stub_mx25.cut_operation = 0;
+	if(mode == 0)
+	{
+		stub_mx25.cut_ns = stub_mx25.time_ns + 1 + (test_rand(&seed) % 5000000) * 1000ull;
+	}
+	else if(mode == 1)
+	{
+		stub_mx25.cut_operation = stub_mx25.program_count + stub_mx25.erase_count + 1 + (test_rand(&seed) % 8);
+		stub_mx25.cut_delay_ns = 1 + (test_rand(&seed) % stub_mx25.program_ns);
+	}
+
+	while(!test_cut())
+	{
+		/* Cut once the next sector is being erased */
+		if((mode == 2) && (stub_mx25.cut_ns == 0) && flash_spi.erasing && (stub_mx25.operation != 0) && !stub_mx25.suspended)
+		{
+			stub_mx25.cut_ns = stub_mx25.time_ns + 1 + (test_rand(&seed) % stub_mx25.erase_ns);
+		}
+
+		uint64_t gap_ns = (1 + (test_rand(&seed) % TEST_GAP_MAX_MS)) * 1000000ull;
+		stub_mx25.time_ns += gap_ns;
+		service_ns += gap_ns;
+		if(test_cut())
+		{
+			break;
+		}
+
+		uint32_t ticks = cart_journal_service_ticks();
+		if(ticks && (service_ns >= ticks * TEST_TICK_NS))
+		{
+			cart_journal_service();
+			service_ns = 0;
+		}
+		else if((test_rand(&seed) % 1000) < TEST_NEW_SESSION_PERMILLE)
+		{
+			test_new_session();
+		}
+		else
+		{
+			test_change();
+		}
+
+		/* Changes programmed while the flash still had its power */
+		if(!test_cut())
+		{
+			struct test_session *s = &session[current];
+			uint64_t programmed = test_position(true);
+
+			pending = pending && (s->session_position > programmed);
+			while((s->durable < s->count) && (s->position[s->durable] <= programmed))
+			{
+				s->durable++;
+			}
+
+			CHECK_EQ(cart_journal.drop_count, 0);
+		}
+	}
+}
+
+
+/**
+ * @brief This function checks the cart replayed after a cut against the changes made before.
+ * @param ret Value of cart_journal_init()
+ * @return void
+ */
+static void test_replay(int ret)
+{
+	if(ret < 0)
+	{
+		/* Only before the record of the first session was programmed */
+		CHECK(pending && (session[current ^ 1].id == 0));
+		test_new_session();
+		return;
+	}
+
+	/* The record of the new session was lost, the previous one is resumed */
+	if(pending && (cart_session.id == session[current ^ 1].id))
+	{
+		current ^= 1;
+		resume_count++;
+	}
+	pending = false;
+
+	struct test_session *s = &session[current];
+	uint32_t replayed = cart_journal.replay_count;
+
+	CHECK_EQ(cart_session.id, s->id);
+	CHECK_EQ((uint32_t)ret, replayed);
+	if((replayed < s->durable) || (replayed > s->count))
+	{
+		fprintf(stderr, "replayed %lu changes of session %08lx, %lu programmed and %lu made\n", (unsigned long)replayed,
+				(unsigned long)s->id, (unsigned long)s->durable, (unsigned long)s->count);
+		CHECK(!"replay of the programmed changes");
+	}
+	lost_max = ((s->count - replayed) > lost_max) ? (s->count - replayed) : lost_max;
+	replay_max = (replayed > replay_max) ? replayed : replay_max;
+
+	test_session_truncate(s, (replayed < s->count) ? replayed : s->count);
+
+	/* The cart is the one of the first changes */
+	uint32_t total = 0;
+	uint32_t item_count = 0;
+	uint32_t line_count = 0;
+	for(uint32_t product_id = 1; product_id <= TEST_PRODUCT_COUNT; product_id++)
+	{
+		const struct cart_ledger_line *line = cart_ledger_find(product_id);
+
+		total += s->in_cart[product_id] * test_price(product_id);
+		item_count += s->in_cart[product_id];
+		line_count += (s->in_cart[product_id] != 0);
+		CHECK_EQ((line == NULL) ? 0 : line->quantity, s->in_cart[product_id]);
+	}
+	CHECK_EQ(cart_ledger.total, total);
+	CHECK_EQ(cart_ledger.item_count, item_count);
+	CHECK_EQ(cart_ledger.line_count, line_count);
+	CHECK_EQ(cart_session.sequence, replayed);
+}
+
+
+/**
+ * @brief A blank flash in deep power down boots without a session, and a journal written before a clean power
+ * down is replayed in full.
+ */
+static void test_boot_deep_power_down(void)
+{
+	stub_mx25_power_up(true);
+	stub_mx25_format();
+
+	CHECK_EQ(test_boot(), -1);
+	CHECK_EQ(stub_mx25.ignored_count, 0);
+	test_new_session();
+	for(uint32_t i = 0; i < 100; i++)
+	{
+		test_change();
+	}
+	cart_journal_service();
+	CHECK_EQ(cart_journal.flushed, cart_journal.fill);
+	session[current].durable = session[current].count;
+	pending = false;
+	erase_count += stub_mx25.erase_count;
+	program_count += stub_mx25.program_count;
+
+	int ret = test_boot();
+	CHECK_EQ(ret, 100);
+	CHECK_EQ(stub_mx25.ignored_count, 0);
+	CHECK_EQ(cart_journal.corrupt_count, 0);
+	CHECK(cart_journal.replay_ticks > 0);
+	test_replay(ret);
+}
+
+
+/**
+ * @brief An erase cut short can leave the header of an old sector with its magic and a generation turned to 0xFF in
+ * its high byte. That sector must not be replayed as the newest one, after the current session.
+ */
+static void test_half_erased_header(void)
+{
+	stub_mx25_format();
+	CHECK_EQ(test_boot(), -1);
+
+	/* An old session filling sector 0, then the current one starting in sector 1 */
+	test_new_session();
+	while(cart_journal.generation < 2)
+	{
+		test_change();
+	}
+	test_new_session();
+	for(uint32_t i = 0; i < 20; i++)
+	{
+		test_change();
+	}
+	cart_journal_service();
+	CHECK_EQ(cart_journal.flushed, cart_journal.fill);
+	CHECK_EQ(cart_journal.session_sector, 1);
+	session[current].durable = session[current].count;
+	pending = false;
+
+	stub_mx25.memory[CART_JOURNAL_ADDRESS + 7] = 0xFF;
+
+	int ret = test_boot();
+	CHECK_EQ(ret, 20);
+	CHECK_EQ(cart_journal.generation, 2);
+	test_replay(ret);
+}
+
+
+/**
+ * @brief Cuts of the power while shopping, each followed by a boot and the replay.
+ */
+static void test_power_cuts(void)
+{
+	uint32_t corrupt = 0;
+
+	for(uint32_t cut = 0; cut < TEST_CUTS; cut++)
+	{
+		uint32_t mode = test_rand(&seed) % 3;
+
+		test_shop(mode);
+		cut_mode_count[mode]++;
+		erase_count += stub_mx25.erase_count;
+		program_count += stub_mx25.program_count;
+
+		int ret = test_boot();
+		corrupt += cart_journal.corrupt_count;
+		CHECK_EQ(stub_mx25.ignored_count, 0);
+		test_replay(ret);
+	}
+
+	fprintf(stderr, "%u cuts (%u random, %u program or erase, %u next sector erase): %lu sector erases, %lu page programs\n",
+			TEST_CUTS, cut_mode_count[0], cut_mode_count[1], cut_mode_count[2], (unsigned long)erase_count,
+			(unsigned long)program_count);
+	fprintf(stderr, "   replayed up to %lu changes, lost up to %lu, %lu corrupt records skipped, %lu previous sessions resumed\n",
+			(unsigned long)replay_max, (unsigned long)lost_max, (unsigned long)corrupt, (unsigned long)resume_count);
+}
+
+
+/**
+ * @brief The tests, cart_journal_init() reads the sector headers into its stack.
+ */
+static void test_main(void)
+{
+	test_boot_deep_power_down();
+	test_half_erased_header();
+	test_power_cuts();
+}
+
+
+int main(void)
+{
+	stub_run(test_main);
+
+	return test_exit("test_cart_journal");
+}
@@ -0,0 +1,289 @@
+/*
+ * @file test_cart_ledger.c
+ * @brief Host unit tests of the cart ledger.
+ *
+ * The operations are checked one by one on small carts, then a long random sequence of adds, removes and voids is
+ * run against a plain array model, with product ids chosen to collide in the index so that the probing and the
+ * backward shift deletion are exercised. After every operation the total, the item count and the index must match.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "test.h"
+#include "inc/cart_ledger.h"
+
+
+#define TEST_RANDOM_OPS							(2000000)
+#define TEST_PRODUCT_COUNT						(CART_LEDGER_LINES_MAX + 64)
+
+
+/* Reference model, one entry per product of the test */
+struct test_line
+{
+	uint32_t product_id;
+	uint32_t price;
+	uint32_t quantity;
+};
+
+static struct test_line model[TEST_PRODUCT_COUNT];
+
+
+/**
+ * @brief This function checks the internal consistency of the ledger: packed lines, index pointing to each line once.
+ * @param void
+ * @return void
+ */
+static void test_check_index(void)
+{
+	uint32_t used = 0;
+	uint64_t total = 0;
+	uint32_t items = 0;
+
+	for(uint32_t slot = 0; slot < CART_LEDGER_INDEX_SIZE; slot++)
+	{
+		if(cart_ledger.index[slot] != CART_LEDGER_INDEX_EMPTY)
+		{
+			CHECK(cart_ledger.index[slot] < cart_ledger.line_count);
+			used++;
+		}
+	}
+	CHECK_EQ(used, cart_ledger.line_count);
+
+	for(uint32_t i = 0; i < cart_ledger.line_count; i++)
+	{
+		const struct cart_ledger_line *line = &cart_ledger.line[i];
+
+		CHECK(line->quantity > 0);
+		CHECK(cart_ledger_find(line->product_id) == line);
+		total += (uint64_t)line->price * line->quantity;
+		items += line->quantity;
+	}
+	CHECK_EQ(total, cart_ledger.total);
+	CHECK_EQ(items, cart_ledger.item_count);
+}
+
+
+/**
+ * @brief This function checks the operations one by one.
+ * @param void
+ * @return void
+ */
+static void test_operations(void)
+{
+	const struct cart_ledger_line *line;
+
+	cart_ledger_init();
+	CHECK_EQ(cart_ledger.total, 0);
+	CHECK(cart_ledger_find(1) == NULL);
+
+	/* Add, then more units of the same product */
+	CHECK_EQ(cart_ledger_add(1, 250, 2), 0);
+	CHECK_EQ(cart_ledger_add(2, 1999, 1), 0);
+	CHECK_EQ(cart_ledger_add(1, 250, 1), 0);
+	line = cart_ledger_find(1);
+	CHECK((line != NULL) && (line->quantity == 3) && (line->price == 250));
+	CHECK_EQ(cart_ledger.total, (3 * 250) + 1999);
+	CHECK_EQ(cart_ledger.item_count, 4);
+	CHECK_EQ(cart_ledger.line_count, 2);
+
+	/* A new price reprices the whole line */
+	CHECK_EQ(cart_ledger_add(1, 300, 1), 0);
+	CHECK_EQ(cart_ledger.total, (4 * 300) + 1999);
+
+	/* Remove some units, more than in the cart, then the last ones */
+	CHECK_EQ(cart_ledger_remove(1, 2), 0);
+	CHECK_EQ(cart_ledger.total, (2 * 300) + 1999);
+	CHECK_EQ(cart_ledger_remove(1, 3), -1);
+	CHECK_EQ(cart_ledger.total, (2 * 300) + 1999);
+	CHECK_EQ(cart_ledger_remove(1, 2), 0);
+	CHECK(cart_ledger_find(1) == NULL);
+	CHECK_EQ(cart_ledger.line_count, 1);
+	CHECK_EQ(cart_ledger.total, 1999);
+	CHECK_EQ(cart_ledger_remove(1, 1), -1);
+
+	/* Void takes out the whole line */
+	CHECK_EQ(cart_ledger_add(2, 1999, 4), 0);
+	CHECK_EQ(cart_ledger_void(2), 5);
+	CHECK_EQ(cart_ledger_void(2), -1);
+	CHECK_EQ(cart_ledger.total, 0);
+	CHECK_EQ(cart_ledger.item_count, 0);
+	CHECK_EQ(cart_ledger.line_count, 0);
+
+	/* Totals above the 4 byte text bill of the former firmware, and the 32 bit limit */
+	CHECK_EQ(cart_ledger_add(3, 99999, 100), 0);
+	CHECK_EQ(cart_ledger.total, 9999900);
+	CHECK_EQ(cart_ledger_add(4, UINT32_MAX, 1), -1);
+	CHECK_EQ(cart_ledger_add(3, UINT32_MAX / 100, 1), -1);
+	CHECK_EQ(cart_ledger.total, 9999900);
+	CHECK_EQ(cart_ledger.line_count, 1);
+
+	/* Quantity of a line */
+	CHECK_EQ(cart_ledger_add(5, 1, UINT16_MAX), 0);
+	CHECK_EQ(cart_ledger_add(5, 1, 1), -1);
+	CHECK_EQ(cart_ledger_find(5)->quantity, UINT16_MAX);
+	test_check_index();
+
+	/* A full cart refuses new products but not more units of the ones it has */
+	cart_ledger_init();
+	for(uint32_t i = 0; i < CART_LEDGER_LINES_MAX; i++)
+	{
+		CHECK_EQ(cart_ledger_add(1000 + i, 100, 1), 0);
+	}
+	CHECK_EQ(cart_ledger_add(999, 100, 1), -1);
+	CHECK_EQ(cart_ledger_add(1000, 100, 1), 0);
+	CHECK_EQ(cart_ledger.line_count, CART_LEDGER_LINES_MAX);
+	CHECK_EQ(cart_ledger.total, (CART_LEDGER_LINES_MAX + 1) * 100);
+	test_check_index();
+
+	/* Emptying it line by line, from the middle */
+	for(uint32_t i = 0; i < CART_LEDGER_LINES_MAX; i++)
+	{
+		uint32_t product = 1000 + ((i * 37) % CART_LEDGER_LINES_MAX);
+
+		CHECK(cart_ledger_void(product) > 0);
+	}
+	CHECK_EQ(cart_ledger.line_count, 0);
+	CHECK_EQ(cart_ledger.total, 0);
+	test_check_index();
+}
+
+
+/**
+ * @brief This function returns a product id whose home slot in the index is one of a few, so that they collide.
+ * @param seed Random generator state.
+ * @return The product id.
+ */
+static uint32_t test_colliding_id(uint32_t *seed)
+{
+	for(;;)
+	{
+		uint32_t id = test_rand(seed);
+		uint16_t slot = (uint16_t)((id * 2654435769u) >> 16) & CART_LEDGER_INDEX_MASK;
+
+		/* Clusters at the start and at the end of the index, the probe sequences wrap around */
+		if((slot < 8) || (slot >= (CART_LEDGER_INDEX_SIZE - 8)) || ((slot & 0x3F) == 0x20) || ((test_rand(seed) % 4) == 0))
+		{
+			return id;
+		}
+	}
+}
+
+
+/**
+ * @brief This function runs random operations against the reference model.
+ * @param void
+ * @return void
+ */
+static void test_random(void)
+{
+	uint32_t seed = 0x1ed9e7;
+	uint64_t total = 0;
+	uint32_t items = 0;
+	uint32_t lines = 0;
+
+	cart_ledger_init();
+	for(uint32_t i = 0; i < TEST_PRODUCT_COUNT; i++)
+	{
+		uint32_t id;
+		bool unique;
+
+		do
+		{
+			id = test_colliding_id(&seed);
+			unique = true;
+			for(uint32_t j = 0; j < i; j++)
+			{
+				unique = unique && (model[j].product_id != id);
+			}
+		} while(!unique);
+
+		model[i].product_id = id;
+		model[i].price = 0;
+		model[i].quantity = 0;
+	}
+
+	for(uint32_t op = 0; op < TEST_RANDOM_OPS; op++)
+	{
+		struct test_line *entry = &model[test_rand(&seed) % TEST_PRODUCT_COUNT];
+		uint32_t draw = test_rand(&seed) % 8;
+		int ret;
+
+		if(draw < 4)
+		{
+			uint32_t price = 1 + (test_rand(&seed) % 5000);
+			uint16_t quantity = 1 + (test_rand(&seed) % 3);
+			bool fits = (entry->quantity != 0) || (lines < CART_LEDGER_LINES_MAX);
+
+			ret = cart_ledger_add(entry->product_id, price, quantity);
+			CHECK_EQ(ret, fits ? 0 : -1);
+			if(ret == 0)
+			{
+				total = total - ((uint64_t)entry->price * entry->quantity) + ((uint64_t)price * (entry->quantity + quantity));
+				lines += (entry->quantity == 0);
+				entry->price = price;
+				entry->quantity += quantity;
+				items += quantity;
+			}
+		}
+		else if(draw < 7)
+		{
+			uint16_t quantity = 1 + (test_rand(&seed) % 3);
+
+			ret = cart_ledger_remove(entry->product_id, quantity);
+			CHECK_EQ(ret, (quantity <= entry->quantity) ? 0 : -1);
+			if(ret == 0)
+			{
+				total -= (uint64_t)entry->price * quantity;
+				entry->quantity -= quantity;
+				items -= quantity;
+				lines -= (entry->quantity == 0);
+			}
+		}
+		else
+		{
+			ret = cart_ledger_void(entry->product_id);
+			CHECK_EQ(ret, entry->quantity ? (int)entry->quantity : -1);
+			total -= (uint64_t)entry->price * entry->quantity;
+			items -= entry->quantity;
+			lines -= (entry->quantity != 0);
+			entry->quantity = 0;
+		}
+
+		CHECK_EQ(cart_ledger.total, total);
+		CHECK_EQ(cart_ledger.item_count, items);
+		CHECK_EQ(cart_ledger.line_count, lines);
+
+		const struct cart_ledger_line *line = cart_ledger_find(entry->product_id);
+		CHECK((line != NULL) == (entry->quantity != 0));
+		CHECK((line == NULL) || ((line->quantity == entry->quantity) && (line->price == entry->price)));
+
+		if((op % 4096) == 0)
+		{
+			test_check_index();
+		}
+	}
+
+	test_check_index();
+	for(uint32_t i = 0; i < TEST_PRODUCT_COUNT; i++)
+	{
+		const struct cart_ledger_line *line = cart_ledger_find(model[i].product_id);
+
+		CHECK((line != NULL) == (model[i].quantity != 0));
+		CHECK((line == NULL) || (line->quantity == model[i].quantity));
+	}
+}
+
+
+int main(void)
+{
+	test_operations();
+	test_random();
+
+	return test_exit("test_cart_ledger");
+}
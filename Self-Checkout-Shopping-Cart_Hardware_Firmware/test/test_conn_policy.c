@@ -0,0 +1,379 @@
+/*
+ * @file test_conn_policy.c
+ * @brief Host tests of the connection parameter policy of conn_policy.c on the requests recorded by native_gecko.h.
+ *
+ * The central answers a request with gecko_evt_le_connection_parameters_id, which the tests deliver by calling
+ * conn_policy_parameters() with the parameters the stand-in recorded, or it rejects or ignores the request and
+ * sends nothing. SOFT_TIMER_CONN_REQUEST of main.c is modelled on the RTCC counter of em_rtcc.h: it is armed with
+ * conn_policy_request_ticks() when not running and fires once the counter reaches its deadline.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "stub.h"
+#include "em_rtcc.h"
+#include "native_gecko.h"
+#include "inc/conn_policy.h"
+#include "inc/connection_param.h"
+
+
+#define TEST_CONNECTION							(1)
+#define TEST_RTCC_FREQ							(32768)
+#define TEST_REQUEST_TICKS						(CON_REQUEST_TIMEOUT_S * TEST_RTCC_FREQ)
+#define TEST_INTERVAL_US(interval)				((uint32_t)(interval) * 1250)
+#define TEST_TIMEOUT_US(timeout)				((uint32_t)(timeout) * 10000)
+
+
+static bool timer_armed;						/* SOFT_TIMER_CONN_REQUEST */
+static uint32_t timer_deadline;
+
+
+/* The interrupts of the models are not used */
+void LDMA_IRQHandler(void)
+{
+}
+
+
+void LEUART0_IRQHandler(void)
+{
+}
+
+
+/**
+ * @brief This function is conn_request_schedule() of main.c.
+ * @param void
+ * @return void
+ */
+static void test_schedule(void)
+{
+	uint32_t ticks = conn_policy_request_ticks();
+
+	if(ticks && !timer_armed)
+	{
+		timer_deadline = stub_rtcc.counter + ticks;
+		timer_armed = true;
+	}
+}
+
+
+/**
+ * @brief This function moves the RTCC counter forward and runs the SOFT_TIMER_CONN_REQUEST handler of main.c each
+ * time the timer fires.
+ * @param uint32_t ticks Ticks to move forward
+ * @return void
+ */
+static void test_advance(uint32_t ticks)
+{
+	uint32_t end = stub_rtcc.counter + ticks;
+
+	while(timer_armed && ((int32_t)(end - timer_deadline) >= 0))
+	{
+		stub_rtcc.counter = timer_deadline;
+		timer_armed = false;
+		conn_policy_request_timeout();
+		test_schedule();
+	}
+	stub_rtcc.counter = end;
+}
+
+
+/**
+ * @brief This function delivers the gecko_evt_le_connection_parameters_id feedback of the last request, with the
+ * maximum interval the central picks.
+ * @param void
+ * @return void
+ */
+static void test_feedback(void)
+{
+	conn_policy_parameters(stub_gecko.conn_interval_max, stub_gecko.conn_latency, stub_gecko.conn_timeout);
+	test_schedule();
+}
+
+
+/**
+ * @brief This function opens a connection at an RTCC counter value.
+ * @param uint32_t counter RTCC counter when the connection opens
+ * @return void
+ */
+static void test_connect(uint32_t counter)
+{
+	stub_reset();
+	stub_rtcc.counter = counter;
+	timer_armed = false;
+	conn_policy_init(TEST_CONNECTION);
+	test_schedule();
+}
+
+
+/**
+ * @brief This function checks one parameter set against the limits iOS accepts.
+ * @param uint16_t interval_min Minimum interval in units of 1.25 ms
+ * @param uint16_t interval_max Maximum interval in units of 1.25 ms
+ * @param uint16_t latency Slave latency
+ * @param uint16_t timeout Supervision timeout in units of 10 ms
+ * @return void
+ */
+static void test_check_limits(uint16_t interval_min, uint16_t interval_max, uint16_t latency, uint16_t timeout)
+{
+	uint32_t listen_us = TEST_INTERVAL_US(interval_max) * (latency + 1);
+
+	CHECK(TEST_INTERVAL_US(interval_min) >= 15000);
+	CHECK_EQ(TEST_INTERVAL_US(interval_min) % 15000, 0);
+	CHECK(TEST_INTERVAL_US(interval_min) + 15000 <= TEST_INTERVAL_US(interval_max));
+	CHECK(latency <= 30);
+	CHECK(listen_us <= 2000000);
+	CHECK(TEST_TIMEOUT_US(timeout) >= 2000000);
+	CHECK(TEST_TIMEOUT_US(timeout) <= 6000000);
+	CHECK(TEST_TIMEOUT_US(timeout) > 3 * listen_us);
+}
+
+
+/**
+ * @brief Both parameter sets are accepted by iOS.
+ */
+static void test_limits(void)
+{
+	test_check_limits(CON_ACTIVE_INTERVAL_MIN, CON_ACTIVE_INTERVAL_MAX, CON_ACTIVE_LATENCY, CON_ACTIVE_TIMEOUT);
+	test_check_limits(CON_IDLE_INTERVAL_MIN, CON_IDLE_INTERVAL_MAX, CON_IDLE_LATENCY, CON_IDLE_TIMEOUT);
+}
+
+
+/**
+ * @brief This function checks that the last request was for the parameters of a mode.
+ * @param enum conn_policy_mode mode The mode
+ * @return void
+ */
+static void test_check_request(enum conn_policy_mode mode)
+{
+	CHECK(conn_policy.request_pending);
+	CHECK_EQ(conn_policy.requested_mode, mode);
+	if(mode == CONN_POLICY_ACTIVE)
+	{
+		CHECK_EQ(stub_gecko.conn_interval_min, CON_ACTIVE_INTERVAL_MIN);
+		CHECK_EQ(stub_gecko.conn_interval_max, CON_ACTIVE_INTERVAL_MAX);
+		CHECK_EQ(stub_gecko.conn_latency, CON_ACTIVE_LATENCY);
+		CHECK_EQ(stub_gecko.conn_timeout, CON_ACTIVE_TIMEOUT);
+	}
+	else
+	{
+		CHECK_EQ(stub_gecko.conn_interval_min, CON_IDLE_INTERVAL_MIN);
+		CHECK_EQ(stub_gecko.conn_interval_max, CON_IDLE_INTERVAL_MAX);
+		CHECK_EQ(stub_gecko.conn_latency, CON_IDLE_LATENCY);
+		CHECK_EQ(stub_gecko.conn_timeout, CON_IDLE_TIMEOUT);
+	}
+}
+
+
+/**
+ * @brief The active parameters at the connection, the idle ones after the quiet period, and back to active on a
+ * scan. A change of mode while a request is in flight is requested when its feedback arrives.
+ */
+static void test_switching(void)
+{
+	test_connect(1000);
+	CHECK_EQ(conn_policy.mode, CONN_POLICY_ACTIVE);
+	CHECK_EQ(stub_gecko.conn_request_count, 1);
+	test_check_request(CONN_POLICY_ACTIVE);
+	CHECK(timer_armed);
+	CHECK_EQ(timer_deadline - 1000, TEST_REQUEST_TICKS);
+
+	/* Before the feedback the retry interval of ble_tx is the active one */
+	CHECK_EQ(conn_policy_interval_ticks(), (CON_ACTIVE_INTERVAL_MAX * 5 * TEST_RTCC_FREQ) / 4000);
+	test_advance(TEST_RTCC_FREQ / 10);
+	test_feedback();
+	CHECK(!conn_policy.request_pending);
+	CHECK_EQ(conn_policy.interval, CON_ACTIVE_INTERVAL_MAX);
+	CHECK_EQ(conn_policy_request_ticks(), 0);
+
+	/* Scans while active change nothing */
+	conn_policy_activity();
+	test_schedule();
+	CHECK_EQ(stub_gecko.conn_request_count, 1);
+
+	/* The quiet period, the timer armed for the first request fires without effect */
+	test_advance(CON_QUIET_PERIOD_S * TEST_RTCC_FREQ);
+	CHECK_EQ(conn_policy.timeout_count, 0);
+	conn_policy_quiet();
+	test_schedule();
+	CHECK_EQ(conn_policy.mode, CONN_POLICY_IDLE);
+	CHECK_EQ(stub_gecko.conn_request_count, 2);
+	test_check_request(CONN_POLICY_IDLE);
+	test_advance(TEST_RTCC_FREQ);
+	test_feedback();
+	CHECK_EQ(conn_policy.interval, CON_IDLE_INTERVAL_MAX);
+	CHECK_EQ(conn_policy.latency, CON_IDLE_LATENCY);
+	CHECK_EQ(conn_policy_interval_ticks(), (CON_IDLE_INTERVAL_MAX * 5 * TEST_RTCC_FREQ) / 4000);
+
+	/* A scan, then the quiet period again before the central answered */
+	conn_policy_activity();
+	test_schedule();
+	CHECK_EQ(stub_gecko.conn_request_count, 3);
+	test_check_request(CONN_POLICY_ACTIVE);
+	conn_policy_quiet();
+	conn_policy_activity();
+	conn_policy_quiet();
+	test_schedule();
+	CHECK_EQ(conn_policy.mode, CONN_POLICY_IDLE);
+	CHECK_EQ(stub_gecko.conn_request_count, 3);
+
+	/* The feedback of the active request sends the idle one */
+	test_advance(TEST_RTCC_FREQ / 10);
+	test_feedback();
+	CHECK_EQ(conn_policy.interval, CON_ACTIVE_INTERVAL_MAX);
+	CHECK_EQ(stub_gecko.conn_request_count, 4);
+	test_check_request(CONN_POLICY_IDLE);
+	test_advance(TEST_RTCC_FREQ);
+	test_feedback();
+	CHECK_EQ(conn_policy.interval, CON_IDLE_INTERVAL_MAX);
+	CHECK(!conn_policy.request_pending);
+
+	CHECK_EQ(conn_policy.active_count, 2);
+	CHECK_EQ(conn_policy.idle_count, 2);
+	CHECK_EQ(conn_policy.update_count, 4);
+	CHECK_EQ(conn_policy.timeout_count, 0);
+
+	/* Nothing pending, the timer runs out */
+	test_advance(2 * TEST_REQUEST_TICKS);
+	CHECK(!timer_armed);
+	CHECK_EQ(stub_gecko.conn_request_count, 4);
+}
+
+
+/**
+ * @brief A central that ignores the requests: each one is sent again after CON_REQUEST_TIMEOUT_S, up to
+ * CON_REQUEST_RETRIES times, then the policy keeps the parameters in use until the mode changes. The counter wraps
+ * on the way.
+ */
+static void test_ignored(void)
+{
+	uint32_t sent;
+
+	test_connect((uint32_t)(0 - TEST_REQUEST_TICKS - 100));
+	test_feedback();
+
+	/* The quiet period, the central never answers */
+	conn_policy_quiet();
+	test_schedule();
+	sent = stub_gecko.conn_request_count;
+	CHECK_EQ(conn_policy_request_ticks(), TEST_REQUEST_TICKS);
+
+	/* Half the timeout, still waiting */
+	test_advance(TEST_REQUEST_TICKS / 2);
+	CHECK(conn_policy.request_pending);
+	CHECK_EQ(conn_policy_request_ticks(), TEST_REQUEST_TICKS - (TEST_REQUEST_TICKS / 2));
+	CHECK_EQ(stub_gecko.conn_request_count, sent);
+
+	/* Each timeout sends the request again */
+	test_advance(TEST_REQUEST_TICKS - (TEST_REQUEST_TICKS / 2));
+	CHECK_EQ(conn_policy.timeout_count, 1);
+	CHECK_EQ(conn_policy.retries, 1);
+	CHECK_EQ(stub_gecko.conn_request_count, sent + 1);
+	test_check_request(CONN_POLICY_IDLE);
+	CHECK(timer_armed);
+
+	test_advance(CON_REQUEST_RETRIES * TEST_REQUEST_TICKS);
+	CHECK_EQ(conn_policy.timeout_count, 1 + CON_REQUEST_RETRIES);
+	CHECK_EQ(conn_policy.give_up_count, 1);
+	CHECK_EQ(stub_gecko.conn_request_count, sent + CON_REQUEST_RETRIES);
+	CHECK(!conn_policy.request_pending);
+	CHECK(!timer_armed);
+	CHECK_EQ(conn_policy_request_ticks(), 0);
+
+	/* Given up, the parameters in use stay and the timer is not armed again */
+	CHECK_EQ(conn_policy.interval, CON_ACTIVE_INTERVAL_MAX);
+	test_advance(10 * TEST_REQUEST_TICKS);
+	CHECK_EQ(stub_gecko.conn_request_count, sent + CON_REQUEST_RETRIES);
+
+	/* A scan asks for the active parameters, which the link already uses, and the central answers */
+	conn_policy_activity();
+	test_schedule();
+	CHECK_EQ(conn_policy.retries, 0);
+	CHECK_EQ(stub_gecko.conn_request_count, sent + CON_REQUEST_RETRIES + 1);
+	test_check_request(CONN_POLICY_ACTIVE);
+	test_advance(TEST_RTCC_FREQ);
+	test_feedback();
+	CHECK(!conn_policy.request_pending);
+
+	/* The next quiet period asks for the idle parameters again, answered after one retry */
+	conn_policy_quiet();
+	test_schedule();
+	test_advance(TEST_REQUEST_TICKS + TEST_RTCC_FREQ);
+	CHECK_EQ(conn_policy.retries, 1);
+	test_feedback();
+	CHECK_EQ(conn_policy.interval, CON_IDLE_INTERVAL_MAX);
+	CHECK_EQ(conn_policy.retries, 0);
+	CHECK_EQ(conn_policy.give_up_count, 1);
+
+	/* A late answer of a timed out request is taken as the parameters in use */
+	conn_policy_activity();
+	test_schedule();
+	test_advance(TEST_REQUEST_TICKS);
+	CHECK_EQ(conn_policy.retries, 1);
+	conn_policy_parameters(CON_ACTIVE_INTERVAL_MAX, CON_ACTIVE_LATENCY, CON_ACTIVE_TIMEOUT);
+	CHECK(!conn_policy.request_pending);
+	CHECK_EQ(conn_policy.interval, CON_ACTIVE_INTERVAL_MAX);
+}
+
+
+/**
+ * @brief A scan while the idle request is ignored: the retry after the timeout asks for the active parameters.
+ */
+static void test_ignored_mode_change(void)
+{
+	test_connect(0);
+	test_feedback();
+	conn_policy_quiet();
+	test_schedule();
+	test_advance(TEST_REQUEST_TICKS / 2);
+	conn_policy_activity();
+	test_schedule();
+	CHECK_EQ(conn_policy.mode, CONN_POLICY_ACTIVE);
+	test_check_request(CONN_POLICY_IDLE);
+
+	test_advance(TEST_REQUEST_TICKS / 2);
+	CHECK_EQ(conn_policy.timeout_count, 1);
+	test_check_request(CONN_POLICY_ACTIVE);
+	test_feedback();
+	CHECK_EQ(conn_policy.interval, CON_ACTIVE_INTERVAL_MAX);
+	CHECK_EQ(conn_policy.retries, 0);
+}
+
+
+/**
+ * @brief A request the stack refuses is not pending and arms no timer, the next mode change requests again.
+ */
+static void test_refused(void)
+{
+	stub_reset();
+	stub_gecko.conn_request_result = bg_err_wrong_state;
+	timer_armed = false;
+	conn_policy_init(TEST_CONNECTION);
+	test_schedule();
+	CHECK(!conn_policy.request_pending);
+	CHECK(!timer_armed);
+	CHECK_EQ(stub_gecko.conn_request_count, 1);
+
+	stub_gecko.conn_request_result = bg_err_success;
+	conn_policy_quiet();
+	test_schedule();
+	test_check_request(CONN_POLICY_IDLE);
+	CHECK(timer_armed);
+}
+
+
+int main(void)
+{
+	test_limits();
+	test_switching();
+	test_ignored();
+	test_ignored_mode_change();
+	test_refused();
+
+	return test_exit("test_conn_policy");
+}
@@ -0,0 +1,217 @@
+/*
+ * @file test_flash_spi.c
+ * @brief Host tests of flash_spi.c on the MX25 model of stub.c: the boot with the flash left in deep power down by
+ * initBoard(), reads during a background erase, and the deadlines of the erase suspend and of the erase wait.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "stub.h"
+#include "mx25flash_spi.h"
+#include "inc/flash_spi.h"
+#include "inc/timing.h"
+
+
+#define TEST_SECTOR								(0x00020000)
+#define TEST_SIZE								(512)
+
+
+static uint8_t buffer[TEST_SIZE];
+
+
+/* Fakes of timing.c on the clock of the flash model, a wait lets the LDMA run and its interrupt fire */
+void timing_wait_us(uint32_t us)
+{
+	stub_mx25.time_ns += (uint64_t)us * 1000;
+	stub_irq_dispatch();
+}
+
+
+void timing_wait_ms(uint32_t ms)
+{
+	timing_wait_us(ms * 1000);
+}
+
+
+uint32_t timing_deadline_us(uint32_t us)
+{
+	return (uint32_t)(stub_mx25.time_ns / 1000) + us;
+}
+
+
+bool timing_expired(uint32_t deadline)
+{
+	stub_irq_dispatch();
+	return ((int32_t)((uint32_t)(stub_mx25.time_ns / 1000) - deadline) >= 0);
+}
+
+
+/**
+ * @brief This function powers the board up with a random flash content.
+ * @param deep_power_down true for the flash left in deep power down by initBoard()
+ * @return void
+ */
+static void test_power_up(bool deep_power_down)
+{
+	uint32_t seed = 0x5eed;
+
+	stub_reset();
+	memset(&flash_spi, 0, sizeof(struct flash_spi));
+	stub_mx25_power_up(deep_power_down);
+	for(uint32_t i = 0; i < STUB_MX25_SIZE; i++)
+	{
+		stub_mx25.memory[i] = (uint8_t)test_rand(&seed);
+	}
+
+	flash_spi_init();
+}
+
+
+/**
+ * @brief The first read after a boot with the flash in deep power down wakes it up and returns its content.
+ */
+static void test_boot_deep_power_down(void)
+{
+	test_power_up(true);
+
+	CHECK(flash_spi.asleep);
+	CHECK_EQ(flash_spi_read(0x1000, buffer, TEST_SIZE), 0);
+	CHECK(memcmp(buffer, &stub_mx25.memory[0x1000], TEST_SIZE) == 0);
+	CHECK_EQ(stub_mx25.wake_count, 1);
+	CHECK_EQ(stub_mx25.ignored_count, 0);
+
+	/* Back to deep power down and woken up again by the next access */
+	flash_spi_sleep();
+	CHECK(stub_mx25.deep_power_down);
+	CHECK_EQ(flash_spi_read(0x2345, buffer, 16), 0);
+	CHECK(memcmp(buffer, &stub_mx25.memory[0x2345], 16) == 0);
+	CHECK_EQ(stub_mx25.wake_count, 2);
+
+	/* The erase and the program are not ignored either */
+	test_power_up(true);
+	CHECK_EQ(flash_spi_erase_start(TEST_SECTOR), 0);
+	CHECK_EQ(flash_spi_erase_wait(), 0);
+	CHECK_EQ(flash_spi_program(TEST_SECTOR + 0x10, "journal", 7), 0);
+	CHECK(memcmp(&stub_mx25.memory[TEST_SECTOR + 0x10], "journal", 7) == 0);
+	CHECK_EQ(stub_mx25.memory[TEST_SECTOR + 0x17], 0xFF);
+	CHECK_EQ(stub_mx25.ignored_count, 0);
+	CHECK_EQ(flash_spi.error_count, 0);
+}
+
+
+/**
+ * @brief A boot with the flash already awake, after a reset that did not go through initBoard(), works the same.
+ */
+static void test_boot_awake(void)
+{
+	test_power_up(false);
+
+	CHECK_EQ(flash_spi_read(0x1000, buffer, TEST_SIZE), 0);
+	CHECK(memcmp(buffer, &stub_mx25.memory[0x1000], TEST_SIZE) == 0);
+	CHECK_EQ(stub_mx25.ignored_count, 0);
+	CHECK(!flash_spi.asleep);
+}
+
+
+/**
+ * @brief A read during a background erase suspends it and the erase still completes.
+ */
+static void test_erase_suspend(void)
+{
+	test_power_up(true);
+
+	CHECK_EQ(flash_spi_erase_start(TEST_SECTOR), 0);
+	CHECK(flash_spi_erase_busy());
+	CHECK_EQ(flash_spi_read(0x1000, buffer, TEST_SIZE), 0);
+	CHECK(memcmp(buffer, &stub_mx25.memory[0x1000], TEST_SIZE) == 0);
+	CHECK_EQ(flash_spi.suspend_count, 1);
+	CHECK_EQ(stub_mx25.suspend_count, 1);
+	CHECK(!stub_mx25.suspended);
+	CHECK_EQ(stub_mx25.busy_read_count, 0);
+
+	CHECK_EQ(flash_spi_erase_wait(), 0);
+	for(uint32_t i = 0; i < STUB_MX25_SECTOR_SIZE; i++)
+	{
+		if(stub_mx25.memory[TEST_SECTOR + i] != 0xFF)
+		{
+			CHECK(!"sector erased");
+			break;
+		}
+	}
+	CHECK_EQ(stub_sleep.block[sleepEM2], 0);
+}
+
+
+/**
+ * @brief An erase that does not suspend within FLASH_SPI_SUSPEND_TIMEOUT_US fails the read instead of hanging,
+ * and is resumed so that it does not stay suspended.
+ */
+static void test_suspend_timeout(void)
+{
+	test_power_up(true);
+
+	stub_mx25.suspend_ns = 10 * FLASH_SPI_SUSPEND_TIMEOUT_US * 1000ull;
+	CHECK_EQ(flash_spi_erase_start(TEST_SECTOR), 0);
+
+	uint64_t start = stub_mx25.time_ns;
+	CHECK_EQ(flash_spi_read(0x1000, buffer, TEST_SIZE), -1);
+	CHECK(stub_mx25.time_ns - start >= FLASH_SPI_SUSPEND_TIMEOUT_US * 1000ull);
+	CHECK(stub_mx25.time_ns - start < 2 * FLASH_SPI_SUSPEND_TIMEOUT_US * 1000ull);
+	CHECK_EQ(flash_spi.error_count, 1);
+	CHECK(!flash_spi.busy);
+	CHECK(!stub_mx25.suspended);
+	CHECK_EQ(stub_sleep.block[sleepEM2], 0);
+
+	CHECK_EQ(flash_spi_erase_wait(), 0);
+	CHECK_EQ(stub_mx25.memory[TEST_SECTOR], 0xFF);
+	CHECK_EQ(stub_mx25.memory[TEST_SECTOR + STUB_MX25_SECTOR_SIZE - 1], 0xFF);
+}
+
+
+/**
+ * @brief An erase running past FLASH_SPI_ERASE_TIMEOUT_MS, or a flash that stopped answering, ends the wait with an error.
+ */
+static void test_erase_timeout(void)
+{
+	test_power_up(true);
+
+	stub_mx25.erase_ns = 2 * FLASH_SPI_ERASE_TIMEOUT_MS * 1000000ull;
+	CHECK_EQ(flash_spi_erase_start(TEST_SECTOR), 0);
+
+	uint64_t start = stub_mx25.time_ns;
+	CHECK_EQ(flash_spi_erase_wait(), -1);
+	CHECK(stub_mx25.time_ns - start >= FLASH_SPI_ERASE_TIMEOUT_MS * 1000000ull);
+	CHECK(stub_mx25.time_ns - start < (FLASH_SPI_ERASE_TIMEOUT_MS + 10) * 1000000ull);
+	CHECK_EQ(flash_spi.error_count, 1);
+
+	/* Still followed, the next wait sees the end */
+	CHECK(flash_spi_erase_busy());
+	CHECK_EQ(flash_spi_erase_wait(), 0);
+	CHECK(!flash_spi_erase_busy());
+
+	/* The status of a flash without power reads busy forever */
+	CHECK_EQ(flash_spi_erase_start(TEST_SECTOR), 0);
+	stub_mx25.cut_ns = stub_mx25.time_ns + 1000;
+	start = stub_mx25.time_ns;
+	CHECK_EQ(flash_spi_erase_wait(), -1);
+	CHECK(stub_mx25.time_ns - start < (FLASH_SPI_ERASE_TIMEOUT_MS + 10) * 1000000ull);
+	CHECK(stub_mx25.off);
+}
+
+
+int main(void)
+{
+	test_boot_deep_power_down();
+	test_boot_awake();
+	test_erase_suspend();
+	test_suspend_timeout();
+	test_erase_timeout();
+
+	return test_exit("test_flash_spi");
+}
@@ -0,0 +1,466 @@
+/*
+ * @file test_i2c.c
+ * @brief Host tests of the interrupt driven I2C engine of i2c.c on the I2C0 bus model of stub.c, with the NTAG model
+ * as the slave.
+ *
+ * The transfers run from stub_irq_dispatch(), their callbacks from i2c_complete() once EVENT_I2C is signalled, as
+ * the bluetooth event loop does. The NTAG does not acknowledge its address while it programs its EEPROM, the reads
+ * behind a block write go through the address retries. The faults of the bus model end the transfer with the
+ * matching status and the next transfer must work: a NACK of a data byte, a lost arbitration, a bus error and a
+ * slave holding SCL low. A random campaign injects them on any byte and checks that every transfer ends once and
+ * that the memory of the NTAG only changes on a block write that ended with I2C_STATUS_DONE.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "stub.h"
+#include "inc/i2c.h"
+#include "inc/external_events.h"
+#include "inc/timing.h"
+
+
+#define TEST_QUEUE_SIZE							(6)
+#define TEST_CAMPAIGN_TRANSFERS					(4000)
+#define TEST_FAULT_PERCENT						(30)
+#define TEST_FAULT_BYTE_MAX						(24)								/* Beyond the bytes of a block read with a retry */
+
+
+static uint8_t shadow[256][STUB_NTAG_BLOCK_SIZE];		/* Expected memory of the NTAG */
+static uint32_t callback_count;
+static struct i2c_transfer *callback_order[TEST_QUEUE_SIZE];
+
+
+/* Fakes of timing.c on the clock of the bus model */
+void timing_wait_us(uint32_t us)
+{
+	stub_i2c.time_ns += (uint64_t)us * 1000;
+	stub_irq_dispatch();
+}
+
+
+void timing_wait_ms(uint32_t ms)
+{
+	timing_wait_us(ms * 1000);
+}
+
+
+/* The other interrupts of the models are not used */
+void LDMA_IRQHandler(void)
+{
+}
+
+
+void LEUART0_IRQHandler(void)
+{
+}
+
+
+/**
+ * @brief This function records the transfers in the order of their callback.
+ * @param struct i2c_transfer* transfer The transfer that ended
+ * @return void
+ */
+static void test_callback(struct i2c_transfer* transfer)
+{
+	if(callback_count < TEST_QUEUE_SIZE)
+	{
+		callback_order[callback_count] = transfer;
+	}
+	callback_count++;
+}
+
+
+/**
+ * @brief This function powers the board up with a random NTAG memory and initializes the engine.
+ * @param uint8_t sda_held_clocks Clocks a slave left in the middle of a byte holds SDA for
+ * @return void
+ */
+static void test_power_up(uint8_t sda_held_clocks)
+{
+	uint32_t seed = 0x12c;
+
+	stub_reset();
+	stub_ntag_power_up();
+	for(uint32_t block = 0; block < 256; block++)
+	{
+		for(uint8_t i = 0; i < STUB_NTAG_BLOCK_SIZE; i++)
+		{
+			stub_ntag.memory[block][i] = (uint8_t)test_rand(&seed);
+		}
+	}
+	memcpy(shadow, stub_ntag.memory, sizeof(shadow));
+
+	external_event = 0;
+	callback_count = 0;
+	stub_i2c.sda_held_clocks = sda_held_clocks;
+	i2c_init();
+}
+
+
+/**
+ * @brief This function runs the bus and hands the ended transfers to i2c_complete(), as the event loop does on
+ * EVENT_I2C, until the engine and its queue are idle.
+ * @param void
+ * @return void
+ */
+static void test_run(void)
+{
+	for(uint32_t guard = 0; guard < 1000; guard++)
+	{
+		stub_irq_dispatch();
+		if(!(stub_gecko.signals & EVENT_I2C))
+		{
+			break;
+		}
+
+		stub_gecko.signals &= ~EVENT_I2C;
+		external_event &= ~EVENT_I2C;
+		i2c_complete();
+	}
+
+	CHECK(!i2c_busy());
+	CHECK(i2c_engine.queue_head == NULL);
+	CHECK_EQ(stub_sleep.block[sleepEM2], 0);
+}
+
+
+/**
+ * @brief This function starts one transfer and runs it to its callback.
+ * @param struct i2c_transfer* transfer The transfer
+ * @return Status of the transfer.
+ */
+static enum i2c_status test_transfer(struct i2c_transfer* transfer)
+{
+	uint32_t count = callback_count;
+
+	transfer->callback = test_callback;
+	CHECK_EQ(i2c_transfer_start(transfer), 0);
+	test_run();
+	CHECK_EQ(callback_count, count + 1);
+
+	return transfer->status;
+}
+
+
+/**
+ * @brief A block written to the EEPROM reads back, the read waits for the end of the programming on the address
+ * retries. A block of the SRAM reads back at once.
+ */
+static void test_block(void)
+{
+	struct i2c_transfer transfer;
+	uint8_t data[STUB_NTAG_BLOCK_SIZE];
+	uint8_t read[STUB_NTAG_BLOCK_SIZE];
+
+	test_power_up(0);
+	for(uint8_t i = 0; i < STUB_NTAG_BLOCK_SIZE; i++)
+	{
+		data[i] = 0xA0 + i;
+	}
+
+	i2c_ntag_block_write(&transfer, 0x01, data);
+	CHECK_EQ(test_transfer(&transfer), I2C_STATUS_DONE);
+	CHECK_EQ(stub_ntag.program_count, 1);
+	CHECK(memcmp(stub_ntag.memory[0x01], data, sizeof(data)) == 0);
+	CHECK(memcmp(stub_ntag.memory[0x02], shadow[0x02], STUB_NTAG_BLOCK_SIZE) == 0);
+
+	i2c_ntag_block_read(&transfer, 0x01, read);
+	CHECK_EQ(test_transfer(&transfer), I2C_STATUS_DONE);
+	CHECK(memcmp(read, data, sizeof(data)) == 0);
+	CHECK(i2c_engine.retry_count > 0);
+	CHECK(i2c_engine.retry_count <= I2C_ADDRESS_RETRIES);
+	CHECK_EQ(stub_ntag.busy_nack_count, i2c_engine.retry_count);
+	CHECK(stub_i2c.time_ns >= stub_ntag.busy_until_ns);
+	fprintf(stderr, "test_i2c: read behind a block write, %u address retries, %.2f ms\n",
+			i2c_engine.retry_count, stub_i2c.time_ns / 1e6);
+
+	i2c_ntag_block_write(&transfer, STUB_NTAG_SRAM_BLOCK, data);
+	CHECK_EQ(test_transfer(&transfer), I2C_STATUS_DONE);
+	i2c_ntag_block_read(&transfer, STUB_NTAG_SRAM_BLOCK, read);
+	CHECK_EQ(test_transfer(&transfer), I2C_STATUS_DONE);
+	CHECK(memcmp(read, data, sizeof(data)) == 0);
+	CHECK_EQ(stub_ntag.sram_write_count, 1);
+	CHECK_EQ(stub_ntag.busy_nack_count, i2c_engine.retry_count);
+	CHECK_EQ(i2c_engine.error_count, 0);
+	CHECK_EQ(stub_i2c.start_count, stub_i2c.stop_count);
+}
+
+
+/**
+ * @brief The session registers read back, a masked write keeps the other bits and reading NS clears NDEF_DATA_READ.
+ */
+static void test_register(void)
+{
+	struct i2c_transfer transfer;
+	uint8_t value = 0;
+
+	test_power_up(0);
+
+	i2c_ntag_register_read(&transfer, NXP_NTAG_REG_NC, &value);
+	CHECK_EQ(test_transfer(&transfer), I2C_STATUS_DONE);
+	CHECK_EQ(value, 0x01);
+
+	i2c_ntag_register_write(&transfer, NXP_NTAG_REG_NC, NXP_NTAG_NC_SRAM_MIRROR | NXP_NTAG_NC_FD_OFF_MASK,
+							NXP_NTAG_NC_SRAM_MIRROR | NXP_NTAG_NC_FD_OFF_NDEF_READ);
+	CHECK_EQ(test_transfer(&transfer), I2C_STATUS_DONE);
+	CHECK_EQ(stub_ntag.session[NXP_NTAG_REG_NC], 0x01 | NXP_NTAG_NC_SRAM_MIRROR | NXP_NTAG_NC_FD_OFF_NDEF_READ);
+	CHECK_EQ(stub_ntag.register_write_count, 1);
+	CHECK_EQ(stub_ntag.program_count, 0);
+
+	stub_ntag.session[NXP_NTAG_REG_NS] |= NXP_NTAG_NS_NDEF_DATA_READ;
+	i2c_ntag_register_read(&transfer, NXP_NTAG_REG_NS, &value);
+	CHECK_EQ(test_transfer(&transfer), I2C_STATUS_DONE);
+	CHECK(value & NXP_NTAG_NS_NDEF_DATA_READ);
+	CHECK(!(stub_ntag.session[NXP_NTAG_REG_NS] & NXP_NTAG_NS_NDEF_DATA_READ));
+	CHECK_EQ(i2c_engine.retry_count, 0);
+}
+
+
+/**
+ * @brief Transfers queued behind a running one start in order once the bus is free, each with its own callback.
+ */
+static void test_queue(void)
+{
+	struct i2c_transfer transfers[TEST_QUEUE_SIZE];
+	uint8_t data[TEST_QUEUE_SIZE][STUB_NTAG_BLOCK_SIZE];
+	uint8_t read[STUB_NTAG_BLOCK_SIZE];
+
+	test_power_up(0);
+	for(uint8_t n = 0; n < TEST_QUEUE_SIZE - 1; n++)
+	{
+		memset(data[n], 0x10 * (n + 1), STUB_NTAG_BLOCK_SIZE);
+		i2c_ntag_block_write(&transfers[n], 0x08 + n, data[n]);
+	}
+	i2c_ntag_block_read(&transfers[TEST_QUEUE_SIZE - 1], 0x08, read);
+
+	for(uint8_t n = 0; n < TEST_QUEUE_SIZE; n++)
+	{
+		transfers[n].callback = test_callback;
+		CHECK_EQ(i2c_transfer_queue(&transfers[n]), 0);
+	}
+	CHECK_EQ(i2c_engine.queue_count, TEST_QUEUE_SIZE - 1);
+	CHECK_EQ(i2c_transfer_start(&transfers[0]), -1);
+
+	test_run();
+	CHECK_EQ(callback_count, TEST_QUEUE_SIZE);
+	for(uint8_t n = 0; n < TEST_QUEUE_SIZE; n++)
+	{
+		CHECK(callback_order[n] == &transfers[n]);
+		CHECK_EQ(transfers[n].status, I2C_STATUS_DONE);
+	}
+	for(uint8_t n = 0; n < TEST_QUEUE_SIZE - 1; n++)
+	{
+		CHECK(memcmp(stub_ntag.memory[0x08 + n], data[n], STUB_NTAG_BLOCK_SIZE) == 0);
+	}
+	CHECK(memcmp(read, data[0], STUB_NTAG_BLOCK_SIZE) == 0);
+	CHECK_EQ(stub_ntag.program_count, TEST_QUEUE_SIZE - 1);
+}
+
+
+/**
+ * @brief An address nobody acknowledges fails after all the retries, a data byte not acknowledged fails at once.
+ * Neither writes the memory.
+ */
+static void test_nack(void)
+{
+	struct i2c_transfer transfer;
+	uint8_t data[STUB_NTAG_BLOCK_SIZE] = {0};
+
+	test_power_up(0);
+
+	i2c_ntag_block_write(&transfer, 0x01, data);
+	transfer.address = 0xA0;
+	CHECK_EQ(test_transfer(&transfer), I2C_STATUS_NACK);
+	CHECK_EQ(stub_i2c.start_count, 1 + I2C_ADDRESS_RETRIES);
+	CHECK_EQ(stub_i2c.stop_count, stub_i2c.start_count);
+
+	/* MEMA past the user memory */
+	i2c_ntag_block_write(&transfer, STUB_NTAG_EEPROM_BLOCKS, data);
+	CHECK_EQ(test_transfer(&transfer), I2C_STATUS_NACK);
+
+	/* Eighth byte of the block */
+	stub_i2c.fault = STUB_I2C_FAULT_NACK;
+	stub_i2c.fault_byte = 10;
+	i2c_ntag_block_write(&transfer, 0x01, data);
+	CHECK_EQ(test_transfer(&transfer), I2C_STATUS_NACK);
+
+	CHECK_EQ(stub_ntag.program_count, 0);
+	CHECK(memcmp(stub_ntag.memory, shadow, sizeof(shadow)) == 0);
+	CHECK_EQ(i2c_engine.error_count, 3);
+	CHECK_EQ(stub_i2c.stop_count, stub_i2c.start_count);
+}
+
+
+/**
+ * @brief A lost arbitration, a bus error and a clock held low end the transfer with their status, the controller
+ * is aborted and the next transfer works.
+ */
+static void test_bus_fault(void)
+{
+	static const struct
+	{
+		enum stub_i2c_fault fault;
+		enum i2c_status status;
+	} faults[] = {
+		{STUB_I2C_FAULT_ARBLOST, I2C_STATUS_ARBLOST},
+		{STUB_I2C_FAULT_BUSERR, I2C_STATUS_BUSERR},
+		{STUB_I2C_FAULT_CLOCK_HELD, I2C_STATUS_TIMEOUT},
+	};
+	struct i2c_transfer transfer;
+	uint8_t data[STUB_NTAG_BLOCK_SIZE];
+	uint8_t read[STUB_NTAG_BLOCK_SIZE];
+
+	for(uint8_t n = 0; n < sizeof(faults) / sizeof(faults[0]); n++)
+	{
+		test_power_up(0);
+		memset(data, 0x5A + n, sizeof(data));
+
+		stub_i2c.fault = faults[n].fault;
+		stub_i2c.fault_byte = 5;
+		i2c_ntag_block_write(&transfer, 0x03, data);
+		CHECK_EQ(test_transfer(&transfer), faults[n].status);
+		CHECK_EQ(stub_ntag.program_count, 0);
+		CHECK_EQ(stub_i2c.abort_count, 1);
+		CHECK(!(stub_i2c0.STATE & I2C_STATE_BUSY));
+
+		/* The clock held low times out every transfer until the slave lets it go */
+		if(faults[n].fault == STUB_I2C_FAULT_CLOCK_HELD)
+		{
+			i2c_ntag_block_read(&transfer, 0x03, read);
+			CHECK_EQ(test_transfer(&transfer), I2C_STATUS_TIMEOUT);
+			CHECK(stub_i2c.time_ns >= 2 * STUB_I2C_CLTO_NS);
+			stub_i2c.clock_held = false;
+		}
+
+		i2c_ntag_block_write(&transfer, 0x03, data);
+		CHECK_EQ(test_transfer(&transfer), I2C_STATUS_DONE);
+		i2c_ntag_block_read(&transfer, 0x03, read);
+		CHECK_EQ(test_transfer(&transfer), I2C_STATUS_DONE);
+		CHECK(memcmp(read, data, sizeof(data)) == 0);
+	}
+}
+
+
+/**
+ * @brief A slave left holding SDA by a reset in the middle of a byte is freed by the clocks of i2c_init(). Without
+ * them the START loses the arbitration.
+ */
+static void test_bus_recovery(void)
+{
+	struct i2c_transfer transfer;
+	uint8_t value;
+
+	test_power_up(9);
+	CHECK_EQ(stub_i2c.sda_held_clocks, 0);
+	i2c_ntag_register_read(&transfer, NXP_NTAG_REG_NC, &value);
+	CHECK_EQ(test_transfer(&transfer), I2C_STATUS_DONE);
+
+	stub_i2c.sda_held_clocks = 9;
+	CHECK_EQ(test_transfer(&transfer), I2C_STATUS_ARBLOST);
+	stub_i2c.sda_held_clocks = 0;
+	CHECK_EQ(test_transfer(&transfer), I2C_STATUS_DONE);
+}
+
+
+/**
+ * @brief Random block writes, block reads and register reads with a fault on a random byte of one transfer in
+ * three. Every transfer ends once, a block write changes the memory only when it is done and a read that is done
+ * returns the memory.
+ */
+static void test_campaign(void)
+{
+	struct i2c_transfer transfer;
+	uint8_t data[STUB_NTAG_BLOCK_SIZE];
+	uint8_t read[STUB_NTAG_BLOCK_SIZE];
+	uint32_t status_count[I2C_STATUS_TIMEOUT + 1] = {0};
+	uint32_t seed = 0xca4;
+
+	test_power_up(0);
+	for(uint32_t n = 0; n < TEST_CAMPAIGN_TRANSFERS; n++)
+	{
+		uint32_t op = test_rand(&seed) % 3;
+		uint8_t block = (test_rand(&seed) % 2) ? (test_rand(&seed) % STUB_NTAG_EEPROM_BLOCKS) :
+						(STUB_NTAG_SRAM_BLOCK + (test_rand(&seed) % STUB_NTAG_SRAM_BLOCKS));
+		uint8_t value = 0;
+
+		if((test_rand(&seed) % 100) < TEST_FAULT_PERCENT)
+		{
+			stub_i2c.fault = 1 + (test_rand(&seed) % (STUB_I2C_FAULT_COUNT - 1));
+			stub_i2c.fault_byte = 1 + (test_rand(&seed) % TEST_FAULT_BYTE_MAX);
+		}
+
+		if(op == 0)
+		{
+			for(uint8_t i = 0; i < STUB_NTAG_BLOCK_SIZE; i++)
+			{
+				data[i] = (uint8_t)test_rand(&seed);
+			}
+			i2c_ntag_block_write(&transfer, block, data);
+		}
+		else if(op == 1)
+		{
+			i2c_ntag_block_read(&transfer, block, read);
+		}
+		else
+		{
+			i2c_ntag_register_read(&transfer, NXP_NTAG_REG_NC, &value);
+		}
+
+		status_count[test_transfer(&transfer)]++;
+		if(transfer.status == I2C_STATUS_DONE)
+		{
+			if(op == 0)
+			{
+				memcpy(shadow[block], data, STUB_NTAG_BLOCK_SIZE);
+			}
+			else if(op == 1)
+			{
+				CHECK(memcmp(read, shadow[block], STUB_NTAG_BLOCK_SIZE) == 0);
+			}
+			else
+			{
+				CHECK_EQ(value, stub_ntag.session[NXP_NTAG_REG_NC]);
+			}
+		}
+		CHECK(memcmp(stub_ntag.memory, shadow, sizeof(shadow)) == 0);
+
+		/* The fault is on this transfer only */
+		stub_i2c.fault_byte = 0;
+		stub_i2c.clock_held = false;
+	}
+
+	CHECK_EQ(callback_count, TEST_CAMPAIGN_TRANSFERS);
+	CHECK_EQ(i2c_engine.transfer_count, TEST_CAMPAIGN_TRANSFERS);
+	CHECK(status_count[I2C_STATUS_DONE] > TEST_CAMPAIGN_TRANSFERS / 2);
+	CHECK(status_count[I2C_STATUS_NACK] > 0);
+	CHECK(status_count[I2C_STATUS_ARBLOST] > 0);
+	CHECK(status_count[I2C_STATUS_BUSERR] > 0);
+	CHECK(status_count[I2C_STATUS_TIMEOUT] > 0);
+	CHECK_EQ(status_count[I2C_STATUS_BUSY], 0);
+	CHECK_EQ(stub_i2c.abort_count, status_count[I2C_STATUS_ARBLOST] + status_count[I2C_STATUS_BUSERR] +
+			 status_count[I2C_STATUS_TIMEOUT]);
+	fprintf(stderr, "test_i2c: campaign of %u transfers, %u done, %u nack, %u arblost, %u buserr, %u timeout, %u retries\n",
+			TEST_CAMPAIGN_TRANSFERS, status_count[I2C_STATUS_DONE], status_count[I2C_STATUS_NACK],
+			status_count[I2C_STATUS_ARBLOST], status_count[I2C_STATUS_BUSERR], status_count[I2C_STATUS_TIMEOUT],
+			i2c_engine.retry_count);
+}
+
+
+int main(void)
+{
+	test_block();
+	test_register();
+	test_queue();
+	test_nack();
+	test_bus_fault();
+	test_bus_recovery();
+	test_campaign();
+
+	return test_exit("test_i2c");
+}
@@ -0,0 +1,393 @@
+/*
+ * @file test_kv_store.c
+ * @brief Host tests of the key/value store on the internal flash model of stub.c, behind the em_msc.h stand-in.
+ *
+ * The model counts the erases of every page, the wear test flushes the values many times over and checks that
+ * the ring spreads the erases evenly and that the counts kept in the page headers match the model. The power loss
+ * test cuts the power in the middle of a word write or page erase, during a flush, a page change or the recovery at
+ * boot, and boots again: every key must read back its last flushed value, or the value of the flush that was cut.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "stub.h"
+#include "inc/kv_store.h"
+
+
+#define TEST_WEAR_FLUSHES						(50000)
+#define TEST_CUTS								(5000)
+#define TEST_CUT_SPAN							(60)								/* Operations before the cut, a few flushes */
+#define TEST_COMPACT_SPAN						(24)								/* Operations of a page change, at most */
+#define TEST_BOOT_CUT_PERCENT					(25)								/* Boots cut during their recovery */
+
+
+/* Value of a key as the test expects it, size 0 for none */
+struct test_value
+{
+	uint8_t data[KV_STORE_VALUE_MAXSIZE];
+	uint8_t size;
+};
+
+static struct test_value durable[KV_KEY_COUNT];		/* Flushed */
+static struct test_value pending[KV_KEY_COUNT];		/* Set, written by the next flush */
+static uint32_t seed = 0x4b56;
+static jmp_buf cut_jump;
+
+/* Statistics, kept out of the locals that a cut unwinds */
+static uint32_t compact_cuts;
+static uint32_t boot_cuts;
+
+
+/* The interrupts of the models are not used */
+void LDMA_IRQHandler(void)
+{
+}
+
+
+void LEUART0_IRQHandler(void)
+{
+}
+
+
+/**
+ * @brief This function sets a key to a random value of a random size, and keeps it as pending.
+ * @param uint8_t key The key
+ * @return void
+ */
+static void test_set(uint8_t key)
+{
+	struct test_value *value = &pending[key];
+
+	value->size = 1 + (test_rand(&seed) % KV_STORE_VALUE_MAXSIZE);
+	for(uint8_t i = 0; i < value->size; i++)
+	{
+		value->data[i] = (uint8_t)test_rand(&seed);
+	}
+	CHECK_EQ(kv_store_set(key, value->data, value->size), 0);
+}
+
+
+/**
+ * @brief This function tells if a key reads back a value.
+ * @param uint8_t key The key
+ * @param struct test_value* value Expected value
+ * @return true if the key holds the value, or has none when the size is 0.
+ */
+static bool test_holds(uint8_t key, const struct test_value *value)
+{
+	uint8_t data[KV_STORE_VALUE_MAXSIZE];
+	int size = kv_store_get(key, data, sizeof(data));
+
+	if(value->size == 0)
+	{
+		return (size == -1);
+	}
+
+	return ((size == value->size) && (memcmp(data, value->data, value->size) == 0));
+}
+
+
+/**
+ * @brief This function checks the statistics of the model against the header of the pages.
+ * @param uint32_t lag Erases a page header may miss or count too many, after power cuts
+ * @return void
+ */
+static void test_erase_counts(uint32_t lag)
+{
+	for(uint8_t page = 0; page < KV_STORE_PAGE_COUNT; page++)
+	{
+		uint32_t model = stub_msc.erase_count[page];
+		uint32_t header = kv_store.erase_count[page];
+
+		CHECK(((header >= model) ? (header - model) : (model - header)) <= lag);
+	}
+	CHECK_EQ(stub_msc.overwrite_count, 0);
+	CHECK_EQ(stub_msc.invalid_count, 0);
+}
+
+
+/**
+ * @brief A blank region and a region holding anything are formatted, every page of the garbage is erased once.
+ */
+static void test_format(void)
+{
+	stub_msc_format();
+	CHECK_EQ(kv_store_init(), 0);
+	CHECK(kv_store.ready);
+	CHECK_EQ(kv_store.page, 0);
+	CHECK_EQ(kv_store.generation, 1);
+	CHECK_EQ(kv_store_get_u32(KV_KEY_CART_ID, 7), 7);
+	for(uint8_t page = 0; page < KV_STORE_PAGE_COUNT; page++)
+	{
+		CHECK_EQ(stub_msc.erase_count[page], 0);
+	}
+
+	for(uint32_t i = 0; i < STUB_MSC_SIZE / 4; i++)
+	{
+		stub_msc.memory[i] = test_rand(&seed);
+	}
+	CHECK_EQ(kv_store_init(), 0);
+	CHECK_EQ(kv_store.page, 0);
+	CHECK_EQ(kv_store_get_u32(KV_KEY_BOOT_COUNT, 0), 0);
+	for(uint8_t page = 0; page < KV_STORE_PAGE_COUNT; page++)
+	{
+		CHECK_EQ(stub_msc.erase_count[page], 1);
+		CHECK_EQ(kv_store.erase_count[page], 1);
+	}
+	test_erase_counts(0);
+}
+
+
+/**
+ * @brief Flushed values survive a reset, values only set do not.
+ */
+static void test_persistence(void)
+{
+	stub_msc_format();
+	CHECK_EQ(kv_store_init(), 0);
+
+	CHECK(!kv_store_dirty());
+	CHECK_EQ(kv_store_set_u32(KV_KEY_CART_ID, 1234), 0);
+	CHECK_EQ(kv_store_set_u32(KV_KEY_BOOT_COUNT, 1), 0);
+	CHECK(kv_store_dirty());
+	CHECK_EQ(kv_store_flush(), 0);
+	CHECK(!kv_store_dirty());
+
+	/* An unchanged value is not written again */
+	uint32_t words = stub_msc.word_write_count;
+	CHECK_EQ(kv_store_set_u32(KV_KEY_CART_ID, 1234), 0);
+	CHECK(!kv_store_dirty());
+	CHECK_EQ(kv_store_flush(), 0);
+	CHECK_EQ(stub_msc.word_write_count, words);
+
+	/* Two words for a changed uint32_t, and the header again to close the record */
+	CHECK_EQ(kv_store_set_u32(KV_KEY_BOOT_COUNT, 2), 0);
+	CHECK_EQ(kv_store_flush(), 0);
+	CHECK_EQ(stub_msc.word_write_count, words + 3);
+	CHECK_EQ(kv_store_set_u32(KV_KEY_SCAN_COUNT, 99), 0);
+
+	/* Keys and sizes out of range */
+	CHECK_EQ(kv_store_set(KV_KEY_COUNT, "x", 1), -1);
+	CHECK_EQ(kv_store_set(KV_KEY_CART_ID, "x", 0), -1);
+	CHECK_EQ(kv_store_set(KV_KEY_CART_ID, "01234567890123456", KV_STORE_VALUE_MAXSIZE + 1), -1);
+
+	CHECK_EQ(kv_store_init(), 0);
+	CHECK_EQ(kv_store_get_u32(KV_KEY_CART_ID, 0), 1234);
+	CHECK_EQ(kv_store_get_u32(KV_KEY_BOOT_COUNT, 0), 2);
+	CHECK_EQ(kv_store_get_u32(KV_KEY_SCAN_COUNT, 0), 0);
+	CHECK_EQ(kv_store.corrupt_count, 0);
+	test_erase_counts(0);
+}
+
+
+/**
+ * @brief Many flushes go around the ring, every page is erased in turn.
+ */
+static void test_wear(void)
+{
+	uint64_t time_ns;
+	uint64_t flush_max_ns = 0;
+	uint32_t erase_min = UINT32_MAX;
+	uint32_t erase_max = 0;
+	uint32_t erase_total = 0;
+
+	stub_msc_format();
+	CHECK_EQ(kv_store_init(), 0);
+	memset(pending, 0, sizeof(pending));
+
+	time_ns = stub_msc.time_ns;
+	for(uint32_t i = 0; i < TEST_WEAR_FLUSHES; i++)
+	{
+		uint64_t start_ns = stub_msc.time_ns;
+
+		test_set(test_rand(&seed) % KV_KEY_COUNT);
+		CHECK_EQ(kv_store_flush(), 0);
+		flush_max_ns = ((stub_msc.time_ns - start_ns) > flush_max_ns) ? (stub_msc.time_ns - start_ns) : flush_max_ns;
+	}
+	time_ns = stub_msc.time_ns - time_ns;
+
+	for(uint8_t page = 0; page < KV_STORE_PAGE_COUNT; page++)
+	{
+		erase_min = (stub_msc.erase_count[page] < erase_min) ? stub_msc.erase_count[page] : erase_min;
+		erase_max = (stub_msc.erase_count[page] > erase_max) ? stub_msc.erase_count[page] : erase_max;
+		erase_total += stub_msc.erase_count[page];
+	}
+	CHECK(erase_max - erase_min <= 1);
+	CHECK(erase_total > 0);
+	CHECK_EQ(kv_store.compact_count, erase_total + 1);
+	test_erase_counts(0);
+
+	CHECK_EQ(kv_store_init(), 0);
+	for(uint8_t key = 0; key < KV_KEY_COUNT; key++)
+	{
+		CHECK(test_holds(key, &pending[key]));
+	}
+	test_erase_counts(0);
+
+	fprintf(stderr, "%u flushes: %lu to %lu erases per page, %.0f flushes per erase, %lu word writes\n",
+			TEST_WEAR_FLUSHES, (unsigned long)erase_min, (unsigned long)erase_max,
+			(double)TEST_WEAR_FLUSHES / erase_total, (unsigned long)stub_msc.word_write_count);
+	fprintf(stderr, "   CPU stalled %.1f us per flush on average, %.1f ms at most\n",
+			time_ns / 1000.0 / TEST_WEAR_FLUSHES, flush_max_ns / 1000000.0);
+}
+
+
+/**
+ * @brief This function tells if the next flush changes page.
+ * @param void
+ * @return true if the dirty records do not fit in the page in use.
+ */
+static bool test_compact_next(void)
+{
+	uint16_t size = 0;
+
+	for(uint8_t key = 0; key < KV_KEY_COUNT; key++)
+	{
+		if(kv_store.dirty & (1UL << key))
+		{
+			size += 4 + ((pending[key].size + 3) & ~3);
+		}
+	}
+
+	return (kv_store.compact_pending || ((kv_store.offset + size) > FLASH_PAGE_SIZE));
+}
+
+
+/**
+ * @brief This function boots after a power cut, the recovery itself is cut at times.
+ * @param void
+ * @return void
+ */
+static void test_boot(void)
+{
+	if((test_rand(&seed) % 100) < TEST_BOOT_CUT_PERCENT)
+	{
+		stub_msc.cut_operation = stub_msc.operation_count + 1 + (test_rand(&seed) % 8);
+		stub_msc.cut_seed = test_rand(&seed);
+	}
+
+	while(setjmp(cut_jump) != 0)
+	{
+		boot_cuts++;
+	}
+	CHECK_EQ(kv_store_init(), 0);
+	stub_msc.cut_operation = 0;
+}
+
+
+/**
+ * @brief Power cuts during flushes, page changes and boots never lose a flushed value.
+ */
+static void test_power_cuts(void)
+{
+	uint32_t new_count = 0;
+	uint32_t corrupt = 0;
+	uint32_t lag_max = 0;
+	uint32_t erase_min = UINT32_MAX;
+	uint32_t erase_max = 0;
+
+	stub_msc_format();
+	CHECK_EQ(kv_store_init(), 0);
+	memset(durable, 0, sizeof(durable));
+	memset(pending, 0, sizeof(pending));
+	stub_msc.cut_jump = &cut_jump;
+
+	for(uint32_t cut = 0; cut < TEST_CUTS; cut++)
+	{
+		/* Every other cut is aimed at a page change, its erases and the recovery at the next boot */
+		bool compact = (cut & 1);
+
+		stub_msc.cut_operation = compact ? 0 : (stub_msc.operation_count + 1 + (test_rand(&seed) % TEST_CUT_SPAN));
+		stub_msc.cut_seed = test_rand(&seed);
+
+		/* Flushes until the power is cut, the flushed values become durable */
+		if(setjmp(cut_jump) == 0)
+		{
+			while(true)
+			{
+				uint8_t count = 1 + (test_rand(&seed) % KV_KEY_COUNT);
+
+				for(uint8_t i = 0; i < count; i++)
+				{
+					test_set(test_rand(&seed) % KV_KEY_COUNT);
+				}
+				if(compact && (stub_msc.cut_operation == 0) && test_compact_next())
+				{
+					stub_msc.cut_operation = stub_msc.operation_count + 1 + (test_rand(&seed) % TEST_COMPACT_SPAN);
+					compact_cuts++;
+				}
+				CHECK_EQ(kv_store_flush(), 0);
+				memcpy(durable, pending, sizeof(durable));
+			}
+		}
+
+		test_boot();
+		corrupt += kv_store.corrupt_count;
+
+		/* The flush cut short is either lost or complete, key by key */
+		for(uint8_t key = 0; key < KV_KEY_COUNT; key++)
+		{
+			bool old = test_holds(key, &durable[key]);
+			bool new = test_holds(key, &pending[key]);
+
+			CHECK(old || new);
+			new_count += (!old && new);
+			pending[key] = new ? pending[key] : durable[key];
+		}
+		memcpy(durable, pending, sizeof(durable));
+
+		/* A count lost right after an erase is recovered from the largest one */
+		for(uint8_t page = 0; page < KV_STORE_PAGE_COUNT; page++)
+		{
+			uint32_t model = stub_msc.erase_count[page];
+			uint32_t header = kv_store.erase_count[page];
+			uint32_t lag = (header >= model) ? (header - model) : (model - header);
+
+			lag_max = (lag > lag_max) ? lag : lag_max;
+		}
+
+		/* The store works on after the boot */
+		test_set(test_rand(&seed) % KV_KEY_COUNT);
+		CHECK_EQ(kv_store_flush(), 0);
+		memcpy(durable, pending, sizeof(durable));
+	}
+	stub_msc.cut_jump = NULL;
+
+	CHECK_EQ(kv_store_init(), 0);
+	for(uint8_t key = 0; key < KV_KEY_COUNT; key++)
+	{
+		CHECK(test_holds(key, &durable[key]));
+	}
+	CHECK_EQ(stub_msc.overwrite_count, 0);
+	CHECK_EQ(stub_msc.invalid_count, 0);
+	for(uint8_t page = 0; page < KV_STORE_PAGE_COUNT; page++)
+	{
+		erase_min = (stub_msc.erase_count[page] < erase_min) ? stub_msc.erase_count[page] : erase_min;
+		erase_max = (stub_msc.erase_count[page] > erase_max) ? stub_msc.erase_count[page] : erase_max;
+	}
+
+	/* A count lost by a cut is taken from the page before in the ring, it does not drift far */
+	CHECK(lag_max <= erase_max / 16);
+
+	fprintf(stderr, "%u power cuts, %lu in a page change: %lu boots cut too, %lu flushes kept, %lu corrupt records skipped\n",
+			TEST_CUTS, (unsigned long)compact_cuts, (unsigned long)boot_cuts, (unsigned long)new_count, (unsigned long)corrupt);
+	fprintf(stderr, "   erase counts in the page headers off by %lu at most, %lu to %lu erases per page\n",
+			(unsigned long)lag_max, (unsigned long)erase_min, (unsigned long)erase_max);
+}
+
+
+int main(void)
+{
+	test_format();
+	test_persistence();
+	test_wear();
+	test_power_cuts();
+
+	return test_exit("test_kv_store");
+}
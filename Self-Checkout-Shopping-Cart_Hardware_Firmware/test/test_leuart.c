@@ -0,0 +1,562 @@
+/*
+ * @file test_leuart.c
+ * @brief Host test of the LEUART0 receive ring buffer and of the barcode frames going through it.
+ *
+ * The ring is checked on its own (wrap around, peek/consume spans, overruns), then synthetic bursts of barcode
+ * frames from the scanner model go through the receive path selected in inc/leuart.h, the LDMA by default or
+ * the per byte interrupt when built with -DLEUART_RX_INTERRUPT. The event loop only runs when EVENT_LEUART was
+ * signalled, as on the target. The stress test adds a late or failing LDMA and a late event loop.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+#include "stub/stub.h"
+#include "inc/leuart.h"
+#include "inc/barcode.h"
+#include "inc/external_events.h"
+#include "inc/payload_pool.h"
+
+
+#define TEST_FRAME_COUNT						(20000)
+
+
+/* Frames received by the event loop, checked against the frames sent by the scanner */
+static uint32_t received_count;
+static uint32_t received_bad;
+static uint32_t next_expected;
+
+
+/* The LDMA interrupt is shared with the external flash reads */
+void flash_spi_ldma_irq(uint32_t flags)
+{
+	(void)flags;
+}
+
+
+/**
+ * @brief This function resets the ring, the parser and the peripheral models and starts the receiver.
+ * @param void
+ * @return void
+ */
+static void test_setup(void)
+{
+	stub_reset();
+	memset(&leuart_circbuff, 0, sizeof(leuart_circbuff));
+	memset(&barcode_parser, 0, sizeof(barcode_parser));
+	barcode_parser_init(&barcode_parser);
+	payload_pool_init();
+	external_event = 0;
+	received_count = 0;
+	received_bad = 0;
+	next_expected = 0;
+	leuart_init();
+}
+
+
+/**
+ * @brief This function writes one byte into the ring through the interrupt path producer.
+ * @param data Byte to write.
+ * @return void
+ */
+static void test_push(char data)
+{
+	stub_leuart.fifo[0] = (uint8_t)data;
+	stub_leuart.fifo_count = 1;
+	leuart_buffer_push();
+}
+
+
+/**
+ * @brief This function reads n bytes from the ring with peek/consume, following the wrap around.
+ * @param out Filled with the bytes read.
+ * @param n Number of bytes to read.
+ * @return Number of bytes read
+ */
+static uint32_t test_read(char *out, uint32_t n)
+{
+	const char *data;
+	uint32_t size;
+	uint32_t read = 0;
+
+	while((read < n) && ((size = leuart_buffer_peek(0, &data)) > 0))
+	{
+		if(size > (n - read))
+		{
+			size = n - read;
+		}
+		memcpy(&out[read], data, size);
+		leuart_buffer_consume(size);
+		read += size;
+	}
+
+	return read;
+}
+
+
+static void test_ring_wraparound(void)
+{
+	char out[LEUART_BUFFER_MAXSIZE];
+	const char *data;
+
+	memset(&leuart_circbuff, 0, sizeof(leuart_circbuff));
+	stub_reset();
+
+	/* Move the read position close to the end of the buffer memory */
+	for(uint32_t i = 0; i < (LEUART_BUFFER_MAXSIZE - 10); i++)
+	{
+		test_push('x');
+	}
+	leuart_buffer_consume(LEUART_BUFFER_MAXSIZE - 10);
+	CHECK(leuart_buffer_empty_status());
+
+	for(uint32_t i = 0; i < 100; i++)
+	{
+		test_push((char)i);
+	}
+	CHECK_EQ(leuart_buffer_count(), 100);
+
+	/* The first span stops at the end of the buffer memory, the second one starts at its beginning */
+	CHECK_EQ(leuart_buffer_peek(0, &data), 10);
+	CHECK(data == &leuart_circbuff.buffer[LEUART_BUFFER_MAXSIZE - 10]);
+	CHECK_EQ(leuart_buffer_peek(10, &data), 90);
+	CHECK(data == &leuart_circbuff.buffer[0]);
+	CHECK_EQ(leuart_buffer_peek(5, &data), 5);
+	CHECK_EQ(data[0], 5);
+	CHECK_EQ(leuart_buffer_peek(99, &data), 1);
+	CHECK_EQ(data[0], 99);
+	CHECK_EQ(leuart_buffer_peek(100, &data), 0);
+
+	CHECK_EQ(test_read(out, 100), 100);
+	for(uint32_t i = 0; i < 100; i++)
+	{
+		CHECK_EQ(out[i], (char)i);
+	}
+
+	/* Consume is limited to the available data, pop returns -1 on an empty buffer */
+	test_push('a');
+	leuart_buffer_consume(10);
+	CHECK(leuart_buffer_empty_status());
+	CHECK_EQ((int)leuart_buffer_pop(), -1);
+
+	/* The free running counters keep working across the 32 bit wrap */
+	leuart_circbuff.head = 0xFFFFFFF0u;
+	leuart_circbuff.tail = 0xFFFFFFF0u;
+	for(uint32_t i = 0; i < 32; i++)
+	{
+		test_push((char)('A' + i));
+	}
+	CHECK_EQ(leuart_buffer_count(), 32);
+	CHECK_EQ(test_read(out, 32), 32);
+	CHECK_EQ(out[0], 'A');
+	CHECK_EQ(out[31], 'A' + 31);
+	CHECK_EQ(leuart_circbuff.overrun_count, 0);
+}
+
+
+static void test_ring_overrun(void)
+{
+	char out[LEUART_BUFFER_MAXSIZE];
+
+	memset(&leuart_circbuff, 0, sizeof(leuart_circbuff));
+	stub_reset();
+
+	/* Interrupt path: the buffer keeps the old data and counts the new bytes it had to drop */
+	for(uint32_t i = 0; i < (LEUART_BUFFER_MAXSIZE + 10); i++)
+	{
+		test_push((char)i);
+	}
+	CHECK_EQ(leuart_buffer_count(), LEUART_BUFFER_MAXSIZE);
+	CHECK_EQ(leuart_circbuff.overrun_count, 10);
+	CHECK_EQ(test_read(out, LEUART_BUFFER_MAXSIZE), LEUART_BUFFER_MAXSIZE);
+	CHECK_EQ(out[0], 0);
+	CHECK_EQ(out[LEUART_BUFFER_MAXSIZE - 1], (char)(LEUART_BUFFER_MAXSIZE - 1));
+
+	/* LDMA path: the producer wrapped over unread data, all of it is discarded */
+	leuart_circbuff.head = leuart_circbuff.tail + LEUART_BUFFER_MAXSIZE + 88;
+	CHECK_EQ(leuart_buffer_count(), 0);
+	CHECK_EQ(leuart_circbuff.overrun_count, 10 + LEUART_BUFFER_MAXSIZE + 88);
+	CHECK(leuart_circbuff.tail == leuart_circbuff.head);
+}
+
+
+/**
+ * @brief This function builds the frame with sequence number n, a named frame or a code frame.
+ * @param n Sequence number.
+ * @param frame Filled with the NULL terminated frame.
+ * @return void
+ */
+static void test_frame(uint32_t n, char *frame)
+{
+	if(n % 3 == 2)
+	{
+		sprintf(frame, "~#%lu`", 4006381000000ul + n);
+	}
+	else
+	{
+		char name[64];
+		int size = sprintf(name, "item_%lu%.*s", (unsigned long)n, (int)(n % 37), "abcdefghijklmnopqrstuvwxyz0123456789_");
+
+		sprintf(frame, "~%03d%03lu%s`", size, (unsigned long)(n % 1000), name);
+	}
+}
+
+
+/**
+ * @brief This function runs the part of the event loop handling EVENT_LEUART, when it was signalled.
+ * Every received frame must be the next one sent by the scanner, the frames lost to an overrun are skipped.
+ * @param void
+ * @return void
+ */
+static void test_event_loop(void)
+{
+	struct barcode_frame frame;
+	struct barcode_packet packet;
+
+	if(!(stub_gecko.signals & EVENT_LEUART))
+	{
+		return;
+	}
+	stub_gecko.signals &= ~EVENT_LEUART;
+	external_event &= ~EVENT_LEUART;
+	leuart_circbuff.wakeup_count++;
+
+	while(barcode_parser_run(&barcode_parser, &frame))
+	{
+		char expected[64];
+		char got[64];
+		uint32_t n;
+
+		/* Frames lost to an overrun are skipped, the order must never change */
+		for(n = next_expected; n < next_expected + 64; n++)
+		{
+			test_frame(n, expected);
+			if(frame.code_digits)
+			{
+				sprintf(got, "~#%llu`", (unsigned long long)frame.code);
+			}
+			else
+			{
+				CHECK(barcode_packet_create(&packet, &frame) >= 0);
+				sprintf(got, "~%03u%03u%s`", frame.payload_size, frame.cost, packet.payload);
+				payload_pool_free(packet.payload);
+			}
+
+			if(strcmp(expected, got) == 0)
+			{
+				break;
+			}
+		}
+
+		if(n == next_expected + 64)
+		{
+			received_bad++;
+		}
+		else
+		{
+			next_expected = n + 1;
+			received_count++;
+		}
+		barcode_frame_release(&barcode_parser, &frame);
+	}
+}
+
+
+/**
+ * @brief This function sends frames in bursts of random size with the carriage return of the scanner between
+ * the frames, the event loop runs after every burst. A burst never holds more than the ring buffer, no frame may be lost.
+ * @param void
+ * @return void
+ */
+static void test_bursts(void)
+{
+	uint32_t seed = 0x1234567;
+	uint32_t sent = 0;
+	uint64_t start;
+	uint64_t bytes = 0;
+	char frame[64];
+
+	test_setup();
+	start = test_clock_ns();
+
+	while(sent < TEST_FRAME_COUNT)
+	{
+		uint32_t burst = 0;
+		uint32_t frames = 1 + (test_rand(&seed) % 6);
+
+		for(uint32_t i = 0; (i < frames) && (sent < TEST_FRAME_COUNT); i++)
+		{
+			test_frame(sent, frame);
+			if((burst + strlen(frame) + 2) > LEUART_BUFFER_MAXSIZE)
+			{
+				break;
+			}
+
+			/* The carriage return of the scanner is dropped by the blocked receiver */
+			stub_leuart_receive_string(frame);
+			stub_leuart_receive('\r');
+			burst += strlen(frame) + 1;
+			sent++;
+		}
+
+		bytes += burst;
+		test_event_loop();
+	}
+
+	CHECK_EQ(received_count, TEST_FRAME_COUNT);
+	CHECK_EQ(received_bad, 0);
+	CHECK_EQ(leuart_circbuff.frame_count, TEST_FRAME_COUNT);
+	CHECK_EQ(leuart_circbuff.overrun_count, 0);
+	CHECK_EQ(barcode_parser.truncated_count, 0);
+	CHECK_EQ(barcode_parser.garbage_count, 0);
+	CHECK_EQ(stub_leuart.overflow_count, 0);
+	CHECK_EQ(stub_leuart.blocked_count, TEST_FRAME_COUNT);
+	CHECK(leuart_buffer_empty_status());
+	CHECK_EQ(stub_core_nesting, 0);
+
+	fprintf(stderr, "bursts: %lu frames, %lu bytes, %lu wakeups, %.1f ns per received byte\n", (unsigned long)received_count,
+			(unsigned long)bytes, (unsigned long)leuart_circbuff.wakeup_count, (double)(test_clock_ns() - start) / (double)bytes);
+}
+
+
+/**
+ * @brief This function lets the scanner outrun the event loop. The frames caught in the overrun are lost,
+ * the ones after it must all be received, in order.
+ * @param void
+ * @return void
+ */
+static void test_burst_overrun(void)
+{
+	char frame[64];
+	uint32_t sent = 0;
+	uint32_t received;
+
+	test_setup();
+
+	/* Three buffers worth of frames without running the event loop */
+	while(sent < 60)
+	{
+		test_frame(sent++, frame);
+		stub_leuart_receive_string(frame);
+	}
+	test_event_loop();
+	CHECK(leuart_circbuff.overrun_count > 0);
+
+	received = received_count;
+	for(uint32_t i = 0; i < 40; i++)
+	{
+		test_frame(sent++, frame);
+		stub_leuart_receive_string(frame);
+		test_event_loop();
+	}
+	CHECK_EQ(received_count - received, 40);
+	CHECK_EQ(next_expected, sent);
+	CHECK_EQ(received_bad, 0);
+}
+
+
+#ifdef LEUART_RX_LDMA
+/**
+ * @brief This function checks the LDMA error path. The interrupt handler must only stop the channel and signal
+ * the event loop, the ring indexes belong to the consumer, which restarts the channel.
+ * @param void
+ * @return void
+ */
+static void test_ldma_error(void)
+{
+	char frame[64];
+	uint32_t tail;
+	uint32_t head;
+	uint32_t sent = 0;
+
+	test_setup();
+
+	/* A complete frame and half of the next one are waiting in the buffer, the consumer has read some of it */
+	test_frame(sent++, frame);
+	stub_leuart_receive_string(frame);
+	stub_leuart_receive_string("~010");
+	leuart_buffer_consume(3);
+	stub_gecko.signals = 0;
+	tail = leuart_circbuff.tail;
+	head = leuart_circbuff.head;
+
+	stub_ldma_error(LEUART_RX_LDMA_CHANNEL);
+	CHECK_EQ(leuart_circbuff.tail, tail);
+	CHECK_EQ(leuart_circbuff.head, head);
+	CHECK(leuart_circbuff.resync);
+	CHECK(!(stub_ldma.CHEN & (1 << LEUART_RX_LDMA_CHANNEL)));
+	CHECK(stub_gecko.signals & EVENT_LEUART);
+
+	/* The event loop restarts the channel and drops the data it could not trust */
+	test_event_loop();
+	CHECK(!leuart_circbuff.resync);
+	CHECK_EQ(leuart_circbuff.resync_count, 1);
+	stub_irq_dispatch();
+	CHECK(stub_ldma.CHEN & (1 << LEUART_RX_LDMA_CHANNEL));
+	CHECK_EQ(leuart_circbuff.overrun_count, head - tail);
+	CHECK_EQ(received_count, 0);
+
+	/* The receiver is still blocked after the signal frame, the rest of the partial frame is dropped in hardware */
+	stub_leuart_receive_string("001abcdefghij`");
+	for(uint32_t i = 0; i < 30; i++)
+	{
+		next_expected = sent;
+		test_frame(sent++, frame);
+		stub_leuart_receive_string(frame);
+		test_event_loop();
+	}
+	CHECK_EQ(received_count, 30);
+	CHECK_EQ(received_bad, 0);
+	CHECK_EQ(stub_core_nesting, 0);
+}
+
+
+/**
+ * @brief This function checks the signal frame handler when the postamble is not moved by the LDMA in time.
+ * The handler must not spin on RXDATAV, the postamble is published by the LDMA handler once it has been moved.
+ * @param void
+ * @return void
+ */
+static void test_ldma_late(void)
+{
+	char frame[64];
+
+	test_setup();
+
+	/* The LDMA is late, the frame is still received as soon as the postamble has been moved */
+	stub_ldma_model.late = true;
+	test_frame(0, frame);
+	stub_leuart_receive_string(frame);
+	CHECK(leuart_circbuff.drain_timeout_count > 0);
+	test_event_loop();
+	CHECK_EQ(received_count, 1);
+
+	/* The channel stopped in the middle of a frame, RXDATA is never emptied. The handler returns and the
+	   frame is dropped once the error interrupt restarted the channel */
+	stub_ldma_model.late = false;
+	test_frame(1, frame);
+	stub_leuart_receive_string("~012");
+	stub_ldma_halt(LEUART_RX_LDMA_CHANNEL);
+	stub_leuart_receive_string(&frame[4]);
+	CHECK(stub_leuart.overflow_count > 0);
+	stub_ldma_error(LEUART_RX_LDMA_CHANNEL);
+	test_event_loop();
+	CHECK_EQ(received_count, 1);
+
+	test_frame(2, frame);
+	stub_leuart_receive_string(frame);
+	test_event_loop();
+	CHECK_EQ(received_count, 2);
+	CHECK_EQ(next_expected, 3);
+	CHECK_EQ(received_bad, 0);
+}
+#endif
+
+
+/**
+ * @brief Stress test of the receive path. The LDMA is randomly late or stopped on an error in the middle of a frame,
+ * and the event loop randomly skips its turn so that the scanner overruns the buffer. Frames may only be lost around
+ * an overrun or an error, they are never reordered or corrupted, and every undisturbed burst is received completely.
+ * @param void
+ * @return void
+ */
+static void test_stress(void)
+{
+	uint32_t seed = 0xC0FFEE;
+	uint32_t sent = 0;
+	uint32_t disturbed = 0;
+	uint32_t clean = 0;
+	char frame[64];
+
+	test_setup();
+
+	while(sent < (10 * TEST_FRAME_COUNT))
+	{
+		uint32_t overrun_count = leuart_circbuff.overrun_count;
+		uint32_t frames = 1 + (test_rand(&seed) % 8);
+		bool error = false;
+
+		for(uint32_t i = 0; i < frames; i++)
+		{
+			uint32_t r = test_rand(&seed);
+
+			test_frame(sent++, frame);
+#ifdef LEUART_RX_LDMA
+			stub_ldma_model.late = ((r & 0x3) == 0);
+			if((r & 0x3FF) == 1)
+			{
+				/* Bus error in the middle of the frame */
+				size_t half = strlen(frame) / 2;
+
+				frame[half] = '\0';
+				stub_leuart_receive_string(frame);
+				stub_ldma_halt(LEUART_RX_LDMA_CHANNEL);
+				test_frame(sent - 1, frame);
+				stub_leuart_receive_string(&frame[half]);
+				stub_ldma_error(LEUART_RX_LDMA_CHANNEL);
+				error = true;
+				continue;
+			}
+#endif
+			stub_leuart_receive_string(frame);
+			stub_leuart_receive('\r');
+
+			/* The event loop is late */
+			if((r & 0x70) != 0)
+			{
+				test_event_loop();
+			}
+		}
+
+		/* Sometimes late for a whole burst */
+		if(test_rand(&seed) & 0x7)
+		{
+			test_event_loop();
+		}
+
+		if(error || (leuart_circbuff.overrun_count != overrun_count) || (stub_gecko.signals & EVENT_LEUART))
+		{
+			disturbed++;
+		}
+		else
+		{
+			CHECK_EQ(next_expected, sent);
+			clean++;
+		}
+	}
+
+	CHECK_EQ(received_bad, 0);
+	CHECK(clean > disturbed);
+	CHECK_EQ(stub_core_nesting, 0);
+
+	fprintf(stderr, "stress: %lu frames sent, %lu received, %lu/%lu bursts disturbed, %lu overrun bytes, %lu resyncs, "
+			"%lu late postambles\n", (unsigned long)sent, (unsigned long)received_count, (unsigned long)disturbed,
+			(unsigned long)(disturbed + clean), (unsigned long)leuart_circbuff.overrun_count,
+			(unsigned long)leuart_circbuff.resync_count, (unsigned long)leuart_circbuff.drain_timeout_count);
+}
+
+
+int main(void)
+{
+	/* A handler spinning on the hardware never returns, fail instead of hanging */
+	alarm(60);
+
+	test_ring_wraparound();
+	test_ring_overrun();
+	test_bursts();
+	test_burst_overrun();
+	test_stress();
+#ifdef LEUART_RX_LDMA
+	test_ldma_error();
+	test_ldma_late();
+	return test_exit("test_leuart (LDMA)");
+#else
+	return test_exit("test_leuart (interrupt)");
+#endif
+}
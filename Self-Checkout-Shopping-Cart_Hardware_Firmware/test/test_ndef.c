@@ -0,0 +1,360 @@
+/*
+ * @file test_ndef.c
+ * @brief Host tests of the NDEF records of ndef.c and of the tag update on the NTAG model of stub.c.
+ *
+ * The EEPROM and the SRAM images are compared byte for byte with vectors written out by hand from the NFC Forum
+ * Type 2 tag TLVs, the NDEF short record and the Bluetooth LE AD structures, and walked as a reader would: the TLV
+ * length must end on the terminator and the AD lengths must add up to the payload length. The update at boot must
+ * write a blank tag, leave a tag that is up to date alone and only write the blocks that differ. A publish must
+ * write the SRAM record without programming the EEPROM, set up the mirror and hand the SRAM over to the NFC side.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "stub.h"
+#include "inc/ndef.h"
+#include "inc/i2c.h"
+#include "inc/external_events.h"
+#include "inc/timing.h"
+
+
+#define TEST_TLV_SIZE							(62)								/* From the message TLV to the terminator */
+#define TEST_PAYLOAD_OFFSET						(5 + 32)							/* TLV, record header and type */
+#define TEST_SESSION_ID							(0x0A0B0C0D)
+#define TEST_NC									(0x01 | NXP_NTAG_NC_SRAM_MIRROR | NXP_NTAG_NC_FD_ON_FIELD | NXP_NTAG_NC_FD_OFF_NDEF_READ)
+
+
+static const uint8_t address[NDEF_BLE_ADDRESS_SIZE] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+static const uint8_t token[NDEF_TOKEN_SIZE] = {0x0D, 0x0C, 0x0B, 0x0A, 0xE1, 0xE2, 0xE3, 0xE4};
+static const uint8_t nonce[NDEF_TOKEN_NONCE_SIZE] = {0xE1, 0xE2, 0xE3, 0xE4};
+
+/* EEPROM record of the address above */
+static const uint8_t ble_oob_vector[NDEF_BLE_OOB_SIZE] =
+{
+	0x03, 0x3B,																/* NDEF message TLV, 59 bytes */
+	0xD2, 0x20, 0x18,														/* MB ME SR, media type, type of 32 bytes, payload of 24 */
+	'a', 'p', 'p', 'l', 'i', 'c', 'a', 't', 'i', 'o', 'n', '/',
+	'v', 'n', 'd', '.', 'b', 'l', 'u', 'e', 't', 'o', 'o', 't', 'h', '.', 'l', 'e', '.', 'o', 'o', 'b',
+	0x08, 0x1B, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x00,					/* LE Bluetooth device address, public */
+	0x02, 0x1C, 0x00,														/* LE role, peripheral only */
+	0x0B, 0x09, 'A', 's', 'h', 'w', 'a', 't', 'h', 'a', 'm', 'a',			/* Complete local name */
+	0xFE,																	/* Terminator TLV */
+	0x00, 0x00
+};
+
+/* SRAM record of the address and token above */
+static const uint8_t ble_oob_session_vector[NDEF_BLE_OOB_SIZE] =
+{
+	0x03, 0x3B,
+	0xD2, 0x20, 0x18,
+	'a', 'p', 'p', 'l', 'i', 'c', 'a', 't', 'i', 'o', 'n', '/',
+	'v', 'n', 'd', '.', 'b', 'l', 'u', 'e', 't', 'o', 'o', 't', 'h', '.', 'l', 'e', '.', 'o', 'o', 'b',
+	0x08, 0x1B, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x00,
+	0x02, 0x1C, 0x00,
+	0x0B, 0xFF, 0xFF, 0xFF, 0x0D, 0x0C, 0x0B, 0x0A, 0xE1, 0xE2, 0xE3, 0xE4,	/* Manufacturer data, no company, token */
+	0xFE,
+	0x00, 0x00
+};
+
+
+/* Fakes of timing.c, the bus recovery of i2c_init() moves the clock of the bus model */
+void timing_wait_us(uint32_t us)
+{
+	stub_i2c.time_ns += (uint64_t)us * 1000;
+	stub_irq_dispatch();
+}
+
+
+void timing_wait_ms(uint32_t ms)
+{
+	timing_wait_us(ms * 1000);
+}
+
+
+/* The other interrupts of the models are not used */
+void LDMA_IRQHandler(void)
+{
+}
+
+
+void LEUART0_IRQHandler(void)
+{
+}
+
+
+/**
+ * @brief This function walks a tag image as a reader does and checks the lengths.
+ * @param uint8_t* image NDEF_BLE_OOB_SIZE bytes
+ * @return void
+ */
+static void test_walk(const uint8_t *image)
+{
+	uint8_t payload_length = image[4];
+	uint8_t offset = TEST_PAYLOAD_OFFSET;
+
+	CHECK_EQ(image[0], 0x03);
+	CHECK_EQ(2 + image[1], TEST_TLV_SIZE - 1);
+	CHECK_EQ(image[2 + image[1]], 0xFE);
+	CHECK_EQ(3 + image[3] + payload_length, image[1]);
+
+	/* The AD structures fill the payload exactly */
+	while(offset < TEST_PAYLOAD_OFFSET + payload_length)
+	{
+		CHECK(image[offset] > 0);
+		offset += 1 + image[offset];
+	}
+	CHECK_EQ(offset, TEST_PAYLOAD_OFFSET + payload_length);
+
+	for(uint8_t i = TEST_TLV_SIZE; i < NDEF_BLE_OOB_SIZE; i++)
+	{
+		CHECK_EQ(image[i], 0);
+	}
+}
+
+
+/**
+ * @brief This function runs the bus and hands the ended transfers to ndef.c, as the event loop does on EVENT_I2C.
+ * @param void
+ * @return void
+ */
+static void test_run(void)
+{
+	for(uint32_t guard = 0; guard < 1000; guard++)
+	{
+		stub_irq_dispatch();
+		if(!(stub_gecko.signals & EVENT_I2C))
+		{
+			break;
+		}
+
+		stub_gecko.signals &= ~EVENT_I2C;
+		external_event &= ~EVENT_I2C;
+		i2c_complete();
+	}
+
+	CHECK(!i2c_busy());
+	CHECK_EQ(ndef_tag.step, NDEF_TAG_IDLE);
+}
+
+
+/**
+ * @brief This function boots the cart with the tag left as it is and runs the update of the EEPROM record.
+ * @param uint8_t* boot_address Bluetooth address of the cart
+ * @return void
+ */
+static void test_boot(const uint8_t *boot_address)
+{
+	stub_reset();
+	stub_ntag_power_up();
+	memset(&ndef_tag, 0, sizeof(struct ndef_tag));
+	external_event = 0;
+	i2c_init();
+
+	CHECK_EQ(ndef_tag_update(boot_address), 0);
+	test_run();
+	CHECK_EQ(ndef_tag.error_count, 0);
+}
+
+
+/**
+ * @brief The EEPROM record matches the vector byte for byte and reads as a well formed TLV.
+ */
+static void test_ble_oob(void)
+{
+	uint8_t image[NDEF_BLE_OOB_SIZE];
+
+	memset(image, 0xA5, sizeof(image));
+	ndef_ble_oob_build(image, address);
+	CHECK(memcmp(image, ble_oob_vector, NDEF_BLE_OOB_SIZE) == 0);
+	test_walk(image);
+	test_walk(ble_oob_vector);
+}
+
+
+/**
+ * @brief The SRAM record matches the vector byte for byte and reads as a well formed TLV.
+ */
+static void test_ble_oob_session(void)
+{
+	uint8_t image[NDEF_BLE_OOB_SIZE];
+
+	memset(image, 0xA5, sizeof(image));
+	ndef_ble_oob_session_build(image, address, token);
+	CHECK(memcmp(image, ble_oob_session_vector, NDEF_BLE_OOB_SIZE) == 0);
+	test_walk(image);
+	test_walk(ble_oob_session_vector);
+}
+
+
+/**
+ * @brief The scan response holds the name AD structure of the EEPROM record and the token AD structure of the SRAM one.
+ */
+static void test_scan_response(void)
+{
+	uint8_t data[NDEF_SCAN_RESPONSE_MAXSIZE];
+	uint8_t size;
+
+	memset(&ndef_tag, 0, sizeof(struct ndef_tag));
+	memcpy(ndef_tag.address, address, NDEF_BLE_ADDRESS_SIZE);
+	memcpy(ndef_tag.token, token, NDEF_TOKEN_SIZE);
+
+	size = ndef_scan_response_build(data);
+	CHECK_EQ(size, 24);
+	CHECK(memcmp(data, &ble_oob_vector[49], 12) == 0);
+	CHECK(memcmp(&data[12], &ble_oob_session_vector[49], 12) == 0);
+}
+
+
+/**
+ * @brief A blank tag is written, a tag that is up to date is only read and a new address only rewrites its block.
+ */
+static void test_update(void)
+{
+	uint8_t other[NDEF_BLE_ADDRESS_SIZE] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x77};
+	uint8_t vector[NDEF_BLE_OOB_SIZE];
+
+	memset(stub_ntag.memory, 0, sizeof(stub_ntag.memory));
+	test_boot(address);
+	CHECK(memcmp(stub_ntag.memory[NDEF_TAG_FIRST_BLOCK], ble_oob_vector, NDEF_BLE_OOB_SIZE) == 0);
+	CHECK_EQ(ndef_tag.write_count, NDEF_BLE_OOB_BLOCKS);
+	CHECK_EQ(stub_ntag.program_count, NDEF_BLE_OOB_BLOCKS);
+
+	test_boot(address);
+	CHECK_EQ(ndef_tag.write_count, 0);
+	CHECK_EQ(ndef_tag.skip_count, NDEF_BLE_OOB_BLOCKS);
+	CHECK_EQ(stub_ntag.program_count, 0);
+	CHECK_EQ(stub_ntag.block_read_count, NDEF_BLE_OOB_BLOCKS);
+
+	/* The last byte of the address is in the third block */
+	memcpy(vector, ble_oob_vector, sizeof(vector));
+	vector[44] = 0x77;
+	test_boot(other);
+	CHECK(memcmp(stub_ntag.memory[NDEF_TAG_FIRST_BLOCK], vector, NDEF_BLE_OOB_SIZE) == 0);
+	CHECK_EQ(ndef_tag.write_count, 1);
+	CHECK_EQ(stub_ntag.program_count, 1);
+
+	/* The block 0 of the NTAG and the blocks after the record are not touched */
+	CHECK_EQ(stub_ntag.memory[0][0], 0);
+	CHECK_EQ(stub_ntag.memory[NDEF_TAG_FIRST_BLOCK + NDEF_BLE_OOB_BLOCKS][0], 0);
+}
+
+
+/**
+ * @brief This function checks that the SRAM holds the session record of a token and is handed over to the NFC side.
+ * @param uint8_t* expected_token The last token published
+ * @return void
+ */
+static void test_sram(const uint8_t *expected_token)
+{
+	uint8_t vector[NDEF_BLE_OOB_SIZE];
+
+	memcpy(vector, ble_oob_session_vector, sizeof(vector));
+	memcpy(&vector[53], expected_token, NDEF_TOKEN_SIZE);
+	CHECK(memcmp(stub_ntag.memory[NXP_NTAG_SRAM_BLOCK], vector, NDEF_BLE_OOB_SIZE) == 0);
+	CHECK_EQ(stub_ntag.session[NXP_NTAG_REG_SRAM_MIRROR_BLOCK], NDEF_TAG_FIRST_BLOCK);
+	CHECK_EQ(stub_ntag.session[NXP_NTAG_REG_LAST_NDEF_BLOCK], NDEF_TAG_FIRST_BLOCK + NDEF_BLE_OOB_BLOCKS - 1);
+	CHECK_EQ(stub_ntag.session[NXP_NTAG_REG_NC], TEST_NC);
+	CHECK(!(stub_ntag.session[NXP_NTAG_REG_NS] & NXP_NTAG_NS_I2C_LOCKED));
+	CHECK(ndef_tag.mirror);
+	CHECK(ndef_tag_configured(stub_ntag.session[NXP_NTAG_REG_NC]));
+}
+
+
+/**
+ * @brief A publish writes the SRAM record and sets up the mirror once, the next ones only write the SRAM. The
+ * EEPROM is never programmed.
+ */
+static void test_publish(void)
+{
+	uint8_t second[NDEF_TOKEN_SIZE] = {0x0E, 0x0C, 0x0B, 0x0A, 0x01, 0x02, 0x03, 0x04};
+
+	test_boot(address);
+	stub_ntag.program_count = 0;
+	ndef_tag_publish(TEST_SESSION_ID, nonce);
+	test_run();
+	test_sram(token);
+	CHECK_EQ(stub_ntag.program_count, 0);
+	CHECK_EQ(stub_ntag.sram_write_count, NDEF_BLE_OOB_BLOCKS);
+	CHECK_EQ(stub_ntag.register_write_count, 4);
+	CHECK_EQ(ndef_tag.publish_count, 1);
+
+	ndef_tag_publish(TEST_SESSION_ID + 1, &second[4]);
+	test_run();
+	test_sram(second);
+	CHECK_EQ(stub_ntag.program_count, 0);
+	CHECK_EQ(stub_ntag.sram_write_count, 2 * NDEF_BLE_OOB_BLOCKS);
+	CHECK_EQ(stub_ntag.register_write_count, 5);
+	CHECK_EQ(ndef_tag.publish_count, 2);
+	CHECK_EQ(ndef_tag.error_count, 0);
+}
+
+
+/**
+ * @brief Publishes during the update at boot are written once it is over, only the last token.
+ */
+static void test_publish_pending(void)
+{
+	uint8_t last[NDEF_TOKEN_SIZE] = {0x0F, 0x0C, 0x0B, 0x0A, 0x05, 0x06, 0x07, 0x08};
+
+	memset(stub_ntag.memory, 0, sizeof(stub_ntag.memory));
+	stub_reset();
+	stub_ntag_power_up();
+	memset(&ndef_tag, 0, sizeof(struct ndef_tag));
+	external_event = 0;
+	i2c_init();
+
+	CHECK_EQ(ndef_tag_update(address), 0);
+	ndef_tag_publish(TEST_SESSION_ID, nonce);
+	ndef_tag_publish(TEST_SESSION_ID + 2, &last[4]);
+	CHECK_EQ(ndef_tag_update(address), -1);
+	test_run();
+
+	CHECK(memcmp(stub_ntag.memory[NDEF_TAG_FIRST_BLOCK], ble_oob_vector, NDEF_BLE_OOB_SIZE) == 0);
+	test_sram(last);
+	CHECK_EQ(stub_ntag.program_count, NDEF_BLE_OOB_BLOCKS);
+	CHECK_EQ(stub_ntag.sram_write_count, NDEF_BLE_OOB_BLOCKS);
+	CHECK_EQ(ndef_tag.publish_count, 1);
+	CHECK_EQ(ndef_tag.error_count, 0);
+}
+
+
+/**
+ * @brief The NTAG loses its session registers when it loses power, the next publish sets the mirror up again.
+ */
+static void test_mirror_lost(void)
+{
+	test_boot(address);
+	ndef_tag_publish(TEST_SESSION_ID, nonce);
+	test_run();
+	CHECK(ndef_tag.mirror);
+
+	stub_ntag_power_up();
+	stub_ntag.program_count = 0;
+	CHECK(!ndef_tag_configured(stub_ntag.session[NXP_NTAG_REG_NC]));
+	CHECK(!ndef_tag.mirror);
+
+	ndef_tag_publish(TEST_SESSION_ID, nonce);
+	test_run();
+	test_sram(token);
+	CHECK_EQ(stub_ntag.program_count, 0);
+}
+
+
+int main(void)
+{
+	test_ble_oob();
+	test_ble_oob_session();
+	test_scan_response();
+	test_update();
+	test_publish();
+	test_publish_pending();
+	test_mirror_lost();
+
+	return test_exit("test_ndef");
+}
@@ -0,0 +1,333 @@
+/*
+ * @file test_nfc_event.c
+ * @brief Host tests of the NFC event service of nfc_event.c on the NTAG and I2C0 bus models of stub.c.
+ *
+ * The tests play the phone: the field sets RF_FIELD_PRESENT in NS_REG, the read of the last NDEF block sets
+ * NDEF_DATA_READ, and FD moves as the NC_REG of ndef.c sets it up, pulled low when the field comes on and released
+ * when the record was read or the field goes off. Every FD edge calls nfc_event_edge() as the event loop does on
+ * EVENT_NFC_GPIO, the register reads run from stub_irq_dispatch() and i2c_complete(). The edge to event
+ * classification is checked on single taps, on a field that goes off without an edge after a read, and on edges that
+ * come in while the registers are being read.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "stub.h"
+#include "em_rtcc.h"
+#include "inc/nfc_event.h"
+#include "inc/ndef.h"
+#include "inc/i2c.h"
+#include "inc/gpio.h"
+#include "inc/external_events.h"
+#include "inc/timing.h"
+
+
+#define TEST_NC									(0x01 | NXP_NTAG_NC_SRAM_MIRROR | NXP_NTAG_NC_FD_ON_FIELD | NXP_NTAG_NC_FD_OFF_NDEF_READ)
+#define TEST_EVENT_MAX							(NFC_EVENT_QUEUE_SIZE)
+
+
+/* Fakes of timing.c on the clock of the bus model */
+void timing_wait_us(uint32_t us)
+{
+	stub_i2c.time_ns += (uint64_t)us * 1000;
+	stub_irq_dispatch();
+}
+
+
+void timing_wait_ms(uint32_t ms)
+{
+	timing_wait_us(ms * 1000);
+}
+
+
+/* The other interrupts of the models are not used */
+void LDMA_IRQHandler(void)
+{
+}
+
+
+void LEUART0_IRQHandler(void)
+{
+}
+
+
+/**
+ * @brief This function powers the board up with the NTAG set up for the mirror by ndef.c, FD released.
+ * @param void
+ * @return void
+ */
+static void test_power_up(void)
+{
+	stub_reset();
+	stub_ntag_power_up();
+	stub_ntag.session[NXP_NTAG_REG_NC] = TEST_NC;
+	stub_gpio.in[GPIO_NFC_PORT] |= (1 << GPIO_NFC_PIN);
+	memset(&ndef_tag, 0, sizeof(struct ndef_tag));
+	ndef_tag.mirror = true;
+
+	external_event = 0;
+	i2c_init();
+	nfc_event_init();
+}
+
+
+/**
+ * @brief This function runs the register reads to their callbacks, as the event loop does on EVENT_I2C.
+ * @param void
+ * @return void
+ */
+static void test_run(void)
+{
+	for(uint32_t guard = 0; guard < 1000; guard++)
+	{
+		stub_irq_dispatch();
+		if(!(stub_gecko.signals & EVENT_I2C))
+		{
+			break;
+		}
+
+		stub_gecko.signals &= ~EVENT_I2C;
+		external_event &= ~EVENT_I2C;
+		i2c_complete();
+	}
+
+	CHECK(!i2c_busy());
+	CHECK(!nfc_event_service.reading);
+}
+
+
+/**
+ * @brief This function moves FD and hands the edge to the service at an RTCC counter value.
+ * @param bool low true when FD is pulled low
+ * @param uint32_t counter RTCC counter value of the edge
+ * @return void
+ */
+static void test_fd(bool low, uint32_t counter)
+{
+	if(low)
+	{
+		stub_gpio.in[GPIO_NFC_PORT] &= ~(1 << GPIO_NFC_PIN);
+	}
+	else
+	{
+		stub_gpio.in[GPIO_NFC_PORT] |= (1 << GPIO_NFC_PIN);
+	}
+
+	stub_rtcc.counter = counter;
+	nfc_event_edge();
+}
+
+
+/**
+ * @brief The phone brings the field.
+ * @param uint32_t counter RTCC counter value of the edge
+ * @return void
+ */
+static void test_field_on(uint32_t counter)
+{
+	stub_ntag.session[NXP_NTAG_REG_NS] |= NXP_NTAG_NS_RF_FIELD_PRESENT;
+	test_fd(true, counter);
+}
+
+
+/**
+ * @brief The phone reads the last NDEF block, FD is released.
+ * @param uint32_t counter RTCC counter value of the edge
+ * @return void
+ */
+static void test_record_read(uint32_t counter)
+{
+	stub_ntag.session[NXP_NTAG_REG_NS] |= NXP_NTAG_NS_NDEF_DATA_READ;
+	test_fd(false, counter);
+}
+
+
+/**
+ * @brief The phone goes away, FD is released if it was still low. After a read there is no edge.
+ * @param uint32_t counter RTCC counter value of the edge
+ * @return void
+ */
+static void test_field_off(uint32_t counter)
+{
+	stub_ntag.session[NXP_NTAG_REG_NS] &= ~NXP_NTAG_NS_RF_FIELD_PRESENT;
+	if(!GPIO_PinInGet(GPIO_NFC_PORT, GPIO_NFC_PIN))
+	{
+		test_fd(false, counter);
+	}
+}
+
+
+/**
+ * @brief This function checks the queued events, in order, and that EVENT_NFC was signalled for them.
+ * @param const enum nfc_event_type* type Expected events
+ * @param const uint32_t* timestamp Expected RTCC counter values of the events
+ * @param uint8_t count Number of expected events
+ * @return void
+ */
+static void test_expect(const enum nfc_event_type* type, const uint32_t* timestamp, uint8_t count)
+{
+	struct nfc_event event;
+	uint8_t n = 0;
+
+	CHECK_EQ(!!(stub_gecko.signals & EVENT_NFC), count > 0);
+	stub_gecko.signals &= ~EVENT_NFC;
+	external_event &= ~EVENT_NFC;
+
+	while(nfc_event_get(&event))
+	{
+		if(n < count)
+		{
+			CHECK_EQ(event.type, type[n]);
+			CHECK_EQ(event.timestamp, timestamp[n]);
+		}
+		n++;
+	}
+	CHECK_EQ(n, count);
+}
+
+
+/**
+ * @brief A tap without a read: field on at the falling edge and field off at the rising one.
+ */
+static void test_tap(void)
+{
+	static const enum nfc_event_type on[] = {NFC_EVENT_FIELD_ON};
+	static const enum nfc_event_type off[] = {NFC_EVENT_FIELD_OFF};
+
+	test_power_up();
+	test_field_on(100);
+	test_run();
+	test_expect(on, (const uint32_t[]){100}, 1);
+	CHECK(nfc_event_service.field);
+
+	test_field_off(900);
+	test_run();
+	test_expect(off, (const uint32_t[]){900}, 1);
+	CHECK(!nfc_event_service.field);
+
+	CHECK_EQ(nfc_event_service.edge_count, 2);
+	CHECK_EQ(nfc_event_service.error_count, 0);
+	CHECK_EQ(nfc_event_service.config_lost_count, 0);
+}
+
+
+/**
+ * @brief A tap with a read: the rising edge of the read is a read done, the field goes off without an edge and the
+ * next field on ends the tap before it. The read of NS_REG clears NDEF_DATA_READ, it is reported once.
+ */
+static void test_read_folds_field_off(void)
+{
+	static const enum nfc_event_type on[] = {NFC_EVENT_FIELD_ON};
+	static const enum nfc_event_type read[] = {NFC_EVENT_READ_DONE};
+	static const enum nfc_event_type next[] = {NFC_EVENT_FIELD_OFF, NFC_EVENT_FIELD_ON};
+
+	test_power_up();
+	test_field_on(100);
+	test_run();
+	test_expect(on, (const uint32_t[]){100}, 1);
+
+	test_record_read(400);
+	test_run();
+	test_expect(read, (const uint32_t[]){400}, 1);
+	CHECK_EQ(stub_ntag.session[NXP_NTAG_REG_NS] & NXP_NTAG_NS_NDEF_DATA_READ, 0);
+	CHECK(nfc_event_service.field);
+
+	/* No edge, nothing is read */
+	test_field_off(900);
+	test_run();
+	test_expect(NULL, NULL, 0);
+	CHECK_EQ(nfc_event_service.edge_count, 2);
+	CHECK(nfc_event_service.field);
+
+	/* The next tap, its field on keeps the time of its edge */
+	test_field_on(5000);
+	test_run();
+	test_expect(next, (const uint32_t[]){5000, 5000}, 2);
+	CHECK(nfc_event_service.field);
+}
+
+
+/**
+ * @brief The phone reads the record while NS_REG of the field on is being read: the two edges give one more read,
+ * the field on keeps the time of the falling edge and the read done has the time of the rising one.
+ */
+static void test_edges_during_read(void)
+{
+	static const enum nfc_event_type events[] = {NFC_EVENT_FIELD_ON, NFC_EVENT_READ_DONE};
+
+	test_power_up();
+	test_field_on(100);
+	test_record_read(130);
+	CHECK(nfc_event_service.again);
+	test_run();
+	test_expect(events, (const uint32_t[]){100, 130}, 2);
+	CHECK_EQ(nfc_event_service.edge_count, 2);
+	CHECK(nfc_event_service.field);
+
+	/* A short tap fully within a read, NS_REG no longer has the field */
+	test_power_up();
+	test_field_on(100);
+	test_field_off(120);
+	test_run();
+	test_expect((const enum nfc_event_type[]){NFC_EVENT_FIELD_ON, NFC_EVENT_FIELD_OFF}, (const uint32_t[]){100, 120}, 2);
+	CHECK(!nfc_event_service.field);
+
+	/* Two taps within a read, the first one is lost and the second one is reported once */
+	test_power_up();
+	test_field_on(100);
+	test_field_off(120);
+	test_field_on(140);
+	test_run();
+	test_expect((const enum nfc_event_type[]){NFC_EVENT_FIELD_ON}, (const uint32_t[]){140}, 1);
+	CHECK(nfc_event_service.field);
+	CHECK_EQ(nfc_event_service.edge_count, 3);
+}
+
+
+/**
+ * @brief Taps the application does not take are counted once the queue is full, and an NTAG that came back with its
+ * power on NC_REG is counted as a lost configuration.
+ */
+static void test_overflow_and_config_lost(void)
+{
+	uint32_t counter = 0;
+
+	test_power_up();
+	for(uint8_t n = 0; n < 5; n++)
+	{
+		test_field_on(counter += 100);
+		test_run();
+		test_field_off(counter += 100);
+		test_run();
+	}
+	CHECK_EQ(nfc_event_service.event_count[NFC_EVENT_FIELD_ON], 5);
+	CHECK_EQ(nfc_event_service.event_count[NFC_EVENT_FIELD_OFF], 5);
+	CHECK_EQ(nfc_event_service.dropped_count, 10 - TEST_EVENT_MAX);
+	CHECK_EQ(nfc_event_service.head - nfc_event_service.tail, TEST_EVENT_MAX);
+
+	/* The NTAG lost its power, FD is pulled low with the default NC_REG */
+	test_power_up();
+	stub_ntag_power_up();
+	test_field_on(100);
+	test_run();
+	test_expect((const enum nfc_event_type[]){NFC_EVENT_FIELD_ON}, (const uint32_t[]){100}, 1);
+	CHECK_EQ(nfc_event_service.config_lost_count, 1);
+	CHECK(!ndef_tag.mirror);
+}
+
+
+int main(void)
+{
+	test_tap();
+	test_read_folds_field_off();
+	test_edges_during_read();
+	test_overflow_and_config_lost();
+
+	return test_exit("test_nfc_event");
+}
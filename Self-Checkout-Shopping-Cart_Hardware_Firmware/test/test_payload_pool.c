@@ -0,0 +1,189 @@
+/*
+ * @file test_payload_pool.c
+ * @brief Host test of the payload pool over millions of random alloc/free cycles.
+ *
+ * Every allocation is filled with a pattern checked when it is freed, so overlapping blocks are caught. An allocation
+ * may only fail when every size class big enough is used up, which is what zero fragmentation means for the pool,
+ * and once everything has been freed the whole pool is available again.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "inc/payload_pool.h"
+
+
+#define TEST_CYCLES								(4000000)
+#define TEST_LIVE_MAXCOUNT						(PAYLOAD_POOL_SMALL_COUNT + PAYLOAD_POOL_MEDIUM_COUNT + \
+												 PAYLOAD_POOL_LARGE_COUNT + PAYLOAD_POOL_MAX_COUNT)
+
+
+static const uint16_t class_size[PAYLOAD_POOL_CLASS_COUNT] =
+{
+	PAYLOAD_POOL_SMALL_SIZE, PAYLOAD_POOL_MEDIUM_SIZE, PAYLOAD_POOL_LARGE_SIZE, PAYLOAD_POOL_MAX_SIZE
+};
+
+static const uint16_t class_count[PAYLOAD_POOL_CLASS_COUNT] =
+{
+	PAYLOAD_POOL_SMALL_COUNT, PAYLOAD_POOL_MEDIUM_COUNT, PAYLOAD_POOL_LARGE_COUNT, PAYLOAD_POOL_MAX_COUNT
+};
+
+
+/* Blocks currently allocated by the test */
+struct live_block
+{
+	char *block;
+	uint16_t size;
+	uint8_t pattern;
+};
+
+static struct live_block live[TEST_LIVE_MAXCOUNT + 1];
+static uint32_t live_count;
+
+
+/**
+ * @brief This function returns a payload size, mostly short product names and sometimes up to the biggest frame.
+ * @param seed Random generator state.
+ * @return Size in bytes, NULL character included
+ */
+static uint16_t test_size(uint32_t *seed)
+{
+	uint32_t r = test_rand(seed);
+
+	switch(r % 16)
+	{
+	case 0:
+		return 1 + ((r >> 8) % (BARCODE_PAYLOAD_MAXSIZE + 1));
+	case 1:
+	case 2:
+		return 1 + ((r >> 8) % PAYLOAD_POOL_LARGE_SIZE);
+	default:
+		return 1 + ((r >> 8) % PAYLOAD_POOL_MEDIUM_SIZE);
+	}
+}
+
+
+/**
+ * @brief This function checks and frees one of the live blocks.
+ * @param index Index of the block in live.
+ * @return void
+ */
+static void test_free(uint32_t index)
+{
+	struct live_block *entry = &live[index];
+	bool intact = true;
+
+	for(uint16_t i = 0; i < entry->size; i++)
+	{
+		intact &= ((uint8_t)entry->block[i] == (uint8_t)(entry->pattern + i));
+	}
+	CHECK(intact);
+
+	payload_pool_free(entry->block);
+	live[index] = live[--live_count];
+}
+
+
+/**
+ * @brief This function checks that an allocation failed only because every class big enough was used up.
+ * @param size Size of the failed allocation.
+ * @return true if the failure is legitimate
+ */
+static bool test_failure_legitimate(uint16_t size)
+{
+	const struct payload_pool_stats *stats = payload_pool_stats_get();
+
+	for(uint8_t i = 0; i < PAYLOAD_POOL_CLASS_COUNT; i++)
+	{
+		if((size <= class_size[i]) && (stats->in_use[i] < class_count[i]))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+int main(void)
+{
+	const struct payload_pool_stats *stats;
+	uint32_t seed = 0xF00D;
+	uint32_t failures = 0;
+	uint32_t illegitimate = 0;
+	uint8_t pattern = 0;
+	uint64_t start;
+
+	payload_pool_init();
+	start = test_clock_ns();
+
+	for(uint32_t cycle = 0; cycle < TEST_CYCLES; cycle++)
+	{
+		uint32_t r = test_rand(&seed);
+
+		/* Allocate more often than free while the pool is lightly used, so it runs full regularly */
+		if((live_count == 0) || ((r % 100) < 55))
+		{
+			uint16_t size = test_size(&seed);
+			char *block = payload_pool_alloc(size);
+
+			if(block == NULL)
+			{
+				failures++;
+				illegitimate += !test_failure_legitimate(size);
+				continue;
+			}
+
+			live[live_count].block = block;
+			live[live_count].size = size;
+			live[live_count].pattern = pattern;
+			for(uint16_t i = 0; i < size; i++)
+			{
+				block[i] = (char)(pattern + i);
+			}
+			live_count++;
+			pattern++;
+		}
+		else
+		{
+			test_free((r >> 8) % live_count);
+		}
+	}
+
+	while(live_count)
+	{
+		test_free(live_count - 1);
+	}
+
+	stats = payload_pool_stats_get();
+	CHECK_EQ(illegitimate, 0);
+	CHECK_EQ(stats->failure_count, failures);
+	CHECK(failures > 0);
+	for(uint8_t i = 0; i < PAYLOAD_POOL_CLASS_COUNT; i++)
+	{
+		CHECK_EQ(stats->in_use[i], 0);
+		CHECK_EQ(stats->high_water[i], class_count[i]);
+	}
+
+	fprintf(stderr, "payload pool: %lu cycles, %lu allocations, %lu failures (%lu not explained by a full class), "
+			"%.1f ns per cycle\n", (unsigned long)TEST_CYCLES, (unsigned long)stats->alloc_count, (unsigned long)failures,
+			(unsigned long)illegitimate, (double)(test_clock_ns() - start) / TEST_CYCLES);
+
+	/* Nothing was lost, every block of every class can be allocated again at the same time */
+	for(uint8_t i = 0; i < PAYLOAD_POOL_CLASS_COUNT; i++)
+	{
+		for(uint16_t j = 0; j < class_count[i]; j++)
+		{
+			CHECK(payload_pool_alloc(class_size[i]) != NULL);
+		}
+	}
+	CHECK(payload_pool_alloc(1) == NULL);
+	CHECK_EQ(stats->failure_count, failures + 1);
+
+	return test_exit("test_payload_pool");
+}
@@ -0,0 +1,269 @@
+/*
+ * @file test_timing.c
+ * @brief Host tests of the timing service of timing.c on the CPU model of em_device.h.
+ *
+ * The model has one clock: every poll of the RTCC counter or of the DWT cycle counter costs CPU time, and a sleep
+ * moves the clock to the end of the CRYOTIMER period. The accuracy test runs waits from 1us to 1s at the core
+ * clocks of the HFRCO and of the HFXO, from a random phase of the LFXO, and checks that a wait is never short and
+ * by how much it is long. The CPU active test measures how much of a wait the core spends awake, against the spin
+ * loops the waits replaced, which kept it awake all along.
+ *
+ * @author: Siddhant Jajoo.
+ * @date 10/17/2026
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "stub.h"
+#include "em_rtcc.h"
+#include "inc/timing.h"
+
+
+#define TEST_TICK_NS							(1000000000ull / STUB_CLOCK_TICKS_PER_S)
+#define TEST_PHASES								(16)								/* Random starting points of each wait */
+#define TEST_POLL_NS							(50)								/* A few cycles of a polling loop */
+
+/* Overshoot of a wait counting CPU cycles, the cycles per microsecond are rounded up */
+#define TEST_SPIN_LATE_NS(us)					(((us) * 1000ull / 32) + (4 * TEST_POLL_NS) + 100)
+/* Overshoot of a wait measured by the RTCC, the tick of the deadline margin and the one the deadline falls in */
+#define TEST_RTCC_LATE_NS						((2 * TEST_TICK_NS) + STUB_CLOCK_EM2_WAKEUP_NS + (8 * TEST_POLL_NS) + 100)
+
+
+static const uint32_t core_hz[] = {19000000, 38400000, 40000000};
+static const uint32_t waits_us[] = {1, 5, 10, 30, 61, 62, 100, 500, 999, 1000, 1007, 4800, 10000, 25000, 100000, 1000000};
+static uint32_t seed = 0x71;
+
+
+/* The other interrupts of the models are not used */
+void LDMA_IRQHandler(void)
+{
+}
+
+
+void LEUART0_IRQHandler(void)
+{
+}
+
+
+/**
+ * @brief This function resets the CPU model and starts the clock at a time.
+ * @param uint32_t hz Core clock
+ * @param uint64_t time_ns Starting time
+ * @param bool init true to set up the timing service, false to keep it as it is before timing_init()
+ * @return void
+ */
+static void test_power_up(uint32_t hz, uint64_t time_ns, bool init)
+{
+	stub_reset();
+	memset(&timing, 0, sizeof(struct timing));
+	stub_clock.core_hz = hz;
+	stub_clock.poll_ns = TEST_POLL_NS;
+	stub_clock.time_ns = time_ns;
+
+	if(init)
+	{
+		timing_init();
+	}
+}
+
+
+/**
+ * @brief This function moves the clock to a random phase of the LFXO tick, as a wait starts anywhere in a tick.
+ * @param void
+ * @return void
+ */
+static void test_random_phase(void)
+{
+	stub_clock.time_ns += test_rand(&seed) % (3 * TEST_TICK_NS);
+}
+
+
+/**
+ * @brief Waits are never short and late by little more than a poll for the short ones, by two LFXO ticks for the
+ * long ones, whatever the core clock.
+ */
+static void test_accuracy(void)
+{
+	for(uint8_t n = 0; n < sizeof(core_hz) / sizeof(core_hz[0]); n++)
+	{
+		uint64_t late_max_spin = 0;
+		uint64_t late_max_rtcc = 0;
+
+		test_power_up(core_hz[n], 0, true);
+		for(uint8_t w = 0; w < sizeof(waits_us) / sizeof(waits_us[0]); w++)
+		{
+			uint64_t wait_ns = waits_us[w] * 1000ull;
+			bool spin = (waits_us[w] <= TIMING_SPIN_MAX_US);
+
+			for(uint8_t phase = 0; phase < TEST_PHASES; phase++)
+			{
+				uint64_t start;
+				uint64_t late;
+
+				test_random_phase();
+				start = stub_clock.time_ns;
+				timing_wait_us(waits_us[w]);
+				CHECK(stub_clock.time_ns - start >= wait_ns);
+
+				late = stub_clock.time_ns - start - wait_ns;
+				CHECK(late <= (spin ? TEST_SPIN_LATE_NS(waits_us[w]) : TEST_RTCC_LATE_NS));
+				if(spin && (late > late_max_spin))
+				{
+					late_max_spin = late;
+				}
+				if(!spin && (late > late_max_rtcc))
+				{
+					late_max_rtcc = late;
+				}
+			}
+		}
+
+		/* The same waits in milliseconds */
+		for(uint32_t ms = 1; ms <= 1000; ms *= 10)
+		{
+			uint64_t start;
+
+			test_random_phase();
+			start = stub_clock.time_ns;
+			timing_wait_ms(ms);
+			CHECK(stub_clock.time_ns - start >= ms * 1000000ull);
+			CHECK(stub_clock.time_ns - start - (ms * 1000000ull) <= TEST_RTCC_LATE_NS);
+		}
+
+		CHECK_EQ(stub_clock.hang_count, 0);
+		fprintf(stderr, "test_timing: core at %.1f MHz, late by %.2f us at most on the cycle counter, %.2f us on the RTCC\n",
+				core_hz[n] / 1e6, late_max_spin / 1e3, late_max_rtcc / 1e3);
+	}
+}
+
+
+/**
+ * @brief Before timing_init() every wait spins on the RTCC, which init_mcu.c starts, and is still not short.
+ */
+static void test_not_ready(void)
+{
+	uint64_t start;
+
+	test_power_up(38400000, 0, false);
+	for(uint8_t w = 0; w < sizeof(waits_us) / sizeof(waits_us[0]) - 1; w++)
+	{
+		test_random_phase();
+		start = stub_clock.time_ns;
+		timing_wait_us(waits_us[w]);
+		CHECK(stub_clock.time_ns - start >= waits_us[w] * 1000ull);
+		CHECK(stub_clock.time_ns - start - (waits_us[w] * 1000ull) <= TEST_RTCC_LATE_NS);
+	}
+	CHECK_EQ(stub_clock.sleep_count, 0);
+}
+
+
+/**
+ * @brief A deadline expires after its timeout and no later than two LFXO ticks after it, also when the RTCC counter
+ * wraps in between.
+ */
+static void test_deadline(void)
+{
+	static const uint64_t starts[] = {0, ((1ull << 32) - 100) * 1000000000ull / STUB_CLOCK_TICKS_PER_S};
+
+	for(uint8_t s = 0; s < sizeof(starts) / sizeof(starts[0]); s++)
+	{
+		test_power_up(38400000, starts[s], true);
+		for(uint32_t us = 100; us <= 100000; us *= 10)
+		{
+			uint64_t start;
+			uint32_t deadline;
+
+			test_random_phase();
+			start = stub_clock.time_ns;
+			deadline = timing_deadline_us(us);
+			while(!timing_expired(deadline));
+			CHECK(stub_clock.time_ns - start >= us * 1000ull);
+			CHECK(stub_clock.time_ns - start - (us * 1000ull) <= TEST_RTCC_LATE_NS);
+
+			start = stub_clock.time_ns;
+			timing_wait_until(timing_deadline_us(us));
+			CHECK(stub_clock.time_ns - start >= us * 1000ull);
+			CHECK(stub_clock.time_ns - start - (us * 1000ull) <= TEST_RTCC_LATE_NS);
+		}
+	}
+}
+
+
+/**
+ * @brief Waits of 1ms and more spend most of their time asleep, in EM2 unless a driver blocks it. The CPU is
+ * awake for the last TIMING_SLEEP_MIN_TICKS at most and the wake ups, where the spin loops kept it awake for the
+ * whole wait.
+ */
+static void test_cpu_active(void)
+{
+	static const uint32_t waits_ms[] = {1, 2, 5, 10, 25, 100, 1000};
+	uint64_t spin_total = 0;
+	uint64_t active_total = 0;
+
+	for(uint8_t w = 0; w < sizeof(waits_ms) / sizeof(waits_ms[0]); w++)
+	{
+		uint64_t elapsed = 0;
+		uint64_t slept = 0;
+		uint32_t sleeps = 0;
+		uint32_t ticks = (waits_ms[w] * STUB_CLOCK_TICKS_PER_S / 1000) + 2;
+
+		test_power_up(38400000, 0, true);
+		for(uint8_t phase = 0; phase < TEST_PHASES; phase++)
+		{
+			uint64_t start;
+			uint64_t sleep_start = stub_clock.em2_ns;
+			uint32_t count_start = stub_clock.sleep_count;
+
+			test_random_phase();
+			start = stub_clock.time_ns;
+			timing_wait_ms(waits_ms[w]);
+			elapsed += stub_clock.time_ns - start;
+			slept += stub_clock.em2_ns - sleep_start;
+			sleeps += stub_clock.sleep_count - count_start;
+
+			/* Awake for the end of the wait and the wake ups */
+			CHECK((stub_clock.time_ns - start) - (stub_clock.em2_ns - sleep_start) <=
+				  ((TIMING_SLEEP_MIN_TICKS + 2) * TEST_TICK_NS) +
+				  ((stub_clock.sleep_count - count_start) * (STUB_CLOCK_EM2_WAKEUP_NS + TEST_TICK_NS)));
+			/* One sleep for each bit of the wait in ticks, at most */
+			CHECK(stub_clock.sleep_count - count_start <= 32u - __CLZ(ticks));
+		}
+
+		CHECK_EQ(stub_clock.em1_ns, 0);
+		CHECK_EQ(timing.wait_count, TEST_PHASES);
+		CHECK((uint64_t)(timing.sleep_ticks + timing.spin_ticks) * TEST_TICK_NS >= elapsed - (TEST_PHASES * TEST_TICK_NS));
+		spin_total += elapsed;
+		active_total += elapsed - slept;
+		fprintf(stderr, "test_timing: wait of %4u ms, CPU active %7.1f us (%5.1f%%) instead of %u us, %.1f sleeps\n",
+				waits_ms[w], (elapsed - slept) / 1e3 / TEST_PHASES, 100.0 * (elapsed - slept) / elapsed,
+				waits_ms[w] * 1000, (double)sleeps / TEST_PHASES);
+	}
+
+	/* The long waits are almost all asleep */
+	CHECK(active_total * 100 <= spin_total);
+	fprintf(stderr, "test_timing: CPU active time saved %.2f%% over the waits of 1 ms to 1 s\n",
+			100.0 - (100.0 * active_total / spin_total));
+
+	/* A driver blocking EM2 keeps the sleeps in EM1 */
+	test_power_up(38400000, 0, true);
+	SLEEP_SleepBlockBegin(sleepEM2);
+	timing_wait_ms(10);
+	CHECK(stub_clock.em1_ns > 9000000);
+	CHECK_EQ(stub_clock.em2_ns, 0);
+	SLEEP_SleepBlockEnd(sleepEM2);
+	CHECK_EQ(stub_clock.hang_count, 0);
+}
+
+
+int main(void)
+{
+	test_accuracy();
+	test_not_ready();
+	test_deadline();
+	test_cpu_active();
+
+	return test_exit("test_timing");
+}